@@ -0,0 +1,94 @@
+/***************************************************************************//**
+* \file FreeRTOSConfig.h
+* \version 1.0
+*
+* \brief
+* FreeRTOS configuration of the BLE_RTOS=FREERTOS build.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include "cy_utils.h"
+
+extern uint32_t SystemCoreClock;
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_TICKLESS_IDLE                 0
+#define configCPU_CLOCK_HZ                      SystemCoreClock
+#define configTICK_RATE_HZ                      1000u
+#define configMAX_PRIORITIES                    7
+#define configMINIMAL_STACK_SIZE                128
+#define configMAX_TASK_NAME_LEN                 16
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configQUEUE_REGISTRY_SIZE               8
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIME_SLICING                  1
+#define configUSE_NEWLIB_REENTRANT              0
+#define configENABLE_BACKWARD_COMPATIBILITY     0
+
+/* Memory allocation related definitions */
+#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configTOTAL_HEAP_SIZE                   (16u * 1024u)
+#define configAPPLICATION_ALLOCATED_HEAP        0
+
+/* Hook function related definitions */
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#define configUSE_MALLOC_FAILED_HOOK            0
+
+/* Run time and task stats gathering related definitions */
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_TRACE_FACILITY                0
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+
+/* Co-routine and software timer related definitions */
+#define configUSE_CO_ROUTINES                   0
+#define configUSE_TIMERS                        0
+
+/* Optional functions */
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_pxTaskGetStackStart             1
+
+/*
+ * The PSoC 6 has 3 interrupt priority bits. The interrupts that call the
+ * FreeRTOS API, BLESS (1), the LPTimer (3) and the debug UART (3), must not
+ * be above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ */
+#define configPRIO_BITS                             3
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY     7
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 1
+#define configKERNEL_INTERRUPT_PRIORITY             (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY        (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define configASSERT(x)                         CY_ASSERT(x)
+
+/* Map the FreeRTOS port interrupt handlers to the CMSIS names */
+#define vPortSVCHandler                         SVC_Handler
+#define xPortPendSVHandler                      PendSV_Handler
+#define xPortSysTickHandler                     SysTick_Handler
+
+#endif /* FREERTOS_CONFIG_H */
+
+/* [] END OF FILE */
@@ -15,23 +15,38 @@
 #include "ble_common.h"
 #include "ble_bond.h"
 #include "ble_app.h"
+#include "ble_time.h"
+#include "ble_event.h"
+#include "ble_timer.h"
+#include "ble_task.h"
+#include "ble_power.h"
+#include "ble_retain.h"
+#include "ble_trace.h"
+#include "ble_ram.h"
 
 #define BLESS_INTR_PRIORITY                         (1u)
+#define BLE_UART_INTR_PRIORITY                      (3u)
 
 /**
  * @brief Enable or Disable the BLE timer function
  */
 #define ENABLE_BLE_MAIN_TIMER                       DISABLED
 
+/**
+ * @brief The timeout of the connection parameter update, it is the L2CAP signaling RTX timeout
+ */
+#define BLE_APP_CONN_UPDATE_TIMEOUT_MS              (30000u)
+
 /**
  * @brief The default MTU size
  */
 #define DEFAULT_MTU_SIZE                            (23)
 
 /**
- * @brief Global Handle to internal BLE structure which holds the BLE connected handle.
+ * @brief The handle of each connection, indexed by attId, the connection
+ *        parameter update is requested on it.
  */
-cy_stc_ble_conn_handle_t ble_app_conn_handle;
+static cy_stc_ble_conn_handle_t ble_app_conn_handle[CY_BLE_CONN_COUNT];
 
 /**
  * @brief Global buffer for generated keys are store.
@@ -49,15 +64,125 @@ static cy_stc_ble_gap_sec_key_info_t keyInfo =
                         CY_BLE_GAP_SMP_RESP_CSRK_KEY_DIST,
 };
 
+/**
+ * @brief The keys of keyInfo are generated or retained, they are known by the
+ *        bonded peers and are not generated again when the stack restarts.
+ */
+static bool keysReady = false;
+
+/**
+ * @brief The boot state, the time to advertise is measured from ble_app_init().
+ */
+static struct
+{
+    bool     warm;                  /* The retained state was valid */
+    bool     advertised;            /* The first advertisement started */
+    bool     link_pending;          /* The retained link parameters are requested on the next connection */
+    uint32_t start;                 /* The time of ble_app_init() in ticks */
+} ble_app_boot;
+
 #if ENABLE_BLE_MAIN_TIMER == ENABLED
-static volatile uint32_t        mainTimer  = 1u;
-static cy_stc_ble_timer_info_t  timerParam = { .timeout = 1 };
+static volatile uint32_t        mainTimer  = 0u;
+static ble_timer_t              mainTimerHandle;
+#endif
+
+/**
+ * @brief The size of negotiate MTU of each connection, indexed by attId.
+ */
+static uint16_t negotiatedMtu[CY_BLE_CONN_COUNT];
+
+/**
+ * @brief The state of the connection parameter update, changed by the stack events.
+ */
+typedef enum
+{
+    BLE_APP_CONN_UPDATE_IDLE,
+    BLE_APP_CONN_UPDATE_PENDING,
+    BLE_APP_CONN_UPDATE_DONE,
+    BLE_APP_CONN_UPDATE_REJECTED,
+    BLE_APP_CONN_UPDATE_DISCONNECTED
+} ble_app_conn_update_state_t;
+
+/**
+ * @brief The requested connection parameters and the update state.
+ */
+static struct
+{
+    uint16_t interval_min;
+    uint16_t interval_max;
+    uint16_t slave_latency;
+    uint16_t timeout_multiplier;
+    uint8_t  conn_id;               /* The updated connection (attId) */
+    uint8_t  bdHandle;              /* The handle of the updated connection, the events of the others are ignored */
+    volatile ble_app_conn_update_state_t state;
+} ble_app_conn_update;
+
+/**
+ * @brief The cooperative tasks of the long BLE operations.
+ */
+static ble_task_t ble_app_stop_task;
+static ble_task_t ble_app_conn_update_task;
+
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+/**
+ * @brief The advertising mode of no advertisement, during a pause.
+ */
+#define BLE_APP_ADV_MODE_NONE                       (0xFFu)
+
+/**
+ * @brief The adaptive advertising state, the phase timer moves to the next
+ *        phase and ble_app_restart_advertisement() follows it.
+ */
+static struct
+{
+    ble_app_adv_policy_t policy;
+    ble_app_adv_phase_t phase;
+    bool     discovering;           /* A discovery runs, no central connected since it started */
+    uint8_t  mode;                  /* The mode of the running advertisement */
+    uint32_t pause_ms;              /* The next pause */
+    uint32_t start;                 /* The start of the discovery in ms */
+    ble_timer_t timer;
+    ble_app_adv_stats_t stats;
+} ble_app_adv;
 #endif
 
+#if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
 /**
- * @brief The size of negotiate MTU.
+ * @brief The time given to store the pending bonds before a recovery.
  */
-static uint16_t negotiatedMtu = DEFAULT_MTU_SIZE;
+#define BLE_APP_RECOVERY_FLASH_TIMEOUT_MS           (100u)
+
+/**
+ * @brief The stack recovery state.
+ */
+static struct
+{
+    bool     active;                /* A recovery runs, until the advertisement restarts */
+    uint32_t start;                 /* The time of the hardware error in ticks */
+    ble_task_t task;
+    ble_app_recovery_stats_t stats;
+} ble_app_recovery;
+#endif
+
+#if (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED)
+/**
+ * @brief The status broadcast, the status follows the configured advertising
+ *        and scan response data at adv_base and scan_base.
+ */
+static struct
+{
+    bool     active;
+    bool     pending;               /* The status is not applied yet */
+    uint8_t  adv_base;
+    uint8_t  scan_base;
+    uint8_t  adv_len;               /* The status bytes of each element */
+    uint8_t  scan_len;
+    uint8_t  status[BLE_APP_BROADCAST_STATUS_MAX];
+    uint32_t last;                  /* The time of the last update in ms */
+    ble_timer_t timer;
+    ble_app_broadcast_stats_t stats;
+} ble_app_broadcast;
+#endif
 
 
 /******************************************************************************
@@ -71,8 +196,328 @@ static uint16_t negotiatedMtu = DEFAULT_MTU_SIZE;
 static void bless_interrupt_handler(void)
 {
     Cy_BLE_BlessIsrHandler();
+    ble_event_post(BLE_EVENT_STACK);
+}
+#endif
+
+/******************************************************************************
+* Function Name: ble_app_host_callback
+*******************************************************************************
+* Summary:
+*  Called by the BLE stack when it needs Cy_BLE_ProcessEvents() to be called.
+*
+******************************************************************************/
+static void ble_app_host_callback(void)
+{
+    ble_event_post(BLE_EVENT_STACK);
+}
+
+#if (BLE_DEBUG_UART_ENABLED == ENABLED)
+/******************************************************************************
+* Function Name: ble_app_uart_callback
+*******************************************************************************
+* Summary:
+*  Debug UART event callback, posts the received data to the run loop.
+*
+******************************************************************************/
+static void ble_app_uart_callback(void *callback_arg, cyhal_uart_event_t event)
+{
+    (void)callback_arg;
+    if(0u != (event & CYHAL_UART_IRQ_RX_NOT_EMPTY)) {
+        ble_event_post(BLE_EVENT_UART);
+    }
+}
+#endif /* (BLE_DEBUG_UART_ENABLED == ENABLED) */
+
+#if ENABLE_BLE_MAIN_TIMER == ENABLED
+/******************************************************************************
+* Function Name: ble_app_main_timer_callback
+*******************************************************************************
+* Summary:
+*  Periodic main timer callback of the software timer wheel.
+*
+******************************************************************************/
+static void ble_app_main_timer_callback(void *arg)
+{
+    (void)arg;
+    mainTimer++;
+    BLE_DBG_PRINTF("mian timer out\r\n");
+}
+#endif
+
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+/*******************************************************************************
+* Function Name: ble_app_adv_enter
+****************************************************************************//**
+*
+* Enters an advertising phase, the advertisement is changed by
+* ble_app_restart_advertisement() on the posted event.
+*
+* \param phase The phase.
+*
+* \return The phase length in ms, 0 if it lasts until a central connects.
+*
+*******************************************************************************/
+static uint32_t ble_app_adv_enter(ble_app_adv_phase_t phase)
+{
+    uint32_t timeout = 0u;
+
+    ble_app_adv.phase = phase;
+    ble_app_adv.stats.phases[phase]++;
+    if(phase == BLE_APP_ADV_PHASE_FAST) {
+        timeout = ble_app_adv.policy.fast_ms;
+    } else if(phase == BLE_APP_ADV_PHASE_SLOW) {
+        timeout = ble_app_adv.policy.slow_ms;
+    } else {
+        timeout = ble_app_adv.pause_ms;
+        /* Back off */
+        ble_app_adv.pause_ms = (ble_app_adv.pause_ms > (ble_app_adv.policy.pause_max_ms / 2u)) ? \
+                               ble_app_adv.policy.pause_max_ms : (ble_app_adv.pause_ms * 2u);
+    }
+    ble_event_post(BLE_EVENT_ADV);
+    return timeout;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_timer_callback
+****************************************************************************//**
+*
+* Ends an advertising phase: fast is followed by slow, slow by a pause when
+* the policy has one, and a pause by slow.
+*
+* \param arg Not used.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_adv_timer_callback(void *arg)
+{
+    uint32_t timeout;
+
+    (void)arg;
+    if((ble_app_adv.phase == BLE_APP_ADV_PHASE_SLOW) && (ble_app_adv.pause_ms != 0u)) {
+        timeout = ble_app_adv_enter(BLE_APP_ADV_PHASE_PAUSE);
+    } else {
+        timeout = ble_app_adv_enter(BLE_APP_ADV_PHASE_SLOW);
+    }
+    if(timeout != 0u) {
+        ble_timer_start(&ble_app_adv.timer, timeout, 0u, ble_app_adv_timer_callback, NULL);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_discover
+****************************************************************************//**
+*
+* Starts a discovery with the fast phase, the time-to-connect is measured
+* from here.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_adv_discover(void)
+{
+    ble_app_adv.discovering = true;
+    ble_app_adv.start = ble_timer_now();
+    ble_app_adv.pause_ms = ble_app_adv.policy.pause_ms;
+    ble_app_adv.stats.discoveries++;
+    ble_timer_start(&ble_app_adv.timer, ble_app_adv_enter(BLE_APP_ADV_PHASE_FAST), 0u, \
+                    ble_app_adv_timer_callback, NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_connected
+****************************************************************************//**
+*
+* Ends the discovery when a central connects and records the time-to-connect.
+* The advertisement for the next central starts a new discovery.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_adv_connected(void)
+{
+    uint32_t ttc;
+    uint32_t bucket = 0u;
+
+    if(!ble_app_adv.discovering) {
+        return;
+    }
+    ttc = ble_timer_now() - ble_app_adv.start;
+    while((bucket < (BLE_APP_ADV_TTC_BUCKETS - 1u)) && (ttc >= (BLE_APP_ADV_TTC_BASE_MS << bucket))) {
+        bucket++;
+    }
+    ble_app_adv.stats.ttc_hist[bucket]++;
+    ble_app_adv.stats.ttc_total_ms += ttc;
+    if(ttc > ble_app_adv.stats.ttc_max_ms) {
+        ble_app_adv.stats.ttc_max_ms = ttc;
+    }
+    ble_app_adv.stats.connects[ble_app_adv.phase]++;
+    ble_app_adv.discovering = false;
+    ble_timer_stop(&ble_app_adv.timer);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_set_policy
+****************************************************************************//**
+*
+* Sets the advertising policy, it applies from the next phase on.
+*
+* \param policy The policy, the fast phase must not be 0.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_adv_set_policy(const ble_app_adv_policy_t *policy)
+{
+    if((policy == NULL) || (policy->fast_ms == 0u) || (policy->pause_max_ms < policy->pause_ms)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    ble_app_adv.policy = *policy;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_wake
+****************************************************************************//**
+*
+* Jumps back to the fast phase at once, such as when there is data to
+* deliver. A slow advertisement is stopped and restarted fast by the run
+* loop, a pause ends. A new discovery starts and the back-off is reset.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_adv_wake(void)
+{
+    ble_app_adv.stats.wakes++;
+    ble_app_adv_discover();
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_get_stats
+****************************************************************************//**
+*
+* Gets the adaptive advertising statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_adv_get_stats(ble_app_adv_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_app_adv.stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_adv_print_stats
+****************************************************************************//**
+*
+* Prints the adaptive advertising statistics and the time-to-connect
+* histogram.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_adv_print_stats(void)
+{
+    ble_app_adv_stats_t *stats = &ble_app_adv.stats;
+    uint32_t connects = stats->connects[BLE_APP_ADV_PHASE_FAST] + stats->connects[BLE_APP_ADV_PHASE_SLOW] + \
+                        stats->connects[BLE_APP_ADV_PHASE_PAUSE];
+    uint32_t i;
+
+    BLE_DBG_PRINTF("Advertising phase %d: discoveries=%lu (wakes %lu), fast=%lu, slow=%lu, pauses=%lu\r\n", \
+        (int)ble_app_adv.phase, (unsigned long)stats->discoveries, (unsigned long)stats->wakes, \
+        (unsigned long)stats->phases[BLE_APP_ADV_PHASE_FAST], (unsigned long)stats->phases[BLE_APP_ADV_PHASE_SLOW], \
+        (unsigned long)stats->phases[BLE_APP_ADV_PHASE_PAUSE]);
+    BLE_DBG_PRINTF("Time to connect: connects=%lu (fast %lu, slow %lu), avg=%lu ms, max=%lu ms\r\n", \
+        (unsigned long)connects, (unsigned long)stats->connects[BLE_APP_ADV_PHASE_FAST], \
+        (unsigned long)stats->connects[BLE_APP_ADV_PHASE_SLOW], \
+        (unsigned long)((connects != 0u) ? (stats->ttc_total_ms / connects) : 0u), (unsigned long)stats->ttc_max_ms);
+    for(i = 0u; i < BLE_APP_ADV_TTC_BUCKETS; i++) {
+        if(i < (BLE_APP_ADV_TTC_BUCKETS - 1u)) {
+            BLE_DBG_PRINTF("  < %6lu ms: %lu\r\n", (unsigned long)(BLE_APP_ADV_TTC_BASE_MS << i), \
+                (unsigned long)stats->ttc_hist[i]);
+        } else {
+            BLE_DBG_PRINTF("  >=%6lu ms: %lu\r\n", (unsigned long)(BLE_APP_ADV_TTC_BASE_MS << (i - 1u)), \
+                (unsigned long)stats->ttc_hist[i]);
+        }
+    }
+}
+#endif /* (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED) */
+
+/*******************************************************************************
+* Function Name: ble_app_set_identity
+****************************************************************************//**
+*
+* Sets the identity address and the default PHY once the keys are ready.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_set_identity(void)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    apiResult = Cy_BLE_GAP_SetIdAddress(&cy_ble_deviceAddress);
+    if(apiResult != CY_BLE_SUCCESS)
+    {
+        BLE_DBG_PRINTF("Cy_BLE_GAP_SetIdAddress API Error: 0x%x \r\n", apiResult);
+    }
+        #if(CY_BLE_CONFIG_ENABLE_PHY_UPDATE != 0u)
+        {
+            const cy_stc_ble_set_suggested_phy_info_t phyInfo =
+            {
+                .allPhyMask = CY_BLE_PHY_NO_PREF_MASK_NONE,
+                .txPhyMask = CY_BLE_PHY_MASK_LE_2M,
+                .rxPhyMask = CY_BLE_PHY_MASK_LE_2M
+            };
+            apiResult = Cy_BLE_SetDefaultPhy(&phyInfo);
+            if(apiResult != CY_BLE_SUCCESS)
+            {
+                BLE_DBG_PRINTF("Cy_BLE_SetDefaultPhy API Error: 0x%x \r\n", apiResult);
+            }
+        }
+        #endif  /* (CY_BLE_CONFIG_ENABLE_PHY_UPDATE != 0u) */
 }
+
+/*******************************************************************************
+* Function Name: ble_app_retain_bonds
+****************************************************************************//**
+*
+* Updates the retained bond index from the bond list of the stack.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_retain_bonds(void)
+{
+#if (CY_BLE_BONDING_REQUIREMENT == CY_BLE_BONDING_YES)
+    ble_retain_data_t *retained = ble_retain_get();
+    cy_stc_ble_gap_bonded_device_list_info_t bondedDeviceList = {.bdHandleAddrList = retained->bonds};
+
+    if(CY_BLE_SUCCESS == Cy_BLE_GAP_GetBondList(&bondedDeviceList)) {
+        retained->bond_count = bondedDeviceList.noOfDevices;
+        ble_retain_commit();
+    }
 #endif
+}
 
 /*******************************************************************************
 * Function Name: ble_app_callback
@@ -90,6 +535,12 @@ static void bless_interrupt_handler(void)
 static void ble_app_callback(uint32_t event, void* eventParam)
 {
     cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+#if (ENABLE_STACK_DEPTH_FUNCTION == ENABLED)
+    uint32_t stack = ble_ram_begin();
+#endif
+#if (ENABLE_EVENT_TRACE_FUNCTION == ENABLED)
+    ble_trace_rec_t *trace = ble_trace_begin(event, eventParam);
+#endif
 
     switch (event)
     {
@@ -99,33 +550,49 @@ static void ble_app_callback(uint32_t event, void* eventParam)
         /* This event is received when the component is Started */
         case CY_BLE_EVT_STACK_ON:
             BLE_DBG_PRINTF("CY_BLE_EVT_STACK_ON\r\n");
+        #if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+            ble_app_adv_discover();
+            ble_app_adv.mode = CY_BLE_ADVERTISING_FAST;
+        #endif
             /* Enter into discoverable mode so that remote can find it. */
             if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GAPP_StartAdvertisement(CY_BLE_ADVERTISING_FAST, \
                                                            CY_BLE_PERIPHERAL_CONFIGURATION_0_INDEX)))
             {
                 BLE_DBG_PRINTF("Cy_BLE_GAPP_StartAdvertisement API Error: 0x%x\r\n", apiResult);
             }
-            /* Display Bond list */
-            ble_display_bond_list();
+            /* Display Bond list, a warm boot has the retained bond index */
+        #if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+            if(!ble_app_boot.warm && !ble_app_recovery.active)
+        #else
+            if(!ble_app_boot.warm)
+        #endif
+            {
+                ble_display_bond_list();
+                ble_app_retain_bonds();
+            }
+            #if ENABLE_BLE_MAIN_TIMER == ENABLED
+            ble_timer_start(&mainTimerHandle, BLE_TIMER_TIMEOUT * 1000u, BLE_TIMER_TIMEOUT * 1000u, \
+                            ble_app_main_timer_callback, NULL);
+            #endif
             break;
             
         case CY_BLE_EVT_TIMEOUT:
             BLE_DBG_PRINTF("CY_BLE_EVT_TIMEOUT\r\n");
-            #if ENABLE_BLE_MAIN_TIMER == ENABLED
-            if((((cy_stc_ble_timeout_param_t *)eventParam)->reasonCode == CY_BLE_GENERIC_APP_TO) && 
-               (((cy_stc_ble_timeout_param_t *)eventParam)->timerHandle == timerParam.timerHandle))
-            {
-                mainTimer++;
-                BLE_DBG_PRINTF("mian timer out\r\n");
-            }
-            #endif
             break;
             
         case CY_BLE_EVT_HARDWARE_ERROR:
             /* This event indicates that some internal HW error has occurred. */
             BLE_DBG_PRINTF("CY_BLE_EVT_HARDWARE_ERROR\r\n");
+        #if (ENABLE_EVENT_TRACE_FUNCTION == ENABLED)
+            /* Keep the events which led to the error */
+            ble_trace_freeze();
+        #endif
+        #if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+            (void)ble_app_recover_start();
+        #else
             /* Halt CPU in Debug mode */
             CY_ASSERT(0u != 0u);
+        #endif
             break;
             
         case CY_BLE_EVT_STACK_BUSY_STATUS:
@@ -157,6 +624,12 @@ static void ble_app_callback(uint32_t event, void* eventParam)
                                                                  eventParams)->privateBdAddr[i-1]);
             }
             BLE_DBG_PRINTF("\r\n");
+            if(keysReady)
+            {
+                /* Keep the keys known by the bonded peers */
+                ble_app_set_identity();
+                break;
+            }
             /* Generates the security keys */
             if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GAP_GenerateKeys(&keyInfo)))
             {
@@ -209,26 +682,11 @@ static void ble_app_callback(uint32_t event, void* eventParam)
         case CY_BLE_EVT_GAP_KEYS_GEN_COMPLETE:
             BLE_DBG_PRINTF("CY_BLE_EVT_GAP_KEYS_GEN_COMPLETE \r\n");
             keyInfo.SecKeyParam = (*(cy_stc_ble_gap_sec_key_param_t *)eventParam);
-            apiResult = Cy_BLE_GAP_SetIdAddress(&cy_ble_deviceAddress);
-            if(apiResult != CY_BLE_SUCCESS)
-            {
-                BLE_DBG_PRINTF("Cy_BLE_GAP_SetIdAddress API Error: 0x%x \r\n", apiResult);
-            }
-            #if(CY_BLE_CONFIG_ENABLE_PHY_UPDATE != 0u)
-            {
-                const cy_stc_ble_set_suggested_phy_info_t phyInfo =
-                {
-                    .allPhyMask = CY_BLE_PHY_NO_PREF_MASK_NONE,
-                    .txPhyMask = CY_BLE_PHY_MASK_LE_2M,
-                    .rxPhyMask = CY_BLE_PHY_MASK_LE_2M
-                };
-                apiResult = Cy_BLE_SetDefaultPhy(&phyInfo);
-                if(apiResult != CY_BLE_SUCCESS)
-                {
-                    BLE_DBG_PRINTF("Cy_BLE_SetDefaultPhy API Error: 0x%x \r\n", apiResult);
-                }
-            }
-            #endif  /* (CY_BLE_CONFIG_ENABLE_PHY_UPDATE != 0u) */
+            keysReady = true;
+            ble_retain_get()->keys = keyInfo.SecKeyParam;
+            ble_retain_get()->keys_valid = true;
+            ble_retain_commit();
+            ble_app_set_identity();
             break;
             
         case CY_BLE_EVT_GAP_AUTH_REQ:
@@ -330,6 +788,28 @@ static void ble_app_callback(uint32_t event, void* eventParam)
             
         case CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP:
             BLE_DBG_PRINTF("CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP, state: %d \r\n", Cy_BLE_GetAdvertisementState());
+        #if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+            if(ble_app_recovery.active && (Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_ADVERTISING))
+            {
+                ble_app_recovery.active = false;
+                ble_app_recovery.stats.last_us = BLE_TIME_TICKS_TO_US(ble_time_now() - ble_app_recovery.start);
+                if(ble_app_recovery.stats.last_us > ble_app_recovery.stats.max_us)
+                {
+                    ble_app_recovery.stats.max_us = ble_app_recovery.stats.last_us;
+                }
+                BLE_DBG_PRINTF("Stack recovered in %lu us\r\n", (unsigned long)ble_app_recovery.stats.last_us);
+            }
+        #endif
+            if(!ble_app_boot.advertised && (Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_ADVERTISING))
+            {
+                uint32_t tta = BLE_TIME_TICKS_TO_US(ble_time_now() - ble_app_boot.start);
+
+                ble_app_boot.advertised = true;
+                ble_retain_boot_done(tta);
+                BLE_DBG_PRINTF("Advertising %lu us after the %s boot\r\n", (unsigned long)tta, \
+                    ble_app_boot.warm ? "warm" : "cold");
+            }
+            ble_event_post(BLE_EVENT_ADV);
             break;
             
     #if(CY_BLE_LL_PRIVACY_FEATURE_ENABLED)
@@ -366,11 +846,14 @@ static void ble_app_callback(uint32_t event, void* eventParam)
                 ((cy_stc_ble_gap_connected_param_t *)eventParam)->supervisionTO);
             connectedBdHandle = ((cy_stc_ble_gap_connected_param_t *)eventParam)->bdHandle;
     #endif  /* CY_BLE_LL_PRIVACY_FEATURE_ENABLED */
+        #if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+            ble_app_adv_connected();
+        #endif
             /* Initiate pairing process */
             if((cy_ble_configPtr->authInfo[CY_BLE_SECURITY_CONFIGURATION_0_INDEX].security & CY_BLE_GAP_SEC_LEVEL_MASK) > 
                 CY_BLE_GAP_SEC_LEVEL_1)
             {
-                cy_ble_configPtr->authInfo[CY_BLE_SECURITY_CONFIGURATION_0_INDEX].bdHandle = ble_app_conn_handle.bdHandle;
+                cy_ble_configPtr->authInfo[CY_BLE_SECURITY_CONFIGURATION_0_INDEX].bdHandle = connectedBdHandle;
                 apiResult = Cy_BLE_GAP_AuthReq(&cy_ble_configPtr->authInfo[CY_BLE_SECURITY_CONFIGURATION_0_INDEX]);
                 if(apiResult != CY_BLE_SUCCESS)
                 {
@@ -393,6 +876,12 @@ static void ble_app_callback(uint32_t event, void* eventParam)
         case CY_BLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP:
             BLE_DBG_PRINTF("CY_BLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP, result = %d\r\n", 
                 (*(cy_stc_ble_l2cap_conn_update_rsp_param_t *)eventParam).result);
+            if((ble_app_conn_update.state == BLE_APP_CONN_UPDATE_PENDING) && \
+               ((*(cy_stc_ble_l2cap_conn_update_rsp_param_t *)eventParam).bdHandle == ble_app_conn_update.bdHandle) && \
+               ((*(cy_stc_ble_l2cap_conn_update_rsp_param_t *)eventParam).result != 0u))
+            {
+                ble_app_conn_update.state = BLE_APP_CONN_UPDATE_REJECTED;
+            }
             break;
             
         case CY_BLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE:
@@ -401,6 +890,21 @@ static void ble_app_callback(uint32_t event, void* eventParam)
                         ((cy_stc_ble_gap_conn_param_updated_in_controller_t *)eventParam)->connIntv * 5u /4u,
                         ((cy_stc_ble_gap_conn_param_updated_in_controller_t *)eventParam)->connLatency,
                         ((cy_stc_ble_gap_conn_param_updated_in_controller_t *)eventParam)->supervisionTO*10);
+            if((ble_app_conn_update.state == BLE_APP_CONN_UPDATE_PENDING) && \
+               (((cy_stc_ble_gap_conn_param_updated_in_controller_t *)eventParam)->bdHandle == ble_app_conn_update.bdHandle))
+            {
+                ble_app_conn_update.state = (((cy_stc_ble_gap_conn_param_updated_in_controller_t *)eventParam)->status == 0u) ? \
+                                            BLE_APP_CONN_UPDATE_DONE : BLE_APP_CONN_UPDATE_REJECTED;
+                if(ble_app_conn_update.state == BLE_APP_CONN_UPDATE_DONE)
+                {
+                    /* Requested again after a warm boot */
+                    ble_retain_get()->link = (ble_retain_link_t){ ble_app_conn_update.interval_min, \
+                        ble_app_conn_update.interval_max, ble_app_conn_update.slave_latency, \
+                        ble_app_conn_update.timeout_multiplier };
+                    ble_retain_get()->link_valid = true;
+                    ble_retain_commit();
+                }
+            }
             break;
             
         case CY_BLE_EVT_GAP_DEVICE_DISCONNECTED:
@@ -408,7 +912,16 @@ static void ble_app_callback(uint32_t event, void* eventParam)
                 (*(cy_stc_ble_gap_disconnect_param_t *)eventParam).bdHandle, 
                 (*(cy_stc_ble_gap_disconnect_param_t *)eventParam).reason, 
                 (*(cy_stc_ble_gap_disconnect_param_t *)eventParam).status);
-            negotiatedMtu = DEFAULT_MTU_SIZE;
+            if((ble_app_conn_update.state == BLE_APP_CONN_UPDATE_PENDING) && \
+               ((*(cy_stc_ble_gap_disconnect_param_t *)eventParam).bdHandle == ble_app_conn_update.bdHandle))
+            {
+                ble_app_conn_update.state = BLE_APP_CONN_UPDATE_DISCONNECTED;
+            }
+        #if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+            /* The central is likely to come back soon */
+            ble_app_adv_wake();
+        #endif
+            ble_event_post(BLE_EVENT_ADV);
             break;
             
         case CY_BLE_EVT_GAP_ENCRYPT_CHANGE:
@@ -420,9 +933,22 @@ static void ble_app_callback(uint32_t event, void* eventParam)
         ***********************************************************/
         /* This event is received when device is connected over GATT level */
         case CY_BLE_EVT_GATT_CONNECT_IND:
-            ble_app_conn_handle = *(cy_stc_ble_conn_handle_t *)eventParam;
+            if((*(cy_stc_ble_conn_handle_t *)eventParam).attId < CY_BLE_CONN_COUNT)
+            {
+                ble_app_conn_handle[(*(cy_stc_ble_conn_handle_t *)eventParam).attId] = *(cy_stc_ble_conn_handle_t *)eventParam;
+                negotiatedMtu[(*(cy_stc_ble_conn_handle_t *)eventParam).attId] = DEFAULT_MTU_SIZE;
+            }
             BLE_DBG_PRINTF("CY_BLE_EVT_GATT_CONNECT_IND: %x, %x \r\n", 
                 (*(cy_stc_ble_conn_handle_t *)eventParam).attId, (*(cy_stc_ble_conn_handle_t *)eventParam).bdHandle);
+            if(ble_app_boot.link_pending)
+            {
+                /* Skip the negotiation of the central which knew the device before the reset */
+                ble_app_boot.link_pending = false;
+                (void)ble_app_connection_param_update_request((*(cy_stc_ble_conn_handle_t *)eventParam).attId, \
+                    ble_retain_get()->link.interval_min, \
+                    ble_retain_get()->link.interval_max, ble_retain_get()->link.slave_latency, \
+                    ble_retain_get()->link.timeout_multiplier);
+            }
             break;
             
         /* This event is received when device is disconnected */
@@ -432,8 +958,12 @@ static void ble_app_callback(uint32_t event, void* eventParam)
             break;
             
         case CY_BLE_EVT_GATTS_XCNHG_MTU_REQ:
-            negotiatedMtu = (((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->mtu < CY_BLE_GATT_MTU) ?
-                        ((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->mtu : CY_BLE_GATT_MTU;
+            if(((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->connHandle.attId < CY_BLE_CONN_COUNT)
+            {
+                negotiatedMtu[((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->connHandle.attId] =
+                    (((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->mtu < CY_BLE_GATT_MTU) ?
+                    ((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->mtu : CY_BLE_GATT_MTU;
+            }
             BLE_DBG_PRINTF("CY_BLE_EVT_GATTS_XCNHG_MTU_REQ mtu=%d\r\n", ((cy_stc_ble_gatt_xchg_mtu_param_t *)eventParam)->mtu);
             break;
             
@@ -473,6 +1003,7 @@ static void ble_app_callback(uint32_t event, void* eventParam)
             * structures are modified and require to be stored in Flash using 
             * Cy_BLE_StoreBondingData() */
             BLE_DBG_PRINTF("CY_BLE_EVT_PENDING_FLASH_WRITE\r\n");
+            ble_event_post(BLE_EVENT_FLASH);
             break;
             
         default:
@@ -482,6 +1013,52 @@ static void ble_app_callback(uint32_t event, void* eventParam)
     
     /* Custom host interface event callback */
     ble_custom_hi_service_evt_callback(event, eventParam);
+#if (ENABLE_EVENT_TRACE_FUNCTION == ENABLED)
+    ble_trace_end(trace);
+#endif
+#if (ENABLE_STACK_DEPTH_FUNCTION == ENABLED)
+    ble_ram_end(event, stack);
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_app_stack_init
+****************************************************************************//**
+*
+* Initializes and enables the BLE stack, the stack on event follows.
+*
+* \param None
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_app_stack_init(void)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    /* Registers the generic callback functions  */
+    Cy_BLE_RegisterEventCallback(ble_app_callback);
+    /* Registers the callback to post the stack processing event */
+    Cy_BLE_RegisterAppHostCallback(ble_app_host_callback);
+
+    /* Initializes the BLE host */
+    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_Init(&cy_ble_config))) {
+        BLE_DBG_PRINTF("Cy_BLE_Init API Error: ");
+        ble_print_api_result(apiResult);
+        return apiResult;
+    }
+
+    /* Enables BLE */
+    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_Enable())) {
+        BLE_DBG_PRINTF("Cy_BLE_Enable API Error: ");
+        ble_print_api_result(apiResult);
+        return apiResult;
+    }
+
+    /* Enables BLE Low-power mode (LPM)*/
+    Cy_BLE_EnableLowPowerMode();
+    return apiResult;
 }
 
 /*******************************************************************************
@@ -503,22 +1080,57 @@ cy_en_ble_api_result_t ble_app_init(void)
     
     /* Initialize Debug UART for BLE */
     BLE_UART_START();
-    /* \x1b[2J\x1b[;H - ANSI ESC sequence for clear screen */
-    BLE_DBG_PRINTF("\x1b[2J\x1b[;H");
-    BLE_DBG_PRINTF("****************************************************************\r\n");
-    BLE_DBG_PRINTF("*                  PSoC6 Custom Service Demo                   *\r\n");
-    BLE_DBG_PRINTF("****************************************************************\r\n");
-
-#if (CY_BLE_CONTR_CORE == CY_CPU_CORTEX_M4)
-    BLE_DBG_PRINTF("BLE stack controller on CM4 core, ");
-#else
-    BLE_DBG_PRINTF("BLE stack controller on CM0+ core, ");
+    /* Initialize the time base for the statistics */
+    (void)ble_time_init();
+    ble_timer_init();
+    ble_task_init();
+    ble_trace_init();
+    ble_ram_init();
+    ble_power_init();
+    ble_event_reset_stats();
+    /* Take the retained state of a soft reset */
+    memset(&ble_app_boot, 0, sizeof(ble_app_boot));
+    ble_app_boot.start = ble_time_now();
+    ble_app_boot.warm = ble_retain_init();
+    if(ble_app_boot.warm && ble_retain_get()->keys_valid) {
+        keyInfo.SecKeyParam = ble_retain_get()->keys;
+        keysReady = true;
+    }
+    ble_app_boot.link_pending = ble_app_boot.warm && ble_retain_get()->link_valid;
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+    memset(&ble_app_adv, 0, sizeof(ble_app_adv));
+    ble_app_adv.policy.fast_ms = BLE_APP_ADV_FAST_MS;
+    ble_app_adv.policy.slow_ms = BLE_APP_ADV_SLOW_MS;
+    ble_app_adv.policy.pause_ms = BLE_APP_ADV_PAUSE_MS;
+    ble_app_adv.policy.pause_max_ms = BLE_APP_ADV_PAUSE_MAX_MS;
+    ble_app_adv.mode = BLE_APP_ADV_MODE_NONE;
 #endif
-#if (CY_BLE_HOST_CORE == CY_CPU_CORTEX_M4)
-    BLE_DBG_PRINTF("host on CM4 core\r\n");
-#else
-    BLE_DBG_PRINTF("host on CM0+ core\r\n");
+#if (BLE_DEBUG_UART_ENABLED == ENABLED)
+    /* Post the run loop event on the debug UART data received */
+    cyhal_uart_register_callback(&cy_retarget_io_uart_obj, ble_app_uart_callback, NULL);
+    cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY, BLE_UART_INTR_PRIORITY, true);
 #endif
+    if(ble_app_boot.warm) {
+        /* The banner was printed by the cold boot */
+        BLE_DBG_PRINTF("Warm boot, %d bonds retained\r\n", ble_retain_get()->bond_count);
+    } else {
+        /* \x1b[2J\x1b[;H - ANSI ESC sequence for clear screen */
+        BLE_DBG_PRINTF("\x1b[2J\x1b[;H");
+        BLE_DBG_PRINTF("****************************************************************\r\n");
+        BLE_DBG_PRINTF("*                  PSoC6 Custom Service Demo                   *\r\n");
+        BLE_DBG_PRINTF("****************************************************************\r\n");
+
+    #if (CY_BLE_CONTR_CORE == CY_CPU_CORTEX_M4)
+        BLE_DBG_PRINTF("BLE stack controller on CM4 core, ");
+    #else
+        BLE_DBG_PRINTF("BLE stack controller on CM0+ core, ");
+    #endif
+    #if (CY_BLE_HOST_CORE == CY_CPU_CORTEX_M4)
+        BLE_DBG_PRINTF("host on CM4 core\r\n");
+    #else
+        BLE_DBG_PRINTF("host on CM0+ core\r\n");
+    #endif
+    }
 
 #if (CY_BLE_CONTR_CORE == CY_CPU_CORTEX_M4)
     static const cy_stc_sysint_t bless_isr_config =
@@ -535,26 +1147,13 @@ cy_en_ble_api_result_t ble_app_init(void)
     cy_ble_config.hw->blessIsrConfig = &bless_isr_config;
 #endif
 
-    /* Registers the generic callback functions  */
-    Cy_BLE_RegisterEventCallback(ble_app_callback);
-
-    /* Initializes the BLE host */
-    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_Init(&cy_ble_config))) {
-        BLE_DBG_PRINTF("Cy_BLE_Init API Error: ");
-        ble_print_api_result(apiResult);
+    if(CY_BLE_SUCCESS != (apiResult = ble_app_stack_init())) {
         return apiResult;
     }
-
-    /* Enables BLE */
-    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_Enable())) {
-        BLE_DBG_PRINTF("Cy_BLE_Enable API Error: ");
-        ble_print_api_result(apiResult);
+    if(ble_app_boot.warm) {
         return apiResult;
     }
 
-    /* Enables BLE Low-power mode (LPM)*/
-    Cy_BLE_EnableLowPowerMode();
-
     /* Output current stack version to UART */
     apiResult = Cy_BLE_GetStackLibraryVersion(&stackVersion);
     if(apiResult != CY_BLE_SUCCESS) {
@@ -567,10 +1166,13 @@ cy_en_ble_api_result_t ble_app_init(void)
 }
 
 /*******************************************************************************
-* Function Name: ble_app_task
+* Function Name: ble_app_restart_advertisement
 ****************************************************************************//**
 *
-* BLE application task.
+* Restarts the advertisement when the stack is on, the advertisement is
+* stopped and another central can connect. With the adaptive advertising the
+* mode follows the phase: a running advertisement of another mode is stopped
+* first and none is started during a pause.
 *
 * \param none.
 *
@@ -578,25 +1180,37 @@ cy_en_ble_api_result_t ble_app_init(void)
 * see \ref cy_en_ble_api_result_t.
 *
 *******************************************************************************/
-cy_en_ble_api_result_t ble_app_task(void)
+static cy_en_ble_api_result_t ble_app_restart_advertisement(void)
 {
     cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
-    
-    /* Cy_BLE_ProcessEvents() allows BLE stack to process pending events */
-    Cy_BLE_ProcessEvents();
-    
-    /* To achieve low power in the device */
-    if(BLE_UART_DEB_IS_TX_COMPLETE() != 0u) {
-        /* Entering into the Deep Sleep */
-        Cy_SysPm_DeepSleep(CY_SYSPM_WAIT_FOR_INTERRUPT);
+    uint8_t mode = CY_BLE_ADVERTISING_FAST;
+
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+    if(Cy_BLE_GetState() != CY_BLE_STATE_ON) {
+        return CY_BLE_SUCCESS;
     }
-    
-    /* Restart the advertisement */
+    if((Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_STOPPED) && !ble_app_adv.discovering && \
+       (Cy_BLE_GetNumOfActiveConn() < CY_BLE_CONN_COUNT)) {
+        ble_app_adv_discover();
+    }
+    mode = (ble_app_adv.phase == BLE_APP_ADV_PHASE_FAST) ? CY_BLE_ADVERTISING_FAST : \
+           (ble_app_adv.phase == BLE_APP_ADV_PHASE_SLOW) ? CY_BLE_ADVERTISING_SLOW : BLE_APP_ADV_MODE_NONE;
+    if((Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_ADVERTISING) && (mode != ble_app_adv.mode)) {
+        /* Restarted in the new mode on the stop event */
+        return Cy_BLE_GAPP_StopAdvertisement();
+    }
+    if(mode == BLE_APP_ADV_MODE_NONE) {
+        return CY_BLE_SUCCESS;
+    }
+#endif
     if((Cy_BLE_GetState() == CY_BLE_STATE_ON) \
         && (Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_STOPPED) \
-        && (Cy_BLE_GetNumOfActiveConn() < 1))
+        && (Cy_BLE_GetNumOfActiveConn() < CY_BLE_CONN_COUNT))
     {
-        apiResult = Cy_BLE_GAPP_StartAdvertisement(CY_BLE_ADVERTISING_FAST, CY_BLE_PERIPHERAL_CONFIGURATION_0_INDEX);
+        apiResult = Cy_BLE_GAPP_StartAdvertisement(mode, CY_BLE_PERIPHERAL_CONFIGURATION_0_INDEX);
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+        ble_app_adv.mode = mode;
+#endif
         if(apiResult != CY_BLE_SUCCESS)
         {
             BLE_DBG_PRINTF("Task StartAdvertisement API Error: ");
@@ -605,28 +1219,118 @@ cy_en_ble_api_result_t ble_app_task(void)
         BLE_DBG_PRINTF("Task StartAdvertisement\r\n");
         Cy_BLE_ProcessEvents();
     }
-    
-    /* Restart timer */
-    #if ENABLE_BLE_MAIN_TIMER == ENABLED
-    if(mainTimer != 0u)
-    {
-        mainTimer = 0u;
-        Cy_BLE_StartTimer(&timerParam);
-    }
-    #endif
-    
-    /* Store bonding data to flash only when all debug information has been sent */
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_store_bonding_data
+****************************************************************************//**
+*
+* Stores the pending bonding data to flash.
+*
+* \param none.
+*
+* \return true if the bonding data are still pending.
+*
+*******************************************************************************/
+static bool ble_app_store_bonding_data(void)
+{
     #if(CY_BLE_BONDING_REQUIREMENT == CY_BLE_BONDING_YES)
+    cy_en_ble_api_result_t apiResult;
+
     if(cy_ble_pendingFlashWrite != 0u) 
     {
         apiResult = Cy_BLE_StoreBondingData();
         BLE_DBG_PRINTF("Store bonding data, status: %x, pending: %x \r\n", apiResult, cy_ble_pendingFlashWrite);
+        if(cy_ble_pendingFlashWrite == 0u)
+        {
+            ble_app_retain_bonds();
+        }
     }
+    return (cy_ble_pendingFlashWrite != 0u);
+    #else
+    return false;
     #endif /* CY_BLE_BONDING_REQUIREMENT == CY_BLE_BONDING_YES */
+}
+
+/*******************************************************************************
+* Function Name: ble_app_task
+****************************************************************************//**
+*
+* BLE application task.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_task(void)
+{
+    uint32_t intr;
+
+    /* Cy_BLE_ProcessEvents() allows BLE stack to process pending events */
+    Cy_BLE_ProcessEvents();
+    
+    /* To achieve low power in the device */
+    intr = Cy_SysLib_EnterCriticalSection();
+    if(ble_power_select() == BLE_POWER_MODE_DEEPSLEEP) {
+        /* Entering into the Deep Sleep */
+        (void)ble_power_enter(BLE_POWER_MODE_DEEPSLEEP);
+    }
+    Cy_SysLib_ExitCriticalSection(intr);
+    
+    /* Restart the advertisement */
+    (void)ble_app_restart_advertisement();
+    
+    /* Process the software timers */
+    ble_timer_process();
+    
+    /* Store bonding data to flash only when all debug information has been sent */
+    (void)ble_app_store_bonding_data();
     
     return CY_BLE_SUCCESS;
 }
 
+/*******************************************************************************
+* Function Name: ble_app_process_events
+****************************************************************************//**
+*
+* BLE application handler of the run loop events. Unlike ble_app_task(), the
+* stack and advertisement states are checked only when the related event is
+* posted, and the caller sleeps in ble_event_wait().
+*
+* \param events The event flags returned by ble_event_wait().
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_process_events(uint32_t events)
+{
+    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+
+    /* Cy_BLE_ProcessEvents() allows BLE stack to process pending events */
+    if(0u != (events & BLE_EVENT_STACK)) {
+        Cy_BLE_ProcessEvents();
+    }
+    /* Restart the advertisement */
+    if(0u != (events & BLE_EVENT_ADV)) {
+        apiResult = ble_app_restart_advertisement();
+    }
+    /* Process the software timers */
+    if(0u != (events & BLE_EVENT_TIMER)) {
+        ble_timer_process();
+    }
+    /* Store bonding data to flash, continue in the next pass if it is not done */
+    if(0u != (events & BLE_EVENT_FLASH)) {
+        if(ble_app_store_bonding_data()) {
+            ble_event_post(BLE_EVENT_FLASH);
+        }
+    }
+    return apiResult;
+}
+
 /*******************************************************************************
 * Function Name: ble_app_stop
 ****************************************************************************//**
@@ -660,11 +1364,188 @@ cy_en_ble_api_result_t ble_app_stop(void)
     return apiResult;
 }
 
+/*******************************************************************************
+* Function Name: ble_app_stop_task_func
+****************************************************************************//**
+*
+* The task of ble_app_stop_start(), disables the stack and waits until it is stopped.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_app_stop_task_func(ble_task_t *task)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    BLE_TASK_BEGIN(task);
+    apiResult = Cy_BLE_Disable();
+    if(apiResult != CY_BLE_SUCCESS)
+    {
+        BLE_DBG_PRINTF("Cy_BLE_Stop API Error: ");
+        ble_print_api_result(apiResult);
+        BLE_TASK_EXIT(task, apiResult);
+    }
+    BLE_DBG_PRINTF("Wait for the BLE to Stop\r\n");
+    BLE_TASK_WAIT_UNTIL(task, BLE_EVENT_STACK, CY_BLE_STATE_STOPPED == Cy_BLE_GetState());
+    BLE_DBG_PRINTF("BLE Stopped!\r\n");
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_stop_start
+****************************************************************************//**
+*
+* Starts to shut down the BLE Stack like ble_app_stop(), but returns at once and
+* the main loop keeps running while the stack is stopping.
+*
+* \param done The completion callback, it can be NULL.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_stop_start(ble_task_done_t done)
+{
+    return ble_task_start(&ble_app_stop_task, "stop", ble_app_stop_task_func, done, NULL);
+}
+
+#if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+/*******************************************************************************
+* Function Name: ble_app_recover_fail
+****************************************************************************//**
+*
+* Ends a recovery which could not restart the stack, the device is reset.
+*
+* \param apiResult The result of the failed step.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_recover_fail(cy_en_ble_api_result_t apiResult)
+{
+    ble_app_recovery.stats.failures++;
+    BLE_DBG_PRINTF("Stack recovery failed: ");
+    ble_print_api_result(apiResult);
+    /* The bonds and keys are kept by the warm boot */
+    ble_retain_soft_reset();
+}
+
+/*******************************************************************************
+* Function Name: ble_app_recover_task_func
+****************************************************************************//**
+*
+* The task of ble_app_recover_start(), stores the pending bonds, stops the
+* stack, ends the lost connections and starts the stack again. Unlike
+* ble_app_stop() it does not wait for the debug UART.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_app_recover_task_func(ble_task_t *task)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    BLE_TASK_BEGIN(task);
+    /* The bonds not stored yet are lost with the stack */
+    BLE_TASK_WAIT_UNTIL_TIMEOUT(task, BLE_EVENT_STACK | BLE_EVENT_FLASH, !ble_app_store_bonding_data(), \
+                                BLE_APP_RECOVERY_FLASH_TIMEOUT_MS);
+    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_Disable())) {
+        ble_app_recover_fail(apiResult);
+        BLE_TASK_EXIT(task, apiResult);
+    }
+    BLE_TASK_WAIT_UNTIL_TIMEOUT(task, BLE_EVENT_STACK, CY_BLE_STATE_STOPPED == Cy_BLE_GetState(), \
+                                BLE_APP_RECOVERY_STOP_TIMEOUT_MS);
+    if(BLE_TASK_TIMED_OUT(task)) {
+        ble_app_recover_fail(CY_BLE_ERROR_INVALID_OPERATION);
+        BLE_TASK_EXIT(task, CY_BLE_ERROR_INVALID_OPERATION);
+    }
+    /* The connections are gone without the disconnection events */
+    ble_custom_hi_stack_reset();
+    if(ble_app_conn_update.state == BLE_APP_CONN_UPDATE_PENDING) {
+        ble_app_conn_update.state = BLE_APP_CONN_UPDATE_DISCONNECTED;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_app_stack_init())) {
+        ble_app_recover_fail(apiResult);
+        BLE_TASK_EXIT(task, apiResult);
+    }
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_recover_start
+****************************************************************************//**
+*
+* Starts a recovery of the stack after a hardware error. The stack is stopped
+* and started again while the main loop keeps running; the bonds, the keys
+* and the application queues are kept, the connections are lost. A hardware
+* error during a recovery is part of it.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_recover_start(void)
+{
+    if(ble_task_is_running(&ble_app_recovery.task)) {
+        return CY_BLE_SUCCESS;
+    }
+    ble_app_recovery.start = ble_time_now();
+    ble_app_recovery.active = true;
+    ble_app_recovery.stats.recoveries++;
+    return ble_task_start(&ble_app_recovery.task, "recover", ble_app_recover_task_func, NULL, NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_recovery_get_stats
+****************************************************************************//**
+*
+* Gets the stack recovery statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_recovery_get_stats(ble_app_recovery_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_app_recovery.stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_recovery_print_stats
+****************************************************************************//**
+*
+* Prints the stack recovery statistics.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_recovery_print_stats(void)
+{
+    BLE_DBG_PRINTF("Recovery: recoveries=%lu, failures=%lu, last=%lu us, max=%lu us\r\n", \
+        (unsigned long)ble_app_recovery.stats.recoveries, (unsigned long)ble_app_recovery.stats.failures, \
+        (unsigned long)ble_app_recovery.stats.last_us, (unsigned long)ble_app_recovery.stats.max_us);
+}
+#endif /* (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED) */
+
 /*******************************************************************************
 * Function Name: ble_app_connection_param_update_request
 ****************************************************************************//**
 *
-* Request the peer Central device to update the connection parameters.
+* Request the peer Central device of a connection to update the connection
+* parameters.
+*
+* \param conn_id       The connection ID (attId).
 *
 * \param interval_min  Minimum value for the connection event interval. This shall be less than
 *                      or equal to conn_Interval_Max. Minimum connection interval will be
@@ -684,7 +1565,7 @@ cy_en_ble_api_result_t ble_app_stop(void)
 * see \ref cy_en_ble_api_result_t.
 *
 *******************************************************************************/
-cy_en_ble_api_result_t ble_app_connection_param_update_request(uint16_t interval_min, \
+cy_en_ble_api_result_t ble_app_connection_param_update_request(uint8_t conn_id, uint16_t interval_min, \
     uint16_t interval_max, uint16_t slave_latency, uint16_t timeout_multiplier)
 {
     cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
@@ -696,13 +1577,13 @@ cy_en_ble_api_result_t ble_app_connection_param_update_request(uint16_t interval
         BLE_DBG_PRINTF("ble_app_connection_param_update_request Input param error\r\n");
         return CY_BLE_ERROR_INVALID_PARAMETER;
     }
-    if((Cy_BLE_GetConnectionState(ble_app_conn_handle) != CY_BLE_CONN_STATE_CONNECTED) \
-        && (Cy_BLE_GetNumOfActiveConn() < 1))
+    if((conn_id >= CY_BLE_CONN_COUNT) || \
+       (Cy_BLE_GetConnectionState(ble_app_conn_handle[conn_id]) != CY_BLE_CONN_STATE_CONNECTED))
     {
         BLE_DBG_PRINTF("ble_app_connection_param_update_request No connection\r\n");
         return CY_BLE_ERROR_NO_CONNECTION;
     }
-    param.bdHandle = ble_app_conn_handle.bdHandle;
+    param.bdHandle = ble_app_conn_handle[conn_id].bdHandle;
     param.connIntvMin = interval_min;
     param.connIntvMax = interval_max;
     param.connLatency = slave_latency;
@@ -715,20 +1596,388 @@ cy_en_ble_api_result_t ble_app_connection_param_update_request(uint16_t interval
     return apiResult;
 }
 
+/*******************************************************************************
+* Function Name: ble_app_conn_update_task_func
+****************************************************************************//**
+*
+* The task of ble_app_connection_param_update_start(), sends the request and
+* waits until the controller updates the connection or the peer rejects it.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_app_conn_update_task_func(ble_task_t *task)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    BLE_TASK_BEGIN(task);
+    ble_app_conn_update.bdHandle = ble_app_conn_handle[ble_app_conn_update.conn_id].bdHandle;
+    ble_app_conn_update.state = BLE_APP_CONN_UPDATE_PENDING;
+    apiResult = ble_app_connection_param_update_request(ble_app_conn_update.conn_id, ble_app_conn_update.interval_min, \
+        ble_app_conn_update.interval_max, ble_app_conn_update.slave_latency, ble_app_conn_update.timeout_multiplier);
+    if(apiResult != CY_BLE_SUCCESS)
+    {
+        ble_app_conn_update.state = BLE_APP_CONN_UPDATE_IDLE;
+        BLE_TASK_EXIT(task, apiResult);
+    }
+    BLE_TASK_WAIT_UNTIL_TIMEOUT(task, BLE_EVENT_STACK, ble_app_conn_update.state != BLE_APP_CONN_UPDATE_PENDING, \
+                                BLE_APP_CONN_UPDATE_TIMEOUT_MS);
+    if(ble_app_conn_update.state == BLE_APP_CONN_UPDATE_DONE)
+    {
+        apiResult = CY_BLE_SUCCESS;
+    }
+    else if(ble_app_conn_update.state == BLE_APP_CONN_UPDATE_DISCONNECTED)
+    {
+        apiResult = CY_BLE_ERROR_NO_CONNECTION;
+    }
+    else if(BLE_TASK_TIMED_OUT(task))
+    {
+        BLE_DBG_PRINTF("Connection parameter update timeout\r\n");
+        apiResult = CY_BLE_ERROR_INVALID_STATE;
+    }
+    else
+    {
+        apiResult = CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    ble_app_conn_update.state = BLE_APP_CONN_UPDATE_IDLE;
+    BLE_TASK_EXIT(task, apiResult);
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_connection_param_update_start
+****************************************************************************//**
+*
+* Requests the connection parameter update like ble_app_connection_param_update_request(),
+* and waits for the result in a task. The result passed to the callback is
+* CY_BLE_SUCCESS when the connection is updated, CY_BLE_ERROR_INVALID_OPERATION
+* when the peer rejects it and CY_BLE_ERROR_INVALID_STATE on the timeout.
+*
+* \param conn_id       See ble_app_connection_param_update_request().
+*
+* \param interval_min  See ble_app_connection_param_update_request().
+*
+* \param interval_max  See ble_app_connection_param_update_request().
+*
+* \param slave_latency See ble_app_connection_param_update_request().
+*
+* \param timeout_multiplier See ble_app_connection_param_update_request().
+*
+* \param done The completion callback, it can be NULL.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_connection_param_update_start(uint8_t conn_id, uint16_t interval_min, \
+    uint16_t interval_max, uint16_t slave_latency, uint16_t timeout_multiplier, ble_task_done_t done)
+{
+    if(ble_task_is_running(&ble_app_conn_update_task))
+    {
+        return CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    if(conn_id >= CY_BLE_CONN_COUNT)
+    {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    ble_app_conn_update.conn_id = conn_id;
+    ble_app_conn_update.interval_min = interval_min;
+    ble_app_conn_update.interval_max = interval_max;
+    ble_app_conn_update.slave_latency = slave_latency;
+    ble_app_conn_update.timeout_multiplier = timeout_multiplier;
+    return ble_task_start(&ble_app_conn_update_task, "conn_update", ble_app_conn_update_task_func, done, NULL);
+}
+
 /*******************************************************************************
 * Function Name: ble_app_negotiate_mtu
 ****************************************************************************//**
 *
-* Get the negotiate mtu size.
+* Get the negotiate mtu size of a connection.
 *
-* \param none
+* \param conn_id The connection ID (attId).
 *
 * \return Return the negotiate mtu size.
 *
 *******************************************************************************/
-uint16_t ble_app_negotiate_mtu(void)
+uint16_t ble_app_negotiate_mtu(uint8_t conn_id)
+{
+    return (conn_id < CY_BLE_CONN_COUNT) ? negotiatedMtu[conn_id] : DEFAULT_MTU_SIZE;
+}
+
+#if (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED)
+/*******************************************************************************
+* Function Name: ble_app_broadcast_disc
+****************************************************************************//**
+*
+* Gets the discovery data of the advertising configuration, the status is
+* written into its buffers which the stack reads.
+*
+* \param none.
+*
+* \return The discovery data.
+*
+*******************************************************************************/
+static cy_stc_ble_gapp_disc_mode_info_t *ble_app_broadcast_disc(void)
+{
+    return &cy_ble_config.discoveryModeInfo[CY_BLE_PERIPHERAL_CONFIGURATION_0_INDEX];
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_element
+****************************************************************************//**
+*
+* Writes the header of a service data AD element.
+*
+* \param buf The element.
+*
+* \param uuid The 16-bit service UUID.
+*
+* \param len The status bytes of the element.
+*
+* \return The element size.
+*
+*******************************************************************************/
+static uint8_t ble_app_broadcast_element(uint8_t *buf, uint16_t uuid, uint8_t len)
+{
+    buf[0] = (uint8_t)(BLE_APP_BROADCAST_AD_HEADER_LEN - 1u + len);
+    buf[1] = BLE_APP_BROADCAST_AD_TYPE;
+    buf[2] = (uint8_t)uuid;
+    buf[3] = (uint8_t)(uuid >> 8u);
+    memset(&buf[BLE_APP_BROADCAST_AD_HEADER_LEN], 0, len);
+    return (uint8_t)(BLE_APP_BROADCAST_AD_HEADER_LEN + len);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_apply
+****************************************************************************//**
+*
+* Copies the pending status into the AD elements in place and, while
+* advertising, gives the new data to the stack. The advertisement is not
+* restarted; when it is not running the data is sent once it starts again.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_app_broadcast_apply(void)
+{
+    cy_stc_ble_gapp_disc_mode_info_t *disc = ble_app_broadcast_disc();
+    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+    uint32_t start = ble_time_now();
+    uint32_t cost;
+
+    memcpy(&disc->advData->advData[ble_app_broadcast.adv_base + BLE_APP_BROADCAST_AD_HEADER_LEN], \
+           ble_app_broadcast.status, ble_app_broadcast.adv_len);
+    if(ble_app_broadcast.scan_len != 0u) {
+        memcpy(&disc->scanRspData->scanRspData[ble_app_broadcast.scan_base + BLE_APP_BROADCAST_AD_HEADER_LEN], \
+               &ble_app_broadcast.status[ble_app_broadcast.adv_len], ble_app_broadcast.scan_len);
+    }
+    ble_app_broadcast.pending = false;
+    ble_app_broadcast.last = ble_timer_now();
+    ble_app_broadcast.stats.updates++;
+    if(Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_ADVERTISING) {
+        if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GAPP_UpdateAdvScanData(disc))) {
+            ble_app_broadcast.stats.errors++;
+        }
+        cost = BLE_TIME_TICKS_TO_US(ble_time_now() - start);
+        ble_app_broadcast.stats.cost_last_us = cost;
+        if(cost > ble_app_broadcast.stats.cost_max_us) {
+            ble_app_broadcast.stats.cost_max_us = cost;
+        }
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_timer_callback
+****************************************************************************//**
+*
+* Applies the status deferred by the minimum update interval.
+*
+* \param arg Not used.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_app_broadcast_timer_callback(void *arg)
+{
+    (void)arg;
+    if(ble_app_broadcast.active && ble_app_broadcast.pending) {
+        (void)ble_app_broadcast_apply();
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_start
+****************************************************************************//**
+*
+* Starts the status broadcast, the service data elements are appended to the
+* configured advertising and scan response data, with a zero status until
+* ble_app_broadcast_set() is called. A host which only needs the status can
+* read it from a scan without connecting.
+*
+* \param uuid The 16-bit service UUID of the service data.
+*
+* \param len The status size, fixed while the broadcast runs.
+*
+* \return Return value indicates if the function succeeded or failed.
+* CY_BLE_ERROR_INSUFFICIENT_RESOURCES is returned when the status does not fit.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_broadcast_start(uint16_t uuid, uint8_t len)
+{
+    cy_stc_ble_gapp_disc_mode_info_t *disc = ble_app_broadcast_disc();
+    uint8_t adv_room = 0u;
+    uint8_t scan_room = 0u;
+
+    if((len == 0u) || (disc->advData == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(ble_app_broadcast.active) {
+        ble_app_broadcast_stop();
+    }
+    ble_app_broadcast.adv_base = disc->advData->advDataLen;
+    if((ble_app_broadcast.adv_base + BLE_APP_BROADCAST_AD_HEADER_LEN) < CY_BLE_GAP_MAX_ADV_DATA_LEN) {
+        adv_room = CY_BLE_GAP_MAX_ADV_DATA_LEN - BLE_APP_BROADCAST_AD_HEADER_LEN - ble_app_broadcast.adv_base;
+    }
+    if(disc->scanRspData != NULL) {
+        ble_app_broadcast.scan_base = disc->scanRspData->scanRspDataLen;
+        if((ble_app_broadcast.scan_base + BLE_APP_BROADCAST_AD_HEADER_LEN) < CY_BLE_GAP_MAX_SCAN_RSP_DATA_LEN) {
+            scan_room = CY_BLE_GAP_MAX_SCAN_RSP_DATA_LEN - BLE_APP_BROADCAST_AD_HEADER_LEN - ble_app_broadcast.scan_base;
+        }
+    }
+    if((adv_room == 0u) || (len > (adv_room + scan_room))) {
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    ble_app_broadcast.adv_len = (len < adv_room) ? len : adv_room;
+    ble_app_broadcast.scan_len = len - ble_app_broadcast.adv_len;
+    disc->advData->advDataLen += ble_app_broadcast_element(&disc->advData->advData[ble_app_broadcast.adv_base], \
+                                                           uuid, ble_app_broadcast.adv_len);
+    if(ble_app_broadcast.scan_len != 0u) {
+        disc->scanRspData->scanRspDataLen += ble_app_broadcast_element( \
+            &disc->scanRspData->scanRspData[ble_app_broadcast.scan_base], uuid, ble_app_broadcast.scan_len);
+    }
+    memset(ble_app_broadcast.status, 0, sizeof(ble_app_broadcast.status));
+    memset(&ble_app_broadcast.stats, 0, sizeof(ble_app_broadcast.stats));
+    ble_app_broadcast.active = true;
+    return ble_app_broadcast_apply();
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_set
+****************************************************************************//**
+*
+* Updates the broadcast status. The update is applied at once unless the
+* last one is younger than BLE_APP_BROADCAST_MIN_INTERVAL_MS, then the latest
+* status is applied when the interval elapses. An update copies the status in
+* place and hands it to the stack, the advertisement keeps running.
+*
+* \param status The status of the size given to ble_app_broadcast_start().
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_broadcast_set(const uint8_t *status)
+{
+    uint32_t age;
+
+    if(status == NULL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(!ble_app_broadcast.active) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    if(ble_app_broadcast.pending) {
+        ble_app_broadcast.stats.coalesced++;
+    }
+    memcpy(ble_app_broadcast.status, status, ble_app_broadcast.adv_len + ble_app_broadcast.scan_len);
+    ble_app_broadcast.pending = true;
+    age = ble_timer_now() - ble_app_broadcast.last;
+    if(age >= BLE_APP_BROADCAST_MIN_INTERVAL_MS) {
+        return ble_app_broadcast_apply();
+    }
+    if(!ble_timer_is_active(&ble_app_broadcast.timer)) {
+        ble_app_broadcast.stats.deferred++;
+        ble_timer_start(&ble_app_broadcast.timer, BLE_APP_BROADCAST_MIN_INTERVAL_MS - age, 0u, \
+                        ble_app_broadcast_timer_callback, NULL);
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_stop
+****************************************************************************//**
+*
+* Stops the status broadcast, the configured advertising and scan response
+* data are restored.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_broadcast_stop(void)
+{
+    cy_stc_ble_gapp_disc_mode_info_t *disc = ble_app_broadcast_disc();
+
+    if(!ble_app_broadcast.active) {
+        return;
+    }
+    ble_timer_stop(&ble_app_broadcast.timer);
+    ble_app_broadcast.active = false;
+    ble_app_broadcast.pending = false;
+    disc->advData->advDataLen = ble_app_broadcast.adv_base;
+    if(ble_app_broadcast.scan_len != 0u) {
+        disc->scanRspData->scanRspDataLen = ble_app_broadcast.scan_base;
+    }
+    if(Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_ADVERTISING) {
+        (void)Cy_BLE_GAPP_UpdateAdvScanData(disc);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_get_stats
+****************************************************************************//**
+*
+* Gets the status broadcast statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_broadcast_get_stats(ble_app_broadcast_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_app_broadcast.stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_broadcast_print_stats
+****************************************************************************//**
+*
+* Prints the status broadcast statistics.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_app_broadcast_print_stats(void)
 {
-    return negotiatedMtu;
+    BLE_DBG_PRINTF("Broadcast %s: updates=%lu, deferred=%lu, coalesced=%lu, errors=%lu, cost=%lu us (max %lu us)\r\n", \
+        ble_app_broadcast.active ? "on" : "off", (unsigned long)ble_app_broadcast.stats.updates, \
+        (unsigned long)ble_app_broadcast.stats.deferred, (unsigned long)ble_app_broadcast.stats.coalesced, \
+        (unsigned long)ble_app_broadcast.stats.errors, (unsigned long)ble_app_broadcast.stats.cost_last_us, \
+        (unsigned long)ble_app_broadcast.stats.cost_max_us);
 }
+#endif /* (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED) */
 
 /* [] END OF FILE */
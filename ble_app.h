@@ -17,6 +17,8 @@
 
 #include "ble_common.h"
 #include "ble_custom_hi.h"
+#include "ble_event.h"
+#include "ble_task.h"
 
 /* The C binding of definitions if building with the C++ compiler */
 #ifdef __cplusplus
@@ -26,20 +28,143 @@ extern "C" {
 /***************************************
 * Macro definitions
 ***************************************/
+/**
+ * @brief The status broadcast: the status is carried by a service data AD
+ *        element (16-bit UUID) appended to the advertising data, the bytes
+ *        which do not fit follow in a second element of the scan response.
+ *        | len(1) | 0x16 | UUID(2, little endian) | status |
+ */
+#define BLE_APP_BROADCAST_AD_TYPE           (0x16u)
+#define BLE_APP_BROADCAST_AD_HEADER_LEN     (4u)
+#define BLE_APP_BROADCAST_STATUS_MAX        ((CY_BLE_GAP_MAX_ADV_DATA_LEN - BLE_APP_BROADCAST_AD_HEADER_LEN) + \
+                                             (CY_BLE_GAP_MAX_SCAN_RSP_DATA_LEN - BLE_APP_BROADCAST_AD_HEADER_LEN))
+
+/**
+ * @brief The minimum time between two updates of the advertising data, the
+ *        status given in between is sent when it elapses.
+ */
+#define BLE_APP_BROADCAST_MIN_INTERVAL_MS   (1000u)
+
+/**
+ * @brief The default advertising policy, see ble_app_adv_policy_t.
+ */
+#define BLE_APP_ADV_FAST_MS                 (30000u)
+#define BLE_APP_ADV_SLOW_MS                 (60000u)
+#define BLE_APP_ADV_PAUSE_MS                (10000u)
+#define BLE_APP_ADV_PAUSE_MAX_MS            (300000u)
+
+/**
+ * @brief The time-to-connect histogram, bucket n counts the connections made
+ *        within (BLE_APP_ADV_TTC_BASE_MS << n) ms of the start of the
+ *        discovery, the last bucket counts the later ones.
+ */
+#define BLE_APP_ADV_TTC_BASE_MS             (250u)
+#define BLE_APP_ADV_TTC_BUCKETS             (10u)
+
+/**
+ * @brief The time given to the stack to stop during a recovery, the device
+ *        is reset if it does not.
+ */
+#define BLE_APP_RECOVERY_STOP_TIMEOUT_MS    (50u)
 
 /***************************************
 * Data Types
 ***************************************/
+/**
+ * @brief The advertising phases: a discovery starts with the fast phase and
+ *        then alternates slow phases and pauses until a central connects.
+ *        The phases are timed here, so the advertising timeouts of the
+ *        configuration should be long enough not to end them earlier.
+ */
+typedef enum
+{
+    BLE_APP_ADV_PHASE_FAST = 0,
+    BLE_APP_ADV_PHASE_SLOW,
+    BLE_APP_ADV_PHASE_PAUSE,
+    BLE_APP_ADV_PHASE_NUM
+} ble_app_adv_phase_t;
+
+/**
+ * @brief The advertising policy, the times are in ms.
+ */
+typedef struct
+{
+    uint32_t fast_ms;                   /* The fast phase length */
+    uint32_t slow_ms;                   /* The slow phase length, 0 to stay slow until a central connects */
+    uint32_t pause_ms;                  /* The first pause after a slow phase, doubled after each pause */
+    uint32_t pause_max_ms;              /* The back-off limit of the pause */
+} ble_app_adv_policy_t;
+
+/**
+ * @brief The adaptive advertising statistics.
+ */
+typedef struct
+{
+    uint32_t discoveries;                           /* Fast phases started, wakes included */
+    uint32_t wakes;                                 /* ble_app_adv_wake() calls */
+    uint32_t phases[BLE_APP_ADV_PHASE_NUM];         /* The entries of each phase */
+    uint32_t connects[BLE_APP_ADV_PHASE_NUM];       /* The connections made in each phase */
+    uint32_t ttc_hist[BLE_APP_ADV_TTC_BUCKETS];     /* The time-to-connect histogram */
+    uint32_t ttc_max_ms;
+    uint32_t ttc_total_ms;
+} ble_app_adv_stats_t;
+
+/**
+ * @brief The status broadcast statistics.
+ */
+typedef struct
+{
+    uint32_t updates;                   /* Status updates applied */
+    uint32_t deferred;                  /* Updates delayed by the minimum interval */
+    uint32_t coalesced;                 /* Updates replaced by a later one before being applied */
+    uint32_t errors;                    /* Cy_BLE_GAPP_UpdateAdvScanData() failures */
+    uint32_t cost_last_us;              /* The time of the last update while advertising */
+    uint32_t cost_max_us;
+} ble_app_broadcast_stats_t;
+
+/**
+ * @brief The stack recovery statistics, the time is from the hardware error
+ *        to the restart of the advertisement.
+ */
+typedef struct
+{
+    uint32_t recoveries;                /* Recoveries started */
+    uint32_t failures;                  /* Recoveries which could not restart the stack */
+    uint32_t last_us;                   /* The time of the last recovery */
+    uint32_t max_us;
+} ble_app_recovery_stats_t;
 
 /***************************************
 * Public Function Prototypes
 ***************************************/
 cy_en_ble_api_result_t ble_app_init(void);
 cy_en_ble_api_result_t ble_app_task(void);
+cy_en_ble_api_result_t ble_app_process_events(uint32_t events);
 cy_en_ble_api_result_t ble_app_stop(void);
-cy_en_ble_api_result_t ble_app_connection_param_update_request(uint16_t interval_min, \
+cy_en_ble_api_result_t ble_app_stop_start(ble_task_done_t done);
+cy_en_ble_api_result_t ble_app_connection_param_update_request(uint8_t conn_id, uint16_t interval_min, \
                         uint16_t interval_max, uint16_t slave_latency, uint16_t timeout_multiplier);
-uint16_t ble_app_negotiate_mtu(void);
+cy_en_ble_api_result_t ble_app_connection_param_update_start(uint8_t conn_id, uint16_t interval_min, \
+                        uint16_t interval_max, uint16_t slave_latency, uint16_t timeout_multiplier, ble_task_done_t done);
+uint16_t ble_app_negotiate_mtu(uint8_t conn_id);
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+cy_en_ble_api_result_t ble_app_adv_set_policy(const ble_app_adv_policy_t *policy);
+void ble_app_adv_wake(void);
+void ble_app_adv_get_stats(ble_app_adv_stats_t *stats);
+void ble_app_adv_print_stats(void);
+#endif
+#if (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED)
+cy_en_ble_api_result_t ble_app_broadcast_start(uint16_t uuid, uint8_t len);
+cy_en_ble_api_result_t ble_app_broadcast_set(const uint8_t *status);
+void ble_app_broadcast_stop(void);
+void ble_app_broadcast_get_stats(ble_app_broadcast_stats_t *stats);
+void ble_app_broadcast_print_stats(void);
+#endif
+#if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+cy_en_ble_api_result_t ble_app_recover_start(void);
+void ble_app_recovery_get_stats(ble_app_recovery_stats_t *stats);
+void ble_app_recovery_print_stats(void);
+#endif
 
 #ifdef __cplusplus
 }
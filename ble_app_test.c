@@ -14,31 +14,986 @@
 *******************************************************************************/
 
 #include "ble_app.h"
+#include "ble_custom_cmd.h"
+#include "ble_timer.h"
+#include "ble_time.h"
+#include "ble_pool.h"
+#include "ble_rtos.h"
+#include "ble_ipc.h"
+#include "ble_power.h"
+#include "ble_seal.h"
+#include "ble_delta.h"
+#include "ble_retain.h"
+#include "ble_trace.h"
+#include "ble_bench.h"
+#include "ble_ram.h"
 
-/* BLE custom service command received buffer */
-static custom_command_buf_t ble_custom_cmd_buf;
+/**
+ * @brief The opcodes of the test commands.
+ */
+#define BLE_APP_TEST_OPCODE_ECHO            (0x01u)
+#define BLE_APP_TEST_OPCODE_STATS           (0x02u)
+#define BLE_APP_TEST_OPCODE_WORKER          (0x10u)    /* Offloaded to the worker task or the IPC peer */
+
+#if (ENABLE_TEST_MODE_FUNCTION == ENABLED)
+/**
+ * @brief The opcodes of the test modes.
+ *        Mode request:      | 0x03 | mode(1) | frames(4), optional |
+ *        Mode response:     | 0x03 | status | ble_app_test_result_t of the mode which ends |
+ *        Sink request:      | 0x04 | seq(4) | data(n) |, no response
+ *        RTT request:       | 0x05 | seq(4) | data(n) |
+ *        RTT response:      | 0x05 | status | seq(4) | data(n) | device time(4) |
+ *        Generator frame:   | 0x06 | status | seq(4) | pattern(n) |
+ *        The generator frames fill the notification payload, frames is their
+ *        number, 0 streams until the mode changes. The device time is
+ *        ble_time_now(), BLE_TIME_TICK_HZ. The result of a generator which
+ *        ends by itself is sent as an unsolicited mode response.
+ */
+#define BLE_APP_TEST_OPCODE_MODE            (0x03u)
+#define BLE_APP_TEST_OPCODE_SINK            (0x04u)
+#define BLE_APP_TEST_OPCODE_RTT             (0x05u)
+#define BLE_APP_TEST_OPCODE_PATTERN         (0x06u)
+
+/**
+ * @brief The test modes.
+ */
+#define BLE_APP_TEST_MODE_IDLE              (0u)
+#define BLE_APP_TEST_MODE_GENERATOR         (1u)
+#define BLE_APP_TEST_MODE_SINK              (2u)
+#define BLE_APP_TEST_MODE_RTT               (3u)
+#define BLE_APP_TEST_MODE_NUM               (4u)
+
+/**
+ * @brief The size of the sequence number and of the device time.
+ */
+#define BLE_APP_TEST_SEQ_LEN                (4u)
+#define BLE_APP_TEST_TIME_LEN               (4u)
+
+/**
+ * @brief The generator checks the connection at least this often.
+ */
+#define BLE_APP_TEST_GEN_POLL_MS            (100u)
+#endif
+
+/**
+ * @brief The payload size and the count of the sealing benchmark.
+ */
+#define BLE_APP_TEST_SEAL_BENCH_LEN         (244u)
+#define BLE_APP_TEST_SEAL_BENCH_COUNT       (200u)
+
+/**
+ * @brief The number of log lines of the test dump.
+ */
+#define BLE_APP_TEST_DUMP_LINES             (48u)
+
+/**
+ * @brief The delta encoded status response type and its keyframe interval.
+ */
+#define BLE_APP_TEST_DELTA_STATUS           (0u)
+#define BLE_APP_TEST_DELTA_KEYFRAME_INTERVAL (16u)
+
+/**
+ * @brief The service UUID and the size of the broadcast status:
+ *        | connections(1) | sleep permille(2) | run loop wakeups(4) |
+ */
+#define BLE_APP_TEST_BROADCAST_UUID         (0xFFF0u)
+#define BLE_APP_TEST_BROADCAST_LEN          (7u)
+
+#if defined(COMPONENT_FREERTOS)
+/**
+ * @brief The stack size in words and the priority of the worker task.
+ */
+#define BLE_APP_TEST_WORKER_STACK_SIZE      (1024u / sizeof(StackType_t))
+#define BLE_APP_TEST_WORKER_PRIORITY        (tskIDLE_PRIORITY + 1u)
+#endif
+
+/*******************************************************************************
+* Function Name: ble_app_test_echo_handler
+****************************************************************************//**
+*
+* \brief The echo command handler, returns the request payload.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_app_test_echo_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    memcpy(res, req, req_len);
+    *res_len = req_len;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_stats_handler
+****************************************************************************//**
+*
+* \brief The statistics command handler, returns ble_custom_cmd_stats_t of
+*  the opcode in the request.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_app_test_stats_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    ble_custom_cmd_stats_t stats;
+
+    if((req_len != 1u) || (CY_BLE_SUCCESS != ble_custom_cmd_get_stats(req[0], &stats))) {
+        return BLE_CUSTOM_CMD_STATUS_FAILED;
+    }
+    memcpy(res, &stats, sizeof(stats));
+    *res_len = sizeof(stats);
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+#if (ENABLE_TEST_MODE_FUNCTION == ENABLED)
+/**
+ * @brief The result of a test mode, sent in the mode response.
+ */
+typedef struct
+{
+    uint8_t  mode;
+    uint8_t  conn_id;
+    uint16_t payload;                   /* The notification payload size */
+    uint32_t duration_ms;               /* From the first to the last packet */
+    uint32_t packets;
+    uint32_t bytes;
+    uint32_t throughput_bps;
+    uint32_t lost;                      /* The sequence numbers skipped */
+    uint32_t out_of_order;              /* The sequence numbers repeated or going back */
+    uint32_t rtt_min_us;                /* The interval of the RTT requests in sequence */
+    uint32_t rtt_avg_us;
+    uint32_t rtt_max_us;
+} ble_app_test_result_t;
+
+/**
+ * @brief The test mode state. The RTT is taken as the interval of the echo
+ *        requests in sequence, the round trip of a host which waits for each
+ *        echo before the next request.
+ */
+static struct
+{
+    ble_task_t task;                    /* The pattern generator */
+    uint8_t  mode;
+    uint8_t  conn_id;
+    uint32_t frames;                    /* The generator frames, 0 until the mode changes */
+    uint32_t seq;                       /* The next sequence number sent or expected */
+    uint32_t first;                     /* The time of the first packet */
+    uint32_t last;                      /* The time of the last packet */
+    uint32_t sent;                      /* The notifications of the connection at the last check */
+    uint32_t rtt_min;
+    uint32_t rtt_max;
+    uint64_t rtt_total;
+    uint32_t rtt_count;
+    ble_app_test_result_t result;
+    uint8_t  pattern[BLE_CUSTOM_RES_BUFFER_SIZE];
+} ble_app_test_mode;
+
+/**
+ * @brief The names of the test modes.
+ */
+static const char * const ble_app_test_mode_names[BLE_APP_TEST_MODE_NUM] =
+{
+    "idle",
+    "generator",
+    "sink",
+    "rtt"
+};
+
+/*******************************************************************************
+* Function Name: ble_app_test_mode_receive
+****************************************************************************//**
+*
+* \brief Counts a packet of the sink or the RTT echo and checks its sequence
+*  number.
+*
+* \param seq  The sequence number.
+*
+* \param len  The packet size.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_mode_receive(uint32_t seq, uint16_t len)
+{
+    uint32_t now = ble_time_now();
+    int32_t gap = (int32_t)(seq - ble_app_test_mode.seq);
+    uint32_t interval;
+
+    if(ble_app_test_mode.result.packets == 0u) {
+        ble_app_test_mode.first = now;
+        gap = 0;
+    } else if(gap > 0) {
+        ble_app_test_mode.result.lost += (uint32_t)gap;
+    } else if(gap < 0) {
+        ble_app_test_mode.result.out_of_order++;
+    } else if(ble_app_test_mode.mode == BLE_APP_TEST_MODE_RTT) {
+        interval = now - ble_app_test_mode.last;
+        if(interval < ble_app_test_mode.rtt_min) {
+            ble_app_test_mode.rtt_min = interval;
+        }
+        if(interval > ble_app_test_mode.rtt_max) {
+            ble_app_test_mode.rtt_max = interval;
+        }
+        ble_app_test_mode.rtt_total += interval;
+        ble_app_test_mode.rtt_count++;
+    }
+    if(gap >= 0) {
+        ble_app_test_mode.seq = seq + 1u;
+    }
+    ble_app_test_mode.result.packets++;
+    ble_app_test_mode.result.bytes += len;
+    ble_app_test_mode.last = now;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_mode_get_result
+****************************************************************************//**
+*
+* \brief Gets the result of the current test mode.
+*
+* \param result The result is copied here.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_mode_get_result(ble_app_test_result_t *result)
+{
+    uint32_t ticks = ble_app_test_mode.last - ble_app_test_mode.first;
+
+    *result = ble_app_test_mode.result;
+    result->mode = ble_app_test_mode.mode;
+    result->conn_id = ble_app_test_mode.conn_id;
+    result->payload = ble_custom_hi_get_payload_size(ble_app_test_mode.conn_id);
+    result->duration_ms = BLE_TIME_TICKS_TO_MS(ticks);
+    if(ticks != 0u) {
+        result->throughput_bps = (uint32_t)(((uint64_t)result->bytes * 8u * BLE_TIME_TICK_HZ) / ticks);
+    }
+    if(ble_app_test_mode.rtt_count != 0u) {
+        result->rtt_min_us = BLE_TIME_TICKS_TO_US(ble_app_test_mode.rtt_min);
+        result->rtt_avg_us = BLE_TIME_TICKS_TO_US(ble_app_test_mode.rtt_total / ble_app_test_mode.rtt_count);
+        result->rtt_max_us = BLE_TIME_TICKS_TO_US(ble_app_test_mode.rtt_max);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_mode_print
+****************************************************************************//**
+*
+* \brief Prints the result of a test mode.
+*
+* \param result The result.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_mode_print(const ble_app_test_result_t *result)
+{
+    BLE_DBG_PRINTF("Test %s: conn %d, payload %d, packets=%lu, bytes=%lu in %lu ms, %lu bps, lost=%lu, " \
+        "out of order=%lu\r\n", ble_app_test_mode_names[result->mode], result->conn_id, result->payload, \
+        (unsigned long)result->packets, (unsigned long)result->bytes, (unsigned long)result->duration_ms, \
+        (unsigned long)result->throughput_bps, (unsigned long)result->lost, (unsigned long)result->out_of_order);
+    if(result->mode == BLE_APP_TEST_MODE_RTT) {
+        BLE_DBG_PRINTF("  rtt min=%lu us, avg=%lu us, max=%lu us\r\n", (unsigned long)result->rtt_min_us, \
+            (unsigned long)result->rtt_avg_us, (unsigned long)result->rtt_max_us);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_mode_end
+****************************************************************************//**
+*
+* \brief Ends the current test mode, its result is printed.
+*
+* \param result The result is copied here.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_mode_end(ble_app_test_result_t *result)
+{
+    ble_task_cancel(&ble_app_test_mode.task);
+    ble_app_test_mode_get_result(result);
+    if(ble_app_test_mode.mode != BLE_APP_TEST_MODE_IDLE) {
+        ble_app_test_mode_print(result);
+    }
+    ble_app_test_mode.mode = BLE_APP_TEST_MODE_IDLE;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_gen_sent
+****************************************************************************//**
+*
+* \brief Checks if the connection sent notifications since the last check,
+*  the transmit queue has room again.
+*
+* \param None
+*
+* \return true if notifications were sent.
+*
+*******************************************************************************/
+static bool ble_app_test_gen_sent(void)
+{
+    ble_custom_hi_conn_stats_t stats;
+
+    if((CY_BLE_SUCCESS != ble_custom_hi_get_conn_stats(ble_app_test_mode.conn_id, &stats)) || \
+       (stats.packets == ble_app_test_mode.sent)) {
+        return false;
+    }
+    ble_app_test_mode.sent = stats.packets;
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_gen_send
+****************************************************************************//**
+*
+* \brief Queues the next frame of the pattern generator, it fills the
+*  notification payload.
+*
+* \param None
+*
+* \return Return value indicates if the function succeeded or failed.
+*  CY_BLE_ERROR_INSUFFICIENT_RESOURCES is returned when the lane is full.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_app_test_gen_send(void)
+{
+    uint8_t header[BLE_CUSTOM_CMD_RES_HEADER_LEN + BLE_APP_TEST_SEQ_LEN];
+    ble_custom_hi_iov_t iov[2];
+    cy_en_ble_api_result_t apiResult;
+    uint16_t payload = ble_custom_hi_get_payload_size(ble_app_test_mode.conn_id);
+    uint32_t now = ble_time_now();
+
+    if(payload > (sizeof(header) + sizeof(ble_app_test_mode.pattern))) {
+        payload = sizeof(header) + sizeof(ble_app_test_mode.pattern);
+    }
+    if(payload < sizeof(header)) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    header[0] = BLE_APP_TEST_OPCODE_PATTERN;
+    header[1] = BLE_CUSTOM_CMD_STATUS_OK;
+    memcpy(&header[BLE_CUSTOM_CMD_RES_HEADER_LEN], &ble_app_test_mode.seq, BLE_APP_TEST_SEQ_LEN);
+    iov[0].base = header;
+    iov[0].len = sizeof(header);
+    iov[1].base = ble_app_test_mode.pattern;
+    iov[1].len = payload - sizeof(header);
+    apiResult = ble_custom_hi_response_queue(ble_app_test_mode.conn_id, BLE_CUSTOM_HI_LANE_BULK, iov, 2u);
+    if(apiResult == CY_BLE_SUCCESS) {
+        if(ble_app_test_mode.result.packets == 0u) {
+            ble_app_test_mode.first = now;
+        }
+        ble_app_test_mode.result.packets++;
+        ble_app_test_mode.result.bytes += payload;
+        ble_app_test_mode.last = now;
+        ble_app_test_mode.seq++;
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_gen_task_func
+****************************************************************************//**
+*
+* \brief The pattern generator, queues frames while the bulk lane takes them
+*  and waits for the notifications to be sent when it is full.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_app_test_gen_task_func(ble_task_t *task)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    BLE_TASK_BEGIN(task);
+    while((ble_app_test_mode.frames == 0u) || (ble_app_test_mode.seq < ble_app_test_mode.frames)) {
+        if(!ble_custom_hi_is_connected(ble_app_test_mode.conn_id)) {
+            BLE_TASK_EXIT(task, CY_BLE_ERROR_NO_CONNECTION);
+        }
+        apiResult = ble_app_test_gen_send();
+        if(apiResult == CY_BLE_ERROR_INSUFFICIENT_RESOURCES) {
+            (void)ble_app_test_gen_sent();
+            BLE_TASK_WAIT_UNTIL_TIMEOUT(task, BLE_EVENT_TX | BLE_EVENT_STACK, ble_app_test_gen_sent(), \
+                                        BLE_APP_TEST_GEN_POLL_MS);
+        } else if(apiResult != CY_BLE_SUCCESS) {
+            BLE_TASK_EXIT(task, apiResult);
+        }
+    }
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_gen_done
+****************************************************************************//**
+*
+* \brief The completion callback of the pattern generator, the result is sent
+*  as an unsolicited mode response.
+*
+* \param task The task.
+*
+* \param result The task result.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_gen_done(ble_task_t *task, cy_en_ble_api_result_t result)
+{
+    uint8_t res[BLE_CUSTOM_CMD_RES_HEADER_LEN + sizeof(ble_app_test_result_t)];
+    const ble_custom_hi_iov_t iov = { .base = res, .len = sizeof(res) };
+    ble_app_test_result_t ended;
+
+    BLE_DBG_PRINTF("Task %s done: 0x%x\r\n", task->name, result);
+    ble_app_test_mode_end(&ended);
+    res[0] = BLE_APP_TEST_OPCODE_MODE;
+    res[1] = (result == CY_BLE_SUCCESS) ? BLE_CUSTOM_CMD_STATUS_OK : BLE_CUSTOM_CMD_STATUS_FAILED;
+    memcpy(&res[BLE_CUSTOM_CMD_RES_HEADER_LEN], &ended, sizeof(ended));
+    (void)ble_custom_hi_response_queue(ended.conn_id, BLE_CUSTOM_HI_LANE_CONTROL, &iov, 1u);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_mode_start
+****************************************************************************//**
+*
+* \brief Ends the current test mode and starts another one.
+*
+* \param mode     The test mode, see BLE_APP_TEST_MODE_xxx.
+*
+* \param conn_id  The connection ID.
+*
+* \param frames   The generator frames, 0 until the mode changes.
+*
+* \param ended    The result of the mode which ends is copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_app_test_mode_start(uint8_t mode, uint8_t conn_id, uint32_t frames, \
+                                                      ble_app_test_result_t *ended)
+{
+    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+    uint32_t i;
+
+    if((mode >= BLE_APP_TEST_MODE_NUM) || (conn_id >= BLE_CUSTOM_HI_CONN_NUM)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    ble_app_test_mode_end(ended);
+    memset(&ble_app_test_mode.result, 0, sizeof(ble_app_test_mode.result));
+    ble_app_test_mode.conn_id = conn_id;
+    ble_app_test_mode.frames = frames;
+    ble_app_test_mode.seq = 0u;
+    ble_app_test_mode.first = ble_time_now();
+    ble_app_test_mode.last = ble_app_test_mode.first;
+    ble_app_test_mode.rtt_min = UINT32_MAX;
+    ble_app_test_mode.rtt_max = 0u;
+    ble_app_test_mode.rtt_total = 0u;
+    ble_app_test_mode.rtt_count = 0u;
+    ble_app_test_mode.mode = mode;
+    if(mode == BLE_APP_TEST_MODE_GENERATOR) {
+        for(i = 0u; i < sizeof(ble_app_test_mode.pattern); i++) {
+            ble_app_test_mode.pattern[i] = (uint8_t)i;
+        }
+        (void)ble_app_test_gen_sent();
+        apiResult = ble_task_start(&ble_app_test_mode.task, "generator", ble_app_test_gen_task_func, \
+                                   ble_app_test_gen_done, NULL);
+        if(apiResult != CY_BLE_SUCCESS) {
+            ble_app_test_mode.mode = BLE_APP_TEST_MODE_IDLE;
+        }
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_mode_handler
+****************************************************************************//**
+*
+* \brief The test mode command handler, returns the result of the mode which
+*  ends.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_app_test_mode_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    ble_app_test_result_t ended;
+    uint32_t frames = 0u;
+
+    if((req_len != 1u) && (req_len != (1u + sizeof(frames)))) {
+        return BLE_CUSTOM_CMD_STATUS_INVALID_LEN;
+    }
+    if(req_len > 1u) {
+        memcpy(&frames, &req[1], sizeof(frames));
+    }
+    if(req[0] >= BLE_APP_TEST_MODE_NUM) {
+        return BLE_CUSTOM_CMD_STATUS_FAILED;
+    }
+    if(CY_BLE_SUCCESS != ble_app_test_mode_start(req[0], ble_custom_cmd_get_conn(), frames, &ended)) {
+        return BLE_CUSTOM_CMD_STATUS_FAILED;
+    }
+    memcpy(res, &ended, sizeof(ended));
+    *res_len = sizeof(ended);
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
 
 /*******************************************************************************
-* Function Name: ble_custom_command_callback
+* Function Name: ble_app_test_sink_handler
 ****************************************************************************//**
 *
-* \brief The callback function handler for BLE custom service command receivced.
+* \brief The sink command handler, counts the data written in the sink mode.
+*  The command has no response.
 *
-* \param len  Received len
+* \param req      The request payload.
 *
-* \param cmd  point to the data buffer
+* \param req_len  The request payload size.
+*
+* \param res      Not used.
+*
+* \param res_len  Not used.
+*
+* \return The status, counted in the command statistics.
+*
+*******************************************************************************/
+static uint8_t ble_app_test_sink_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    uint32_t seq;
+
+    (void)res;
+    (void)res_len;
+    if((req_len < BLE_APP_TEST_SEQ_LEN) || (ble_app_test_mode.mode != BLE_APP_TEST_MODE_SINK) || \
+       (ble_custom_cmd_get_conn() != ble_app_test_mode.conn_id)) {
+        return BLE_CUSTOM_CMD_STATUS_FAILED;
+    }
+    memcpy(&seq, req, sizeof(seq));
+    ble_app_test_mode_receive(seq, BLE_CUSTOM_CMD_REQ_HEADER_LEN + req_len);
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_rtt_handler
+****************************************************************************//**
+*
+* \brief The RTT echo command handler, returns the request payload with the
+*  device time. The requests are counted in the RTT mode.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_app_test_rtt_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    uint32_t now = ble_time_now();
+    uint32_t seq;
+
+    if(req_len < BLE_APP_TEST_SEQ_LEN) {
+        return BLE_CUSTOM_CMD_STATUS_INVALID_LEN;
+    }
+    if((ble_app_test_mode.mode == BLE_APP_TEST_MODE_RTT) && \
+       (ble_custom_cmd_get_conn() == ble_app_test_mode.conn_id)) {
+        memcpy(&seq, req, sizeof(seq));
+        ble_app_test_mode_receive(seq, BLE_CUSTOM_CMD_REQ_HEADER_LEN + req_len);
+    }
+    memcpy(res, req, req_len);
+    memcpy(&res[req_len], &now, BLE_APP_TEST_TIME_LEN);
+    *res_len = req_len + BLE_APP_TEST_TIME_LEN;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+#endif /* (ENABLE_TEST_MODE_FUNCTION == ENABLED) */
+
+/**
+ * @brief The test command table.
+ */
+static const ble_custom_cmd_desc_t ble_app_test_cmd_table[] =
+{
+    {
+        .opcode      = BLE_APP_TEST_OPCODE_ECHO,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE,
+        .max_req_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .max_res_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .handler     = ble_app_test_echo_handler
+    },
+    {
+        .opcode      = BLE_APP_TEST_OPCODE_STATS,
+        .flags       = 0u,
+        .max_req_len = 1u,
+        .max_res_len = sizeof(ble_custom_cmd_stats_t),
+        .handler     = ble_app_test_stats_handler
+    },
+#if (ENABLE_TEST_MODE_FUNCTION == ENABLED)
+    {
+        .opcode      = BLE_APP_TEST_OPCODE_MODE,
+        .flags       = 0u,
+        .max_req_len = 1u + sizeof(uint32_t),
+        .max_res_len = sizeof(ble_app_test_result_t),
+        .handler     = ble_app_test_mode_handler
+    },
+    {
+        .opcode      = BLE_APP_TEST_OPCODE_SINK,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE | BLE_CUSTOM_CMD_FLAG_NO_RESPONSE,
+        .max_req_len = BLE_CUSTOM_CMD_REQ_PAYLOAD_MAX,
+        .max_res_len = 0u,
+        .handler     = ble_app_test_sink_handler
+    },
+    {
+        .opcode      = BLE_APP_TEST_OPCODE_RTT,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE,
+        .max_req_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX - BLE_APP_TEST_TIME_LEN,
+        .max_res_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .handler     = ble_app_test_rtt_handler
+    },
+#endif
+};
+
+/**
+ * @brief The image of the delta encoded status response.
+ */
+typedef struct
+{
+    ble_event_stats_t run;
+    ble_timer_stats_t timers;
+} ble_app_test_status_t;
+
+/**
+ * @brief The delta encoded response types.
+ */
+static const ble_delta_desc_t ble_app_test_delta_table[] =
+{
+    {
+        .type              = BLE_APP_TEST_DELTA_STATUS,
+        .size              = sizeof(ble_app_test_status_t),
+        .keyframe_interval = BLE_APP_TEST_DELTA_KEYFRAME_INTERVAL
+    },
+};
+
+/*******************************************************************************
+* Function Name: ble_app_test_task_done
+****************************************************************************//**
+*
+* \brief The completion callback of the console started tasks.
+*
+* \param task The task.
+*
+* \param result The task result.
 *
 * \return None
 *
 *******************************************************************************/
-static void ble_custom_command_callback(uint32_t len, void *cmd)
+static void ble_app_test_task_done(ble_task_t *task, cy_en_ble_api_result_t result)
 {
-    if(true == ble_custom_cmd_buf.receive_flag) {
-        return;
+    BLE_DBG_PRINTF("Task %s done: 0x%x\r\n", task->name, result);
+}
+
+#if defined(COMPONENT_FREERTOS) || defined(COMPONENT_BLESS_HOST_IPC)
+/*******************************************************************************
+* Function Name: ble_app_test_offload_handler
+****************************************************************************//**
+*
+* \brief The handler of the offloaded commands, runs in the worker task or on
+*  the IPC peer. The command frame is replaced with the response frame.
+*
+* \param buf   The command frame, the response frame is written here.
+*
+* \param len   The command frame size.
+*
+* \param size  The buffer size.
+*
+* \return The response frame size.
+*
+*******************************************************************************/
+static uint16_t ble_app_test_offload_handler(uint8_t *buf, uint16_t len, uint16_t size)
+{
+    uint16_t payload = len - BLE_CUSTOM_CMD_REQ_HEADER_LEN;
+
+    /* | opcode | payload | -> | opcode | status | payload | */
+    if(buf[0] != BLE_APP_TEST_OPCODE_WORKER) {
+        buf[1] = BLE_CUSTOM_CMD_STATUS_UNKNOWN;
+        payload = 0u;
+    } else {
+        if(payload > (size - BLE_CUSTOM_CMD_RES_HEADER_LEN)) {
+            payload = size - BLE_CUSTOM_CMD_RES_HEADER_LEN;
+        }
+        memmove(&buf[BLE_CUSTOM_CMD_RES_HEADER_LEN], &buf[BLE_CUSTOM_CMD_REQ_HEADER_LEN], payload);
+        buf[1] = BLE_CUSTOM_CMD_STATUS_OK;
     }
-    ble_custom_cmd_buf.len = len;
-    memcpy(ble_custom_cmd_buf.buf, (uint8_t *)cmd, len);
-    ble_custom_cmd_buf.receive_flag = true;
+    return BLE_CUSTOM_CMD_RES_HEADER_LEN + payload;
+}
+#endif
+
+/*******************************************************************************
+* Function Name: ble_app_test_console
+****************************************************************************//**
+*
+* \brief The debug console, handles the keys received by the debug UART.
+*  's' - print the run loop and timer statistics.
+*  'p' - print the power mode statistics.
+*  'r' - reset the run loop and power mode statistics.
+*  't' - print the task statistics.
+*  'u' - request the connection interval of 30 ~ 50 ms on the first connection.
+*  'i' - send a confirmed response to the first connection.
+*  'k' - seal the payloads of the first connection with the test key.
+*  'e' - run the sealing benchmark of the backends.
+*  'z' - send a compressed log dump to the first connection.
+*  'd' - send a delta encoded status to the first connection.
+*  'f' - send the next status of the first connection as a keyframe.
+*  'b' - start the status broadcast or update its status.
+*  'B' - stop the status broadcast.
+*  'w' - jump back to the fast advertising phase.
+*  'h' - restart the stack as on a hardware error.
+*  'R' - soft reset the device, the next boot is a warm boot.
+*  'T' - dump the event trace over the debug UART.
+*  'g' - send the event trace to the first connection.
+*  'x' - resume the event trace frozen by a hardware error.
+*  'n' - benchmark the transmit paths on the first connection.
+*  'l' - start or stop the pattern generator on the first connection.
+*  'm' - print the result of the current test mode.
+*  'M' - print the stack high water and the callback stack depths.
+*
+* \param none.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_console(void)
+{
+    #if (BLE_DEBUG_UART_ENABLED == ENABLED)
+    ble_event_stats_t stats;
+    ble_timer_stats_t timer_stats;
+#if defined(COMPONENT_FREERTOS)
+    ble_rtos_stats_t rtos_stats;
+#endif
+    static const uint8_t ping[] = { 'p', 'i', 'n', 'g' };
+    static const char * const dump_lines[] = {
+        "[INFO] conn 0: interval=30ms latency=0 timeout=500ms\r\n",
+        "[INFO] conn 0: mtu=247 notify=on\r\n",
+        "[WARN] conn 0: lane bulk full, response dropped\r\n",
+        "[INFO] conn 0: 1024 bytes sent in 12 notifications\r\n"
+    };
+    ble_custom_hi_iov_t dump[BLE_APP_TEST_DUMP_LINES];
+    ble_app_test_status_t status;
+#if (ENABLE_TEST_MODE_FUNCTION == ENABLED)
+    ble_app_test_result_t result;
+#endif
+#if (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED)
+    static bool broadcasting = false;
+    uint8_t bcast[BLE_APP_TEST_BROADCAST_LEN];
+#endif
+    uint32_t line;
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+    static const uint8_t seal_key[BLE_SEAL_KEY_LEN] = { 'b', 'l', 'e', '-', 'c', 'u', 's', 't', \
+                                                        'o', 'm', '-', 't', 'e', 's', 't', '!' };
+    static const uint8_t seal_iv[BLE_SEAL_IV_LEN] = { 0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u };
+#endif
+    uint8_t conn_id;
+    uint32_t key;
+
+    while(CY_SCB_UART_RX_NO_DATA != (key = BLE_UART_DEB_GET_CHAR())) {
+        switch(key)
+        {
+            case 's':
+                ble_event_get_stats(&stats);
+                BLE_DBG_PRINTF("Run loop: wakeups=%lu (%lu/s), posts=%lu, asleep=%lu.%lu%%\r\n", \
+                    (unsigned long)stats.wakeups, (unsigned long)stats.wakeups_per_sec, (unsigned long)stats.posts, \
+                    (unsigned long)(stats.sleep_permille / 10u), (unsigned long)(stats.sleep_permille % 10u));
+                ble_timer_get_stats(&timer_stats);
+                BLE_DBG_PRINTF("Timers: active=%lu, expired=%lu, wakeups=%lu, coalesced=%lu, cascades=%lu\r\n", \
+                    (unsigned long)timer_stats.active, (unsigned long)timer_stats.expired, \
+                    (unsigned long)timer_stats.wakeups, (unsigned long)timer_stats.coalesced, \
+                    (unsigned long)timer_stats.cascades);
+                ble_pool_print_stats();
+                ble_custom_hi_print_conn_stats();
+                ble_custom_hi_print_comp_stats();
+                ble_delta_print_stats();
+#if (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED)
+                ble_app_broadcast_print_stats();
+#endif
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+                ble_app_adv_print_stats();
+#endif
+#if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+                ble_app_recovery_print_stats();
+#endif
+                ble_retain_print_stats();
+                ble_ram_print_stats();
+#if (ENABLE_EVENT_TRACE_FUNCTION == ENABLED)
+                ble_trace_print_stats();
+#endif
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+                ble_seal_print_stats();
+#endif
+#if defined(COMPONENT_FREERTOS)
+                ble_rtos_get_stats(&rtos_stats);
+                BLE_DBG_PRINTF("Queues: commands=%lu (dropped %lu), responses=%lu (dropped %lu), retries=%lu, min free=%lu\r\n", \
+                    (unsigned long)rtos_stats.commands, (unsigned long)rtos_stats.commands_dropped, \
+                    (unsigned long)rtos_stats.responses, (unsigned long)rtos_stats.responses_dropped, \
+                    (unsigned long)rtos_stats.retries, (unsigned long)rtos_stats.msg_min_free);
+#endif
+#if defined(COMPONENT_BLESS_HOST_IPC)
+                ble_ipc_print_stats();
+#endif
+                break;
+            case 'p':
+                ble_power_print_stats();
+                break;
+            case 'r':
+                ble_event_reset_stats();
+                ble_power_reset_stats();
+                BLE_DBG_PRINTF("Run loop statistics reset\r\n");
+                break;
+            case 't':
+                ble_task_print_stats();
+                break;
+            case 'u':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Connection update %d: 0x%x\r\n", conn_id, \
+                    ble_app_connection_param_update_start(conn_id, 24u, 40u, 0u, 500u, ble_app_test_task_done));
+                break;
+            case 'i':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Confirmed response %d: 0x%x\r\n", conn_id, \
+                    ble_custom_hi_response_confirmed(conn_id, sizeof(ping), ping, ble_app_test_task_done));
+                break;
+            case 'z':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                for(line = 0u; line < BLE_APP_TEST_DUMP_LINES; line++) {
+                    dump[line].base = dump_lines[line % (sizeof(dump_lines) / sizeof(dump_lines[0]))];
+                    dump[line].len = (uint16_t)strlen(dump[line].base);
+                }
+                BLE_DBG_PRINTF("Compressed response %d: 0x%x\r\n", conn_id, \
+                    ble_custom_hi_response_compressed(conn_id, BLE_CUSTOM_HI_LANE_BULK, dump, BLE_APP_TEST_DUMP_LINES));
+                break;
+            case 'd':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                memset(&status, 0, sizeof(status));
+                ble_event_get_stats(&status.run);
+                ble_timer_get_stats(&status.timers);
+                BLE_DBG_PRINTF("Delta response %d: 0x%x\r\n", conn_id, \
+                    ble_custom_hi_response_delta(conn_id, BLE_CUSTOM_HI_LANE_CONTROL, BLE_APP_TEST_DELTA_STATUS, &status));
+                break;
+            case 'f':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Keyframe %d: 0x%x\r\n", conn_id, ble_delta_keyframe(conn_id, BLE_APP_TEST_DELTA_STATUS));
+                break;
+#if (ENABLE_STATUS_BROADCAST_FUNCTION == ENABLED)
+            case 'b':
+                if(!broadcasting) {
+                    broadcasting = (CY_BLE_SUCCESS == ble_app_broadcast_start(BLE_APP_TEST_BROADCAST_UUID, \
+                                                                              BLE_APP_TEST_BROADCAST_LEN));
+                }
+                ble_event_get_stats(&stats);
+                bcast[0] = Cy_BLE_GetNumOfActiveConn();
+                bcast[1] = (uint8_t)stats.sleep_permille;
+                bcast[2] = (uint8_t)(stats.sleep_permille >> 8u);
+                memcpy(&bcast[3], &stats.wakeups, sizeof(stats.wakeups));
+                BLE_DBG_PRINTF("Broadcast: 0x%x\r\n", ble_app_broadcast_set(bcast));
+                break;
+            case 'B':
+                ble_app_broadcast_stop();
+                broadcasting = false;
+                break;
+#endif
+#if (ENABLE_ADAPTIVE_ADV_FUNCTION == ENABLED)
+            case 'w':
+                ble_app_adv_wake();
+                break;
+#endif
+#if (ENABLE_STACK_RECOVERY_FUNCTION == ENABLED)
+            case 'h':
+                /* Recovers as on a hardware error */
+                BLE_DBG_PRINTF("Recovery: 0x%x\r\n", ble_app_recover_start());
+                break;
+#endif
+#if (ENABLE_EVENT_TRACE_FUNCTION == ENABLED)
+            case 'T':
+                ble_trace_dump_uart();
+                break;
+            case 'g':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Trace response %d: 0x%x\r\n", conn_id, \
+                    ble_trace_dump_gatt(conn_id, BLE_CUSTOM_HI_LANE_BULK, NULL));
+                break;
+            case 'x':
+                ble_trace_resume();
+                break;
+#endif
+#if (ENABLE_TEST_MODE_FUNCTION == ENABLED)
+            case 'l':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Generator %d: 0x%x\r\n", conn_id, ble_app_test_mode_start( \
+                    (ble_app_test_mode.mode == BLE_APP_TEST_MODE_GENERATOR) ? BLE_APP_TEST_MODE_IDLE : \
+                    BLE_APP_TEST_MODE_GENERATOR, conn_id, 0u, &result));
+                break;
+            case 'm':
+                ble_app_test_mode_get_result(&result);
+                ble_app_test_mode_print(&result);
+                break;
+#endif
+#if (ENABLE_BENCHMARK_FUNCTION == ENABLED)
+            case 'n':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Benchmark %d: 0x%x\r\n", conn_id, ble_bench_start(conn_id, BLE_BENCH_ALL, NULL));
+                break;
+#endif
+            case 'M':
+                ble_ram_print_stats();
+                break;
+            case 'R':
+                /* The next boot is a warm boot */
+                ble_retain_soft_reset();
+                break;
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+            case 'k':
+                for(conn_id = 0u; (conn_id < BLE_CUSTOM_HI_CONN_NUM) && !ble_custom_hi_is_connected(conn_id); conn_id++) {
+                }
+                BLE_DBG_PRINTF("Seal %d: 0x%x\r\n", conn_id, ble_seal_start(conn_id, seal_key, seal_iv));
+                break;
+            case 'e':
+                ble_seal_benchmark(BLE_APP_TEST_SEAL_BENCH_LEN, BLE_APP_TEST_SEAL_BENCH_COUNT);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+    #endif /* (BLE_DEBUG_UART_ENABLED == ENABLED) */
 }
 
 /*******************************************************************************
@@ -56,27 +1011,136 @@ static void ble_custom_command_callback(uint32_t len, void *cmd)
 cy_en_ble_api_result_t ble_app_test(void)
 {
     cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
-    ble_custom_hi_config_t custom_hi_config;
     
-    ble_custom_cmd_buf.receive_flag = false;
-    /* Initializes the custom host interface */
-    custom_hi_config.cmd_callback_func = ble_custom_command_callback;
-    ble_custom_hi_init(&custom_hi_config);
+    /* Initializes the custom command framework and host interface */
+    ble_custom_cmd_init();
+    ble_custom_cmd_register(ble_app_test_cmd_table, \
+                            sizeof(ble_app_test_cmd_table) / sizeof(ble_app_test_cmd_table[0]));
+    ble_delta_register(ble_app_test_delta_table, \
+                       sizeof(ble_app_test_delta_table) / sizeof(ble_app_test_delta_table[0]));
     /* Initializes the BLE application */
     if(CY_BLE_SUCCESS != (apiResult = ble_app_init())) {
         return apiResult;
     }
+#if defined(COMPONENT_BLESS_HOST_IPC)
+    /* Offloads the commands without a handler to the peer core */
+    if(CY_BLE_SUCCESS != (apiResult = ble_ipc_init())) {
+        return apiResult;
+    }
+#endif
     
     for(;;)
     {
-        /* Echo the received data to host */
-        if(ble_custom_cmd_buf.receive_flag) {
-            ble_custom_cmd_buf.receive_flag = false;
-            ble_custom_hi_response_fast(ble_custom_cmd_buf.len, ble_custom_cmd_buf.buf);
+        /* Sleep until an event is posted */
+        uint32_t events = ble_event_wait();
+        /* BLE application events: stack processing, advertisement, bonding data */
+        ble_app_process_events(events);
+        /* Dispatch the received commands and queue the responses, or the kept ones */
+        if(0u != (events & (BLE_EVENT_COMMAND | BLE_EVENT_TX))) {
+            ble_custom_cmd_task();
+        }
+#if defined(COMPONENT_FREERTOS)
+        /* Move the responses of the other tasks to the transmit queue */
+        if(0u != (events & (BLE_EVENT_QUEUE | BLE_EVENT_TX))) {
+            ble_rtos_process();
+        }
+#endif
+#if defined(COMPONENT_BLESS_HOST_IPC)
+        /* Handle the offloaded commands and queue the peer responses */
+        if(0u != (events & (BLE_EVENT_IPC | BLE_EVENT_TX))) {
+#if (BLE_IPC_PEER_LOOPBACK == ENABLED)
+            ble_ipc_peer_process(ble_app_test_offload_handler);
+#endif
+            ble_ipc_process();
+        }
+#endif
+        /* Send the queued responses to host */
+        if(0u != (events & (BLE_EVENT_TX | BLE_EVENT_COMMAND | BLE_EVENT_QUEUE | BLE_EVENT_IPC))) {
+            ble_custom_hi_tx_task();
+        }
+        /* Resume the tasks waiting for the events */
+        ble_task_run(events);
+        /* Debug console */
+        if(0u != (events & BLE_EVENT_UART)) {
+            ble_app_test_console();
+        }
+    }
+}
+
+#if defined(COMPONENT_FREERTOS)
+/*******************************************************************************
+* Function Name: ble_app_test_worker_task
+****************************************************************************//**
+*
+* \brief The worker task, handles the commands forwarded by the BLE task. The
+*  response is built in the pool block of the command message and submitted
+*  back.
+*
+* \param arg Not used.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_worker_task(void *arg)
+{
+    ble_rtos_msg_t *msg;
+
+    (void)arg;
+    for(;;)
+    {
+        msg = ble_rtos_command_receive(portMAX_DELAY);
+        if(msg == NULL) {
+            continue;
         }
-        /* BLE application task. */
-        ble_app_task();
+        msg->len = ble_app_test_offload_handler(msg->data, msg->len, ble_pool_block_size(msg->data));
+        (void)ble_rtos_response_submit(msg, BLE_CUSTOM_HI_LANE_BULK);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_ble_task
+****************************************************************************//**
+*
+* \brief The BLE task, runs the BLE application test.
+*
+* \param arg Not used.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_app_test_ble_task(void *arg)
+{
+    (void)arg;
+    (void)ble_app_test();
+    vTaskDelete(NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_app_test_rtos
+****************************************************************************//**
+*
+* BLE application test of the FreeRTOS build, creates the BLE task and the
+* worker task. vTaskStartScheduler() should be called after it.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_app_test_rtos(void)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    if(CY_BLE_SUCCESS != (apiResult = ble_rtos_init(ble_app_test_ble_task, NULL))) {
+        return apiResult;
+    }
+    if(pdPASS != xTaskCreate(ble_app_test_worker_task, "worker", BLE_APP_TEST_WORKER_STACK_SIZE, NULL, \
+                             BLE_APP_TEST_WORKER_PRIORITY, NULL)) {
+        return CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
     }
+    return CY_BLE_SUCCESS;
 }
+#endif /* defined(COMPONENT_FREERTOS) */
 
 /* [] END OF FILE */
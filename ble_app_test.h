@@ -34,6 +34,9 @@ extern "C" {
 * Public Function Prototypes
 ***************************************/
 cy_en_ble_api_result_t ble_app_test(void);
+#if defined(COMPONENT_FREERTOS)
+cy_en_ble_api_result_t ble_app_test_rtos(void);
+#endif
 
 
 #ifdef __cplusplus
@@ -0,0 +1,504 @@
+/***************************************************************************//**
+* \file ble_bench.c
+* \version 1.0
+*
+* \brief
+* Source file for the BLE custom service benchmark.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_bench.h"
+#include "ble_time.h"
+#include "ble_event.h"
+#include "ble_pool.h"
+
+/**
+ * @brief The sizes of the mixed scenario, clipped to the payload size.
+ */
+static const uint16_t ble_bench_sizes[] = { 1u, 8u, 20u, 64u, 100u, 128u, 200u, 0xFFFFu };
+
+/**
+ * @brief The names of the scenarios in the JSON report.
+ */
+static const char * const ble_bench_names[BLE_BENCH_SCENARIO_NUM] =
+{
+    "notify_stream",
+    "response_burst",
+    "mixed_sizes",
+    "indication"
+};
+
+/**
+ * @brief The benchmark state. A sample holds the time an operation was issued
+ *        until it completes, then its latency, both in ble_time ticks.
+ */
+static struct
+{
+    ble_task_t task;
+    uint8_t  conn_id;
+    uint8_t  scenario;              /* The running scenario */
+    uint8_t  last;                  /* The last scenario of the run */
+    uint16_t payload;
+    uint32_t issued;                /* The operations issued */
+    uint32_t done;                  /* The operations completed */
+    uint32_t base;                  /* The progress counter at the start */
+    uint32_t progress;              /* The progress counter at the last check */
+    uint32_t confirmed;             /* The indications confirmed */
+    uint32_t bytes;
+    uint32_t start;
+    uint32_t last_progress;         /* The time of the last progress */
+    uint32_t allocs;                /* The counters at the start */
+    ble_custom_hi_copy_stats_t copies;
+    cy_en_ble_api_result_t error;
+    uint32_t samples[BLE_BENCH_OPS];
+    uint8_t  pattern[BLE_CUSTOM_RES_BUFFER_SIZE];
+    ble_bench_result_t results[BLE_BENCH_SCENARIO_NUM];
+} ble_bench;
+
+
+/*******************************************************************************
+* Function Name: ble_bench_pool_allocs
+****************************************************************************//**
+*
+* Gets the allocations of all memory pool classes.
+*
+* \param none.
+*
+* \return The number of allocations.
+*
+*******************************************************************************/
+static uint32_t ble_bench_pool_allocs(void)
+{
+    ble_pool_stats_t stats;
+    uint32_t allocs = 0u;
+    uint32_t i;
+
+    for(i = 0u; i < BLE_POOL_CLASS_NUM; i++) {
+        if(CY_BLE_SUCCESS == ble_pool_get_stats(i, &stats)) {
+            allocs += stats.allocs;
+        }
+    }
+    return allocs;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_get_progress
+****************************************************************************//**
+*
+* Gets the progress counter of the running scenario: the stream bytes sent,
+* the notifications sent or the indications confirmed.
+*
+* \param none.
+*
+* \return The progress counter.
+*
+*******************************************************************************/
+static uint32_t ble_bench_get_progress(void)
+{
+    ble_custom_hi_stream_stats_t stream;
+    ble_custom_hi_conn_stats_t conn;
+
+    switch(ble_bench.scenario)
+    {
+        case BLE_BENCH_NOTIFY_STREAM:
+            (void)ble_custom_hi_get_stream_stats(&stream);
+            return stream.bytes_out;
+        case BLE_BENCH_INDICATION:
+            return ble_bench.confirmed;
+        default:
+            (void)ble_custom_hi_get_conn_stats(ble_bench.conn_id, &conn);
+            return conn.packets;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_get_mark
+****************************************************************************//**
+*
+* Gets the progress an operation is completed at, relative to the start.
+*
+* \param op The operation index.
+*
+* \return The progress mark.
+*
+*******************************************************************************/
+static uint32_t ble_bench_get_mark(uint32_t op)
+{
+    if(ble_bench.scenario == BLE_BENCH_NOTIFY_STREAM) {
+        return (op + 1u) * ble_bench.payload;
+    }
+    return op + 1u;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_collect
+****************************************************************************//**
+*
+* Completes the operations reached by the progress counter.
+*
+* \param none.
+*
+* \return true if the progress counter moved.
+*
+*******************************************************************************/
+static bool ble_bench_collect(void)
+{
+    uint32_t progress = ble_bench_get_progress();
+    uint32_t now = ble_time_now();
+
+    if(progress == ble_bench.progress) {
+        return false;
+    }
+    ble_bench.progress = progress;
+    ble_bench.last_progress = now;
+    while((ble_bench.done < ble_bench.issued) && \
+          ((progress - ble_bench.base) >= ble_bench_get_mark(ble_bench.done))) {
+        ble_bench.samples[ble_bench.done] = now - ble_bench.samples[ble_bench.done];
+        ble_bench.done++;
+    }
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_confirmed
+****************************************************************************//**
+*
+* The completion callback of the confirmed responses.
+*
+* \param task The task of the confirmed response.
+*
+* \param result The result of the confirmed response.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_bench_confirmed(ble_task_t *task, cy_en_ble_api_result_t result)
+{
+    (void)task;
+    if(result == CY_BLE_SUCCESS) {
+        ble_bench.confirmed++;
+    } else {
+        ble_bench.error = result;
+    }
+    ble_event_post(BLE_EVENT_TX);
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_issue
+****************************************************************************//**
+*
+* Issues the next operation of the running scenario.
+*
+* \param none.
+*
+* \return true if the operation is issued, false if the transmit path is
+* full or failed.
+*
+*******************************************************************************/
+static bool ble_bench_issue(void)
+{
+    ble_custom_hi_iov_t iov;
+    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+    uint16_t len = ble_bench.payload;
+    uint32_t now = ble_time_now();
+
+    ble_bench.pattern[0] = (uint8_t)ble_bench.issued;
+    switch(ble_bench.scenario)
+    {
+        case BLE_BENCH_NOTIFY_STREAM:
+            if(ble_custom_hi_stream_free() < len) {
+                return false;
+            }
+            (void)ble_custom_hi_stream_write(ble_bench.pattern, len);
+            break;
+        case BLE_BENCH_INDICATION:
+            if(ble_bench.done != ble_bench.issued) {
+                return false;
+            }
+            apiResult = ble_custom_hi_response_confirmed(ble_bench.conn_id, len, ble_bench.pattern, \
+                                                         ble_bench_confirmed);
+            break;
+        default:
+            if(ble_bench.scenario == BLE_BENCH_MIXED_SIZES) {
+                len = ble_bench_sizes[ble_bench.issued % (sizeof(ble_bench_sizes) / sizeof(ble_bench_sizes[0]))];
+                if(len > ble_bench.payload) {
+                    len = ble_bench.payload;
+                }
+            }
+            iov.base = ble_bench.pattern;
+            iov.len = len;
+            apiResult = ble_custom_hi_response_queue(ble_bench.conn_id, BLE_CUSTOM_HI_LANE_BULK, &iov, 1u);
+            break;
+    }
+    if(apiResult != CY_BLE_SUCCESS) {
+        if((apiResult != CY_BLE_ERROR_INSUFFICIENT_RESOURCES) && (apiResult != CY_BLE_ERROR_INVALID_OPERATION)) {
+            ble_bench.error = apiResult;
+        }
+        return false;
+    }
+    ble_bench.samples[ble_bench.issued++] = now;
+    ble_bench.bytes += len;
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_setup
+****************************************************************************//**
+*
+* Prepares the running scenario.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_bench_setup(void)
+{
+    ble_custom_hi_stream_config_t config =
+    {
+        .high_watermark = (BLE_CUSTOM_HI_STREAM_BUF_SIZE * 3u) / 4u,
+        .low_watermark  = BLE_CUSTOM_HI_STREAM_BUF_SIZE / 4u,
+        .callback       = NULL,
+        .conn_id        = ble_bench.conn_id
+    };
+
+    if(ble_bench.scenario == BLE_BENCH_NOTIFY_STREAM) {
+        (void)ble_custom_hi_stream_config(&config);
+    }
+    ble_bench.issued = 0u;
+    ble_bench.done = 0u;
+    ble_bench.bytes = 0u;
+    ble_bench.confirmed = 0u;
+    ble_bench.error = CY_BLE_SUCCESS;
+    ble_bench.base = ble_bench_get_progress();
+    ble_bench.progress = ble_bench.base;
+    ble_bench.allocs = ble_bench_pool_allocs();
+    (void)ble_custom_hi_get_copy_stats(&ble_bench.copies);
+    ble_bench.start = ble_time_now();
+    ble_bench.last_progress = ble_bench.start;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_report
+****************************************************************************//**
+*
+* Computes the result of the running scenario, the latency samples are sorted.
+*
+* \param status The scenario status.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_bench_report(cy_en_ble_api_result_t status)
+{
+    ble_bench_result_t *result = &ble_bench.results[ble_bench.scenario];
+    ble_custom_hi_copy_stats_t copies;
+    uint32_t n = ble_bench.done;
+    uint32_t sample;
+    uint32_t i;
+    uint32_t j;
+
+    /* Insertion sort, the samples are mostly in order */
+    for(i = 1u; i < n; i++) {
+        sample = ble_bench.samples[i];
+        for(j = i; (j > 0u) && (ble_bench.samples[j - 1u] > sample); j--) {
+            ble_bench.samples[j] = ble_bench.samples[j - 1u];
+        }
+        ble_bench.samples[j] = sample;
+    }
+    (void)ble_custom_hi_get_copy_stats(&copies);
+    memset(result, 0, sizeof(*result));
+    result->status = status;
+    result->valid = true;
+    result->ops = n;
+    result->bytes = ble_bench.bytes;
+    result->elapsed_us = BLE_TIME_TICKS_TO_US(ble_bench.last_progress - ble_bench.start);
+    if(result->elapsed_us != 0u) {
+        result->ops_per_s = (uint32_t)(((uint64_t)n * 1000000u) / result->elapsed_us);
+        result->bytes_per_s = (uint32_t)(((uint64_t)ble_bench.bytes * 1000000u) / result->elapsed_us);
+    }
+    if(n != 0u) {
+        result->p50_us = BLE_TIME_TICKS_TO_US(ble_bench.samples[(n * 50u) / 100u]);
+        result->p99_us = BLE_TIME_TICKS_TO_US(ble_bench.samples[(n * 99u) / 100u]);
+        result->max_us = BLE_TIME_TICKS_TO_US(ble_bench.samples[n - 1u]);
+    }
+    result->allocs = ble_bench_pool_allocs() - ble_bench.allocs;
+    result->copies = copies.copies - ble_bench.copies.copies;
+    result->copy_bytes = copies.bytes - ble_bench.copies.bytes;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_task_func
+****************************************************************************//**
+*
+* The task of ble_bench_start(), runs the scenarios in turn. The operations
+* are issued while the transmit path takes them, and completed when the
+* progress counter reaches them.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_bench_task_func(ble_task_t *task)
+{
+    BLE_TASK_BEGIN(task);
+    for(; ble_bench.scenario <= ble_bench.last; ble_bench.scenario++) {
+        ble_bench_setup();
+        while(ble_bench.done < BLE_BENCH_OPS) {
+            while((ble_bench.issued < BLE_BENCH_OPS) && ble_bench_issue()) {
+            }
+            if(ble_bench.error != CY_BLE_SUCCESS) {
+                break;
+            }
+            BLE_TASK_WAIT_UNTIL_TIMEOUT(task, BLE_EVENT_TX | BLE_EVENT_STACK, ble_bench_collect(), BLE_BENCH_POLL_MS);
+            if(!ble_custom_hi_is_connected(ble_bench.conn_id)) {
+                ble_bench.error = CY_BLE_ERROR_NO_CONNECTION;
+                break;
+            }
+            if(BLE_TIME_TICKS_TO_MS(ble_time_now() - ble_bench.last_progress) >= BLE_BENCH_STALL_MS) {
+                ble_bench.error = CY_BLE_ERROR_INVALID_OPERATION;
+                break;
+            }
+        }
+        ble_bench_report(ble_bench.error);
+        if(ble_bench.error != CY_BLE_SUCCESS) {
+            ble_bench_print_json();
+            BLE_TASK_EXIT(task, ble_bench.error);
+        }
+    }
+    ble_bench_print_json();
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_start
+****************************************************************************//**
+*
+* Starts the benchmark of a scenario or of all of them, the JSON report is
+* printed when it ends. The stream of ble_custom_hi.c is configured to the
+* connection by the stream scenario.
+*
+* \param conn_id The connection ID.
+*
+* \param scenario The scenario, BLE_BENCH_ALL for all of them.
+*
+* \param done The completion callback, it can be NULL.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_bench_start(uint8_t conn_id, ble_bench_scenario_t scenario, ble_task_done_t done)
+{
+    uint16_t payload;
+    uint32_t i;
+
+    if(scenario > BLE_BENCH_ALL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(!ble_custom_hi_is_connected(conn_id)) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(ble_task_is_running(&ble_bench.task)) {
+        return CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    payload = ble_custom_hi_get_payload_size(conn_id);
+    if(payload > sizeof(ble_bench.pattern)) {
+        payload = sizeof(ble_bench.pattern);
+    }
+    for(i = 0u; i < sizeof(ble_bench.pattern); i++) {
+        ble_bench.pattern[i] = (uint8_t)i;
+    }
+    memset(ble_bench.results, 0, sizeof(ble_bench.results));
+    ble_bench.conn_id = conn_id;
+    ble_bench.payload = payload;
+    ble_bench.scenario = (scenario == BLE_BENCH_ALL) ? 0u : (uint8_t)scenario;
+    ble_bench.last = (scenario == BLE_BENCH_ALL) ? (BLE_BENCH_SCENARIO_NUM - 1u) : (uint8_t)scenario;
+    return ble_task_start(&ble_bench.task, "bench", ble_bench_task_func, done, NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_is_running
+****************************************************************************//**
+*
+* Checks if the benchmark runs.
+*
+* \param none.
+*
+* \return true if the benchmark runs.
+*
+*******************************************************************************/
+bool ble_bench_is_running(void)
+{
+    return ble_task_is_running(&ble_bench.task);
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_get_result
+****************************************************************************//**
+*
+* Gets the result of a scenario of the last run.
+*
+* \param scenario The scenario.
+*
+* \param result The result is copied here, valid is false if the scenario
+* was not run.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_bench_get_result(ble_bench_scenario_t scenario, ble_bench_result_t *result)
+{
+    if((scenario >= BLE_BENCH_SCENARIO_NUM) || (result == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    *result = ble_bench.results[scenario];
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_bench_print_json
+****************************************************************************//**
+*
+* Prints the results of the last run as one JSON line, see ble_bench.h.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_bench_print_json(void)
+{
+    const ble_bench_result_t *result;
+    bool first = true;
+    uint32_t i;
+
+    BLE_DBG_PRINTF("{\"bench\":\"ble_custom_hi\",\"conn\":%d,\"payload\":%d,\"results\":[", \
+        ble_bench.conn_id, ble_bench.payload);
+    for(i = 0u; i < BLE_BENCH_SCENARIO_NUM; i++) {
+        result = &ble_bench.results[i];
+        if(!result->valid) {
+            continue;
+        }
+        BLE_DBG_PRINTF("%s{\"scenario\":\"%s\",\"status\":%lu,\"ops\":%lu,\"bytes\":%lu,\"elapsed_us\":%lu,", \
+            first ? "" : ",", ble_bench_names[i], (unsigned long)result->status, (unsigned long)result->ops, \
+            (unsigned long)result->bytes, (unsigned long)result->elapsed_us);
+        BLE_DBG_PRINTF("\"ops_per_s\":%lu,\"bytes_per_s\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu,", \
+            (unsigned long)result->ops_per_s, (unsigned long)result->bytes_per_s, (unsigned long)result->p50_us, \
+            (unsigned long)result->p99_us, (unsigned long)result->max_us);
+        BLE_DBG_PRINTF("\"allocs\":%lu,\"copies\":%lu,\"copy_bytes\":%lu}", (unsigned long)result->allocs, \
+            (unsigned long)result->copies, (unsigned long)result->copy_bytes);
+        first = false;
+    }
+    BLE_DBG_PRINTF("]}\r\n");
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,103 @@
+/***************************************************************************//**
+* \file ble_bench.h
+* \version 1.0
+*
+* \brief
+* Header file for the BLE custom service benchmark.
+*
+* The benchmark drives the transmit paths of ble_custom_hi.c over a live
+* connection with BLE_BENCH_OPS operations per scenario. The latency of an
+* operation is the time from the call to the notification handed to the
+* stack, or to the confirmation of an indication. The results are printed as
+* one JSON line, so that they can be collected per build:
+*
+* {"bench":"ble_custom_hi","conn":0,"payload":244,"results":[{"scenario":
+* "notify_stream","status":0,"ops":200,"bytes":48800,"elapsed_us":...,
+* "ops_per_s":...,"bytes_per_s":...,"p50_us":...,"p99_us":...,"max_us":...,
+* "allocs":0,"copies":...,"copy_bytes":...},...]}
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_BENCH_H_
+#define _BLE_BENCH_H_
+
+#include "ble_common.h"
+#include "ble_custom_hi.h"
+#include "ble_task.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The operations of a scenario, a latency sample is kept for each.
+ */
+#define BLE_BENCH_OPS                       (200u)
+
+/**
+ * @brief The progress is polled at least this often, and a scenario is
+ *        aborted if it makes no progress for BLE_BENCH_STALL_MS.
+ */
+#define BLE_BENCH_POLL_MS                   (10u)
+#define BLE_BENCH_STALL_MS                  (2000u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The benchmark scenarios.
+ */
+typedef enum
+{
+    BLE_BENCH_NOTIFY_STREAM = 0,        /* MTU sized writes to the stream ring */
+    BLE_BENCH_RESPONSE_BURST,           /* MTU sized responses queued in the bulk lane */
+    BLE_BENCH_MIXED_SIZES,              /* Responses of 1 byte to the MTU payload */
+    BLE_BENCH_INDICATION,               /* Confirmed responses, one at a time */
+    BLE_BENCH_SCENARIO_NUM,
+    BLE_BENCH_ALL = BLE_BENCH_SCENARIO_NUM
+} ble_bench_scenario_t;
+
+/**
+ * @brief The result of a scenario.
+ */
+typedef struct
+{
+    cy_en_ble_api_result_t status;      /* CY_BLE_SUCCESS, or the reason of the abort */
+    bool     valid;                     /* The scenario was run */
+    uint32_t ops;                       /* The completed operations */
+    uint32_t bytes;
+    uint32_t elapsed_us;
+    uint32_t ops_per_s;
+    uint32_t bytes_per_s;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t allocs;                    /* Memory pool allocations */
+    uint32_t copies;                    /* Payload copies, see ble_custom_hi_get_copy_stats() */
+    uint32_t copy_bytes;
+} ble_bench_result_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+cy_en_ble_api_result_t ble_bench_start(uint8_t conn_id, ble_bench_scenario_t scenario, ble_task_done_t done);
+bool ble_bench_is_running(void);
+cy_en_ble_api_result_t ble_bench_get_result(ble_bench_scenario_t scenario, ble_bench_result_t *result);
+void ble_bench_print_json(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_BENCH_H_ */
+
+/* [] END OF FILE */
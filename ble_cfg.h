@@ -36,9 +36,85 @@
 #define BLE_DEBUG_UART_ENABLED                          ENABLED
 
 /**
- * @brief Enable or Disable the system low power function
+ * @brief Enable or Disable the system low power function, when enabled the
+ *        run loop enters Deep Sleep through the power manager, otherwise
+ *        only the CPU Sleep is used.
  */
-#define ENABLE_SYS_LPM_FUNCTION                         DISABLED
+#define ENABLE_SYS_LPM_FUNCTION                         ENABLED
+
+/**
+ * @brief Enable or Disable the AES-CCM sealing of the command and response
+ *        payloads, when enabled the payloads of a connection are sealed
+ *        after ble_seal_start() is called for it.
+ */
+#define ENABLE_PAYLOAD_SEAL_FUNCTION                    ENABLED
+
+/**
+ * @brief Enable or Disable the LZ compression of the responses sent by
+ *        ble_custom_hi_response_compressed(), when disabled they are sent
+ *        with the same framing but not compressed.
+ */
+#define ENABLE_RESPONSE_COMPRESS_FUNCTION               ENABLED
+
+/**
+ * @brief Enable or Disable the delta encoding of the state responses sent by
+ *        ble_custom_hi_response_delta(), when disabled every frame is a
+ *        keyframe.
+ */
+#define ENABLE_RESPONSE_DELTA_FUNCTION                  ENABLED
+
+/**
+ * @brief Enable or Disable the connectionless status broadcast, the status
+ *        given to ble_app_broadcast_set() is put into the service data of the
+ *        advertising and scan response packets.
+ */
+#define ENABLE_STATUS_BROADCAST_FUNCTION                ENABLED
+
+/**
+ * @brief Enable or Disable the adaptive advertising, when enabled the
+ *        advertisement runs in fast and slow phases with back-off pauses,
+ *        see ble_app_adv_policy_t, otherwise it is fast whenever a central
+ *        can connect.
+ */
+#define ENABLE_ADAPTIVE_ADV_FUNCTION                    ENABLED
+
+/**
+ * @brief Enable or Disable the stack recovery, when enabled a hardware error
+ *        restarts the stack and keeps the bonds, the keys and the application
+ *        queues, otherwise it halts the CPU in the debug mode.
+ */
+#define ENABLE_STACK_RECOVERY_FUNCTION                  ENABLED
+
+/**
+ * @brief Enable or Disable the warm boot, when enabled the keys, the link
+ *        parameters and the bond index retained across a soft reset let the
+ *        boot skip the banner, the stack version and the key generation.
+ */
+#define ENABLE_WARM_BOOT_FUNCTION                       ENABLED
+
+/**
+ * @brief Enable or Disable the stack event trace, when enabled every event of
+ *        ble_app_callback() is recorded into the ring of ble_trace.h.
+ */
+#define ENABLE_EVENT_TRACE_FUNCTION                     ENABLED
+
+/**
+ * @brief Enable or Disable the benchmark of the custom service transmit
+ *        paths, see ble_bench.h.
+ */
+#define ENABLE_BENCHMARK_FUNCTION                       ENABLED
+
+/**
+ * @brief Enable or Disable the test modes of ble_app_test: the pattern
+ *        generator, the write sink and the RTT echo.
+ */
+#define ENABLE_TEST_MODE_FUNCTION                       ENABLED
+
+/**
+ * @brief Enable or Disable the stack depth sampling of ble_app_callback(),
+ *        see ble_ram.h. The stack high water is available either way.
+ */
+#define ENABLE_STACK_DEPTH_FUNCTION                     ENABLED
 
 /***************************************
 * Data Types
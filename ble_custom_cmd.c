@@ -0,0 +1,675 @@
+/***************************************************************************//**
+* \file ble_custom_cmd.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE custom command framework.
+*
+* The commands written to the custom command characteristic are decoded by
+* the opcode in the first byte and dispatched through a handler table indexed
+* by the opcode. Handlers marked as ISR safe run in the BLE stack event
+* callback, the others are deferred to ble_custom_cmd_task(). The responses
+* are queued in the control lane and sent back by notification of the custom
+* response characteristic. The commands without a response, such as bulk data
+* writes, do not take a queue entry.
+*
+* A batch container carries several length-prefixed commands in one write.
+* The commands are dispatched in order and their responses are packed into
+* as few notifications as the MTU allows.
+*
+* Each connection has its own command queue and its responses are sent back
+* to it. The task takes one command of each connection in turn, so a busy
+* central does not hold back the others.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_custom_cmd.h"
+#include "ble_event.h"
+#include "ble_pool.h"
+
+/**
+ * @brief The state of command queue entry, stored in receive_flag.
+ */
+#define BLE_CUSTOM_CMD_ENTRY_FREE           (0u)
+#define BLE_CUSTOM_CMD_ENTRY_REQUEST        (1u)
+#define BLE_CUSTOM_CMD_ENTRY_RESPONSE       (2u)
+
+/**
+ * @brief The handler table indexed by opcode.
+ */
+static const ble_custom_cmd_desc_t *ble_custom_cmd_table[BLE_CUSTOM_CMD_OPCODE_NUM];
+
+/**
+ * @brief Per-opcode statistics.
+ */
+static ble_custom_cmd_stats_t ble_custom_cmd_stats[BLE_CUSTOM_CMD_OPCODE_NUM];
+
+/**
+ * @brief The command queue of a connection, written by the BLE callback and
+ *        read by ble_custom_cmd_task.
+ */
+typedef struct
+{
+    custom_command_buf_t entry[BLE_CUSTOM_CMD_QUEUE_DEPTH];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+} ble_custom_cmd_queue_t;
+
+/**
+ * @brief The command queues indexed by the connection ID.
+ */
+static ble_custom_cmd_queue_t ble_custom_cmd_queues[BLE_CUSTOM_HI_CONN_NUM];
+
+/**
+ * @brief The hook of the commands without a handler.
+ */
+static ble_custom_cmd_forward_t ble_custom_cmd_forward = NULL;
+
+/**
+ * @brief The connection of the command being dispatched.
+ */
+static uint8_t ble_custom_cmd_conn = 0u;
+
+
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_dispatch
+****************************************************************************//**
+*
+* Validates the command and runs its handler, updates the opcode statistics.
+*
+* \param opcode The command opcode.
+*
+* \param req The request payload.
+*
+* \param req_len The request payload size.
+*
+* \param res The response payload buffer, it must hold max_res_len bytes of the handler.
+*
+* \param res_len The response payload size is returned here.
+*
+* \return The response status, see BLE_CUSTOM_CMD_STATUS_xxx.
+*
+*******************************************************************************/
+static uint8_t ble_custom_cmd_dispatch(uint8_t opcode, const uint8_t *req, uint16_t req_len, \
+                                       uint8_t *res, uint16_t *res_len)
+{
+    const ble_custom_cmd_desc_t *desc;
+    uint8_t status;
+
+    *res_len = 0u;
+    if(opcode >= BLE_CUSTOM_CMD_OPCODE_NUM) {
+        return BLE_CUSTOM_CMD_STATUS_UNKNOWN;
+    }
+    ble_custom_cmd_stats[opcode].count++;
+    desc = ble_custom_cmd_table[opcode];
+    if(desc == NULL) {
+        status = BLE_CUSTOM_CMD_STATUS_UNKNOWN;
+    } else if(req_len > desc->max_req_len) {
+        ble_custom_cmd_stats[opcode].invalid_len++;
+        return BLE_CUSTOM_CMD_STATUS_INVALID_LEN;
+    } else {
+        status = desc->handler(req, req_len, res, res_len);
+        if(*res_len > desc->max_res_len) {
+            status = BLE_CUSTOM_CMD_STATUS_FAILED;
+            *res_len = 0u;
+        }
+    }
+    if(status != BLE_CUSTOM_CMD_STATUS_OK) {
+        ble_custom_cmd_stats[opcode].errors++;
+    }
+    return status;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_is_isr_safe
+****************************************************************************//**
+*
+* Checks if the command can be completed in the BLE stack event callback.
+* The unknown opcodes are completed there with an error response, unless
+* the forward hook is set.
+*
+* \param opcode The command opcode.
+*
+* \return true if the command is completed in the callback.
+*
+*******************************************************************************/
+static bool ble_custom_cmd_is_isr_safe(uint8_t opcode)
+{
+    if(opcode == BLE_CUSTOM_CMD_OPCODE_BATCH) {
+        return false;
+    }
+    if((opcode >= BLE_CUSTOM_CMD_OPCODE_NUM) || (ble_custom_cmd_table[opcode] == NULL)) {
+        return (ble_custom_cmd_forward == NULL);
+    }
+    return (0u != (ble_custom_cmd_table[opcode]->flags & BLE_CUSTOM_CMD_FLAG_ISR_SAFE));
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_write_callback
+****************************************************************************//**
+*
+* The custom host interface write callback, decodes and queues the command in
+* the queue of the connection. The ISR safe handlers are executed here and only
+* their responses are queued.
+*
+* \param conn_id The connection ID.
+*
+* \param len  Received len
+*
+* \param cmd  point to the data buffer
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_custom_cmd_write_callback(uint8_t conn_id, uint32_t len, void *cmd)
+{
+    const uint8_t *req = (const uint8_t *)cmd;
+    ble_custom_cmd_queue_t *queue;
+    custom_command_buf_t *entry;
+    uint8_t opcode = req[0];
+    uint16_t res_len = 0u;
+    uint16_t size = (uint16_t)len;
+    bool isr_safe = ble_custom_cmd_is_isr_safe(opcode);
+    uint8_t head;
+
+    if(conn_id >= BLE_CUSTOM_HI_CONN_NUM) {
+        return;
+    }
+    ble_custom_cmd_conn = conn_id;
+    if(isr_safe && (opcode < BLE_CUSTOM_CMD_OPCODE_NUM) && (ble_custom_cmd_table[opcode] != NULL) && \
+       (0u != (ble_custom_cmd_table[opcode]->flags & BLE_CUSTOM_CMD_FLAG_NO_RESPONSE))) {
+        /* Nothing to send back, the queue is bypassed */
+        (void)ble_custom_cmd_dispatch(opcode, &req[BLE_CUSTOM_CMD_REQ_HEADER_LEN], \
+                  (uint16_t)(len - BLE_CUSTOM_CMD_REQ_HEADER_LEN), NULL, &res_len);
+        return;
+    }
+    queue = &ble_custom_cmd_queues[conn_id];
+    head = queue->head;
+    entry = &queue->entry[head];
+    if(isr_safe) {
+        /* The block holds the response of the handler */
+        size = BLE_CUSTOM_CMD_RES_HEADER_LEN;
+        if((opcode < BLE_CUSTOM_CMD_OPCODE_NUM) && (ble_custom_cmd_table[opcode] != NULL)) {
+            size += ble_custom_cmd_table[opcode]->max_res_len;
+        }
+    } else if(((opcode >= BLE_CUSTOM_CMD_OPCODE_NUM) || (ble_custom_cmd_table[opcode] == NULL)) && \
+              (len < BLE_CUSTOM_CMD_BUFFER_SIZE)) {
+        /* The block is handed over, it holds the status byte of an in-place response */
+        size += BLE_CUSTOM_CMD_RES_HEADER_LEN - BLE_CUSTOM_CMD_REQ_HEADER_LEN;
+    }
+    if((len > BLE_CUSTOM_CMD_BUFFER_SIZE) || (entry->receive_flag != BLE_CUSTOM_CMD_ENTRY_FREE) || \
+       (NULL == (entry->buf = ble_pool_alloc(size)))) {
+        if(opcode < BLE_CUSTOM_CMD_OPCODE_NUM) {
+            ble_custom_cmd_stats[opcode].dropped++;
+        }
+        return;
+    }
+    entry->offset = BLE_CUSTOM_CMD_REQ_HEADER_LEN;
+    entry->res = NULL;
+    if(isr_safe) {
+        /* Run the handler now, the response is built in the queue entry */
+        entry->buf[0] = opcode;
+        entry->buf[1] = ble_custom_cmd_dispatch(opcode, &req[BLE_CUSTOM_CMD_REQ_HEADER_LEN], \
+                            (uint16_t)(len - BLE_CUSTOM_CMD_REQ_HEADER_LEN), \
+                            &entry->buf[BLE_CUSTOM_CMD_RES_HEADER_LEN], &res_len);
+        entry->len = BLE_CUSTOM_CMD_RES_HEADER_LEN + res_len;
+        entry->receive_flag = BLE_CUSTOM_CMD_ENTRY_RESPONSE;
+    } else {
+        /* Defer the handler or the batch to the task */
+        memcpy(entry->buf, req, len);
+        entry->len = (uint16_t)len;
+        entry->receive_flag = BLE_CUSTOM_CMD_ENTRY_REQUEST;
+    }
+    queue->head = (head + 1u) % BLE_CUSTOM_CMD_QUEUE_DEPTH;
+    ble_event_post(BLE_EVENT_COMMAND);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_send
+****************************************************************************//**
+*
+* Queues a response in the control lane of the transmit queue of a connection.
+* When the lane is full, the queued packets are sent first; if the stack is
+* busy the caller keeps the response for the next BLE_EVENT_TX.
+*
+* \param conn_id The connection ID.
+*
+* \param iov The array of the response segments.
+*
+* \param iovcnt The number of the response segments.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_cmd_send(uint8_t conn_id, const ble_custom_hi_iov_t *iov, uint32_t iovcnt)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    apiResult = ble_custom_hi_response_queue(conn_id, BLE_CUSTOM_HI_LANE_CONTROL, iov, iovcnt);
+    if(apiResult == CY_BLE_ERROR_INSUFFICIENT_RESOURCES) {
+        ble_custom_hi_tx_task();
+        apiResult = ble_custom_hi_response_queue(conn_id, BLE_CUSTOM_HI_LANE_CONTROL, iov, iovcnt);
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_send_buf
+****************************************************************************//**
+*
+* Queues a contiguous response in the control lane of the transmit queue.
+*
+* \param conn_id The connection ID.
+*
+* \param len The response size.
+*
+* \param buf The response data.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_cmd_send_buf(uint8_t conn_id, uint16_t len, const uint8_t *buf)
+{
+    const ble_custom_hi_iov_t iov = { .base = buf, .len = len };
+
+    return ble_custom_cmd_send(conn_id, &iov, 1u);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_set_response
+****************************************************************************//**
+*
+* Turns a queue entry into a response entry, the request block is reused for
+* a short response such as a status. The pool blocks hold at least
+* BLE_POOL_SMALL_SIZE bytes.
+*
+* \param entry The command queue entry.
+*
+* \param res The response, NULL if it is already built in the request block.
+*
+* \param len The response size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_cmd_set_response(custom_command_buf_t *entry, uint8_t *res, uint16_t len)
+{
+    if(res != NULL) {
+        ble_pool_free(entry->buf);
+        entry->buf = res;
+    }
+    entry->len = len;
+    entry->receive_flag = BLE_CUSTOM_CMD_ENTRY_RESPONSE;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_batch
+****************************************************************************//**
+*
+* Dispatches the commands of a batch container in order and aggregates the
+* responses. A notification is sent only when the next response does not fit.
+* When the control lane is full, the aggregated responses are kept in the
+* entry with the next item, and the batch resumes on the next call.
+*
+* Batch request:  | 0x80 | len | command frame(len) | len | command frame(len) | ...
+* Batch response: | 0x80 | len | response frame(len) | len | response frame(len) | ...
+*
+* \param conn_id The connection ID.
+*
+* \param entry The command queue entry of the batch container.
+*
+* \return true if the batch is completed, false if it waits for room in the
+* control lane.
+*
+*******************************************************************************/
+static bool ble_custom_cmd_batch(uint8_t conn_id, custom_command_buf_t *entry)
+{
+    const ble_custom_cmd_desc_t *desc;
+    const uint8_t *batch = entry->buf;
+    uint16_t len = entry->len;
+    uint16_t payload = ble_custom_hi_get_payload_size(conn_id);
+    uint16_t pos = entry->offset;
+    uint16_t fill = BLE_CUSTOM_CMD_REQ_HEADER_LEN;
+    uint16_t need;
+    uint16_t res_len;
+    uint8_t *buf;
+    uint8_t *res;
+    uint8_t *scratch;
+    uint8_t opcode;
+    uint8_t status;
+    uint8_t sub_len;
+    bool malformed = false;
+
+    if((payload == 0u) || (payload > BLE_CUSTOM_RES_BUFFER_SIZE)) {
+        payload = BLE_CUSTOM_RES_BUFFER_SIZE;
+    }
+    if(entry->res != NULL) {
+        /* Send the responses kept by the last call, the block is reused */
+        if(CY_BLE_ERROR_INSUFFICIENT_RESOURCES == ble_custom_cmd_send_buf(conn_id, entry->res_len, entry->res)) {
+            return false;
+        }
+        buf = entry->res;
+        entry->res = NULL;
+    } else if(NULL == (buf = ble_pool_alloc(payload))) {
+        /* The buffer to aggregate the responses of one notification */
+        entry->buf[1] = BLE_CUSTOM_CMD_RES_HEADER_LEN;
+        entry->buf[2] = BLE_CUSTOM_CMD_OPCODE_BATCH;
+        entry->buf[3] = BLE_CUSTOM_CMD_STATUS_BUSY;
+        ble_custom_cmd_set_response(entry, NULL, 4u);
+        return (CY_BLE_ERROR_INSUFFICIENT_RESOURCES != ble_custom_cmd_send_buf(conn_id, entry->len, entry->buf));
+    }
+    buf[0] = BLE_CUSTOM_CMD_OPCODE_BATCH;
+    while(pos < len) {
+        sub_len = batch[pos];
+        if((sub_len < BLE_CUSTOM_CMD_REQ_HEADER_LEN) || ((pos + 1u + sub_len) > len)) {
+            /* Malformed container, report it once and drop the rest */
+            opcode = BLE_CUSTOM_CMD_OPCODE_BATCH;
+            malformed = true;
+            need = BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN;
+        } else {
+            opcode = batch[pos + 1u];
+            desc = (opcode < BLE_CUSTOM_CMD_OPCODE_NUM) ? ble_custom_cmd_table[opcode] : NULL;
+            need = BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN + ((desc != NULL) ? desc->max_res_len : 0u);
+        }
+        /* Send the aggregated responses if the next one may not fit */
+        if(((fill + need) > payload) && (fill > BLE_CUSTOM_CMD_REQ_HEADER_LEN)) {
+            if(CY_BLE_ERROR_INSUFFICIENT_RESOURCES == ble_custom_cmd_send_buf(conn_id, fill, buf)) {
+                entry->res = buf;
+                entry->res_len = fill;
+                entry->offset = pos;
+                return false;
+            }
+            fill = BLE_CUSTOM_CMD_REQ_HEADER_LEN;
+        }
+        /* The handler writes in place if the worst case fits, otherwise into a scratch block */
+        scratch = NULL;
+        if((fill + need) <= payload) {
+            res = &buf[fill + BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN];
+        } else {
+            res = scratch = ble_pool_alloc(need - BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN);
+        }
+        res_len = 0u;
+        if(opcode == BLE_CUSTOM_CMD_OPCODE_BATCH) {
+            status = BLE_CUSTOM_CMD_STATUS_INVALID_LEN;
+        } else if(res == NULL) {
+            status = BLE_CUSTOM_CMD_STATUS_BUSY;
+        } else {
+            status = ble_custom_cmd_dispatch(opcode, &batch[pos + 2u], sub_len - BLE_CUSTOM_CMD_REQ_HEADER_LEN, \
+                                             res, &res_len);
+            if(res_len > BLE_CUSTOM_CMD_BATCH_RES_PAYLOAD_MAX) {
+                /* The item length is one byte */
+                status = BLE_CUSTOM_CMD_STATUS_OVERFLOW;
+                res_len = 0u;
+            }
+        }
+        if(scratch != NULL) {
+            /* The aggregation is empty here, the response fits unless it exceeds the MTU */
+            if((fill + BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN + res_len) > payload) {
+                status = BLE_CUSTOM_CMD_STATUS_OVERFLOW;
+                res_len = 0u;
+            }
+            memcpy(&buf[fill + BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN], scratch, res_len);
+            ble_pool_free(scratch);
+        }
+        buf[fill]      = (uint8_t)(BLE_CUSTOM_CMD_RES_HEADER_LEN + res_len);
+        buf[fill + 1u] = opcode;
+        buf[fill + 2u] = status;
+        fill += BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN + res_len;
+        pos = malformed ? len : (pos + 1u + sub_len);
+    }
+    if((fill > BLE_CUSTOM_CMD_REQ_HEADER_LEN) && \
+       (CY_BLE_ERROR_INSUFFICIENT_RESOURCES == ble_custom_cmd_send_buf(conn_id, fill, buf))) {
+        entry->res = buf;
+        entry->res_len = fill;
+        entry->offset = len;
+        return false;
+    }
+    ble_pool_free(buf);
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_init
+****************************************************************************//**
+*
+* Initializes the custom command framework and the custom host interface.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_cmd_init(void)
+{
+    ble_custom_hi_config_t custom_hi_config = { .cmd_callback_func = ble_custom_cmd_write_callback };
+
+    memset(ble_custom_cmd_table, 0, sizeof(ble_custom_cmd_table));
+    memset(ble_custom_cmd_stats, 0, sizeof(ble_custom_cmd_stats));
+    memset(ble_custom_cmd_queues, 0, sizeof(ble_custom_cmd_queues));
+    return ble_custom_hi_init(&custom_hi_config);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_register
+****************************************************************************//**
+*
+* Registers a table of command descriptors. The descriptors are referenced,
+* not copied, so the table must be kept valid (usually a const table).
+*
+* \param table The command descriptor table.
+*
+* \param count The number of descriptors in the table.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_cmd_register(const ble_custom_cmd_desc_t *table, uint32_t count)
+{
+    uint32_t i;
+
+    if(table == NULL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    for(i = 0u; i < count; i++) {
+        if((table[i].opcode >= BLE_CUSTOM_CMD_OPCODE_NUM) || (table[i].handler == NULL) || \
+           (table[i].max_req_len > BLE_CUSTOM_CMD_REQ_PAYLOAD_MAX) || \
+           (table[i].max_res_len > BLE_CUSTOM_CMD_RES_PAYLOAD_MAX) || \
+           ((0u != (table[i].flags & BLE_CUSTOM_CMD_FLAG_NO_RESPONSE)) && \
+            ((0u == (table[i].flags & BLE_CUSTOM_CMD_FLAG_ISR_SAFE)) || (table[i].max_res_len != 0u)))) {
+            BLE_DBG_PRINTF("ble_custom_cmd_register invalid descriptor %d\r\n", (int)i);
+            return CY_BLE_ERROR_INVALID_PARAMETER;
+        }
+    }
+    for(i = 0u; i < count; i++) {
+        ble_custom_cmd_table[table[i].opcode] = &table[i];
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_set_forward
+****************************************************************************//**
+*
+* Sets the hook of the commands without a handler, such as the commands
+* handled by other tasks. The hook is called in the ble_custom_cmd_task()
+* context with the pool block of the command, which it takes over. The batch
+* items are not forwarded.
+*
+* \param forward The forward hook, NULL to answer such commands with
+* BLE_CUSTOM_CMD_STATUS_UNKNOWN.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_cmd_set_forward(ble_custom_cmd_forward_t forward)
+{
+    ble_custom_cmd_forward = forward;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_get_conn
+****************************************************************************//**
+*
+* Gets the connection of the command being dispatched, for the handlers
+* which start work on the connection of the command.
+*
+* \param none.
+*
+* \return The connection ID, only valid within a handler.
+*
+*******************************************************************************/
+uint8_t ble_custom_cmd_get_conn(void)
+{
+    return ble_custom_cmd_conn;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_process
+****************************************************************************//**
+*
+* Runs the deferred handler or sends the queued response of one command. The
+* command of a lost connection is dropped. When the control lane is full, the
+* response is kept in the entry and sent on a later call, the handler is not
+* run again.
+*
+* \param conn_id The connection ID.
+*
+* \param entry The command queue entry.
+*
+* \return true if the entry is completed, false if it waits for room in the
+* control lane.
+*
+*******************************************************************************/
+static bool ble_custom_cmd_process(uint8_t conn_id, custom_command_buf_t *entry)
+{
+    const ble_custom_cmd_desc_t *desc;
+    uint16_t res_len;
+    uint8_t *res;
+
+    ble_custom_cmd_conn = conn_id;
+    if(!ble_custom_hi_is_connected(conn_id)) {
+        if(entry->buf[0] < BLE_CUSTOM_CMD_OPCODE_NUM) {
+            ble_custom_cmd_stats[entry->buf[0]].dropped++;
+        }
+        return true;
+    }
+    if(entry->receive_flag == BLE_CUSTOM_CMD_ENTRY_RESPONSE) {
+        /* The response of an ISR safe handler, or a kept one */
+    } else if(entry->buf[0] == BLE_CUSTOM_CMD_OPCODE_BATCH) {
+        return ble_custom_cmd_batch(conn_id, entry);
+    } else if(((entry->buf[0] >= BLE_CUSTOM_CMD_OPCODE_NUM) || (ble_custom_cmd_table[entry->buf[0]] == NULL)) && \
+              (ble_custom_cmd_forward != NULL)) {
+        /* Hand over the command block, the taker frees it and sends the response */
+        if(entry->buf[0] < BLE_CUSTOM_CMD_OPCODE_NUM) {
+            ble_custom_cmd_stats[entry->buf[0]].count++;
+        }
+        if(ble_custom_cmd_forward(conn_id, entry->buf, entry->len)) {
+            entry->buf = NULL;
+            return true;
+        }
+        if(entry->buf[0] < BLE_CUSTOM_CMD_OPCODE_NUM) {
+            ble_custom_cmd_stats[entry->buf[0]].dropped++;
+        }
+        entry->buf[1] = BLE_CUSTOM_CMD_STATUS_BUSY;
+        ble_custom_cmd_set_response(entry, NULL, BLE_CUSTOM_CMD_RES_HEADER_LEN);
+    } else {
+        /* The response block holds the worst case of the handler */
+        desc = (entry->buf[0] < BLE_CUSTOM_CMD_OPCODE_NUM) ? ble_custom_cmd_table[entry->buf[0]] : NULL;
+        res = ble_pool_alloc(BLE_CUSTOM_CMD_RES_HEADER_LEN + ((desc != NULL) ? desc->max_res_len : 0u));
+        if(res == NULL) {
+            if(entry->buf[0] < BLE_CUSTOM_CMD_OPCODE_NUM) {
+                ble_custom_cmd_stats[entry->buf[0]].dropped++;
+            }
+            entry->buf[1] = BLE_CUSTOM_CMD_STATUS_BUSY;
+            ble_custom_cmd_set_response(entry, NULL, BLE_CUSTOM_CMD_RES_HEADER_LEN);
+        } else {
+            res[0] = entry->buf[0];
+            res[1] = ble_custom_cmd_dispatch(entry->buf[0], &entry->buf[BLE_CUSTOM_CMD_REQ_HEADER_LEN], \
+                         entry->len - BLE_CUSTOM_CMD_REQ_HEADER_LEN, &res[BLE_CUSTOM_CMD_RES_HEADER_LEN], &res_len);
+            ble_custom_cmd_set_response(entry, res, BLE_CUSTOM_CMD_RES_HEADER_LEN + res_len);
+        }
+    }
+    return (CY_BLE_ERROR_INSUFFICIENT_RESOURCES != ble_custom_cmd_send_buf(conn_id, entry->len, entry->buf));
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_task
+****************************************************************************//**
+*
+* Runs the deferred handlers and sends the queued responses. The queues of
+* the connections are served in turn, one command of each at a time. A queue
+* whose response does not fit in the control lane waits for the next call.
+* This function should be called in the main loop on BLE_EVENT_COMMAND and
+* BLE_EVENT_TX.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_cmd_task(void)
+{
+    ble_custom_cmd_queue_t *queue;
+    custom_command_buf_t *entry;
+    uint8_t conn_id;
+    bool pending;
+
+    do {
+        pending = false;
+        for(conn_id = 0u; conn_id < BLE_CUSTOM_HI_CONN_NUM; conn_id++) {
+            queue = &ble_custom_cmd_queues[conn_id];
+            if(queue->tail == queue->head) {
+                continue;
+            }
+            entry = &queue->entry[queue->tail];
+            if(!ble_custom_cmd_process(conn_id, entry)) {
+                continue;
+            }
+            ble_pool_free(entry->buf);
+            if(entry->res != NULL) {
+                ble_pool_free(entry->res);
+            }
+            entry->buf = NULL;
+            entry->res = NULL;
+            entry->receive_flag = BLE_CUSTOM_CMD_ENTRY_FREE;
+            queue->tail = (queue->tail + 1u) % BLE_CUSTOM_CMD_QUEUE_DEPTH;
+            pending = true;
+        }
+    } while(pending);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_cmd_get_stats
+****************************************************************************//**
+*
+* Gets the statistics of an opcode.
+*
+* \param opcode The command opcode.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_cmd_get_stats(uint8_t opcode, ble_custom_cmd_stats_t *stats)
+{
+    if((opcode >= BLE_CUSTOM_CMD_OPCODE_NUM) || (stats == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    *stats = ble_custom_cmd_stats[opcode];
+    return CY_BLE_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,158 @@
+/***************************************************************************//**
+* \file ble_custom_cmd.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE custom command framework.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_CUSTOM_CMD_H_
+#define _BLE_CUSTOM_CMD_H_
+
+#include "ble_custom_hi.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The number of opcodes of the handler table, opcodes are 0 ~ (BLE_CUSTOM_CMD_OPCODE_NUM - 1).
+ */
+#define BLE_CUSTOM_CMD_OPCODE_NUM           (0x40u)
+
+/**
+ * @brief The depth of the command queue of each connection between the BLE
+ *        callback and ble_custom_cmd_task.
+ */
+#define BLE_CUSTOM_CMD_QUEUE_DEPTH          (4u)
+
+/**
+ * @brief Command frame:  | opcode(1) | request payload(n) |
+ *        Response frame: | opcode(1) | status(1) | response payload(n) |
+ */
+#define BLE_CUSTOM_CMD_REQ_HEADER_LEN       (1u)
+#define BLE_CUSTOM_CMD_RES_HEADER_LEN       (2u)
+
+/**
+ * @brief The batch container opcode, the container holds length-prefixed command frames:
+ *        | 0x80 | len(1) | command frame(len) | len(1) | command frame(len) | ...
+ *        The responses are returned in the same layout with response frames.
+ */
+#define BLE_CUSTOM_CMD_OPCODE_BATCH         (0x80u)
+#define BLE_CUSTOM_CMD_BATCH_ITEM_HEADER_LEN (1u + BLE_CUSTOM_CMD_RES_HEADER_LEN)
+
+/**
+ * @brief The maximum response payload of a batch item, a larger response is
+ *        replaced by BLE_CUSTOM_CMD_STATUS_OVERFLOW.
+ */
+#define BLE_CUSTOM_CMD_BATCH_RES_PAYLOAD_MAX (0xFFu - BLE_CUSTOM_CMD_RES_HEADER_LEN)
+
+/**
+ * @brief The maximum request and response payload size of a handler.
+ */
+#define BLE_CUSTOM_CMD_REQ_PAYLOAD_MAX      (BLE_CUSTOM_CMD_BUFFER_SIZE - BLE_CUSTOM_CMD_REQ_HEADER_LEN)
+#define BLE_CUSTOM_CMD_RES_PAYLOAD_MAX      (BLE_CUSTOM_RES_BUFFER_SIZE - BLE_CUSTOM_CMD_RES_HEADER_LEN)
+
+/**
+ * @brief The handler can run in the BLE stack event callback context.
+ */
+#define BLE_CUSTOM_CMD_FLAG_ISR_SAFE        (0x01u)
+
+/**
+ * @brief The command has no response, such as a bulk data write. It needs
+ *        BLE_CUSTOM_CMD_FLAG_ISR_SAFE and a max_res_len of 0. The handler runs
+ *        in the BLE stack event callback without a queue entry, a batch item
+ *        still gets its status.
+ */
+#define BLE_CUSTOM_CMD_FLAG_NO_RESPONSE     (0x02u)
+
+/**
+ * @brief Command response status.
+ */
+#define BLE_CUSTOM_CMD_STATUS_OK            (0x00u)
+#define BLE_CUSTOM_CMD_STATUS_UNKNOWN       (0x01u)
+#define BLE_CUSTOM_CMD_STATUS_INVALID_LEN   (0x02u)
+#define BLE_CUSTOM_CMD_STATUS_FAILED        (0x03u)
+#define BLE_CUSTOM_CMD_STATUS_OVERFLOW      (0x04u)
+#define BLE_CUSTOM_CMD_STATUS_BUSY          (0x05u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The command handler prototype.
+ *
+ * \param req     The request payload (the opcode is removed).
+ * \param req_len The request payload size, not greater than the declared max_req_len.
+ * \param res     The response payload buffer of max_res_len bytes.
+ * \param res_len The response payload size is returned here, it is 0 on entry.
+ *
+ * \return The response status, see BLE_CUSTOM_CMD_STATUS_xxx.
+ */
+typedef uint8_t (* ble_custom_cmd_handler_t)(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len);
+
+/**
+ * @brief The forward hook prototype, it takes the commands without a handler.
+ *
+ * \param conn_id The connection ID, the response is sent to this connection.
+ * \param cmd     The command frame, opcode included, in a block of ble_pool.c.
+ *                The block holds one more byte than the frame, so a response
+ *                can be built in place.
+ * \param len     The command frame size.
+ *
+ * \return true if the command is taken: the block is owned by the taker, it
+ *         is freed with ble_pool_free() and the response is sent by the taker.
+ */
+typedef bool (* ble_custom_cmd_forward_t)(uint8_t conn_id, uint8_t *cmd, uint16_t len);
+
+/**
+ * @brief The command descriptor, usually placed in a const table.
+ */
+typedef struct
+{
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t max_req_len;
+    uint16_t max_res_len;
+    ble_custom_cmd_handler_t handler;
+} ble_custom_cmd_desc_t;
+
+/**
+ * @brief Per-opcode command statistics.
+ */
+typedef struct
+{
+    uint32_t count;
+    uint32_t errors;
+    uint32_t invalid_len;
+    uint32_t dropped;
+} ble_custom_cmd_stats_t;
+
+
+/***************************************
+* Function Prototypes
+***************************************/
+cy_en_ble_api_result_t ble_custom_cmd_init(void);
+cy_en_ble_api_result_t ble_custom_cmd_register(const ble_custom_cmd_desc_t *table, uint32_t count);
+void ble_custom_cmd_set_forward(ble_custom_cmd_forward_t forward);
+uint8_t ble_custom_cmd_get_conn(void);
+void ble_custom_cmd_task(void);
+cy_en_ble_api_result_t ble_custom_cmd_get_stats(uint8_t opcode, ble_custom_cmd_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_CUSTOM_CMD_H_ */
+
+/* [] END OF FILE */
@@ -12,15 +12,142 @@
 * disclaimers, and limitations in the end user license agreement accompanying
 * the software package with which this file was provided.
 *******************************************************************************/
+#include <string.h>
 #include "ble_custom_hi.h"
+#include "ble_time.h"
+#include "ble_event.h"
+#include "ble_timer.h"
+#include "ble_pool.h"
+#include "ble_seal.h"
+#include "ble_lz.h"
+#include "ble_delta.h"
 
 /**
  * @brief Global Handle to internal BLE custom host interafce structure.
  */
 static ble_custom_hi_config_t ble_custom_hi_config;
 
-/* Global Handle to internal BLE structure which holds the BLE connected handle */
-static cy_stc_ble_conn_handle_t m_psoc6_ble_conn_handle;
+/* Staging buffer to assemble one notification. It is used only by the paths
+ * which do not process the stack events while it holds data, the others
+ * gather into a block of the pool. */
+static uint8_t ble_custom_res_buf[BLE_CUSTOM_RES_BUFFER_SIZE];
+
+/**
+ * @brief The packet record in the lane buffer: | len(2) | enqueue time(4) | data(len) | (pad to even)
+ *        A record length of BLE_CUSTOM_HI_LANE_PAD marks the unused end of the buffer.
+ */
+#define BLE_CUSTOM_HI_LANE_REC_HEADER_LEN   (6u)
+#define BLE_CUSTOM_HI_LANE_PAD              (0xFFFFu)
+#define BLE_CUSTOM_HI_LANE_REC_SIZE(len)    ((BLE_CUSTOM_HI_LANE_REC_HEADER_LEN + (len) + 1u) & ~1u)
+
+/**
+ * @brief The transmit queue of one priority lane, a byte ring of packet records.
+ */
+typedef struct
+{
+    uint8_t  buf[BLE_CUSTOM_HI_LANE_BUF_SIZE];
+    uint16_t head;
+    uint16_t tail;
+    uint16_t used;
+    uint16_t packets;
+    ble_custom_hi_lane_stats_t stats;
+} ble_custom_hi_tx_lane_t;
+
+/**
+ * @brief The context of one connection, indexed by the ATT instance (attId).
+ */
+typedef struct
+{
+    cy_stc_ble_conn_handle_t handle;
+    bool connected;
+    /* The priority lanes of the response transmit queue */
+    ble_custom_hi_tx_lane_t lanes[BLE_CUSTOM_HI_LANE_NUM];
+    /* The number of control packets sent in a row while bulk packets are waiting */
+    uint8_t control_streak;
+    /* The bytes the connection may still send in this scheduler round */
+    uint32_t deficit;
+    /* The notification payload size of the current scheduler pass */
+    uint16_t payload;
+    ble_custom_hi_conn_stats_t stats;
+    uint32_t rate_time;
+    uint32_t rate_bytes;
+} ble_custom_hi_conn_t;
+
+/* The connection contexts */
+static ble_custom_hi_conn_t ble_custom_hi_conns[BLE_CUSTOM_HI_CONN_NUM];
+
+/* The connection served first in the next scheduler round */
+static uint8_t ble_custom_hi_drr_next;
+
+/**
+ * @brief The packet sources of a connection, chosen by ble_custom_hi_conn_select().
+ */
+typedef enum
+{
+    BLE_CUSTOM_HI_SRC_NONE = 0,
+    BLE_CUSTOM_HI_SRC_CONTROL,
+    BLE_CUSTOM_HI_SRC_BULK,
+    BLE_CUSTOM_HI_SRC_STREAM
+} ble_custom_hi_src_t;
+
+/**
+ * @brief The stream ring, written by the producer and read by the transmit task.
+ *        The indexes are free running, the ring holds (head - tail) bytes.
+ */
+typedef struct
+{
+    uint8_t  buf[BLE_CUSTOM_HI_STREAM_BUF_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t first_time;
+    volatile bool     xoff;
+    volatile bool     flush;
+    ble_custom_hi_stream_config_t config;
+    ble_custom_hi_stream_stats_t stats;
+    uint32_t rate_time;
+    uint32_t rate_bytes;
+} ble_custom_hi_stream_t;
+
+/* The stream stage of the bulk lane */
+static ble_custom_hi_stream_t ble_custom_hi_stream = {
+    .config = {
+        .high_watermark = (BLE_CUSTOM_HI_STREAM_BUF_SIZE * 3u) / 4u,
+        .low_watermark  = BLE_CUSTOM_HI_STREAM_BUF_SIZE / 4u
+    }
+};
+
+/* Wakes up the transmit task to flush a partial stream notification */
+static ble_timer_t ble_custom_hi_stream_timer;
+
+#if (ENABLE_RESPONSE_COMPRESS_FUNCTION == ENABLED)
+/* The encoder of ble_custom_hi_response_compressed(), a response is compressed within one call */
+static ble_lz_t ble_custom_hi_lz;
+#endif
+
+/* The statistics of the compressed responses, the encoder time is counted in ble_time ticks */
+static ble_custom_hi_comp_stats_t ble_custom_hi_comp_stats;
+static uint32_t ble_custom_hi_comp_ticks;
+
+/* The payload copies made before the data reach the stack */
+static ble_custom_hi_copy_stats_t ble_custom_hi_copy_stats;
+
+/**
+ * @brief The state of the confirmed response, changed by the stack events.
+ */
+typedef enum
+{
+    BLE_CUSTOM_HI_IND_IDLE,
+    BLE_CUSTOM_HI_IND_PENDING,
+    BLE_CUSTOM_HI_IND_CONFIRMED,
+    BLE_CUSTOM_HI_IND_DISCONNECTED
+} ble_custom_hi_ind_state_t;
+
+/* The task and the data of the confirmed response, one is in flight on any connection */
+static ble_task_t ble_custom_hi_ind_task;
+static ble_custom_hi_conn_t *ble_custom_hi_ind_conn = NULL;
+static volatile ble_custom_hi_ind_state_t ble_custom_hi_ind_state = BLE_CUSTOM_HI_IND_IDLE;
+static uint16_t ble_custom_hi_ind_len;
+static uint8_t *ble_custom_hi_ind_buf = NULL;
 
 
 /*******************************************************************************
@@ -40,6 +167,18 @@ cy_en_ble_api_result_t ble_custom_hi_init(ble_custom_hi_config_t *config)
     if(config == NULL) {
         return CY_BLE_ERROR_INVALID_PARAMETER;
     }
+    /* The payload buffers of the commands and responses */
+    ble_pool_init();
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+    ble_seal_init();
+#endif
+    ble_delta_init();
+    memset(ble_custom_hi_conns, 0, sizeof(ble_custom_hi_conns));
+    ble_custom_hi_drr_next = 0u;
+    memset(&ble_custom_hi_comp_stats, 0, sizeof(ble_custom_hi_comp_stats));
+    ble_custom_hi_comp_ticks = 0u;
+    ble_custom_hi_ind_buf = NULL;
+    ble_custom_hi_ind_conn = NULL;
     /* command write callback */
     if(NULL != config->cmd_callback_func) {
         ble_custom_hi_config.cmd_callback_func = config->cmd_callback_func;
@@ -49,6 +188,124 @@ cy_en_ble_api_result_t ble_custom_hi_init(ble_custom_hi_config_t *config)
     return CY_BLE_SUCCESS;
 }
 
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_conn
+****************************************************************************//**
+*
+* Gets the context of a connection.
+*
+* \param conn_id The connection ID.
+*
+* \return The connection context, NULL if the connection is not established.
+*
+*******************************************************************************/
+static ble_custom_hi_conn_t *ble_custom_hi_get_conn(uint8_t conn_id)
+{
+    if((conn_id >= BLE_CUSTOM_HI_CONN_NUM) || (!ble_custom_hi_conns[conn_id].connected)) {
+        return NULL;
+    }
+    return &ble_custom_hi_conns[conn_id];
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_find_conn
+****************************************************************************//**
+*
+* Finds the context of the connection of a stack event.
+*
+* \param connHandle The connection handle of the event.
+*
+* \return The connection context, NULL if the connection is not known.
+*
+*******************************************************************************/
+static ble_custom_hi_conn_t *ble_custom_hi_find_conn(cy_stc_ble_conn_handle_t connHandle)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(connHandle.attId);
+
+    if((conn == NULL) || (conn->handle.bdHandle != connHandle.bdHandle)) {
+        return NULL;
+    }
+    return conn;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_is_connected
+****************************************************************************//**
+*
+* Checks if a connection is established on the GATT level.
+*
+* \param conn_id The connection ID.
+*
+* \return true if connected.
+*
+*******************************************************************************/
+bool ble_custom_hi_is_connected(uint8_t conn_id)
+{
+    return (ble_custom_hi_get_conn(conn_id) != NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_count_copy
+****************************************************************************//**
+*
+* Counts a payload copy. The counters are shared with the stream producer,
+* which may run in an interrupt.
+*
+* \param bytes The bytes copied.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_count_copy(uint32_t bytes)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+
+    ble_custom_hi_copy_stats.copies++;
+    ble_custom_hi_copy_stats.bytes += bytes;
+    Cy_SysLib_ExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_tx_flush
+****************************************************************************//**
+*
+* Drops all packets of the transmit queue of a connection, e.g. when the
+* connection is lost. The stream data is dropped if the stream is sent to it.
+*
+* \param conn The connection context.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_tx_flush(ble_custom_hi_conn_t *conn)
+{
+    uint32_t intr;
+    uint32_t head;
+    uint32_t i;
+
+    for(i = 0u; i < BLE_CUSTOM_HI_LANE_NUM; i++) {
+        conn->lanes[i].stats.dropped += conn->lanes[i].packets;
+        conn->stats.dropped += conn->lanes[i].packets;
+        conn->lanes[i].head = 0u;
+        conn->lanes[i].tail = 0u;
+        conn->lanes[i].used = 0u;
+        conn->lanes[i].packets = 0u;
+    }
+    conn->control_streak = 0u;
+    conn->deficit = 0u;
+    if(conn != &ble_custom_hi_conns[ble_custom_hi_stream.config.conn_id]) {
+        return;
+    }
+    /* Drop the stream data up to one snapshot of head, the producer side is
+     * not touched and the bytes it writes later are kept */
+    intr = Cy_SysLib_EnterCriticalSection();
+    head = ble_custom_hi_stream.head;
+    ble_custom_hi_stream.stats.bytes_dropped += head - ble_custom_hi_stream.tail;
+    Cy_SysLib_ExitCriticalSection(intr);
+    ble_custom_hi_stream.tail = head;
+    ble_custom_hi_stream.flush = false;
+}
+
 /*******************************************************************************
 * Function Name: ble_custom_command_write_request
 ****************************************************************************//**
@@ -63,23 +320,46 @@ cy_en_ble_api_result_t ble_custom_hi_init(ble_custom_hi_config_t *config)
 *******************************************************************************/
 static cy_en_ble_api_result_t ble_custom_command_write_request(cy_stc_ble_gatt_write_param_t *writeRequest)
 {
+    uint8_t conn_id = writeRequest->connHandle.attId;
+    uint16_t len = writeRequest->handleValPair.value.len;
+    uint8_t *cmd = writeRequest->handleValPair.value.val;
+    uint8_t *opened = NULL;
+
     /* Check if the returned handle is matching to custom commad Write Attribute */
     if(CUSTOM_CMD_CHAR_HANDLE == writeRequest->handleValPair.attrHandle)
     {
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+        /* Open the sealed command in a pool block, the stack buffer is not changed */
+        if(ble_seal_is_active(conn_id)) {
+            cy_en_ble_api_result_t apiResult;
+
+            if(NULL == (opened = ble_pool_alloc(len))) {
+                return CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+            memcpy(opened, cmd, len);
+            if(CY_BLE_SUCCESS != (apiResult = ble_seal_decrypt(conn_id, opened, len))) {
+                BLE_DBG_PRINTF("CMD[%d]: sealed command dropped 0x%x\r\n", conn_id, apiResult);
+                ble_pool_free(opened);
+                return apiResult;
+            }
+            cmd = opened;
+            len -= BLE_SEAL_MIC_LEN;
+        }
+#endif
         /* command callback */
-        if((NULL != ble_custom_hi_config.cmd_callback_func) && (0 < writeRequest->handleValPair.value.len))
+        if((NULL != ble_custom_hi_config.cmd_callback_func) && (0 < len))
         {
-            ble_custom_hi_config.cmd_callback_func(writeRequest->handleValPair.value.len, \
-                                                   writeRequest->handleValPair.value.val);
+            ble_custom_hi_config.cmd_callback_func(conn_id, len, cmd);
             #if (BLE_DEBUG_UART_ENABLED == ENABLED)
             uint8_t n = 0;
-            BLE_DBG_PRINTF("CMD: ");
-            for(n=0; n<writeRequest->handleValPair.value.len; n++) {
-                BLE_DBG_PRINTF("%02x ", (*((uint8_t *)(writeRequest->handleValPair.value.val)+n)));
+            BLE_DBG_PRINTF("CMD[%d]: ", conn_id);
+            for(n=0; n<len; n++) {
+                BLE_DBG_PRINTF("%02x ", cmd[n]);
             }
             BLE_DBG_PRINTF("\r\n");
             #endif
         }
+        ble_pool_free(opened);
     }
     return CY_BLE_SUCCESS;
 }
@@ -102,7 +382,7 @@ static cy_en_ble_api_result_t ble_custom_hi_write_request_handler(cy_stc_ble_gat
     cy_en_ble_gatt_err_code_t gattErr = CY_BLE_GATT_ERR_NONE;
     bool need_send_rsp = true;
     
-    if((writeRequest == NULL) || (m_psoc6_ble_conn_handle.bdHandle != writeRequest->connHandle.bdHandle)) {
+    if((writeRequest == NULL) || (ble_custom_hi_find_conn(writeRequest->connHandle) == NULL)) {
         return CY_BLE_ERROR_INVALID_PARAMETER;
     }
     
@@ -116,6 +396,9 @@ static cy_en_ble_api_result_t ble_custom_hi_write_request_handler(cy_stc_ble_gat
         gattErr = Cy_BLE_GATTS_WriteAttributeValueCCCD(&dbAttrValInfo);
         if(gattErr != CY_BLE_GATT_ERR_NONE) {
             apiResult = CY_BLE_ERROR_INVALID_OPERATION;
+        } else {
+            /* The responses kept while the CCCD was disabled may be sent */
+            ble_event_post(BLE_EVENT_TX);
         }
     } else if(writeRequest->handleValPair.attrHandle == CUSTOM_CMD_CHAR_HANDLE) {
         gattErr = Cy_BLE_GATTS_WriteAttributeValueLocal(&(writeRequest->handleValPair));
@@ -176,7 +459,7 @@ static cy_en_ble_api_result_t ble_custom_hi_write_cmd_handler(cy_stc_ble_gatt_wr
 {
     cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
 
-    if((writeCmd == NULL) || (m_psoc6_ble_conn_handle.bdHandle != writeCmd->connHandle.bdHandle))
+    if((writeCmd == NULL) || (ble_custom_hi_find_conn(writeCmd->connHandle) == NULL))
     {
         return CY_BLE_ERROR_INVALID_PARAMETER;
     }
@@ -190,6 +473,55 @@ static cy_en_ble_api_result_t ble_custom_hi_write_cmd_handler(cy_stc_ble_gatt_wr
     return apiResult;
 }
 
+/*******************************************************************************
+* Function Name: ble_custom_hi_conn_lost
+****************************************************************************//**
+*
+* Ends a connection, its transmit queue is dropped and a pending indication
+* fails.
+*
+* \param conn The connection context.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_conn_lost(ble_custom_hi_conn_t *conn)
+{
+    ble_custom_hi_tx_flush(conn);
+    conn->connected = false;
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+    ble_seal_stop(conn->handle.attId);
+#endif
+    ble_delta_reset(conn->handle.attId);
+    if((ble_custom_hi_ind_conn == conn) && (ble_custom_hi_ind_state == BLE_CUSTOM_HI_IND_PENDING)) {
+        ble_custom_hi_ind_state = BLE_CUSTOM_HI_IND_DISCONNECTED;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stack_reset
+****************************************************************************//**
+*
+* Ends all connections when the stack is restarted without disconnection
+* events. The queues which do not belong to a connection, such as the stream
+* and the command queues, are kept.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_hi_stack_reset(void)
+{
+    uint32_t i;
+
+    for(i = 0u; i < BLE_CUSTOM_HI_CONN_NUM; i++) {
+        if(ble_custom_hi_conns[i].connected) {
+            ble_custom_hi_conn_lost(&ble_custom_hi_conns[i]);
+        }
+    }
+}
+
 /*******************************************************************************
 * Function Name: ble_custom_hi_service_evt_callback
 ****************************************************************************//**
@@ -207,6 +539,8 @@ void ble_custom_hi_service_evt_callback(uint32_t event, void* eventParam)
 {
     cy_stc_ble_gatt_write_param_t *gatt_write_param = NULL;
     cy_stc_ble_gatts_write_cmd_req_param_t *gatt_write_cmd = NULL;
+    cy_stc_ble_conn_handle_t connHandle;
+    ble_custom_hi_conn_t *conn;
 
     switch(event)
     {
@@ -214,8 +548,24 @@ void ble_custom_hi_service_evt_callback(uint32_t event, void* eventParam)
      *                       GATTS Events
      ***********************************************************/
     case CY_BLE_EVT_GATT_CONNECT_IND:
-        m_psoc6_ble_conn_handle = *(cy_stc_ble_conn_handle_t *)eventParam;
-        BLE_DBG_PRINTF("CY_BLE_EVT_GATT_CONNECT_IND: %x, %x \r\n", m_psoc6_ble_conn_handle.attId, m_psoc6_ble_conn_handle.bdHandle);
+        connHandle = *(cy_stc_ble_conn_handle_t *)eventParam;
+        BLE_DBG_PRINTF("CY_BLE_EVT_GATT_CONNECT_IND: %x, %x \r\n", connHandle.attId, connHandle.bdHandle);
+        if(connHandle.attId < BLE_CUSTOM_HI_CONN_NUM) {
+            conn = &ble_custom_hi_conns[connHandle.attId];
+            ble_custom_hi_tx_flush(conn);
+            memset(&conn->lanes[BLE_CUSTOM_HI_LANE_CONTROL].stats, 0, sizeof(ble_custom_hi_lane_stats_t));
+            memset(&conn->lanes[BLE_CUSTOM_HI_LANE_BULK].stats, 0, sizeof(ble_custom_hi_lane_stats_t));
+            memset(&conn->stats, 0, sizeof(conn->stats));
+            conn->stats.weight = BLE_CUSTOM_HI_DRR_WEIGHT_DEFAULT;
+            conn->rate_time = ble_time_now();
+            conn->rate_bytes = 0u;
+            conn->handle = connHandle;
+            conn->connected = true;
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+            ble_seal_stop(connHandle.attId);
+#endif
+            ble_delta_reset(connHandle.attId);
+        }
         break;
         
     case CY_BLE_EVT_GATTS_WRITE_REQ:
@@ -230,112 +580,1752 @@ void ble_custom_hi_service_evt_callback(uint32_t event, void* eventParam)
             BLE_DBG_PRINTF("ble_custom_hi_write_cmd_handler return error\r\n");
         }
         break;
+    case CY_BLE_EVT_GATT_DISCONNECT_IND:
+        if(NULL != (conn = ble_custom_hi_find_conn(*(cy_stc_ble_conn_handle_t *)eventParam))) {
+            ble_custom_hi_conn_lost(conn);
+        }
+        break;
+    /* The stack may accept more packets of the transmit queue */
+    case CY_BLE_EVT_STACK_BUSY_STATUS:
+        if(*(uint8_t *)eventParam == CY_BLE_STACK_STATE_FREE) {
+            ble_event_post(BLE_EVENT_TX);
+        }
+        break;
     /* Indication Response is received from the GATT Client */
     case CY_BLE_EVT_GATTS_HANDLE_VALUE_CNF:
+        if((ble_custom_hi_ind_conn != NULL) && (ble_custom_hi_ind_state == BLE_CUSTOM_HI_IND_PENDING) && \
+           (ble_custom_hi_ind_conn->handle.bdHandle == ((cy_stc_ble_conn_handle_t *)eventParam)->bdHandle)) {
+            ble_custom_hi_ind_state = BLE_CUSTOM_HI_IND_CONFIRMED;
+        }
         break;
     }
 }
 
 /*******************************************************************************
-* Function Name: ble_custom_hi_response_fast
+* Function Name: ble_custom_hi_wait_stack_free
 ****************************************************************************//**
 *
-* This function updates the response data to host by notification.
+* Processes the stack events until the GATT layer of the connection is not busy.
+*
+* \param conn The connection context.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_wait_stack_free(ble_custom_hi_conn_t *conn)
+{
+    while(Cy_BLE_GATT_GetBusyStatus(conn->handle.attId) == CY_BLE_STACK_STATE_BUSY) {
+        Cy_BLE_ProcessEvents();
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_seal_overhead
+****************************************************************************//**
 *
-* \param connHandle The ble connected handle.
+* Gets the bytes added to each response payload of a connection by sealing.
 *
-* \param value Notification status. Valid values are CCCD_NOTIFY_DISABLED and CCCD_NOTIFY_ENABLED.
+* \param conn The connection context.
+*
+* \return The MIC size if the payloads are sealed, otherwise 0.
+*
+*******************************************************************************/
+static uint16_t ble_custom_hi_seal_overhead(const ble_custom_hi_conn_t *conn)
+{
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+    return ble_seal_is_active(conn->handle.attId) ? BLE_SEAL_MIC_LEN : 0u;
+#else
+    (void)conn;
+    return 0u;
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_value_send
+****************************************************************************//**
+*
+* Sends a value of the response characteristic by notification or indication.
+* When the payloads of the connection are sealed, the value is copied into a
+* pool block and sealed in place. The stack copies the value into its own
+* buffer, so the block is freed when the function returns.
+*
+* \param conn The connection context.
+*
+* \param indicate true to send an indication.
+*
+* \param len The value size.
+*
+* \param val The value.
 *
 * \return Return value indicates if the function succeeded or failed.
 * see \ref cy_en_ble_api_result_t.
 *
 *******************************************************************************/
-cy_en_ble_api_result_t ble_custom_hi_response_fast(uint16_t len, void *res)
+static cy_en_ble_api_result_t ble_custom_hi_value_send(ble_custom_hi_conn_t *conn, bool indicate, \
+                                                       uint16_t len, const uint8_t *val)
 {
-    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
-    
-    if(Cy_BLE_GetConnectionState(m_psoc6_ble_conn_handle) != CY_BLE_CONN_STATE_CONNECTED) {
-        apiResult = CY_BLE_ERROR_NO_CONNECTION;
-    } else if(!CY_BLE_IS_NOTIFICATION_ENABLED(m_psoc6_ble_conn_handle.attId, CUSTOM_RES_CCCD_HANDLE)) {
-        apiResult = CY_BLE_ERROR_NTF_DISABLED;
+    cy_en_ble_api_result_t apiResult;
+    cy_stc_ble_gatt_handle_value_pair_t valParam = {
+        .attrHandle = CUSTOM_RES_CHAR_HANDLE,
+        .value.val  = (uint8_t *)val,
+        .value.len  = len
+    };
+    uint8_t *sealed = NULL;
+
+#if (ENABLE_PAYLOAD_SEAL_FUNCTION == ENABLED)
+    if(ble_seal_is_active(conn->handle.attId)) {
+        if(NULL == (sealed = ble_pool_alloc(len + BLE_SEAL_MIC_LEN))) {
+            return CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+        memcpy(sealed, val, len);
+        ble_custom_hi_count_copy(len);
+        if(CY_BLE_SUCCESS != (apiResult = ble_seal_encrypt(conn->handle.attId, sealed, len))) {
+            ble_pool_free(sealed);
+            return apiResult;
+        }
+        valParam.value.val = sealed;
+        valParam.value.len = len + BLE_SEAL_MIC_LEN;
+    }
+#endif
+    if(indicate) {
+        apiResult = Cy_BLE_GATTS_SendIndication(&conn->handle, &valParam);
     } else {
-        /* Wait for the stack is idle */
-        while(Cy_BLE_GATT_GetBusyStatus(m_psoc6_ble_conn_handle.attId) == CY_BLE_STACK_STATE_BUSY) {
-            Cy_BLE_ProcessEvents();
-        }
-        /* Make sure that stack is not busy, then send the notification. */
-        if (Cy_BLE_GATT_GetBusyStatus(m_psoc6_ble_conn_handle.attId) == CY_BLE_STACK_STATE_FREE) {
-            /* Get GATT MTU size */
-            cy_stc_ble_gatt_xchg_mtu_param_t mtuParam = { .connHandle = m_psoc6_ble_conn_handle };
-            if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GATT_GetMtuSize(&mtuParam))) {
-                return apiResult;
-            }
-            if((mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN) < len) {
-                len = mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN;
-            }
-            /* Send the updated value to the peer device using notification procedure */
-            cy_stc_ble_gatt_handle_value_pair_t ntfReqParam = {
-                .attrHandle = CUSTOM_RES_CHAR_HANDLE,
-                .value.val  = res,
-                .value.len  = len
-            };
-            apiResult = Cy_BLE_GATTS_SendNotification(&m_psoc6_ble_conn_handle, &ntfReqParam);
-            if(apiResult != CY_BLE_SUCCESS) {
-                BLE_DBG_PRINTF("Cy_BLE_GATTS_Notification API Error: 0x%x \r\n", apiResult);
+        apiResult = Cy_BLE_GATTS_SendNotification(&conn->handle, &valParam);
+    }
+    if(sealed != NULL) {
+        if(apiResult != CY_BLE_SUCCESS) {
+            ble_seal_cancel(conn->handle.attId);
+        }
+        ble_pool_free(sealed);
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_notify_check
+****************************************************************************//**
+*
+* Checks that the response characteristic can be notified on a connection and
+* gets the maximum payload size of one notification. The CCCD is kept by the
+* stack for each connection.
+*
+* \param conn The connection context.
+*
+* \param payload The maximum notification payload size (MTU - 3) is returned here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_notify_check(ble_custom_hi_conn_t *conn, uint16_t *payload)
+{
+    cy_en_ble_api_result_t apiResult;
+    cy_stc_ble_gatt_xchg_mtu_param_t mtuParam = { .connHandle = conn->handle };
+
+    if((!conn->connected) || (Cy_BLE_GetConnectionState(conn->handle) != CY_BLE_CONN_STATE_CONNECTED)) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(!CY_BLE_IS_NOTIFICATION_ENABLED(conn->handle.attId, CUSTOM_RES_CCCD_HANDLE)) {
+        return CY_BLE_ERROR_NTF_DISABLED;
+    }
+    /* Get GATT MTU size */
+    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GATT_GetMtuSize(&mtuParam))) {
+        return apiResult;
+    }
+    *payload = mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN;
+    if(*payload > BLE_CUSTOM_RES_BUFFER_SIZE) {
+        *payload = BLE_CUSTOM_RES_BUFFER_SIZE;
+    }
+    *payload -= ble_custom_hi_seal_overhead(conn);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_payload_size
+****************************************************************************//**
+*
+* Gets the maximum payload size of one response notification of a connection.
+*
+* \param conn_id The connection ID.
+*
+* \return The payload size (MTU - 3), or 0 when the response can not be notified.
+*
+*******************************************************************************/
+uint16_t ble_custom_hi_get_payload_size(uint8_t conn_id)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    uint16_t payload = 0u;
+
+    if((conn == NULL) || (CY_BLE_SUCCESS != ble_custom_hi_notify_check(conn, &payload))) {
+        payload = 0u;
+    }
+    return payload;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_is_idle
+****************************************************************************//**
+*
+* Checks if the transmit queues of all connections and the stream ring are empty.
+*
+* \param none.
+*
+* \return true if no response data is waiting.
+*
+*******************************************************************************/
+bool ble_custom_hi_is_idle(void)
+{
+    uint32_t n;
+    uint32_t i;
+
+    for(n = 0u; n < BLE_CUSTOM_HI_CONN_NUM; n++) {
+        for(i = 0u; i < BLE_CUSTOM_HI_LANE_NUM; i++) {
+            if(ble_custom_hi_conns[n].lanes[i].packets != 0u) {
+                return false;
             }
-        } else {
-            BLE_DBG_PRINTF("CY_BLE_STACK_STATE_BUSY\r\n");
-            apiResult = CY_BLE_ERROR_INVALID_PARAMETER;
         }
     }
+    return (ble_custom_hi_stream.head == ble_custom_hi_stream.tail);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_send_notification
+****************************************************************************//**
+*
+* Waits for the stack is free and sends one notification of the response
+* characteristic. The stack copies the value into its own buffer, so the data
+* may be released after the function returns.
+*
+* \param conn The connection context.
+*
+* \param len The size of the notification payload.
+*
+* \param val The pointer to the notification payload.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_send_notification(ble_custom_hi_conn_t *conn, \
+                                                              uint16_t len, const uint8_t *val)
+{
+    cy_en_ble_api_result_t apiResult;
+
     /* Wait for the stack is idle */
-    while(Cy_BLE_GATT_GetBusyStatus(m_psoc6_ble_conn_handle.attId) == CY_BLE_STACK_STATE_BUSY) {
-        Cy_BLE_ProcessEvents();
+    ble_custom_hi_wait_stack_free(conn);
+    /* Make sure that stack is not busy, then send the notification. */
+    if(Cy_BLE_GATT_GetBusyStatus(conn->handle.attId) != CY_BLE_STACK_STATE_FREE) {
+        BLE_DBG_PRINTF("CY_BLE_STACK_STATE_BUSY\r\n");
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    /* Send the updated value to the peer device using notification procedure */
+    apiResult = ble_custom_hi_value_send(conn, false, len, val);
+    if(apiResult != CY_BLE_SUCCESS) {
+        BLE_DBG_PRINTF("Cy_BLE_GATTS_Notification API Error: 0x%x \r\n", apiResult);
     }
     return apiResult;
 }
 
-/******************************************************************************
-* Function Name: ble_custom_hi_response
-***************************************************************************//**
+/*******************************************************************************
+* Function Name: ble_custom_hi_iov_total
+****************************************************************************//**
 *
-* This function updates the response data to host by indication.
+* Validates the response segments and gets the total size.
 *
-*  \param len: The size of the characteristic value attribute.
-*  \param res:The pointer to the characteristic value data that should be sent to the client's device.
+* \param iov The array of the response segments.
+*
+* \param iovcnt The number of the response segments.
+*
+* \param total The total size of the segments is returned here.
 *
 * \return Return value indicates if the function succeeded or failed.
 * see \ref cy_en_ble_api_result_t.
-******************************************************************************/
-cy_en_ble_api_result_t ble_custom_hi_response(uint16_t len, void *res)
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_iov_total(const ble_custom_hi_iov_t *iov, uint32_t iovcnt, uint32_t *total)
 {
-    cy_en_ble_api_result_t apiResult;
+    uint32_t seg;
 
-    if((len < 1) || (res == NULL)) {
+    *total = 0u;
+    if((iov == NULL) || (iovcnt == 0u)) {
         return CY_BLE_ERROR_INVALID_PARAMETER;
     }
-    /* Send indication if it is enabled and connected */
-    if(Cy_BLE_GetConnectionState(m_psoc6_ble_conn_handle) < CY_BLE_CONN_STATE_CONNECTED)
-    {
-        apiResult = CY_BLE_ERROR_INVALID_STATE;
-    } else if(!CY_BLE_IS_INDICATION_ENABLED(m_psoc6_ble_conn_handle.attId, CUSTOM_RES_CCCD_HANDLE)){
-        apiResult = CY_BLE_ERROR_IND_DISABLED;
-    } else {
+    for(seg = 0u; seg < iovcnt; seg++) {
+        if((iov[seg].base == NULL) && (iov[seg].len != 0u)) {
+            return CY_BLE_ERROR_INVALID_PARAMETER;
+        }
+        *total += iov[seg].len;
+    }
+    return (*total == 0u) ? CY_BLE_ERROR_INVALID_PARAMETER : CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_iov_gather
+****************************************************************************//**
+*
+* Copies the data of the response segments from the current position and
+* advances the position.
+*
+* \param dst The destination buffer.
+*
+* \param iov The array of the response segments.
+*
+* \param seg The current segment index, updated.
+*
+* \param offset The offset in the current segment, updated.
+*
+* \param n The number of bytes to copy, must not exceed the remaining data.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_iov_gather(uint8_t *dst, const ble_custom_hi_iov_t *iov, uint32_t *seg, \
+                                     uint16_t *offset, uint16_t n)
+{
+    uint16_t cnt;
+
+    while(n > 0u) {
+        cnt = iov[*seg].len - *offset;
+        if(cnt > n) {
+            cnt = n;
+        }
+        memcpy(dst, (const uint8_t *)iov[*seg].base + *offset, cnt);
+        ble_custom_hi_count_copy(cnt);
+        dst += cnt;
+        n -= cnt;
+        *offset += cnt;
+        if(*offset >= iov[*seg].len) {
+            (*seg)++;
+            *offset = 0u;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_response_fast
+****************************************************************************//**
+*
+* This function updates the response data to host by notification.
+* The response is truncated to the negotiated MTU.
+*
+* \param conn_id The connection ID.
+*
+* \param len The size of the response data.
+*
+* \param res The pointer to the response data.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response_fast(uint8_t conn_id, uint16_t len, void *res)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    cy_en_ble_api_result_t apiResult;
+    uint16_t payload = 0u;
+
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(CY_BLE_SUCCESS == (apiResult = ble_custom_hi_notify_check(conn, &payload))) {
+        if(payload < len) {
+            len = payload;
+        }
+        apiResult = ble_custom_hi_send_notification(conn, len, (const uint8_t *)res);
+    }
+    /* Wait for the stack is idle */
+    ble_custom_hi_wait_stack_free(conn);
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_ind_release
+****************************************************************************//**
+*
+* Frees the data of the confirmed response when its task exits.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_ind_release(void)
+{
+    ble_pool_free(ble_custom_hi_ind_buf);
+    ble_custom_hi_ind_buf = NULL;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_ind_task_func
+****************************************************************************//**
+*
+* The task of ble_custom_hi_response_confirmed(), waits for the stack, sends
+* the indication and waits for the confirmation of the GATT Client.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_custom_hi_ind_task_func(ble_task_t *task)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    BLE_TASK_BEGIN(task);
+    BLE_TASK_WAIT_UNTIL(task, BLE_EVENT_STACK | BLE_EVENT_TX, \
+        (!ble_custom_hi_ind_conn->connected) || \
+        (Cy_BLE_GATT_GetBusyStatus(ble_custom_hi_ind_conn->handle.attId) == CY_BLE_STACK_STATE_FREE));
+    if(!ble_custom_hi_ind_conn->connected) {
+        ble_custom_hi_ind_release();
+        BLE_TASK_EXIT(task, CY_BLE_ERROR_NO_CONNECTION);
+    }
+    ble_custom_hi_ind_state = BLE_CUSTOM_HI_IND_PENDING;
+    apiResult = ble_custom_hi_value_send(ble_custom_hi_ind_conn, true, ble_custom_hi_ind_len, ble_custom_hi_ind_buf);
+    if(apiResult != CY_BLE_SUCCESS) {
+        BLE_DBG_PRINTF("Cy_BLE_GATTS_SendIndication API Error: 0x%x \r\n", apiResult);
+        ble_custom_hi_ind_state = BLE_CUSTOM_HI_IND_IDLE;
+        ble_custom_hi_ind_release();
+        BLE_TASK_EXIT(task, apiResult);
+    }
+    BLE_TASK_WAIT_UNTIL_TIMEOUT(task, BLE_EVENT_STACK, ble_custom_hi_ind_state != BLE_CUSTOM_HI_IND_PENDING, \
+                                BLE_CUSTOM_HI_IND_TIMEOUT_MS);
+    if(ble_custom_hi_ind_state == BLE_CUSTOM_HI_IND_CONFIRMED) {
+        apiResult = CY_BLE_SUCCESS;
+    } else if(ble_custom_hi_ind_state == BLE_CUSTOM_HI_IND_DISCONNECTED) {
+        apiResult = CY_BLE_ERROR_NO_CONNECTION;
+    } else {
+        BLE_DBG_PRINTF("Indication confirmation timeout\r\n");
+        apiResult = CY_BLE_ERROR_INVALID_STATE;
+    }
+    ble_custom_hi_ind_state = BLE_CUSTOM_HI_IND_IDLE;
+    ble_custom_hi_ind_release();
+    BLE_TASK_EXIT(task, apiResult);
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_response_confirmed
+****************************************************************************//**
+*
+* This function sends the response to host by indication and returns at once,
+* a task waits for the confirmation of the host and reports the result to the
+* callback. Only one confirmed response can be in flight on all connections.
+*
+* \param conn_id The connection ID.
+*
+* \param len The size of the response data, not greater than MTU - 3.
+*
+* \param res The pointer to the response data, it is copied.
+*
+* \param done The completion callback, it can be NULL.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response_confirmed(uint8_t conn_id, uint16_t len, const void *res, \
+                                                        ble_task_done_t done)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    cy_en_ble_api_result_t apiResult;
+    cy_stc_ble_gatt_xchg_mtu_param_t mtuParam;
+
+    if((res == NULL) || (len == 0u) || (len > BLE_CUSTOM_RES_BUFFER_SIZE)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if((conn == NULL) || (Cy_BLE_GetConnectionState(conn->handle) != CY_BLE_CONN_STATE_CONNECTED)) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(!CY_BLE_IS_INDICATION_ENABLED(conn->handle.attId, CUSTOM_RES_CCCD_HANDLE)) {
+        return CY_BLE_ERROR_IND_DISABLED;
+    }
+    mtuParam.connHandle = conn->handle;
+    if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GATT_GetMtuSize(&mtuParam))) {
+        return apiResult;
+    }
+    if(len > (mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN - ble_custom_hi_seal_overhead(conn))) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(ble_task_is_running(&ble_custom_hi_ind_task)) {
+        return CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    if(NULL == (ble_custom_hi_ind_buf = ble_pool_alloc(len))) {
+        return CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+    memcpy(ble_custom_hi_ind_buf, res, len);
+    ble_custom_hi_count_copy(len);
+    ble_custom_hi_ind_len = len;
+    ble_custom_hi_ind_conn = conn;
+    return ble_task_start(&ble_custom_hi_ind_task, "indicate", ble_custom_hi_ind_task_func, done, NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_response_v
+****************************************************************************//**
+*
+* This function gathers the response segments and sends them to host by
+* notifications. The gathered payload is split into MTU sized notifications.
+* A segment which covers a whole notification is passed to the stack directly,
+* other notifications are assembled into a staging block of the pool. The
+* block is owned by the call, as the stack events processed while waiting for
+* the stack may send other responses.
+*
+* \param conn_id The connection ID.
+*
+* \param iov The array of the response segments.
+*
+* \param iovcnt The number of the response segments.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response_v(uint8_t conn_id, const ble_custom_hi_iov_t *iov, uint32_t iovcnt)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    cy_en_ble_api_result_t apiResult;
+    uint32_t total = 0u;
+    uint32_t seg = 0u;
+    uint16_t offset = 0u;
+    uint16_t payload = 0u;
+    uint16_t chunk;
+    uint8_t *buf = NULL;
+
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_hi_iov_total(iov, iovcnt, &total))) {
+        return apiResult;
+    }
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_hi_notify_check(conn, &payload))) {
+        return apiResult;
+    }
+    
+    while((total > 0u) && (apiResult == CY_BLE_SUCCESS)) {
+        /* Skip the consumed and empty segments */
+        while(offset >= iov[seg].len) {
+            seg++;
+            offset = 0u;
+        }
+        chunk = (total < payload) ? (uint16_t)total : payload;
+        if((uint32_t)(iov[seg].len - offset) >= chunk) {
+            /* The segment covers the whole notification, no copy needed */
+            apiResult = ble_custom_hi_send_notification(conn, chunk, (const uint8_t *)iov[seg].base + offset);
+            offset += chunk;
+        } else if((buf == NULL) && (NULL == (buf = ble_pool_alloc(payload)))) {
+            apiResult = CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        } else {
+            /* Gather the segments into the staging block */
+            ble_custom_hi_iov_gather(buf, iov, &seg, &offset, chunk);
+            apiResult = ble_custom_hi_send_notification(conn, chunk, buf);
+        }
+        total -= chunk;
+    }
+    /* Wait for the stack is idle */
+    ble_custom_hi_wait_stack_free(conn);
+    if(buf != NULL) {
+        ble_pool_free(buf);
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_lane_alloc
+****************************************************************************//**
+*
+* Allocates a packet record at the head of the lane buffer.
+*
+* \param lane The transmit lane.
+*
+* \param len The packet size.
+*
+* \return The pointer to the record, or NULL when the lane is full.
+*
+*******************************************************************************/
+static uint8_t *ble_custom_hi_lane_alloc(ble_custom_hi_tx_lane_t *lane, uint16_t len)
+{
+    uint16_t need = BLE_CUSTOM_HI_LANE_REC_SIZE(len);
+    uint16_t pad;
+    uint8_t *rec;
+
+    if(lane->used == 0u) {
+        lane->head = 0u;
+        lane->tail = 0u;
+    } else if(lane->head == lane->tail) {
+        /* The lane is full */
+        return NULL;
+    }
+    if(lane->head < lane->tail) {
+        if((lane->tail - lane->head) < need) {
+            return NULL;
+        }
+    } else if((BLE_CUSTOM_HI_LANE_BUF_SIZE - lane->head) < need) {
+        /* Not enough room at the end, wrap around if the beginning has room */
+        if((lane->used == 0u) || (lane->tail < need)) {
+            return NULL;
+        }
+        pad = BLE_CUSTOM_HI_LANE_BUF_SIZE - lane->head;
+        lane->buf[lane->head]      = (uint8_t)BLE_CUSTOM_HI_LANE_PAD;
+        lane->buf[lane->head + 1u] = (uint8_t)(BLE_CUSTOM_HI_LANE_PAD >> 8u);
+        lane->used += pad;
+        lane->head = 0u;
+    }
+    rec = &lane->buf[lane->head];
+    lane->head += need;
+    if(lane->head >= BLE_CUSTOM_HI_LANE_BUF_SIZE) {
+        lane->head = 0u;
+    }
+    lane->used += need;
+    return rec;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_response_queue
+****************************************************************************//**
+*
+* This function gathers the response segments into MTU sized packets and puts
+* them into a priority lane of the transmit queue of a connection. The packets
+* are sent by ble_custom_hi_tx_task(). The response is queued completely or not
+* at all.
+*
+* \param conn_id The connection ID.
+*
+* \param lane The priority lane, see \ref ble_custom_hi_lane_t.
+*
+* \param iov The array of the response segments.
+*
+* \param iovcnt The number of the response segments.
+*
+* \return Return value indicates if the function succeeded or failed.
+* CY_BLE_ERROR_INSUFFICIENT_RESOURCES is returned when the lane is full.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response_queue(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    const ble_custom_hi_iov_t *iov, uint32_t iovcnt)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_tx_lane_t *txLane;
+    uint32_t total = 0u;
+    uint32_t seg = 0u;
+    uint16_t offset = 0u;
+    uint16_t payload = 0u;
+    uint16_t chunk;
+    uint16_t head;
+    uint16_t used;
+    uint16_t packets = 0u;
+    uint32_t now = ble_time_now();
+    uint8_t *rec;
+
+    if(lane >= BLE_CUSTOM_HI_LANE_NUM) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_hi_iov_total(iov, iovcnt, &total))) {
+        return apiResult;
+    }
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_hi_notify_check(conn, &payload))) {
+        return apiResult;
+    }
+    txLane = &conn->lanes[lane];
+    head = txLane->head;
+    used = txLane->used;
+    while(total > 0u) {
+        chunk = (total < payload) ? (uint16_t)total : payload;
+        if(NULL == (rec = ble_custom_hi_lane_alloc(txLane, chunk))) {
+            /* Roll back the packets of this response */
+            txLane->head = head;
+            txLane->used = used;
+            txLane->stats.dropped++;
+            return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+        }
+        memcpy(&rec[0], &chunk, sizeof(chunk));
+        memcpy(&rec[2], &now, sizeof(now));
+        ble_custom_hi_iov_gather(&rec[BLE_CUSTOM_HI_LANE_REC_HEADER_LEN], iov, &seg, &offset, chunk);
+        total -= chunk;
+        packets++;
+    }
+    txLane->packets += packets;
+    ble_event_post(BLE_EVENT_TX);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_comp_fill
+****************************************************************************//**
+*
+* Fills the payload of one notification of a framed response, with the next
+* response bytes or with the encoder output.
+*
+* \param iov The array of the response segments.
+*
+* \param seg The current segment, updated here.
+*
+* \param offset The offset in the current segment, updated here.
+*
+* \param remaining The response bytes not taken yet, updated here.
+*
+* \param dst The payload buffer.
+*
+* \param size The payload buffer size.
+*
+* \param lz true to compress the response.
+*
+* \return The payload size, less than size only at the end of the response.
+*
+*******************************************************************************/
+static uint16_t ble_custom_hi_comp_fill(const ble_custom_hi_iov_t *iov, uint32_t *seg, uint16_t *offset, \
+                                        uint32_t *remaining, uint8_t *dst, uint16_t size, bool lz)
+{
+    uint16_t fill = 0u;
+    uint32_t n;
+
+    if(!lz) {
+        n = (*remaining < size) ? *remaining : size;
+        ble_custom_hi_iov_gather(dst, iov, seg, offset, (uint16_t)n);
+        *remaining -= n;
+        return (uint16_t)n;
+    }
+#if (ENABLE_RESPONSE_COMPRESS_FUNCTION == ENABLED)
+    while(fill < size) {
+        /* Feed the encoder until its ring is full, the empty segments are skipped */
+        while(*remaining > 0u) {
+            if(*offset >= iov[*seg].len) {
+                (*seg)++;
+                *offset = 0u;
+                continue;
+            }
+            n = ble_lz_sink(&ble_custom_hi_lz, (const uint8_t *)iov[*seg].base + *offset, iov[*seg].len - *offset);
+            if(n == 0u) {
+                break;
+            }
+            *offset += (uint16_t)n;
+            *remaining -= n;
+        }
+        n = ble_lz_poll(&ble_custom_hi_lz, &dst[fill], size - fill, (*remaining == 0u));
+        if((n == 0u) && (*remaining == 0u)) {
+            break;
+        }
+        fill += (uint16_t)n;
+    }
+#endif
+    return fill;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_comp_queue
+****************************************************************************//**
+*
+* Puts a framed response into a lane, see BLE_CUSTOM_HI_COMP_MARKER. The
+* notifications are built in the staging buffer. The caller rolls back the
+* lane if it fails.
+*
+* \param txLane The transmit lane.
+*
+* \param iov The array of the response segments.
+*
+* \param total The response size.
+*
+* \param payload The maximum notification payload size.
+*
+* \param lz true to compress the response.
+*
+* \param packets The number of notifications is returned here.
+*
+* \param out The payload bytes after the headers are returned here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_comp_queue(ble_custom_hi_tx_lane_t *txLane, const ble_custom_hi_iov_t *iov, \
+                                                       uint32_t total, uint16_t payload, bool lz, \
+                                                       uint16_t *packets, uint32_t *out)
+{
+    uint8_t *buf = ble_custom_res_buf;
+    uint32_t now = ble_time_now();
+    uint32_t remaining = total;
+    uint32_t seg = 0u;
+    uint16_t offset = 0u;
+    uint16_t fill;
+    uint16_t n;
+    uint8_t seq = 0u;
+    uint8_t *rec;
+    bool last;
+
+    *packets = 0u;
+    *out = 0u;
+#if (ENABLE_RESPONSE_COMPRESS_FUNCTION == ENABLED)
+    if(lz) {
+        ble_lz_init(&ble_custom_hi_lz);
+    }
+#endif
+    do {
+        buf[0] = BLE_CUSTOM_HI_COMP_MARKER;
+        buf[1] = (uint8_t)((lz ? BLE_CUSTOM_HI_COMP_FLAG_LZ : 0u) | (seq & BLE_CUSTOM_HI_COMP_SEQ_MASK));
+        fill = BLE_CUSTOM_HI_COMP_HEADER_LEN;
+        if(*packets == 0u) {
+            buf[1] |= BLE_CUSTOM_HI_COMP_FLAG_FIRST;
+            buf[fill++] = (uint8_t)total;
+            buf[fill++] = (uint8_t)(total >> 8u);
+            buf[fill++] = (uint8_t)(total >> 16u);
+            buf[fill++] = (uint8_t)(total >> 24u);
+        }
+        n = ble_custom_hi_comp_fill(iov, &seg, &offset, &remaining, &buf[fill], payload - fill, lz);
+        fill += n;
+        *out += n;
+        last = (remaining == 0u);
+#if (ENABLE_RESPONSE_COMPRESS_FUNCTION == ENABLED)
+        if(lz) {
+            last = last && ble_lz_is_done(&ble_custom_hi_lz);
+        }
+#endif
+        if(last) {
+            buf[1] |= BLE_CUSTOM_HI_COMP_FLAG_LAST;
+        }
+        if(NULL == (rec = ble_custom_hi_lane_alloc(txLane, fill))) {
+            return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+        }
+        memcpy(&rec[0], &fill, sizeof(fill));
+        memcpy(&rec[2], &now, sizeof(now));
+        memcpy(&rec[BLE_CUSTOM_HI_LANE_REC_HEADER_LEN], buf, fill);
+        ble_custom_hi_count_copy(fill);
+        (*packets)++;
+        seq++;
+    } while(!last);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_response_compressed
+****************************************************************************//**
+*
+* This function puts a large response, such as a log or a configuration dump,
+* into a priority lane of the transmit queue of a connection with the framing
+* of BLE_CUSTOM_HI_COMP_MARKER. The response is compressed if it is at least
+* BLE_CUSTOM_HI_COMP_MIN_LEN bytes and the compressed stream is smaller;
+* the flag in the header tells the host. The response is queued completely
+* or not at all, and it may be larger than the lane when it compresses well.
+*
+* \param conn_id The connection ID.
+*
+* \param lane The priority lane, see \ref ble_custom_hi_lane_t.
+*
+* \param iov The array of the response segments.
+*
+* \param iovcnt The number of the response segments.
+*
+* \return Return value indicates if the function succeeded or failed.
+* CY_BLE_ERROR_INSUFFICIENT_RESOURCES is returned when the lane is full.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response_compressed(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                         const ble_custom_hi_iov_t *iov, uint32_t iovcnt)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_tx_lane_t *txLane;
+    uint32_t total = 0u;
+    uint32_t out = 0u;
+    uint16_t payload = 0u;
+    uint16_t packets = 0u;
+    uint16_t head;
+    uint16_t used;
+    bool lz = false;
+
+    if(lane >= BLE_CUSTOM_HI_LANE_NUM) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_hi_iov_total(iov, iovcnt, &total))) {
+        return apiResult;
+    }
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_hi_notify_check(conn, &payload))) {
+        return apiResult;
+    }
+    if(payload <= (BLE_CUSTOM_HI_COMP_HEADER_LEN + BLE_CUSTOM_HI_COMP_SIZE_LEN)) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    txLane = &conn->lanes[lane];
+    head = txLane->head;
+    used = txLane->used;
+#if (ENABLE_RESPONSE_COMPRESS_FUNCTION == ENABLED)
+    if(total >= BLE_CUSTOM_HI_COMP_MIN_LEN) {
+        uint32_t start = ble_time_now();
+
+        apiResult = ble_custom_hi_comp_queue(txLane, iov, total, payload, true, &packets, &out);
+        ble_custom_hi_comp_ticks += ble_time_now() - start;
+        lz = (apiResult == CY_BLE_SUCCESS) && (out < total);
+        if(!lz) {
+            /* Not compressible or the stream does not fit the lane, take the
+             * packets back and try the response as it is */
+            txLane->head = head;
+            txLane->used = used;
+        }
+    }
+#endif
+    if(!lz) {
+        apiResult = ble_custom_hi_comp_queue(txLane, iov, total, payload, false, &packets, &out);
+    }
+    if(apiResult != CY_BLE_SUCCESS) {
+        txLane->head = head;
+        txLane->used = used;
+        txLane->stats.dropped++;
+        return apiResult;
+    }
+    txLane->packets += packets;
+    ble_custom_hi_comp_stats.responses++;
+    ble_custom_hi_comp_stats.compressed += lz ? 1u : 0u;
+    ble_custom_hi_comp_stats.bytes_in += total;
+    ble_custom_hi_comp_stats.bytes_out += out + (packets * BLE_CUSTOM_HI_COMP_HEADER_LEN) + BLE_CUSTOM_HI_COMP_SIZE_LEN;
+    ble_event_post(BLE_EVENT_TX);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_response_delta
+****************************************************************************//**
+*
+* This function puts an update of a registered state response type into a
+* priority lane of the transmit queue of a connection, delta encoded against
+* the last image sent to the connection, see ble_delta.h. Nothing is sent if
+* the image did not change. The image is kept only if the frame is queued.
+*
+* \param conn_id The connection ID.
+*
+* \param lane The priority lane, see \ref ble_custom_hi_lane_t.
+*
+* \param type The response type registered by ble_delta_register().
+*
+* \param data The new image of the registered size.
+*
+* \return Return value indicates if the function succeeded or failed.
+* CY_BLE_ERROR_INSUFFICIENT_RESOURCES is returned when the lane is full.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response_delta(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    uint8_t type, const void *data)
+{
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_iov_t iov;
+    uint16_t len;
+
+    if(CY_BLE_SUCCESS != (apiResult = ble_delta_encode(conn_id, type, data, ble_custom_res_buf, \
+                                                       sizeof(ble_custom_res_buf), &len))) {
+        return apiResult;
+    }
+    if(len == 0u) {
+        return CY_BLE_SUCCESS;
+    }
+    iov.base = ble_custom_res_buf;
+    iov.len = len;
+    if(CY_BLE_SUCCESS == (apiResult = ble_custom_hi_response_queue(conn_id, lane, &iov, 1u))) {
+        ble_delta_commit(conn_id, type, data, len);
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_lane_send
+****************************************************************************//**
+*
+* Sends the oldest packet of the lane directly from the lane buffer.
+*
+* \param conn The connection context.
+*
+* \param txLane The transmit lane of the connection, it must not be empty.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_lane_send(ble_custom_hi_conn_t *conn, ble_custom_hi_tx_lane_t *txLane)
+{
+    cy_en_ble_api_result_t apiResult;
+    uint16_t len;
+    uint32_t enqueued;
+    uint32_t wait;
+
+    /* Skip the pad at the end of the buffer */
+    memcpy(&len, &txLane->buf[txLane->tail], sizeof(len));
+    if(len == BLE_CUSTOM_HI_LANE_PAD) {
+        txLane->used -= BLE_CUSTOM_HI_LANE_BUF_SIZE - txLane->tail;
+        txLane->tail = 0u;
+        memcpy(&len, &txLane->buf[0], sizeof(len));
+    }
+    apiResult = ble_custom_hi_value_send(conn, false, len, \
+                                         &txLane->buf[txLane->tail + BLE_CUSTOM_HI_LANE_REC_HEADER_LEN]);
+    if(apiResult != CY_BLE_SUCCESS) {
+        BLE_DBG_PRINTF("Cy_BLE_GATTS_Notification API Error: 0x%x \r\n", apiResult);
+        return apiResult;
+    }
+    /* Update the lane statistics */
+    memcpy(&enqueued, &txLane->buf[txLane->tail + 2u], sizeof(enqueued));
+    wait = BLE_TIME_TICKS_TO_US(ble_time_now() - enqueued);
+    txLane->stats.packets++;
+    txLane->stats.bytes += len;
+    txLane->stats.wait_total_us += wait;
+    if(wait > txLane->stats.wait_max_us) {
+        txLane->stats.wait_max_us = wait;
+    }
+    /* Release the packet record */
+    txLane->used -= BLE_CUSTOM_HI_LANE_REC_SIZE(len);
+    txLane->tail += BLE_CUSTOM_HI_LANE_REC_SIZE(len);
+    if(txLane->tail >= BLE_CUSTOM_HI_LANE_BUF_SIZE) {
+        txLane->tail = 0u;
+    }
+    txLane->packets--;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_ready
+****************************************************************************//**
+*
+* Gets the size of the next stream notification. A partial notification is
+* sent only when flush is requested or the data waits longer than
+* BLE_CUSTOM_HI_STREAM_FLUSH_MS.
+*
+* \param payload The maximum notification payload size.
+*
+* \return The size of the next stream notification, 0 if nothing to send.
+*
+*******************************************************************************/
+static uint16_t ble_custom_hi_stream_ready(uint16_t payload)
+{
+    uint32_t used = ble_custom_hi_stream.head - ble_custom_hi_stream.tail;
+
+    if(used >= payload) {
+        return payload;
+    }
+    if((used != 0u) && (ble_custom_hi_stream.flush || \
+       ((ble_time_now() - ble_custom_hi_stream.first_time) >= BLE_TIME_MS_TO_TICKS(BLE_CUSTOM_HI_STREAM_FLUSH_MS)))) {
+        return (uint16_t)used;
+    }
+    return 0u;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_flush_callback
+****************************************************************************//**
+*
+* The flush timer callback, wakes up the transmit task.
+*
+* \param arg Not used.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_stream_flush_callback(void *arg)
+{
+    (void)arg;
+    ble_event_post(BLE_EVENT_TX);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_arm_flush
+****************************************************************************//**
+*
+* Starts the flush timer if a partial notification is left in the stream ring,
+* so that it is sent after BLE_CUSTOM_HI_STREAM_FLUSH_MS without polling.
+*
+* \param payload The notification payload size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_custom_hi_stream_arm_flush(uint16_t payload)
+{
+    uint32_t used = ble_custom_hi_stream.head - ble_custom_hi_stream.tail;
+    uint32_t age;
+
+    if((used == 0u) || (used >= payload) || ble_timer_is_active(&ble_custom_hi_stream_timer)) {
+        return;
+    }
+    age = BLE_TIME_TICKS_TO_MS(ble_time_now() - ble_custom_hi_stream.first_time);
+    ble_timer_start(&ble_custom_hi_stream_timer, \
+                    (age < BLE_CUSTOM_HI_STREAM_FLUSH_MS) ? (BLE_CUSTOM_HI_STREAM_FLUSH_MS - age + 1u) : 1u, \
+                    0u, ble_custom_hi_stream_flush_callback, NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_send
+****************************************************************************//**
+*
+* Cuts one notification from the stream ring and sends it. The data is sent
+* directly from the ring unless it wraps around the end of the ring.
+*
+* \param conn The connection context of the stream.
+*
+* \param len The notification size returned by ble_custom_hi_stream_ready().
+*
+* \param payload The maximum notification payload size.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_stream_send(ble_custom_hi_conn_t *conn, uint16_t len, uint16_t payload)
+{
+    ble_custom_hi_stream_t *stream = &ble_custom_hi_stream;
+    cy_en_ble_api_result_t apiResult;
+    const uint8_t *val;
+    uint32_t pos = stream->tail & (BLE_CUSTOM_HI_STREAM_BUF_SIZE - 1u);
+    uint32_t first = BLE_CUSTOM_HI_STREAM_BUF_SIZE - pos;
+    uint32_t now;
+    uint32_t used;
+
+    if(first >= len) {
+        val = &stream->buf[pos];
+    } else {
+        memcpy(ble_custom_res_buf, &stream->buf[pos], first);
+        memcpy(&ble_custom_res_buf[first], &stream->buf[0], len - first);
+        ble_custom_hi_count_copy(len);
+        val = ble_custom_res_buf;
+    }
+    apiResult = ble_custom_hi_value_send(conn, false, len, val);
+    if(apiResult != CY_BLE_SUCCESS) {
+        BLE_DBG_PRINTF("Cy_BLE_GATTS_Notification API Error: 0x%x \r\n", apiResult);
+        return apiResult;
+    }
+    stream->tail += len;
+    used = stream->head - stream->tail;
+    now = ble_time_now();
+    stream->first_time = now;
+    if(used == 0u) {
+        stream->flush = false;
+    }
+    /* Update the stream statistics */
+    stream->stats.bytes_out += len;
+    stream->stats.notifications++;
+    if(len < payload) {
+        stream->stats.partial_notifications++;
+    }
+    stream->rate_bytes += len;
+    if((now - stream->rate_time) >= BLE_TIME_MS_TO_TICKS(BLE_CUSTOM_HI_STREAM_RATE_WINDOW_MS)) {
+        stream->stats.throughput_bps = (uint32_t)(((uint64_t)stream->rate_bytes * 8u * BLE_TIME_TICK_HZ) / \
+                                                  (now - stream->rate_time));
+        if(stream->stats.throughput_bps > stream->stats.peak_bps) {
+            stream->stats.peak_bps = stream->stats.throughput_bps;
+        }
+        stream->rate_time = now;
+        stream->rate_bytes = 0u;
+    }
+    /* Release the producer */
+    if(stream->xoff && (used <= stream->config.low_watermark)) {
+        stream->xoff = false;
+        if(stream->config.callback != NULL) {
+            stream->config.callback(BLE_CUSTOM_HI_STREAM_EVT_XON);
+        }
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_lane_peek
+****************************************************************************//**
+*
+* Gets the size of the oldest packet of the lane.
+*
+* \param txLane The transmit lane, it must not be empty.
+*
+* \return The packet size.
+*
+*******************************************************************************/
+static uint16_t ble_custom_hi_lane_peek(const ble_custom_hi_tx_lane_t *txLane)
+{
+    uint16_t len;
+
+    memcpy(&len, &txLane->buf[txLane->tail], sizeof(len));
+    if(len == BLE_CUSTOM_HI_LANE_PAD) {
+        memcpy(&len, &txLane->buf[0], sizeof(len));
+    }
+    return len;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_conn_select
+****************************************************************************//**
+*
+* Chooses the next packet of a connection. The control lane is served first,
+* a bulk packet is chosen after BLE_CUSTOM_HI_BULK_STARVE_LIMIT control
+* packets in a row so that the bulk lane is not starved. The bulk lane sends
+* its queued packets before the stream data, if the stream is sent to this
+* connection.
+*
+* \param conn The connection context, conn->payload must be set.
+*
+* \param src The packet source is returned here.
+*
+* \return The packet size, 0 if nothing can be sent now.
+*
+*******************************************************************************/
+static uint16_t ble_custom_hi_conn_select(ble_custom_hi_conn_t *conn, ble_custom_hi_src_t *src)
+{
+    ble_custom_hi_tx_lane_t *control = &conn->lanes[BLE_CUSTOM_HI_LANE_CONTROL];
+    ble_custom_hi_tx_lane_t *bulk = &conn->lanes[BLE_CUSTOM_HI_LANE_BULK];
+    uint16_t stream_len = 0u;
+    bool bulk_ready;
+
+    if((bulk->packets == 0u) && (conn == &ble_custom_hi_conns[ble_custom_hi_stream.config.conn_id])) {
+        stream_len = ble_custom_hi_stream_ready(conn->payload);
+    }
+    bulk_ready = (bulk->packets != 0u) || (stream_len != 0u);
+    if((control->packets != 0u) && \
+       ((!bulk_ready) || (conn->control_streak < BLE_CUSTOM_HI_BULK_STARVE_LIMIT))) {
+        *src = BLE_CUSTOM_HI_SRC_CONTROL;
+        return ble_custom_hi_lane_peek(control);
+    }
+    if(bulk->packets != 0u) {
+        *src = BLE_CUSTOM_HI_SRC_BULK;
+        return ble_custom_hi_lane_peek(bulk);
+    }
+    *src = (stream_len != 0u) ? BLE_CUSTOM_HI_SRC_STREAM : BLE_CUSTOM_HI_SRC_NONE;
+    return stream_len;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_conn_send
+****************************************************************************//**
+*
+* Sends the packet chosen by ble_custom_hi_conn_select() and updates the
+* connection statistics.
+*
+* \param conn The connection context.
+*
+* \param src The packet source.
+*
+* \param len The packet size.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_custom_hi_conn_send(ble_custom_hi_conn_t *conn, ble_custom_hi_src_t src, uint16_t len)
+{
+    cy_en_ble_api_result_t apiResult;
+    uint32_t now;
+
+    if(src == BLE_CUSTOM_HI_SRC_CONTROL) {
+        apiResult = ble_custom_hi_lane_send(conn, &conn->lanes[BLE_CUSTOM_HI_LANE_CONTROL]);
+        conn->control_streak = ((conn->lanes[BLE_CUSTOM_HI_LANE_BULK].packets != 0u) || \
+                                (ble_custom_hi_stream.head != ble_custom_hi_stream.tail)) ? \
+                               (conn->control_streak + 1u) : 0u;
+    } else if(src == BLE_CUSTOM_HI_SRC_BULK) {
+        apiResult = ble_custom_hi_lane_send(conn, &conn->lanes[BLE_CUSTOM_HI_LANE_BULK]);
+        conn->control_streak = 0u;
+    } else {
+        apiResult = ble_custom_hi_stream_send(conn, len, conn->payload);
+        conn->control_streak = 0u;
+    }
+    if(apiResult != CY_BLE_SUCCESS) {
+        return apiResult;
+    }
+    conn->stats.packets++;
+    conn->stats.bytes += len;
+    conn->rate_bytes += len;
+    now = ble_time_now();
+    if((now - conn->rate_time) >= BLE_TIME_MS_TO_TICKS(BLE_CUSTOM_HI_CONN_RATE_WINDOW_MS)) {
+        conn->stats.throughput_bps = (uint32_t)(((uint64_t)conn->rate_bytes * 8u * BLE_TIME_TICK_HZ) / \
+                                                (now - conn->rate_time));
+        if(conn->stats.throughput_bps > conn->stats.peak_bps) {
+            conn->stats.peak_bps = conn->stats.throughput_bps;
+        }
+        conn->rate_time = now;
+        conn->rate_bytes = 0u;
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_conn_serve
+****************************************************************************//**
+*
+* Serves one connection in a scheduler round: its deficit grows by its quantum
+* and packets are sent while they fit in the deficit and the link has a free
+* stack buffer. The deficit is cleared when nothing is left to send, so an
+* idle connection does not save up credit.
+*
+* \param conn The connection context.
+*
+* \return true if the connection can send more in the next round.
+*
+*******************************************************************************/
+static bool ble_custom_hi_conn_serve(ble_custom_hi_conn_t *conn)
+{
+    ble_custom_hi_src_t src;
+    uint16_t len;
+
+    if(0u == (len = ble_custom_hi_conn_select(conn, &src))) {
+        conn->deficit = 0u;
+        return false;
+    }
+    if(Cy_BLE_GATT_GetBusyStatus(conn->handle.attId) != CY_BLE_STACK_STATE_FREE) {
+        conn->stats.stack_busy++;
+        return false;
+    }
+    conn->deficit += (uint32_t)conn->stats.weight * BLE_CUSTOM_HI_DRR_QUANTUM;
+    while(len <= conn->deficit) {
+        if(CY_BLE_SUCCESS != ble_custom_hi_conn_send(conn, src, len)) {
+            return false;
+        }
+        conn->deficit -= len;
+        if(0u == (len = ble_custom_hi_conn_select(conn, &src))) {
+            conn->deficit = 0u;
+            return false;
+        }
+        if(Cy_BLE_GATT_GetBusyStatus(conn->handle.attId) != CY_BLE_STACK_STATE_FREE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_tx_task
+****************************************************************************//**
+*
+* Sends the queued packets of all connections by deficit round-robin. Each
+* round serves the connections in turn, starting one later than the previous
+* round, with a share given by their weights. A connection whose link has no
+* free stack buffer is skipped and keeps its deficit. The rounds go on until
+* no connection can send. A connection which can not be notified, such as
+* while its CCCD is disabled, keeps its queue; only the queue of a lost link
+* is dropped. This function should be called in the main loop.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_hi_tx_task(void)
+{
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_conn_t *conn;
+    uint32_t i;
+    bool more;
+
+    /* Get the notification payload size, drop the data of the lost links */
+    for(i = 0u; i < BLE_CUSTOM_HI_CONN_NUM; i++) {
+        conn = &ble_custom_hi_conns[i];
+        if(conn->connected && (CY_BLE_SUCCESS != (apiResult = ble_custom_hi_notify_check(conn, &conn->payload)))) {
+            conn->payload = 0u;
+            if(apiResult == CY_BLE_ERROR_NO_CONNECTION) {
+                ble_custom_hi_tx_flush(conn);
+            }
+        }
+    }
+    do {
+        more = false;
+        for(i = 0u; i < BLE_CUSTOM_HI_CONN_NUM; i++) {
+            conn = &ble_custom_hi_conns[(ble_custom_hi_drr_next + i) % BLE_CUSTOM_HI_CONN_NUM];
+            if(conn->connected && (conn->payload != 0u) && ble_custom_hi_conn_serve(conn)) {
+                more = true;
+            }
+        }
+        ble_custom_hi_drr_next = (ble_custom_hi_drr_next + 1u) % BLE_CUSTOM_HI_CONN_NUM;
+    } while(more);
+    /* Send a partial stream notification later */
+    conn = &ble_custom_hi_conns[ble_custom_hi_stream.config.conn_id];
+    if(conn->connected && (conn->payload != 0u)) {
+        ble_custom_hi_stream_arm_flush(conn->payload);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_lane_stats
+****************************************************************************//**
+*
+* Gets the transmit statistics of a priority lane of a connection.
+*
+* \param conn_id The connection ID.
+*
+* \param lane The priority lane, see \ref ble_custom_hi_lane_t.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_get_lane_stats(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    ble_custom_hi_lane_stats_t *stats)
+{
+    if((conn_id >= BLE_CUSTOM_HI_CONN_NUM) || (lane >= BLE_CUSTOM_HI_LANE_NUM) || (stats == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    *stats = ble_custom_hi_conns[conn_id].lanes[lane].stats;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_set_weight
+****************************************************************************//**
+*
+* Sets the scheduler weight of a connection, it is reset to
+* BLE_CUSTOM_HI_DRR_WEIGHT_DEFAULT when the connection is established.
+*
+* \param conn_id The connection ID.
+*
+* \param weight The weight, 1 ~ BLE_CUSTOM_HI_DRR_WEIGHT_MAX.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_set_weight(uint8_t conn_id, uint8_t weight)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+
+    if((weight == 0u) || (weight > BLE_CUSTOM_HI_DRR_WEIGHT_MAX)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    conn->stats.weight = weight;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_conn_stats
+****************************************************************************//**
+*
+* Gets the transmit statistics of a connection. The queueing delay is the time
+* of the lane packets from ble_custom_hi_response_queue() to the stack.
+*
+* \param conn_id The connection ID.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_get_conn_stats(uint8_t conn_id, ble_custom_hi_conn_stats_t *stats)
+{
+    const ble_custom_hi_conn_t *conn;
+    uint64_t wait_total = 0u;
+    uint32_t packets = 0u;
+    uint32_t i;
+
+    if((conn_id >= BLE_CUSTOM_HI_CONN_NUM) || (stats == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    conn = &ble_custom_hi_conns[conn_id];
+    *stats = conn->stats;
+    stats->wait_max_us = 0u;
+    for(i = 0u; i < BLE_CUSTOM_HI_LANE_NUM; i++) {
+        wait_total += conn->lanes[i].stats.wait_total_us;
+        packets += conn->lanes[i].stats.packets;
+        if(conn->lanes[i].stats.wait_max_us > stats->wait_max_us) {
+            stats->wait_max_us = conn->lanes[i].stats.wait_max_us;
+        }
+    }
+    stats->wait_avg_us = (packets != 0u) ? (uint32_t)(wait_total / packets) : 0u;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_print_conn_stats
+****************************************************************************//**
+*
+* Prints the transmit statistics of the established connections.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_hi_print_conn_stats(void)
+{
+    ble_custom_hi_conn_stats_t stats;
+    uint8_t conn_id;
+
+    for(conn_id = 0u; conn_id < BLE_CUSTOM_HI_CONN_NUM; conn_id++) {
+        if(!ble_custom_hi_is_connected(conn_id)) {
+            continue;
+        }
+        (void)ble_custom_hi_get_conn_stats(conn_id, &stats);
+        BLE_DBG_PRINTF("Conn %d: weight=%d, packets=%lu, bytes=%lu, rate=%lubps (peak %lu), " \
+                       "wait avg=%luus max=%luus, busy=%lu, dropped=%lu\r\n", conn_id, stats.weight, \
+            (unsigned long)stats.packets, (unsigned long)stats.bytes, (unsigned long)stats.throughput_bps, \
+            (unsigned long)stats.peak_bps, (unsigned long)stats.wait_avg_us, (unsigned long)stats.wait_max_us, \
+            (unsigned long)stats.stack_busy, (unsigned long)stats.dropped);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_comp_stats
+****************************************************************************//**
+*
+* Gets the statistics of the compressed responses.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_get_comp_stats(ble_custom_hi_comp_stats_t *stats)
+{
+    if(stats == NULL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    *stats = ble_custom_hi_comp_stats;
+    stats->encode_us = BLE_TIME_TICKS_TO_US(ble_custom_hi_comp_ticks);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_print_comp_stats
+****************************************************************************//**
+*
+* Prints the statistics of the compressed responses. The gain is the ratio of
+* the response bytes to the bytes sent, it is the throughput gain when the
+* link is the bottleneck.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_hi_print_comp_stats(void)
+{
+    ble_custom_hi_comp_stats_t stats;
+    uint32_t gain;
+
+    (void)ble_custom_hi_get_comp_stats(&stats);
+    gain = (stats.bytes_out != 0u) ? (uint32_t)(((uint64_t)stats.bytes_in * 100u) / stats.bytes_out) : 100u;
+    BLE_DBG_PRINTF("Compress: responses=%lu (compressed %lu), in=%lu, out=%lu, gain=%lu.%02lux, encoder=%lu kB/s\r\n", \
+        (unsigned long)stats.responses, (unsigned long)stats.compressed, (unsigned long)stats.bytes_in, \
+        (unsigned long)stats.bytes_out, (unsigned long)(gain / 100u), (unsigned long)(gain % 100u), \
+        (unsigned long)((stats.encode_us != 0u) ? (((uint64_t)stats.bytes_in * 1000u) / ((uint64_t)stats.encode_us * 1024u / 1000u)) : 0u));
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_copy_stats
+****************************************************************************//**
+*
+* Gets the number and the bytes of the payload copies, the stream ring, the
+* transmit lanes, the staging buffers and the sealing included.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_get_copy_stats(ble_custom_hi_copy_stats_t *stats)
+{
+    uint32_t intr;
+
+    if(stats == NULL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    intr = Cy_SysLib_EnterCriticalSection();
+    *stats = ble_custom_hi_copy_stats;
+    Cy_SysLib_ExitCriticalSection(intr);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_config
+****************************************************************************//**
+*
+* Configures the connection, the backpressure watermarks and the callback of
+* the stream. The stream data is dropped when its connection is lost.
+*
+* \param config The stream configuration.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_stream_config(const ble_custom_hi_stream_config_t *config)
+{
+    if((config == NULL) || (config->high_watermark > BLE_CUSTOM_HI_STREAM_BUF_SIZE) || \
+       (config->low_watermark >= config->high_watermark) || (config->conn_id >= BLE_CUSTOM_HI_CONN_NUM)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    ble_custom_hi_stream.config = *config;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_write
+****************************************************************************//**
+*
+* Appends the data to the stream ring, the data is sent in MTU sized
+* notifications of the bulk lane by ble_custom_hi_tx_task(). There must be
+* only one producer, it may run in an interrupt. The statistics shared with
+* the thread context are updated in a critical section.
+* The XOFF event is signalled when the ring reaches the high watermark.
+*
+* \param data The stream data.
+*
+* \param len The size of the stream data.
+*
+* \return The number of bytes accepted, less than len when the ring is full.
+*
+*******************************************************************************/
+uint32_t ble_custom_hi_stream_write(const void *data, uint32_t len)
+{
+    ble_custom_hi_stream_t *stream = &ble_custom_hi_stream;
+    uint32_t head = stream->head;
+    uint32_t used = head - stream->tail;
+    uint32_t pos = head & (BLE_CUSTOM_HI_STREAM_BUF_SIZE - 1u);
+    uint32_t dropped = 0u;
+    uint32_t first;
+    uint32_t intr;
+    bool xoff;
+
+    if(data == NULL) {
+        return 0u;
+    }
+    if(len > (BLE_CUSTOM_HI_STREAM_BUF_SIZE - used)) {
+        dropped = len - (BLE_CUSTOM_HI_STREAM_BUF_SIZE - used);
+        len = BLE_CUSTOM_HI_STREAM_BUF_SIZE - used;
+    }
+    first = BLE_CUSTOM_HI_STREAM_BUF_SIZE - pos;
+    if(first > len) {
+        first = len;
+    }
+    memcpy(&stream->buf[pos], data, first);
+    memcpy(&stream->buf[0], (const uint8_t *)data + first, len - first);
+    if(used == 0u) {
+        stream->first_time = ble_time_now();
+    }
+    stream->head = head + len;
+    xoff = (!stream->xoff) && ((used + len) >= stream->config.high_watermark);
+    /* The statistics are read by the thread context */
+    intr = Cy_SysLib_EnterCriticalSection();
+    ble_custom_hi_copy_stats.copies++;
+    ble_custom_hi_copy_stats.bytes += len;
+    stream->stats.bytes_dropped += dropped;
+    stream->stats.bytes_in += len;
+    if(xoff) {
+        stream->stats.xoff_count++;
+    }
+    Cy_SysLib_ExitCriticalSection(intr);
+    ble_event_post(BLE_EVENT_TX);
+    /* Signal the producer to stop */
+    if(xoff) {
+        stream->xoff = true;
+        if(stream->config.callback != NULL) {
+            stream->config.callback(BLE_CUSTOM_HI_STREAM_EVT_XOFF);
+        }
+    }
+    return len;
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_free
+****************************************************************************//**
+*
+* Gets the free space of the stream ring.
+*
+* \param none.
+*
+* \return The number of bytes which can be written.
+*
+*******************************************************************************/
+uint32_t ble_custom_hi_stream_free(void)
+{
+    return BLE_CUSTOM_HI_STREAM_BUF_SIZE - (ble_custom_hi_stream.head - ble_custom_hi_stream.tail);
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_stream_flush
+****************************************************************************//**
+*
+* Requests to send the stream data in the ring without waiting for a full
+* notification.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_custom_hi_stream_flush(void)
+{
+    if(ble_custom_hi_stream.head != ble_custom_hi_stream.tail) {
+        ble_custom_hi_stream.flush = true;
+        ble_event_post(BLE_EVENT_TX);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_custom_hi_get_stream_stats
+****************************************************************************//**
+*
+* Gets the stream statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_get_stream_stats(ble_custom_hi_stream_stats_t *stats)
+{
+    uint32_t intr;
+
+    if(stats == NULL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    intr = Cy_SysLib_EnterCriticalSection();
+    *stats = ble_custom_hi_stream.stats;
+    Cy_SysLib_ExitCriticalSection(intr);
+    return CY_BLE_SUCCESS;
+}
+
+/******************************************************************************
+* Function Name: ble_custom_hi_response
+***************************************************************************//**
+*
+* This function updates the response data to host by indication.
+*
+*  \param conn_id: The connection ID.
+*  \param len: The size of the characteristic value attribute.
+*  \param res:The pointer to the characteristic value data that should be sent to the client's device.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+******************************************************************************/
+cy_en_ble_api_result_t ble_custom_hi_response(uint8_t conn_id, uint16_t len, void *res)
+{
+    ble_custom_hi_conn_t *conn = ble_custom_hi_get_conn(conn_id);
+    cy_en_ble_api_result_t apiResult;
+
+    if((len < 1) || (res == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    /* Send indication if it is enabled and connected */
+    if((conn == NULL) || (Cy_BLE_GetConnectionState(conn->handle) < CY_BLE_CONN_STATE_CONNECTED))
+    {
+        apiResult = CY_BLE_ERROR_INVALID_STATE;
+    } else if(!CY_BLE_IS_INDICATION_ENABLED(conn->handle.attId, CUSTOM_RES_CCCD_HANDLE)){
+        apiResult = CY_BLE_ERROR_IND_DISABLED;
+    } else {
         /* Get GATT MTU size */
-        cy_stc_ble_gatt_xchg_mtu_param_t mtuParam = { .connHandle = m_psoc6_ble_conn_handle };
+        cy_stc_ble_gatt_xchg_mtu_param_t mtuParam = { .connHandle = conn->handle };
         if(CY_BLE_SUCCESS != (apiResult = Cy_BLE_GATT_GetMtuSize(&mtuParam))) {
             return apiResult;
         }
-        if((mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN) < len) {
-            len = mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN;
+        if((mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN - ble_custom_hi_seal_overhead(conn)) < len) {
+            len = mtuParam.mtu - CY_BLE_GATT_WRITE_HEADER_LEN - ble_custom_hi_seal_overhead(conn);
         }
         /* Send the attribute value to to the peer device */
-        cy_stc_ble_gatt_handle_value_pair_t indReqParam = {
-            .attrHandle = CUSTOM_RES_CHAR_HANDLE,
-            .value.val  = res,
-            .value.len  = len
-        };
-        apiResult = Cy_BLE_GATTS_SendIndication(&m_psoc6_ble_conn_handle, &indReqParam);
+        apiResult = ble_custom_hi_value_send(conn, true, len, (const uint8_t *)res);
     }
     return(apiResult);
 }
@@ -16,6 +16,7 @@
 #define _BLE_CUSTOM_HI_H_
 
 #include "ble_common.h"
+#include "ble_task.h"
 
 /* The C binding of definitions if building with the C++ compiler */
 #ifdef __cplusplus
@@ -40,7 +41,17 @@ extern "C" {
 #define CUSTOM_RES_CCCD_HANDLE (CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)
 
 /* The callback function prototype to handle custom command */
-typedef void (* ble_custom_write_callback_t)(uint32_t len, void *cmd);
+typedef void (* ble_custom_write_callback_t)(uint8_t conn_id, uint32_t len, void *cmd);
+
+/**
+ * @brief The number of concurrent connections, see ConnectionCount of design.cybt.
+ *        The connection ID of the response API is the ATT instance (attId) of
+ *        the connection, 0 ~ (BLE_CUSTOM_HI_CONN_NUM - 1). The stack keeps the
+ *        CCCD state and the GATT busy status per attId, while the bdHandle is
+ *        assigned by the controller and is not bounded by the connection count,
+ *        so the bdHandle only checks that the context is not stale.
+ */
+#define BLE_CUSTOM_HI_CONN_NUM          (CY_BLE_CONN_COUNT)
 
 /**
  * @brief BLE custom command buffer size.
@@ -52,6 +63,70 @@ typedef void (* ble_custom_write_callback_t)(uint32_t len, void *cmd);
  */
 #define BLE_CUSTOM_RES_BUFFER_SIZE      (CY_BLE_GATT_DB_MAX_VALUE_LEN)
 
+/**
+ * @brief The transmit queue buffer size of each priority lane, must be even.
+ */
+#define BLE_CUSTOM_HI_LANE_BUF_SIZE     (1024u)
+
+/**
+ * @brief The maximum number of control packets sent in a row while bulk packets are waiting.
+ */
+#define BLE_CUSTOM_HI_BULK_STARVE_LIMIT (4u)
+
+/**
+ * @brief The timeout of the indication confirmation, it is the ATT transaction timeout.
+ */
+#define BLE_CUSTOM_HI_IND_TIMEOUT_MS    (30000u)
+
+/**
+ * @brief The stream ring buffer size, must be a power of 2.
+ */
+#define BLE_CUSTOM_HI_STREAM_BUF_SIZE   (2048u)
+
+/**
+ * @brief The stream data is sent in a partial notification if it waits longer than this (ms).
+ */
+#define BLE_CUSTOM_HI_STREAM_FLUSH_MS   (50u)
+
+/**
+ * @brief The window of the stream throughput measurement (ms).
+ */
+#define BLE_CUSTOM_HI_STREAM_RATE_WINDOW_MS (1000u)
+
+/**
+ * @brief The connections are served by deficit round-robin, a connection of
+ *        weight w may send w * BLE_CUSTOM_HI_DRR_QUANTUM bytes per round.
+ */
+#define BLE_CUSTOM_HI_DRR_QUANTUM       (256u)
+#define BLE_CUSTOM_HI_DRR_WEIGHT_DEFAULT (1u)
+#define BLE_CUSTOM_HI_DRR_WEIGHT_MAX    (16u)
+
+/**
+ * @brief The window of the connection throughput measurement (ms).
+ */
+#define BLE_CUSTOM_HI_CONN_RATE_WINDOW_MS (1000u)
+
+/**
+ * @brief The framing of ble_custom_hi_response_compressed(). Each notification
+ *        of the response starts with | BLE_CUSTOM_HI_COMP_MARKER | ctrl |, the
+ *        first one is followed by the response size (4 bytes, little endian).
+ *        The payloads after the headers form one ble_lz stream if the response
+ *        is compressed, otherwise the response itself. The marker is not the
+ *        first byte of the other responses (opcodes 0x00 ~ 0x3F, batch 0x80).
+ */
+#define BLE_CUSTOM_HI_COMP_MARKER       (0xC0u)
+#define BLE_CUSTOM_HI_COMP_HEADER_LEN   (2u)
+#define BLE_CUSTOM_HI_COMP_SIZE_LEN     (4u)
+#define BLE_CUSTOM_HI_COMP_FLAG_LZ      (0x80u)     /* The response is compressed */
+#define BLE_CUSTOM_HI_COMP_FLAG_FIRST   (0x40u)
+#define BLE_CUSTOM_HI_COMP_FLAG_LAST    (0x20u)
+#define BLE_CUSTOM_HI_COMP_SEQ_MASK     (0x1Fu)     /* The notification sequence number */
+
+/**
+ * @brief The responses shorter than this are not compressed.
+ */
+#define BLE_CUSTOM_HI_COMP_MIN_LEN      (64u)
+
 
 /***************************************
 * Data Types
@@ -70,17 +145,153 @@ typedef struct
     volatile uint8_t receive_flag;
     uint8_t reserve[3];
     uint16_t len;
-    uint8_t  buf[BLE_CUSTOM_CMD_BUFFER_SIZE];
+    uint16_t offset;                /* The next batch item to dispatch */
+    uint8_t  *buf;                  /* A block of the BLE packet buffer pool */
+    uint8_t  *res;                  /* The batch responses waiting for room in the control lane */
+    uint16_t res_len;
 } custom_command_buf_t;
 
+/**
+ * @brief One segment of a scatter-gather response.
+ */
+typedef struct
+{
+    const void *base;
+    uint16_t    len;
+} ble_custom_hi_iov_t;
+
+/**
+ * @brief The priority lanes of the response transmit queue.
+ */
+typedef enum
+{
+    BLE_CUSTOM_HI_LANE_CONTROL = 0,     /* Control and urgent responses */
+    BLE_CUSTOM_HI_LANE_BULK,            /* Bulk and streaming data */
+    BLE_CUSTOM_HI_LANE_NUM
+} ble_custom_hi_lane_t;
+
+/**
+ * @brief Per-lane transmit statistics.
+ */
+typedef struct
+{
+    uint32_t packets;
+    uint32_t bytes;
+    uint32_t dropped;
+    uint32_t wait_max_us;
+    uint64_t wait_total_us;
+} ble_custom_hi_lane_stats_t;
+
+
+/**
+ * @brief Per-connection transmit statistics, reset when the connection is established.
+ */
+typedef struct
+{
+    uint8_t  weight;                    /* The scheduler weight */
+    uint32_t packets;                   /* Notifications sent, stream included */
+    uint32_t bytes;
+    uint32_t dropped;                   /* Queued packets dropped */
+    uint32_t stack_busy;                /* Scheduler turns skipped, no free stack buffer on the link */
+    uint32_t throughput_bps;
+    uint32_t peak_bps;
+    uint32_t wait_avg_us;               /* The queueing delay of the lane packets */
+    uint32_t wait_max_us;
+} ble_custom_hi_conn_stats_t;
+
+/**
+ * @brief The statistics of the compressed responses.
+ */
+typedef struct
+{
+    uint32_t responses;                 /* Responses queued by ble_custom_hi_response_compressed() */
+    uint32_t compressed;                /* Responses sent compressed */
+    uint32_t bytes_in;                  /* The response bytes */
+    uint32_t bytes_out;                 /* The notification payload bytes, headers included */
+    uint32_t encode_us;                 /* The time spent in the encoder */
+} ble_custom_hi_comp_stats_t;
+
+/**
+ * @brief The payload copies made before the data reach the stack.
+ */
+typedef struct
+{
+    uint32_t copies;
+    uint32_t bytes;
+} ble_custom_hi_copy_stats_t;
+
+/**
+ * @brief The stream backpressure events.
+ */
+typedef enum
+{
+    BLE_CUSTOM_HI_STREAM_EVT_XOFF = 0,  /* The ring reached the high watermark, stop producing */
+    BLE_CUSTOM_HI_STREAM_EVT_XON        /* The ring drained to the low watermark, resume producing */
+} ble_custom_hi_stream_evt_t;
+
+/* The stream backpressure callback, it may be called from the producer context */
+typedef void (* ble_custom_hi_stream_callback_t)(ble_custom_hi_stream_evt_t event);
+
+/**
+ * @brief The stream configuration.
+ */
+typedef struct
+{
+    uint16_t high_watermark;
+    uint16_t low_watermark;
+    ble_custom_hi_stream_callback_t callback;
+    uint8_t  conn_id;                   /* The connection the stream is sent to */
+} ble_custom_hi_stream_config_t;
+
+/**
+ * @brief The stream statistics.
+ */
+typedef struct
+{
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint32_t bytes_dropped;
+    uint32_t notifications;
+    uint32_t partial_notifications;
+    uint32_t xoff_count;
+    uint32_t throughput_bps;
+    uint32_t peak_bps;
+} ble_custom_hi_stream_stats_t;
+
 
 /***************************************
 * Function Prototypes
 ***************************************/
 cy_en_ble_api_result_t ble_custom_hi_init(ble_custom_hi_config_t *config);
 void ble_custom_hi_service_evt_callback(uint32_t event, void* eventParam);
-cy_en_ble_api_result_t ble_custom_hi_response_fast(uint16_t len, void *res);
-cy_en_ble_api_result_t ble_custom_hi_response(uint16_t len, void *res);
+bool ble_custom_hi_is_connected(uint8_t conn_id);
+cy_en_ble_api_result_t ble_custom_hi_response_fast(uint8_t conn_id, uint16_t len, void *res);
+cy_en_ble_api_result_t ble_custom_hi_response(uint8_t conn_id, uint16_t len, void *res);
+cy_en_ble_api_result_t ble_custom_hi_response_v(uint8_t conn_id, const ble_custom_hi_iov_t *iov, uint32_t iovcnt);
+cy_en_ble_api_result_t ble_custom_hi_response_confirmed(uint8_t conn_id, uint16_t len, const void *res, ble_task_done_t done);
+uint16_t ble_custom_hi_get_payload_size(uint8_t conn_id);
+bool ble_custom_hi_is_idle(void);
+cy_en_ble_api_result_t ble_custom_hi_response_queue(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    const ble_custom_hi_iov_t *iov, uint32_t iovcnt);
+cy_en_ble_api_result_t ble_custom_hi_response_compressed(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                         const ble_custom_hi_iov_t *iov, uint32_t iovcnt);
+cy_en_ble_api_result_t ble_custom_hi_response_delta(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    uint8_t type, const void *data);
+void ble_custom_hi_tx_task(void);
+void ble_custom_hi_stack_reset(void);
+cy_en_ble_api_result_t ble_custom_hi_get_lane_stats(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    ble_custom_hi_lane_stats_t *stats);
+cy_en_ble_api_result_t ble_custom_hi_set_weight(uint8_t conn_id, uint8_t weight);
+cy_en_ble_api_result_t ble_custom_hi_get_conn_stats(uint8_t conn_id, ble_custom_hi_conn_stats_t *stats);
+void ble_custom_hi_print_conn_stats(void);
+cy_en_ble_api_result_t ble_custom_hi_get_comp_stats(ble_custom_hi_comp_stats_t *stats);
+void ble_custom_hi_print_comp_stats(void);
+cy_en_ble_api_result_t ble_custom_hi_get_copy_stats(ble_custom_hi_copy_stats_t *stats);
+cy_en_ble_api_result_t ble_custom_hi_stream_config(const ble_custom_hi_stream_config_t *config);
+uint32_t ble_custom_hi_stream_write(const void *data, uint32_t len);
+uint32_t ble_custom_hi_stream_free(void);
+void ble_custom_hi_stream_flush(void);
+cy_en_ble_api_result_t ble_custom_hi_get_stream_stats(ble_custom_hi_stream_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,313 @@
+/***************************************************************************//**
+* \file ble_delta.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE delta encoding of the periodic state responses.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_delta.h"
+
+/**
+ * @brief The last image of a type sent to a connection.
+ */
+typedef struct
+{
+    uint8_t  image[BLE_DELTA_IMAGE_MAX];
+    bool     valid;                 /* false until a keyframe is sent */
+    bool     key;                   /* The frame of ble_delta_encode() is a keyframe */
+    uint8_t  seq;
+    uint16_t since_key;             /* The frames sent since the last keyframe, that one included */
+} ble_delta_image_t;
+
+/* The registered types */
+static const ble_delta_desc_t *ble_delta_types[BLE_DELTA_TYPE_NUM];
+
+/* The images indexed by the connection ID and the type */
+static ble_delta_image_t ble_delta_images[CY_BLE_CONN_COUNT][BLE_DELTA_TYPE_NUM];
+
+/* The delta encoding statistics */
+static ble_delta_stats_t ble_delta_stats;
+
+
+/*******************************************************************************
+* Function Name: ble_delta_init
+****************************************************************************//**
+*
+* Initializes the delta encoding, the registered types and the images are
+* cleared.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_delta_init(void)
+{
+    memset(ble_delta_types, 0, sizeof(ble_delta_types));
+    memset(ble_delta_images, 0, sizeof(ble_delta_images));
+    memset(&ble_delta_stats, 0, sizeof(ble_delta_stats));
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_register
+****************************************************************************//**
+*
+* Registers a table of response type descriptors. The descriptors are
+* referenced, not copied, so the table must be kept valid (usually a const
+* table).
+*
+* \param table The response type descriptor table.
+*
+* \param count The number of descriptors in the table.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_delta_register(const ble_delta_desc_t *table, uint32_t count)
+{
+    uint32_t i;
+    uint32_t conn_id;
+
+    if(table == NULL) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    for(i = 0u; i < count; i++) {
+        if((table[i].type >= BLE_DELTA_TYPE_NUM) || (table[i].size == 0u) || \
+           (table[i].size > BLE_DELTA_IMAGE_MAX)) {
+            BLE_DBG_PRINTF("ble_delta_register invalid descriptor %d\r\n", (int)i);
+            return CY_BLE_ERROR_INVALID_PARAMETER;
+        }
+    }
+    for(i = 0u; i < count; i++) {
+        ble_delta_types[table[i].type] = &table[i];
+        for(conn_id = 0u; conn_id < CY_BLE_CONN_COUNT; conn_id++) {
+            ble_delta_images[conn_id][table[i].type].valid = false;
+        }
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_reset
+****************************************************************************//**
+*
+* Forgets the images of a connection, the next frame of each type is a
+* keyframe. It is called when the connection starts or ends.
+*
+* \param conn_id The connection ID.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_delta_reset(uint8_t conn_id)
+{
+    if(conn_id < CY_BLE_CONN_COUNT) {
+        memset(ble_delta_images[conn_id], 0, sizeof(ble_delta_images[conn_id]));
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_keyframe
+****************************************************************************//**
+*
+* Requests a keyframe, such as when the host lost a frame. The next update of
+* the type to the connection is sent in full even if it did not change.
+*
+* \param conn_id The connection ID.
+*
+* \param type The response type.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_delta_keyframe(uint8_t conn_id, uint8_t type)
+{
+    if((conn_id >= CY_BLE_CONN_COUNT) || (type >= BLE_DELTA_TYPE_NUM) || (ble_delta_types[type] == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    ble_delta_images[conn_id][type].valid = false;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_encode
+****************************************************************************//**
+*
+* Builds the frame of an update against the last image sent to the
+* connection. A keyframe is built for the first update, on request, every
+* keyframe_interval frames, or when the delta would not be smaller. No frame
+* is built if the image did not change. The image is kept only by
+* ble_delta_commit() once the frame is queued.
+*
+* \param conn_id The connection ID.
+*
+* \param type The response type.
+*
+* \param data The new image of the registered size.
+*
+* \param frame The frame buffer.
+*
+* \param size The frame buffer size, at least BLE_DELTA_HEADER_LEN plus the
+* image size.
+*
+* \param len The frame size is returned here, 0 if there is nothing to send.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_delta_encode(uint8_t conn_id, uint8_t type, const void *data, \
+                                        uint8_t *frame, uint16_t size, uint16_t *len)
+{
+    const ble_delta_desc_t *desc;
+    const uint8_t *src = (const uint8_t *)data;
+    ble_delta_image_t *img;
+    uint16_t fill;
+    uint16_t off;
+    uint16_t block;
+    uint16_t n;
+    bool key;
+
+    if((conn_id >= CY_BLE_CONN_COUNT) || (type >= BLE_DELTA_TYPE_NUM) || \
+       (NULL == (desc = ble_delta_types[type])) || (data == NULL) || (frame == NULL) || (len == NULL) || \
+       (size < (BLE_DELTA_HEADER_LEN + desc->size))) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    *len = 0u;
+    img = &ble_delta_images[conn_id][type];
+    key = (!img->valid) || ((desc->keyframe_interval != 0u) && (img->since_key >= desc->keyframe_interval));
+#if (ENABLE_RESPONSE_DELTA_FUNCTION == DISABLED)
+    key = true;
+#endif
+    frame[0] = BLE_DELTA_MARKER;
+    frame[1] = type;
+    frame[2] = img->seq & BLE_DELTA_CTRL_SEQ_MASK;
+    if(!key) {
+        fill = BLE_DELTA_HEADER_LEN + BLE_DELTA_BITMAP_LEN(desc->size);
+        memset(&frame[BLE_DELTA_HEADER_LEN], 0, BLE_DELTA_BITMAP_LEN(desc->size));
+        for(off = 0u, block = 0u; off < desc->size; off += BLE_DELTA_BLOCK_LEN, block++) {
+            n = (uint16_t)(desc->size - off);
+            if(n > BLE_DELTA_BLOCK_LEN) {
+                n = BLE_DELTA_BLOCK_LEN;
+            }
+            if(0 != memcmp(&img->image[off], &src[off], n)) {
+                if((fill + n) >= (BLE_DELTA_HEADER_LEN + desc->size)) {
+                    /* The delta is not smaller than the image */
+                    key = true;
+                    break;
+                }
+                frame[BLE_DELTA_HEADER_LEN + (block / 8u)] |= (uint8_t)(1u << (block % 8u));
+                memcpy(&frame[fill], &src[off], n);
+                fill += n;
+            }
+        }
+        if((!key) && (fill == (BLE_DELTA_HEADER_LEN + BLE_DELTA_BITMAP_LEN(desc->size)))) {
+            ble_delta_stats.unchanged++;
+            return CY_BLE_SUCCESS;
+        }
+    }
+    if(key) {
+        frame[2] |= BLE_DELTA_CTRL_KEY;
+        memcpy(&frame[BLE_DELTA_HEADER_LEN], src, desc->size);
+        fill = BLE_DELTA_HEADER_LEN + desc->size;
+    }
+    img->key = key;
+    *len = fill;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_commit
+****************************************************************************//**
+*
+* Keeps the image of the frame of ble_delta_encode() once the frame is queued,
+* the next update is encoded against it.
+*
+* \param conn_id The connection ID.
+*
+* \param type The response type.
+*
+* \param data The image given to ble_delta_encode().
+*
+* \param len The frame size.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_delta_commit(uint8_t conn_id, uint8_t type, const void *data, uint16_t len)
+{
+    ble_delta_image_t *img;
+
+    if((conn_id >= CY_BLE_CONN_COUNT) || (type >= BLE_DELTA_TYPE_NUM) || (ble_delta_types[type] == NULL)) {
+        return;
+    }
+    img = &ble_delta_images[conn_id][type];
+    memcpy(img->image, data, ble_delta_types[type]->size);
+    img->valid = true;
+    img->seq++;
+    if(img->key) {
+        img->since_key = 1u;
+        ble_delta_stats.keyframes++;
+    } else {
+        img->since_key++;
+    }
+    ble_delta_stats.frames++;
+    ble_delta_stats.bytes_full += BLE_DELTA_HEADER_LEN + ble_delta_types[type]->size;
+    ble_delta_stats.bytes_sent += len;
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_get_stats
+****************************************************************************//**
+*
+* Gets the delta encoding statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_delta_get_stats(ble_delta_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_delta_stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_delta_print_stats
+****************************************************************************//**
+*
+* Prints the delta encoding statistics, saved is the share of the keyframe
+* bytes not sent.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_delta_print_stats(void)
+{
+    uint32_t saved = 0u;
+
+    if(ble_delta_stats.bytes_full != 0u) {
+        saved = (uint32_t)(((uint64_t)(ble_delta_stats.bytes_full - ble_delta_stats.bytes_sent) * 100u) / \
+                           ble_delta_stats.bytes_full);
+    }
+    BLE_DBG_PRINTF("Delta: frames=%lu (keyframes %lu), unchanged=%lu, full=%lu, sent=%lu, saved=%lu%%\r\n", \
+        (unsigned long)ble_delta_stats.frames, (unsigned long)ble_delta_stats.keyframes, \
+        (unsigned long)ble_delta_stats.unchanged, (unsigned long)ble_delta_stats.bytes_full, \
+        (unsigned long)ble_delta_stats.bytes_sent, (unsigned long)saved);
+}
+
+/* [] END OF FILE */
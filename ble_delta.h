@@ -0,0 +1,121 @@
+/***************************************************************************//**
+* \file ble_delta.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE delta encoding of the periodic state responses.
+*
+* A registered response type is a fixed-size state image, such as a status
+* structure. The last image sent to each connection is kept and an update
+* only carries the blocks of BLE_DELTA_BLOCK_LEN bytes which changed since:
+*
+* Keyframe: | BLE_DELTA_MARKER | type(1) | ctrl(1) | image(size) |
+* Delta:    | BLE_DELTA_MARKER | type(1) | ctrl(1) | bitmap(n) | changed blocks |
+*
+* Bit i of the bitmap (byte i / 8, LSB first) is set if block i changed, the
+* changed blocks follow in order and the last block of the image may be
+* short. The ctrl byte holds BLE_DELTA_CTRL_KEY and the frame sequence number
+* of the type; a host which misses a frame waits for the next keyframe or
+* asks for one.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_DELTA_H_
+#define _BLE_DELTA_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The first byte of the delta frames, it is not the first byte of the
+ *        other responses (opcodes 0x00 ~ 0x3F, batch 0x80, compressed 0xC0).
+ */
+#define BLE_DELTA_MARKER                    (0xD0u)
+#define BLE_DELTA_HEADER_LEN                (3u)
+
+/**
+ * @brief The ctrl byte: the keyframe flag and the sequence number.
+ */
+#define BLE_DELTA_CTRL_KEY                  (0x80u)
+#define BLE_DELTA_CTRL_SEQ_MASK             (0x7Fu)
+
+/**
+ * @brief The number of response types and the largest image. Each connection
+ *        keeps an image of each type, so the RAM is
+ *        CY_BLE_CONN_COUNT * BLE_DELTA_TYPE_NUM * BLE_DELTA_IMAGE_MAX.
+ */
+#ifndef BLE_DELTA_TYPE_NUM
+#define BLE_DELTA_TYPE_NUM                  (4u)
+#endif
+#ifndef BLE_DELTA_IMAGE_MAX
+#define BLE_DELTA_IMAGE_MAX                 (128u)
+#endif
+
+/**
+ * @brief The change granularity, one bitmap bit per block.
+ */
+#define BLE_DELTA_BLOCK_LEN                 (4u)
+#define BLE_DELTA_BITMAP_LEN(size)          (((((size) + BLE_DELTA_BLOCK_LEN - 1u) / BLE_DELTA_BLOCK_LEN) + 7u) / 8u)
+
+/**
+ * @brief The largest frame of a type, a keyframe.
+ */
+#define BLE_DELTA_FRAME_MAX                 (BLE_DELTA_HEADER_LEN + BLE_DELTA_IMAGE_MAX)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The response type descriptor, usually placed in a const table.
+ */
+typedef struct
+{
+    uint8_t  type;                  /* 0 ~ (BLE_DELTA_TYPE_NUM - 1) */
+    uint16_t size;                  /* The image size, 1 ~ BLE_DELTA_IMAGE_MAX */
+    uint16_t keyframe_interval;     /* A keyframe every this many frames, 0 for none */
+} ble_delta_desc_t;
+
+/**
+ * @brief The delta encoding statistics.
+ */
+typedef struct
+{
+    uint32_t frames;                /* Frames sent */
+    uint32_t keyframes;             /* Keyframes among them */
+    uint32_t unchanged;             /* Updates not sent, the image did not change */
+    uint32_t bytes_full;            /* The bytes of the frames as keyframes */
+    uint32_t bytes_sent;            /* The bytes of the frames sent */
+} ble_delta_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_delta_init(void);
+cy_en_ble_api_result_t ble_delta_register(const ble_delta_desc_t *table, uint32_t count);
+void ble_delta_reset(uint8_t conn_id);
+cy_en_ble_api_result_t ble_delta_keyframe(uint8_t conn_id, uint8_t type);
+cy_en_ble_api_result_t ble_delta_encode(uint8_t conn_id, uint8_t type, const void *data, \
+                                        uint8_t *frame, uint16_t size, uint16_t *len);
+void ble_delta_commit(uint8_t conn_id, uint8_t type, const void *data, uint16_t len);
+void ble_delta_get_stats(ble_delta_stats_t *stats);
+void ble_delta_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_DELTA_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,202 @@
+/***************************************************************************//**
+* \file ble_event.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE application event flags.
+*
+* The BLE callback, timers and interrupts post event flags, the run loop
+* waits for the flags and sleeps only when no flag is pending. The wakeups
+* and the time spent in low power modes are counted with the time base.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_event.h"
+#include "ble_time.h"
+#include "ble_power.h"
+#if defined(COMPONENT_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+/**
+ * @brief The pending event flags.
+ */
+static volatile uint32_t ble_event_pending;
+
+/**
+ * @brief The run loop statistics and the start time of the measurement.
+ */
+static ble_event_stats_t ble_event_stats;
+static uint32_t ble_event_stats_start;
+
+#if defined(COMPONENT_FREERTOS)
+/**
+ * @brief The task waiting in ble_event_wait(), it is notified by ble_event_post().
+ */
+static TaskHandle_t volatile ble_event_task = NULL;
+#endif
+
+
+/*******************************************************************************
+* Function Name: ble_event_post
+****************************************************************************//**
+*
+* Posts the event flags to the run loop, it can be called from interrupts
+* and, in the FreeRTOS build, from any task.
+*
+* \param events The event flags, see BLE_EVENT_xxx.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_event_post(uint32_t events)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+
+    ble_event_pending |= events;
+    ble_event_stats.posts++;
+    Cy_SysLib_ExitCriticalSection(intr);
+#if defined(COMPONENT_FREERTOS)
+    if(ble_event_task != NULL) {
+        if(__get_IPSR() != 0u) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(ble_event_task, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            (void)xTaskNotifyGive(ble_event_task);
+        }
+    }
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_event_poll
+****************************************************************************//**
+*
+* Gets and clears the pending event flags without waiting.
+*
+* \param none.
+*
+* \return The pending event flags.
+*
+*******************************************************************************/
+uint32_t ble_event_poll(void)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+    uint32_t events = ble_event_pending;
+
+    ble_event_pending = 0u;
+    Cy_SysLib_ExitCriticalSection(intr);
+    return events;
+}
+
+/*******************************************************************************
+* Function Name: ble_event_wait
+****************************************************************************//**
+*
+* Waits for the event flags. The CPU enters Deep Sleep (or Sleep while the
+* debug UART is transmitting) only if no flag is pending. The check and the
+* sleep are done with the interrupts masked, so a flag posted by an interrupt
+* can not be missed; the interrupt is serviced after the wakeup.
+* In the FreeRTOS build the calling task blocks on its notification instead,
+* the sleep statistics count the blocked time and the idle task sleeps.
+*
+* \param none.
+*
+* \return The pending event flags, they are cleared.
+*
+*******************************************************************************/
+uint32_t ble_event_wait(void)
+{
+    uint32_t intr;
+    uint32_t events;
+    uint32_t start;
+
+#if defined(COMPONENT_FREERTOS)
+    (void)intr;
+    ble_event_task = xTaskGetCurrentTaskHandle();
+    for(;;)
+    {
+        events = ble_event_poll();
+        if(events != 0u) {
+            return events;
+        }
+        start = ble_time_now();
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ble_event_stats.sleep_ticks += ble_time_now() - start;
+        ble_event_stats.wakeups++;
+    }
+#else
+    for(;;)
+    {
+        intr = Cy_SysLib_EnterCriticalSection();
+        events = ble_event_pending;
+        if(events != 0u) {
+            ble_event_pending = 0u;
+            Cy_SysLib_ExitCriticalSection(intr);
+            return events;
+        }
+        start = ble_time_now();
+        /* Entering into the Deep Sleep or the CPU Sleep */
+        (void)ble_power_enter(ble_power_select());
+        ble_event_stats.sleep_ticks += ble_time_now() - start;
+        ble_event_stats.wakeups++;
+        /* The wakeup interrupt is serviced here */
+        Cy_SysLib_ExitCriticalSection(intr);
+        ble_power_wakeup(ble_event_pending);
+    }
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_event_get_stats
+****************************************************************************//**
+*
+* Gets the run loop statistics since the last reset.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_event_get_stats(ble_event_stats_t *stats)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+
+    *stats = ble_event_stats;
+    Cy_SysLib_ExitCriticalSection(intr);
+    stats->elapsed_ticks = ble_time_now() - ble_event_stats_start;
+    if(stats->elapsed_ticks != 0u) {
+        stats->wakeups_per_sec = (uint32_t)(((uint64_t)stats->wakeups * BLE_TIME_TICK_HZ) / stats->elapsed_ticks);
+        stats->sleep_permille = (uint32_t)(((uint64_t)stats->sleep_ticks * 1000u) / stats->elapsed_ticks);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_event_reset_stats
+****************************************************************************//**
+*
+* Resets the run loop statistics and starts a new measurement.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_event_reset_stats(void)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+
+    memset(&ble_event_stats, 0, sizeof(ble_event_stats));
+    ble_event_stats_start = ble_time_now();
+    Cy_SysLib_ExitCriticalSection(intr);
+}
+
+/* [] END OF FILE */
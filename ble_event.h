@@ -0,0 +1,74 @@
+/***************************************************************************//**
+* \file ble_event.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE application event flags.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_EVENT_H_
+#define _BLE_EVENT_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The event flags of the run loop.
+ */
+#define BLE_EVENT_STACK                     (1uL << 0u)    /* The BLE stack needs Cy_BLE_ProcessEvents() */
+#define BLE_EVENT_COMMAND                   (1uL << 1u)    /* A custom command is queued */
+#define BLE_EVENT_TX                        (1uL << 2u)    /* Response data is queued or the stack is free */
+#define BLE_EVENT_ADV                       (1uL << 3u)    /* The advertisement state or connection count changed */
+#define BLE_EVENT_FLASH                     (1uL << 4u)    /* The bonding data need to be stored */
+#define BLE_EVENT_TIMER                     (1uL << 5u)    /* A timer expired */
+#define BLE_EVENT_UART                      (1uL << 6u)    /* Debug UART data received */
+#define BLE_EVENT_TASK                      (1uL << 7u)    /* A cooperative task is ready to run */
+#define BLE_EVENT_QUEUE                     (1uL << 8u)    /* A response is submitted by another RTOS task */
+#define BLE_EVENT_IPC                       (1uL << 9u)    /* An IPC descriptor ring is updated */
+#define BLE_EVENT_USER(n)                   (1uL << (16u + (n)))   /* Application events, n = 0 ~ 15 */
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The run loop statistics.
+ */
+typedef struct
+{
+    uint32_t wakeups;
+    uint32_t posts;
+    uint32_t sleep_ticks;
+    uint32_t elapsed_ticks;
+    uint32_t wakeups_per_sec;
+    uint32_t sleep_permille;
+} ble_event_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_event_post(uint32_t events);
+uint32_t ble_event_wait(void);
+uint32_t ble_event_poll(void);
+void ble_event_get_stats(ble_event_stats_t *stats);
+void ble_event_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_EVENT_H_ */
+
+/* [] END OF FILE */
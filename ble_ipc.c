@@ -0,0 +1,395 @@
+/***************************************************************************//**
+* \file ble_ipc.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE inter-core command offload.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "ble_ipc.h"
+
+#if defined(COMPONENT_BLESS_HOST_IPC)
+
+#include <string.h>
+#include "ble_custom_cmd.h"
+#include "ble_event.h"
+#include "ble_pool.h"
+#include "ble_timer.h"
+
+/**
+ * @brief The shared memory, not initialized during the device startup.
+ */
+CY_SECTION(".cy_sharedmem") static ble_ipc_shared_t ble_ipc_shared;
+
+/**
+ * @brief The free shared buffers, CM4 only.
+ */
+static uint32_t ble_ipc_buf_free = 0u;
+static uint32_t ble_ipc_buf_free_num = 0u;
+
+/**
+ * @brief The offload statistics and the start time of the throughput.
+ */
+static ble_ipc_stats_t ble_ipc_stats;
+static uint32_t ble_ipc_start_ms = 0u;
+
+
+/*******************************************************************************
+* Function Name: ble_ipc_ring_push
+****************************************************************************//**
+*
+* Writes a descriptor to a ring, producer only. The ring is never full since
+* it has a slot for every shared buffer.
+*
+* \param ring The ring.
+*
+* \param desc The descriptor.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_ipc_ring_push(ble_ipc_ring_t *ring, const ble_ipc_desc_t *desc)
+{
+    uint32_t head = ring->head;
+
+    ring->desc[head & (BLE_IPC_BUF_NUM - 1u)] = *desc;
+    /* The descriptor and the buffer are visible before the head */
+    __DMB();
+    ring->head = head + 1u;
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_ring_peek
+****************************************************************************//**
+*
+* Gets the oldest descriptor of a ring, consumer only.
+*
+* \param ring The ring.
+*
+* \return The descriptor, NULL if the ring is empty.
+*
+*******************************************************************************/
+static ble_ipc_desc_t *ble_ipc_ring_peek(ble_ipc_ring_t *ring)
+{
+    uint32_t tail = ring->tail;
+
+    if(tail == ring->head) {
+        return NULL;
+    }
+    __DMB();
+    return &ring->desc[tail & (BLE_IPC_BUF_NUM - 1u)];
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_ring_advance
+****************************************************************************//**
+*
+* Releases the oldest descriptor of a ring, consumer only.
+*
+* \param ring The ring.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_ipc_ring_advance(ble_ipc_ring_t *ring)
+{
+    /* The descriptor is read before its slot is given back */
+    __DMB();
+    ring->tail = ring->tail + 1u;
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_doorbell
+****************************************************************************//**
+*
+* Notifies the consumer of a ring. If the channel is still locked, the
+* previous notify is not handled yet and the consumer sees the new descriptor
+* when it drains the ring.
+*
+* \param chan The IPC channel of the ring.
+*
+* \param intr The IPC interrupt structure of the consumer.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_ipc_doorbell(uint32_t chan, uint32_t intr)
+{
+    if(CY_IPC_DRV_SUCCESS == Cy_IPC_Drv_SendMsgWord(Cy_IPC_Drv_GetIpcBaseAddress(chan), 1uL << intr, 0u)) {
+        ble_ipc_stats.doorbells++;
+    } else {
+        ble_ipc_stats.coalesced++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_interrupt
+****************************************************************************//**
+*
+* The IPC interrupt of the CM4, acknowledges the doorbells and posts
+* BLE_EVENT_IPC.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_ipc_interrupt(void)
+{
+    IPC_INTR_STRUCT_Type *intr = Cy_IPC_Drv_GetIntrBaseAddr(BLE_IPC_INTR_CM4);
+    uint32_t notify = Cy_IPC_Drv_ExtractAcquireMask(Cy_IPC_Drv_GetInterruptStatusMasked(intr));
+
+    Cy_IPC_Drv_ClearInterrupt(intr, CY_IPC_NO_NOTIFICATION, notify);
+    if(0u != (notify & (1uL << BLE_IPC_CHAN_CMD))) {
+        (void)Cy_IPC_Drv_LockRelease(Cy_IPC_Drv_GetIpcBaseAddress(BLE_IPC_CHAN_CMD), CY_IPC_NO_NOTIFICATION);
+    }
+    if(0u != (notify & (1uL << BLE_IPC_CHAN_RES))) {
+        (void)Cy_IPC_Drv_LockRelease(Cy_IPC_Drv_GetIpcBaseAddress(BLE_IPC_CHAN_RES), CY_IPC_NO_NOTIFICATION);
+    }
+    ble_event_post(BLE_EVENT_IPC);
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_command_forward
+****************************************************************************//**
+*
+* The forward hook of the command framework, copies the command frame to a
+* shared buffer and sends its descriptor to the peer. The pool block of the
+* frame is not visible to the peer core, it is freed once copied.
+*
+* \param conn_id The connection ID.
+*
+* \param cmd The command frame, in a block of the pool.
+*
+* \param len The command frame size.
+*
+* \return true if the command is sent.
+*
+*******************************************************************************/
+static bool ble_ipc_command_forward(uint8_t conn_id, uint8_t *cmd, uint16_t len)
+{
+    ble_ipc_desc_t desc;
+
+    if((ble_ipc_buf_free == 0u) || (len > BLE_IPC_BUF_SIZE)) {
+        ble_ipc_stats.busy++;
+        return false;
+    }
+    desc.buf = (uint8_t)__CLZ(__RBIT(ble_ipc_buf_free));
+    ble_ipc_buf_free &= ~(1uL << desc.buf);
+    if(--ble_ipc_buf_free_num < ble_ipc_stats.buf_min_free) {
+        ble_ipc_stats.buf_min_free = ble_ipc_buf_free_num;
+    }
+
+    memcpy(ble_ipc_shared.buf[desc.buf], cmd, len);
+    ble_pool_free(cmd);
+    desc.len = len;
+    desc.lane = (uint8_t)BLE_CUSTOM_HI_LANE_BULK;
+    desc.conn = conn_id;
+    desc.reserve = 0u;
+    desc.stamp = DWT->CYCCNT;
+    ble_ipc_ring_push(&ble_ipc_shared.cmd, &desc);
+    ble_ipc_stats.commands++;
+    ble_ipc_stats.cmd_bytes += len;
+    ble_ipc_doorbell(BLE_IPC_CHAN_CMD, BLE_IPC_INTR_PEER);
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_init
+****************************************************************************//**
+*
+* Initializes the shared memory and the doorbell interrupt of the CM4, and
+* takes the forward hook of the command framework. It should be called after
+* ble_app_init().
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_ipc_init(void)
+{
+    const cy_stc_sysint_t intr_cfg =
+    {
+        .intrSrc = (IRQn_Type)((uint32_t)cpuss_interrupts_ipc_0_IRQn + BLE_IPC_INTR_CM4),
+        .intrPriority = BLE_IPC_INTR_PRIORITY,
+    };
+    uint32_t notify_mask = 1uL << BLE_IPC_CHAN_RES;
+
+#if (BLE_IPC_PEER_LOOPBACK == ENABLED)
+    notify_mask |= 1uL << BLE_IPC_CHAN_CMD;
+#endif
+    ble_ipc_shared.magic = 0u;
+    memset(&ble_ipc_shared.cmd, 0, sizeof(ble_ipc_shared.cmd));
+    memset(&ble_ipc_shared.res, 0, sizeof(ble_ipc_shared.res));
+    ble_ipc_buf_free = (1uL << BLE_IPC_BUF_NUM) - 1u;
+    ble_ipc_buf_free_num = BLE_IPC_BUF_NUM;
+    memset(&ble_ipc_stats, 0, sizeof(ble_ipc_stats));
+    ble_ipc_stats.buf_min_free = BLE_IPC_BUF_NUM;
+    ble_ipc_start_ms = ble_timer_now();
+    __DMB();
+    ble_ipc_shared.magic = BLE_IPC_MAGIC;
+
+    Cy_IPC_Drv_SetInterruptMask(Cy_IPC_Drv_GetIntrBaseAddr(BLE_IPC_INTR_CM4), CY_IPC_NO_NOTIFICATION, notify_mask);
+    if(CY_SYSINT_SUCCESS != Cy_SysInt_Init(&intr_cfg, ble_ipc_interrupt)) {
+        return CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    NVIC_ClearPendingIRQ(intr_cfg.intrSrc);
+    NVIC_EnableIRQ(intr_cfg.intrSrc);
+
+    ble_custom_cmd_set_forward(ble_ipc_command_forward);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_process
+****************************************************************************//**
+*
+* Moves the responses of the peer to the transmit queue, the frames are
+* queued from the shared buffers. When a lane is full, the queued packets are
+* sent first; if the stack is busy the response waits for the next
+* BLE_EVENT_TX. This function should be called on BLE_EVENT_IPC and
+* BLE_EVENT_TX.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ipc_process(void)
+{
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_iov_t iov;
+    ble_ipc_desc_t *desc;
+    uint32_t cycles;
+
+    while(NULL != (desc = ble_ipc_ring_peek(&ble_ipc_shared.res))) {
+        if(desc->len != 0u) {
+            iov.base = ble_ipc_shared.buf[desc->buf];
+            iov.len = desc->len;
+            apiResult = ble_custom_hi_response_queue(desc->conn, (ble_custom_hi_lane_t)desc->lane, &iov, 1u);
+            if(apiResult == CY_BLE_ERROR_INSUFFICIENT_RESOURCES) {
+                ble_custom_hi_tx_task();
+                apiResult = ble_custom_hi_response_queue(desc->conn, (ble_custom_hi_lane_t)desc->lane, &iov, 1u);
+                if(apiResult == CY_BLE_ERROR_INSUFFICIENT_RESOURCES) {
+                    break;
+                }
+            }
+            if(apiResult == CY_BLE_SUCCESS) {
+                ble_ipc_stats.res_bytes += desc->len;
+            } else {
+                ble_ipc_stats.dropped++;
+            }
+        }
+        cycles = DWT->CYCCNT - desc->stamp;
+        ble_ipc_stats.latency_cycles += cycles;
+        if(cycles > ble_ipc_stats.latency_max) {
+            ble_ipc_stats.latency_max = cycles;
+        }
+        ble_ipc_stats.responses++;
+        ble_ipc_buf_free |= 1uL << desc->buf;
+        ble_ipc_buf_free_num++;
+        ble_ipc_ring_advance(&ble_ipc_shared.res);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_peer_process
+****************************************************************************//**
+*
+* The peer side, handles the command descriptors and returns the response
+* descriptors in the same buffers. It runs on the peer doorbell interrupt, or
+* in the CM4 run loop on BLE_EVENT_IPC with BLE_IPC_PEER_LOOPBACK.
+*
+* \param handler The command handler.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ipc_peer_process(ble_ipc_handler_t handler)
+{
+    ble_ipc_desc_t *cmd;
+    ble_ipc_desc_t res;
+    bool done = false;
+
+    if((handler == NULL) || (ble_ipc_shared.magic != BLE_IPC_MAGIC)) {
+        return;
+    }
+    while(NULL != (cmd = ble_ipc_ring_peek(&ble_ipc_shared.cmd))) {
+        res = *cmd;
+        ble_ipc_ring_advance(&ble_ipc_shared.cmd);
+        res.len = handler(ble_ipc_shared.buf[res.buf], res.len, BLE_IPC_BUF_SIZE);
+        if(res.len > BLE_IPC_BUF_SIZE) {
+            res.len = BLE_IPC_BUF_SIZE;
+        }
+        ble_ipc_ring_push(&ble_ipc_shared.res, &res);
+        done = true;
+    }
+    if(done) {
+        ble_ipc_doorbell(BLE_IPC_CHAN_RES, BLE_IPC_INTR_CM4);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_get_stats
+****************************************************************************//**
+*
+* Gets the offload statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ipc_get_stats(ble_ipc_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_ipc_stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ipc_print_stats
+****************************************************************************//**
+*
+* Prints the offload statistics, the round trip latency and the throughput
+* since ble_ipc_init().
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ipc_print_stats(void)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+    uint32_t elapsed = ble_timer_now() - ble_ipc_start_ms;
+    uint32_t avg = 0u;
+
+    if(ble_ipc_stats.responses != 0u) {
+        avg = (uint32_t)(ble_ipc_stats.latency_cycles / ble_ipc_stats.responses);
+    }
+    if(elapsed == 0u) {
+        elapsed = 1u;
+    }
+    BLE_DBG_PRINTF("IPC: commands=%lu, responses=%lu, busy=%lu, dropped=%lu, doorbells=%lu (coalesced %lu), min free=%lu\r\n", \
+        (unsigned long)ble_ipc_stats.commands, (unsigned long)ble_ipc_stats.responses, \
+        (unsigned long)ble_ipc_stats.busy, (unsigned long)ble_ipc_stats.dropped, \
+        (unsigned long)ble_ipc_stats.doorbells, (unsigned long)ble_ipc_stats.coalesced, \
+        (unsigned long)ble_ipc_stats.buf_min_free);
+    BLE_DBG_PRINTF("IPC: latency avg=%luus max=%luus, throughput cmd=%luB/s res=%luB/s\r\n", \
+        (unsigned long)(avg / cycles_per_us), (unsigned long)(ble_ipc_stats.latency_max / cycles_per_us), \
+        (unsigned long)(((uint64_t)ble_ipc_stats.cmd_bytes * 1000u) / elapsed), \
+        (unsigned long)(((uint64_t)ble_ipc_stats.res_bytes * 1000u) / elapsed));
+}
+
+#endif /* defined(COMPONENT_BLESS_HOST_IPC) */
+
+/* [] END OF FILE */
@@ -0,0 +1,161 @@
+/***************************************************************************//**
+* \file ble_ipc.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE inter-core command offload.
+*
+* In the BLE Dual CPU Mode (BLE_STACK_MODE=DUAL in the Makefile) the commands
+* without a handler are passed to the peer core by descriptor. The command
+* frame is written once into a buffer of the shared memory (the .cy_sharedmem
+* section of the dual CPU linker scripts), the peer builds the response in the
+* same buffer and returns the descriptor. Two single producer rings carry the
+* descriptors, an IPC channel notify is the doorbell of each ring.
+*
+* The CM0+ image of the CM0P_BLESS component is prebuilt and runs only the
+* BLE controller, so with BLE_IPC_PEER_LOOPBACK the peer side runs on the CM4
+* in the run loop. With a custom CM0+ image the loopback is disabled and the
+* CM0+ calls ble_ipc_peer_process() on its doorbell interrupt.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_IPC_H_
+#define _BLE_IPC_H_
+
+#if defined(COMPONENT_BLESS_HOST_IPC)
+
+#include "ble_common.h"
+#include "ble_custom_hi.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The number of shared buffers, it is also the size of the rings so a
+ *        ring is never full. It must be a power of 2.
+ */
+#define BLE_IPC_BUF_NUM                     (8u)
+#define BLE_IPC_BUF_SIZE                    (BLE_CUSTOM_RES_BUFFER_SIZE)
+
+/**
+ * @brief The shared memory is initialized, checked by the peer.
+ */
+#define BLE_IPC_MAGIC                       (0x42495043uL)
+
+/**
+ * @brief The peer side runs on the CM4, see the file description.
+ */
+#if !defined(BLE_IPC_PEER_LOOPBACK)
+#define BLE_IPC_PEER_LOOPBACK               ENABLED
+#endif
+
+/**
+ * @brief The IPC channels of the doorbells and the IPC interrupt structures
+ *        of the cores. The notify of a channel is acknowledged by releasing it.
+ */
+#define BLE_IPC_CHAN_CMD                    (CY_IPC_CHAN_USER)
+#define BLE_IPC_CHAN_RES                    (CY_IPC_CHAN_USER + 1u)
+#define BLE_IPC_INTR_CM4                    (CY_IPC_INTR_USER)
+#if (BLE_IPC_PEER_LOOPBACK == ENABLED)
+#define BLE_IPC_INTR_PEER                   (BLE_IPC_INTR_CM4)
+#else
+#define BLE_IPC_INTR_PEER                   (CY_IPC_INTR_USER + 1u)
+#endif
+#define BLE_IPC_INTR_PRIORITY               (3u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The descriptor of a command or response frame.
+ */
+typedef struct
+{
+    uint8_t  buf;                   /* The shared buffer index */
+    uint8_t  lane;                  /* The transmit lane of the response */
+    uint8_t  conn;                  /* The connection ID of the command and its response */
+    uint8_t  reserve;
+    uint16_t len;                   /* The frame size */
+    uint32_t stamp;                 /* The CM4 cycle count when the command is sent */
+} ble_ipc_desc_t;
+
+/**
+ * @brief The descriptor ring, the head is written only by the producer and
+ *        the tail only by the consumer. The indexes are free running.
+ */
+typedef struct
+{
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    ble_ipc_desc_t desc[BLE_IPC_BUF_NUM];
+} ble_ipc_ring_t;
+
+/**
+ * @brief The shared memory of the cores.
+ */
+typedef struct
+{
+    volatile uint32_t magic;
+    ble_ipc_ring_t cmd;             /* CM4 to peer */
+    ble_ipc_ring_t res;             /* Peer to CM4 */
+    uint8_t buf[BLE_IPC_BUF_NUM][BLE_IPC_BUF_SIZE];
+} ble_ipc_shared_t;
+
+/**
+ * @brief The peer command handler, it replaces the command frame in the buffer
+ *        with the response frame.
+ *
+ * \param buf  The command frame, the response frame is written here.
+ * \param len  The command frame size.
+ * \param size The buffer size.
+ *
+ * \return The response frame size, 0 for no response.
+ */
+typedef uint16_t (* ble_ipc_handler_t)(uint8_t *buf, uint16_t len, uint16_t size);
+
+/**
+ * @brief The offload statistics.
+ */
+typedef struct
+{
+    uint32_t commands;              /* Command descriptors sent */
+    uint32_t responses;             /* Response descriptors received */
+    uint32_t busy;                  /* Commands answered busy, no free buffer */
+    uint32_t dropped;               /* Responses dropped by the transmit queue */
+    uint32_t doorbells;             /* Doorbells rung */
+    uint32_t coalesced;             /* Doorbells skipped, the previous one is pending */
+    uint32_t cmd_bytes;
+    uint32_t res_bytes;
+    uint32_t buf_min_free;          /* The low water mark of the free buffers */
+    uint32_t latency_max;           /* The maximum round trip in cycles */
+    uint64_t latency_cycles;        /* The sum of the round trips in cycles */
+} ble_ipc_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+cy_en_ble_api_result_t ble_ipc_init(void);
+void ble_ipc_process(void);
+void ble_ipc_peer_process(ble_ipc_handler_t handler);
+void ble_ipc_get_stats(ble_ipc_stats_t *stats);
+void ble_ipc_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* defined(COMPONENT_BLESS_HOST_IPC) */
+
+#endif /* _BLE_IPC_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,228 @@
+/***************************************************************************//**
+* \file ble_lz.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE streaming LZ compression.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_lz.h"
+
+/**
+ * @brief The ring index of a position.
+ */
+#define BLE_LZ_RING_INDEX(pos)              ((pos) & (BLE_LZ_RING_SIZE - 1u))
+
+/**
+ * @brief The number of items of a group.
+ */
+#define BLE_LZ_GROUP_ITEMS                  (8u)
+
+
+/*******************************************************************************
+* Function Name: ble_lz_hash
+****************************************************************************//**
+*
+* Gets the hash of the 3 bytes at a position.
+*
+* \param lz The encoder.
+*
+* \param pos The position, 3 bytes must be in the ring.
+*
+* \return The hash table index.
+*
+*******************************************************************************/
+static uint32_t ble_lz_hash(const ble_lz_t *lz, uint32_t pos)
+{
+    uint32_t key = ((uint32_t)lz->ring[BLE_LZ_RING_INDEX(pos)] << 16u) | \
+                   ((uint32_t)lz->ring[BLE_LZ_RING_INDEX(pos + 1u)] << 8u) | \
+                   (uint32_t)lz->ring[BLE_LZ_RING_INDEX(pos + 2u)];
+
+    return (key * 2654435761u) >> (32u - BLE_LZ_HASH_BITS);
+}
+
+/*******************************************************************************
+* Function Name: ble_lz_encode
+****************************************************************************//**
+*
+* Encodes one item at the current position into the group. The candidate of
+* the hash table is checked byte by byte, so a stale entry only costs a
+* compare.
+*
+* \param lz The encoder, at least one byte must wait for encoding.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_lz_encode(ble_lz_t *lz)
+{
+    uint32_t pending = lz->head - lz->pos;
+    uint32_t max = (pending < BLE_LZ_MATCH_MAX) ? pending : BLE_LZ_MATCH_MAX;
+    uint32_t dist = 0u;
+    uint32_t len = 0u;
+    uint32_t n;
+
+    if(pending >= BLE_LZ_MATCH_MIN) {
+        dist = (uint16_t)((uint16_t)lz->pos - lz->hash[ble_lz_hash(lz, lz->pos)]);
+        if((dist != 0u) && (dist <= BLE_LZ_WINDOW_SIZE) && (dist <= lz->pos)) {
+            while((len < max) && (lz->ring[BLE_LZ_RING_INDEX(lz->pos - dist + len)] == \
+                                  lz->ring[BLE_LZ_RING_INDEX(lz->pos + len)])) {
+                len++;
+            }
+        }
+    }
+    if(lz->group_len == 0u) {
+        lz->group[0] = 0u;
+        lz->group_len = 1u;
+    }
+    if(len >= BLE_LZ_MATCH_MIN) {
+        lz->group[0] |= (uint8_t)(1u << lz->items);
+        lz->group[lz->group_len++] = (uint8_t)(dist - 1u);
+        lz->group[lz->group_len++] = (uint8_t)((((dist - 1u) >> 8u) << 6u) | (len - BLE_LZ_MATCH_MIN));
+    } else {
+        lz->group[lz->group_len++] = lz->ring[BLE_LZ_RING_INDEX(lz->pos)];
+        len = 1u;
+    }
+    /* Every position is hashed, the matches can start inside an earlier match */
+    for(n = 0u; n < len; n++) {
+        if((lz->head - lz->pos) >= BLE_LZ_MATCH_MIN) {
+            lz->hash[ble_lz_hash(lz, lz->pos)] = (uint16_t)lz->pos;
+        }
+        lz->pos++;
+    }
+    if(++lz->items == BLE_LZ_GROUP_ITEMS) {
+        lz->group_ready = true;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_lz_init
+****************************************************************************//**
+*
+* Initializes the encoder for a new stream, the window is empty.
+*
+* \param lz The encoder.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_lz_init(ble_lz_t *lz)
+{
+    memset(lz->hash, 0, sizeof(lz->hash));
+    lz->head = 0u;
+    lz->pos = 0u;
+    lz->group_len = 0u;
+    lz->group_out = 0u;
+    lz->items = 0u;
+    lz->group_ready = false;
+}
+
+/*******************************************************************************
+* Function Name: ble_lz_sink
+****************************************************************************//**
+*
+* Takes input bytes as long as the ring has room, the window behind the
+* encoded position is kept.
+*
+* \param lz The encoder.
+*
+* \param in The input data.
+*
+* \param len The input size.
+*
+* \return The number of bytes taken, 0 if ble_lz_poll() must be called first.
+*
+*******************************************************************************/
+uint32_t ble_lz_sink(ble_lz_t *lz, const uint8_t *in, uint32_t len)
+{
+    uint32_t room = (BLE_LZ_RING_SIZE - BLE_LZ_WINDOW_SIZE) - (lz->head - lz->pos);
+    uint32_t index = BLE_LZ_RING_INDEX(lz->head);
+    uint32_t first;
+
+    if(len > room) {
+        len = room;
+    }
+    first = BLE_LZ_RING_SIZE - index;
+    if(first >= len) {
+        memcpy(&lz->ring[index], in, len);
+    } else {
+        memcpy(&lz->ring[index], in, first);
+        memcpy(&lz->ring[0], &in[first], len - first);
+    }
+    lz->head += len;
+    return len;
+}
+
+/*******************************************************************************
+* Function Name: ble_lz_poll
+****************************************************************************//**
+*
+* Encodes the input and gives the output bytes. The input is encoded only
+* when a longest match fits in the ring, unless finish is set.
+*
+* \param lz The encoder.
+*
+* \param out The output buffer.
+*
+* \param size The output buffer size.
+*
+* \param finish true when no more input follows.
+*
+* \return The number of output bytes, 0 if more input is needed or, with
+* finish, the stream is complete.
+*
+*******************************************************************************/
+uint32_t ble_lz_poll(ble_lz_t *lz, uint8_t *out, uint32_t size, bool finish)
+{
+    uint32_t pending;
+    uint32_t n = 0u;
+
+    while(n < size) {
+        if(lz->group_ready) {
+            out[n++] = lz->group[lz->group_out++];
+            if(lz->group_out == lz->group_len) {
+                lz->group_len = 0u;
+                lz->group_out = 0u;
+                lz->items = 0u;
+                lz->group_ready = false;
+            }
+            continue;
+        }
+        pending = lz->head - lz->pos;
+        if((pending == 0u) || ((!finish) && (pending < BLE_LZ_MATCH_MAX))) {
+            if(finish && (lz->group_len != 0u)) {
+                /* The last group is not full */
+                lz->group_ready = true;
+                continue;
+            }
+            break;
+        }
+        ble_lz_encode(lz);
+    }
+    return n;
+}
+
+/*******************************************************************************
+* Function Name: ble_lz_is_done
+****************************************************************************//**
+*
+* Checks if all input is encoded and given out.
+*
+* \param lz The encoder.
+*
+* \return true if the stream is complete.
+*
+*******************************************************************************/
+bool ble_lz_is_done(const ble_lz_t *lz)
+{
+    return (lz->head == lz->pos) && (lz->group_len == 0u);
+}
+
+/* [] END OF FILE */
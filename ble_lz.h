@@ -0,0 +1,96 @@
+/***************************************************************************//**
+* \file ble_lz.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE streaming LZ compression.
+*
+* A small LZSS encoder with a fixed RAM window, fed with ble_lz_sink() and
+* drained with ble_lz_poll() in pieces of any size. The output is a sequence
+* of groups, a flag byte followed by up to 8 items; bit n of the flag byte
+* (LSB first) tells the kind of item n:
+*   0: a literal byte.
+*   1: a match of 2 bytes | d[7:0] | d[9:8] << 6 | (len - 3) |, copy len bytes
+*      from d + 1 bytes back in the output, byte by byte as they may overlap.
+* The last group may hold less than 8 items, the decoder stops at the end of
+* the input.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_LZ_H_
+#define _BLE_LZ_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The match distance limit, the ring holds the window and the input
+ *        not encoded yet. The ring size must be a power of 2.
+ */
+#define BLE_LZ_WINDOW_SIZE                  (1024u)
+#define BLE_LZ_RING_SIZE                    (2048u)
+
+/**
+ * @brief The match length limits.
+ */
+#define BLE_LZ_MATCH_MIN                    (3u)
+#define BLE_LZ_MATCH_MAX                    (BLE_LZ_MATCH_MIN + 63u)
+
+/**
+ * @brief The match finder is a hash table of the last position of each
+ *        3-byte prefix.
+ */
+#define BLE_LZ_HASH_BITS                    (9u)
+#define BLE_LZ_HASH_SIZE                    (1u << BLE_LZ_HASH_BITS)
+
+/**
+ * @brief The largest group: the flag byte and 8 matches.
+ */
+#define BLE_LZ_GROUP_MAX                    (1u + (8u * 2u))
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The encoder state, the positions count the input bytes.
+ */
+typedef struct
+{
+    uint8_t  ring[BLE_LZ_RING_SIZE];
+    uint16_t hash[BLE_LZ_HASH_SIZE];
+    uint8_t  group[BLE_LZ_GROUP_MAX];
+    uint32_t head;                  /* The bytes taken by ble_lz_sink() */
+    uint32_t pos;                   /* The bytes encoded */
+    uint8_t  group_len;
+    uint8_t  group_out;             /* The group bytes given by ble_lz_poll() */
+    uint8_t  items;
+    bool     group_ready;
+} ble_lz_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_lz_init(ble_lz_t *lz);
+uint32_t ble_lz_sink(ble_lz_t *lz, const uint8_t *in, uint32_t len);
+uint32_t ble_lz_poll(ble_lz_t *lz, uint8_t *out, uint32_t size, bool finish);
+bool ble_lz_is_done(const ble_lz_t *lz);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_LZ_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,267 @@
+/***************************************************************************//**
+* \file ble_pool.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE packet buffer pool.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "ble_pool.h"
+
+/**
+ * @brief A free block, the link is stored in the block itself.
+ */
+typedef struct ble_pool_block
+{
+    struct ble_pool_block *next;
+} ble_pool_block_t;
+
+/**
+ * @brief A size class, its blocks are contiguous in the class memory.
+ */
+typedef struct
+{
+    uint8_t *base;
+    ble_pool_block_t *free_list;
+    ble_pool_stats_t stats;
+} ble_pool_class_t;
+
+/**
+ * @brief The block memory of the size classes.
+ */
+static uint32_t ble_pool_small_mem[(BLE_POOL_SMALL_SIZE * BLE_POOL_SMALL_NUM) / 4u];
+static uint32_t ble_pool_medium_mem[(BLE_POOL_MEDIUM_SIZE * BLE_POOL_MEDIUM_NUM) / 4u];
+static uint32_t ble_pool_large_mem[(BLE_POOL_LARGE_SIZE * BLE_POOL_LARGE_NUM) / 4u];
+
+/**
+ * @brief The size classes in ascending block size.
+ */
+static ble_pool_class_t ble_pool_classes[BLE_POOL_CLASS_NUM] =
+{
+    { .base = (uint8_t *)ble_pool_small_mem,  .stats = { .size = BLE_POOL_SMALL_SIZE,  .count = BLE_POOL_SMALL_NUM } },
+    { .base = (uint8_t *)ble_pool_medium_mem, .stats = { .size = BLE_POOL_MEDIUM_SIZE, .count = BLE_POOL_MEDIUM_NUM } },
+    { .base = (uint8_t *)ble_pool_large_mem,  .stats = { .size = BLE_POOL_LARGE_SIZE,  .count = BLE_POOL_LARGE_NUM } },
+};
+
+
+/*******************************************************************************
+* Function Name: ble_pool_find_class
+****************************************************************************//**
+*
+* Finds the size class of a block by its address.
+*
+* \param block The block.
+*
+* \return The size class, NULL if the block is not from the pool.
+*
+*******************************************************************************/
+static ble_pool_class_t *ble_pool_find_class(const void *block)
+{
+    const uint8_t *addr = (const uint8_t *)block;
+    ble_pool_class_t *pool_class;
+    uint32_t i;
+
+    for(i = 0u; i < BLE_POOL_CLASS_NUM; i++) {
+        pool_class = &ble_pool_classes[i];
+        if((addr >= pool_class->base) && \
+           (addr < (pool_class->base + ((uint32_t)pool_class->stats.size * pool_class->stats.count)))) {
+            return pool_class;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: ble_pool_init
+****************************************************************************//**
+*
+* Initializes the pool, all blocks are freed and the statistics are reset.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_pool_init(void)
+{
+    ble_pool_class_t *pool_class;
+    ble_pool_block_t *block;
+    uint32_t i;
+    uint32_t n;
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+
+    for(i = 0u; i < BLE_POOL_CLASS_NUM; i++) {
+        pool_class = &ble_pool_classes[i];
+        pool_class->free_list = NULL;
+        for(n = pool_class->stats.count; n > 0u; n--) {
+            block = (ble_pool_block_t *)(pool_class->base + ((n - 1u) * pool_class->stats.size));
+            block->next = pool_class->free_list;
+            pool_class->free_list = block;
+        }
+        pool_class->stats.used = 0u;
+        pool_class->stats.high_water = 0u;
+        pool_class->stats.allocs = 0u;
+        pool_class->stats.fallbacks = 0u;
+        pool_class->stats.failures = 0u;
+    }
+    Cy_SysLib_ExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+* Function Name: ble_pool_alloc
+****************************************************************************//**
+*
+* Allocates a block of at least size bytes, it can be called from interrupts.
+*
+* \param size The requested size.
+*
+* \return The block, NULL if no block is free.
+*
+*******************************************************************************/
+void *ble_pool_alloc(uint16_t size)
+{
+    ble_pool_class_t *pool_class;
+    ble_pool_block_t *block = NULL;
+    uint32_t first;
+    uint32_t i;
+    uint32_t intr;
+
+    for(first = 0u; first < BLE_POOL_CLASS_NUM; first++) {
+        if(size <= ble_pool_classes[first].stats.size) {
+            break;
+        }
+    }
+    if(first == BLE_POOL_CLASS_NUM) {
+        return NULL;
+    }
+
+    intr = Cy_SysLib_EnterCriticalSection();
+    for(i = first; i < BLE_POOL_CLASS_NUM; i++) {
+        pool_class = &ble_pool_classes[i];
+        if(pool_class->free_list != NULL) {
+            block = pool_class->free_list;
+            pool_class->free_list = block->next;
+            pool_class->stats.allocs++;
+            if(++pool_class->stats.used > pool_class->stats.high_water) {
+                pool_class->stats.high_water = pool_class->stats.used;
+            }
+            break;
+        }
+    }
+    if(block == NULL) {
+        ble_pool_classes[first].stats.failures++;
+    } else if(i != first) {
+        ble_pool_classes[first].stats.fallbacks++;
+    }
+    Cy_SysLib_ExitCriticalSection(intr);
+    return block;
+}
+
+/*******************************************************************************
+* Function Name: ble_pool_free
+****************************************************************************//**
+*
+* Frees a block, it can be called from interrupts.
+*
+* \param block The block, NULL is ignored.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_pool_free(void *block)
+{
+    ble_pool_class_t *pool_class;
+    uint32_t intr;
+
+    if(block == NULL) {
+        return;
+    }
+    pool_class = ble_pool_find_class(block);
+    CY_ASSERT(pool_class != NULL);
+    if(pool_class == NULL) {
+        return;
+    }
+    intr = Cy_SysLib_EnterCriticalSection();
+    ((ble_pool_block_t *)block)->next = pool_class->free_list;
+    pool_class->free_list = (ble_pool_block_t *)block;
+    pool_class->stats.used--;
+    Cy_SysLib_ExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+* Function Name: ble_pool_block_size
+****************************************************************************//**
+*
+* Gets the usable size of a block, it may be larger than the requested size.
+*
+* \param block The block.
+*
+* \return The block size, 0 if the block is not from the pool.
+*
+*******************************************************************************/
+uint16_t ble_pool_block_size(const void *block)
+{
+    const ble_pool_class_t *pool_class = ble_pool_find_class(block);
+
+    return (pool_class != NULL) ? pool_class->stats.size : 0u;
+}
+
+/*******************************************************************************
+* Function Name: ble_pool_get_stats
+****************************************************************************//**
+*
+* Gets the statistics of a size class.
+*
+* \param class_idx The size class, 0 ~ (BLE_POOL_CLASS_NUM - 1) in ascending
+* block size.
+*
+* \param stats The statistics are copied here.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_pool_get_stats(uint32_t class_idx, ble_pool_stats_t *stats)
+{
+    uint32_t intr;
+
+    if((class_idx >= BLE_POOL_CLASS_NUM) || (stats == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    intr = Cy_SysLib_EnterCriticalSection();
+    *stats = ble_pool_classes[class_idx].stats;
+    Cy_SysLib_ExitCriticalSection(intr);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_pool_print_stats
+****************************************************************************//**
+*
+* Prints the statistics of the size classes.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_pool_print_stats(void)
+{
+    ble_pool_stats_t stats;
+    uint32_t i;
+
+    for(i = 0u; i < BLE_POOL_CLASS_NUM; i++) {
+        (void)ble_pool_get_stats(i, &stats);
+        BLE_DBG_PRINTF("Pool %u: used=%u/%u, high water=%u, allocs=%lu, fallbacks=%lu, failures=%lu\r\n", \
+            (unsigned)stats.size, (unsigned)stats.used, (unsigned)stats.count, (unsigned)stats.high_water, \
+            (unsigned long)stats.allocs, (unsigned long)stats.fallbacks, (unsigned long)stats.failures);
+    }
+}
+
+/* [] END OF FILE */
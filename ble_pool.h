@@ -0,0 +1,95 @@
+/***************************************************************************//**
+* \file ble_pool.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE packet buffer pool.
+*
+* The payload buffers of the BLE layer are fixed size blocks of a few size
+* classes. A request is served by the smallest class that fits, or by a
+* larger class when that one is exhausted. Alloc and free are O(1) and can be
+* called from interrupts.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_POOL_H_
+#define _BLE_POOL_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The block size and the block count of each size class. The large
+ *        class holds the largest attribute value, so any command or response
+ *        frame fits in one block. The sizes must be multiples of 4.
+ */
+#define BLE_POOL_SMALL_SIZE                 (32u)
+#define BLE_POOL_SMALL_NUM                  (8u)
+#define BLE_POOL_MEDIUM_SIZE                (128u)
+#define BLE_POOL_MEDIUM_NUM                 (6u + BLE_POOL_RTOS_NUM)
+#define BLE_POOL_LARGE_SIZE                 ((CY_BLE_GATT_DB_MAX_VALUE_LEN > 256u) ? \
+                                             ((CY_BLE_GATT_DB_MAX_VALUE_LEN + 3u) & ~3u) : 256u)
+#define BLE_POOL_LARGE_NUM                  (4u + BLE_POOL_RTOS_NUM)
+
+/**
+ * @brief The blocks added to the medium and the large classes in the FreeRTOS
+ *        build, for the payloads held by the BLE_RTOS_MSG_NUM messages of
+ *        ble_rtos.c while the tasks handle them.
+ */
+#if defined(COMPONENT_FREERTOS)
+#define BLE_POOL_RTOS_NUM                   (4u)
+#else
+#define BLE_POOL_RTOS_NUM                   (0u)
+#endif
+
+/**
+ * @brief The number of size classes.
+ */
+#define BLE_POOL_CLASS_NUM                  (3u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The statistics of a size class.
+ */
+typedef struct
+{
+    uint16_t size;                  /* The block size */
+    uint16_t count;                 /* The number of blocks */
+    uint16_t used;                  /* The blocks in use */
+    uint16_t high_water;            /* The maximum of the blocks in use */
+    uint32_t allocs;                /* Blocks allocated from this class */
+    uint32_t fallbacks;             /* Requests of this class served by a larger class */
+    uint32_t failures;              /* Requests of this class not served */
+} ble_pool_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_pool_init(void);
+void *ble_pool_alloc(uint16_t size);
+void ble_pool_free(void *block);
+uint16_t ble_pool_block_size(const void *block);
+cy_en_ble_api_result_t ble_pool_get_stats(uint32_t class_idx, ble_pool_stats_t *stats);
+void ble_pool_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_POOL_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,352 @@
+/***************************************************************************//**
+* \file ble_power.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE power manager.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_power.h"
+#include "ble_time.h"
+#include "ble_timer.h"
+#include "ble_custom_hi.h"
+
+/**
+ * @brief The power manager statistics and the start time of the measurement.
+ */
+static ble_power_stats_t ble_power_stats;
+static uint32_t ble_power_stats_start;
+
+/**
+ * @brief The names of the wakeup sources, see BLE_EVENT_xxx.
+ */
+static const char * const ble_power_wake_names[BLE_POWER_WAKE_NUM] =
+{
+    "stack", "command", "tx", "adv", "flash", "timer", "uart", "task", "queue", "ipc",
+    NULL, NULL, NULL, NULL, NULL, NULL, "user", "none"
+};
+
+#if (ENABLE_SYS_LPM_FUNCTION == ENABLED)
+static cy_en_syspm_status_t ble_power_service_callback(cy_stc_syspm_callback_params_t *params, \
+                                                       cy_en_syspm_callback_mode_t mode);
+
+/**
+ * @brief The SysPm callback of the custom service.
+ */
+static cy_stc_syspm_callback_params_t ble_power_service_params = { .base = NULL, .context = NULL };
+static cy_stc_syspm_callback_t ble_power_service_cb =
+{
+    .callback       = ble_power_service_callback,
+    .type           = CY_SYSPM_DEEPSLEEP,
+    .skipMode       = CY_SYSPM_SKIP_CHECK_FAIL | CY_SYSPM_SKIP_BEFORE_TRANSITION | CY_SYSPM_SKIP_AFTER_TRANSITION,
+    .callbackParams = &ble_power_service_params,
+};
+
+#if (BLE_DEBUG_UART_ENABLED == ENABLED)
+static cy_en_syspm_status_t ble_power_uart_callback(cy_stc_syspm_callback_params_t *params, \
+                                                    cy_en_syspm_callback_mode_t mode);
+
+/**
+ * @brief The SysPm callback of the debug UART.
+ */
+static cy_stc_syspm_callback_params_t ble_power_uart_params = { .base = NULL, .context = NULL };
+static cy_stc_syspm_callback_t ble_power_uart_cb =
+{
+    .callback       = ble_power_uart_callback,
+    .type           = CY_SYSPM_DEEPSLEEP,
+    .skipMode       = CY_SYSPM_SKIP_CHECK_FAIL | CY_SYSPM_SKIP_BEFORE_TRANSITION | CY_SYSPM_SKIP_AFTER_TRANSITION,
+    .callbackParams = &ble_power_uart_params,
+};
+#endif /* (BLE_DEBUG_UART_ENABLED == ENABLED) */
+
+static bool ble_power_registered = false;
+#endif /* (ENABLE_SYS_LPM_FUNCTION == ENABLED) */
+
+
+#if (ENABLE_SYS_LPM_FUNCTION == ENABLED)
+/*******************************************************************************
+* Function Name: ble_power_service_callback
+****************************************************************************//**
+*
+* The SysPm callback of the custom service, refuses Deep Sleep while response
+* data is waiting for transmit.
+*
+* \param params The callback parameters, not used.
+*
+* \param mode The callback mode.
+*
+* \return The callback status.
+*
+*******************************************************************************/
+static cy_en_syspm_status_t ble_power_service_callback(cy_stc_syspm_callback_params_t *params, \
+                                                       cy_en_syspm_callback_mode_t mode)
+{
+    (void)params;
+    if((mode == CY_SYSPM_CHECK_READY) && (!ble_custom_hi_is_idle())) {
+        ble_power_stats.refused_service++;
+        return CY_SYSPM_FAIL;
+    }
+    return CY_SYSPM_SUCCESS;
+}
+
+#if (BLE_DEBUG_UART_ENABLED == ENABLED)
+/*******************************************************************************
+* Function Name: ble_power_uart_callback
+****************************************************************************//**
+*
+* The SysPm callback of the debug UART, refuses Deep Sleep while a character
+* is transmitted or received.
+*
+* \param params The callback parameters, not used.
+*
+* \param mode The callback mode.
+*
+* \return The callback status.
+*
+*******************************************************************************/
+static cy_en_syspm_status_t ble_power_uart_callback(cy_stc_syspm_callback_params_t *params, \
+                                                    cy_en_syspm_callback_mode_t mode)
+{
+    (void)params;
+    if((mode == CY_SYSPM_CHECK_READY) && \
+       ((BLE_UART_DEB_IS_TX_COMPLETE() == 0u) || (Cy_SCB_UART_GetNumInRxFifo(cy_retarget_io_uart_obj.base) != 0u))) {
+        ble_power_stats.refused_uart++;
+        return CY_SYSPM_FAIL;
+    }
+    return CY_SYSPM_SUCCESS;
+}
+#endif /* (BLE_DEBUG_UART_ENABLED == ENABLED) */
+#endif /* (ENABLE_SYS_LPM_FUNCTION == ENABLED) */
+
+/*******************************************************************************
+* Function Name: ble_power_init
+****************************************************************************//**
+*
+* Initializes the power manager and registers the SysPm callbacks.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_power_init(void)
+{
+#if (ENABLE_SYS_LPM_FUNCTION == ENABLED)
+    if(!ble_power_registered) {
+        (void)Cy_SysPm_RegisterCallback(&ble_power_service_cb);
+    #if (BLE_DEBUG_UART_ENABLED == ENABLED)
+        (void)Cy_SysPm_RegisterCallback(&ble_power_uart_cb);
+    #endif
+        ble_power_registered = true;
+    }
+#endif
+    ble_power_reset_stats();
+}
+
+/*******************************************************************************
+* Function Name: ble_power_select
+****************************************************************************//**
+*
+* Chooses the low power mode of the run loop, it should be called with the
+* interrupts masked after no event is found pending.
+*
+* \param none.
+*
+* \return BLE_POWER_MODE_DEEPSLEEP or BLE_POWER_MODE_SLEEP.
+*
+*******************************************************************************/
+ble_power_mode_t ble_power_select(void)
+{
+#if (ENABLE_SYS_LPM_FUNCTION == ENABLED)
+    cy_en_ble_bless_state_t state;
+
+    if(!ble_custom_hi_is_idle()) {
+        ble_power_stats.sleep_work++;
+        return BLE_POWER_MODE_SLEEP;
+    }
+    if(BLE_UART_DEB_IS_TX_COMPLETE() == 0u) {
+        ble_power_stats.sleep_uart++;
+        return BLE_POWER_MODE_SLEEP;
+    }
+#if defined(COMPONENT_BLESS_CONTROLLER)
+    /* The link layer is about to close an event, it will interrupt at once */
+    state = Cy_BLE_StackGetBleSsState();
+    if((state == CY_BLE_BLESS_STATE_ACTIVE) || (state == CY_BLE_BLESS_STATE_EVENT_CLOSE)) {
+        ble_power_stats.sleep_stack++;
+        return BLE_POWER_MODE_SLEEP;
+    }
+#else
+    (void)state;
+#endif
+    if(ble_timer_next_timeout() < BLE_POWER_DEEPSLEEP_MIN_MS) {
+        ble_power_stats.sleep_timer++;
+        return BLE_POWER_MODE_SLEEP;
+    }
+    return BLE_POWER_MODE_DEEPSLEEP;
+#else
+    return BLE_POWER_MODE_SLEEP;
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_power_enter
+****************************************************************************//**
+*
+* Enters a low power mode and counts its residency, it should be called with
+* the interrupts masked; the wakeup interrupt is serviced when they are
+* unmasked. If Deep Sleep is refused by a SysPm callback the CPU Sleep is
+* entered instead.
+*
+* \param mode The power mode, see ble_power_select().
+*
+* \return The power mode entered.
+*
+*******************************************************************************/
+ble_power_mode_t ble_power_enter(ble_power_mode_t mode)
+{
+    uint32_t start = ble_time_now();
+
+    if(mode == BLE_POWER_MODE_DEEPSLEEP) {
+        if(CY_SYSPM_SUCCESS != Cy_SysPm_DeepSleep(CY_SYSPM_WAIT_FOR_INTERRUPT)) {
+            ble_power_stats.refused++;
+            mode = BLE_POWER_MODE_SLEEP;
+        }
+    }
+    if(mode == BLE_POWER_MODE_SLEEP) {
+        (void)Cy_SysPm_CpuEnterSleep(CY_SYSPM_WAIT_FOR_INTERRUPT);
+    }
+    if(mode != BLE_POWER_MODE_ACTIVE) {
+        ble_power_stats.entries[mode]++;
+        ble_power_stats.residency_ticks[mode] += ble_time_now() - start;
+    }
+    return mode;
+}
+
+/*******************************************************************************
+* Function Name: ble_power_wakeup
+****************************************************************************//**
+*
+* Counts the wakeup sources, it should be called after the wakeup interrupt
+* is serviced.
+*
+* \param events The event flags posted since the low power mode was entered.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_power_wakeup(uint32_t events)
+{
+    uint32_t bit;
+
+    if(events == 0u) {
+        ble_power_stats.wake_sources[BLE_POWER_WAKE_NONE]++;
+        return;
+    }
+    for(bit = 0u; bit < BLE_POWER_WAKE_USER; bit++) {
+        if(0u != (events & (1uL << bit))) {
+            ble_power_stats.wake_sources[bit]++;
+        }
+    }
+    if(0u != (events >> BLE_POWER_WAKE_USER)) {
+        ble_power_stats.wake_sources[BLE_POWER_WAKE_USER]++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_power_get_stats
+****************************************************************************//**
+*
+* Gets the power manager statistics since the last reset.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_power_get_stats(ble_power_stats_t *stats)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+    uint32_t asleep;
+    uint32_t i;
+
+    *stats = ble_power_stats;
+    Cy_SysLib_ExitCriticalSection(intr);
+    stats->elapsed_ticks = ble_time_now() - ble_power_stats_start;
+    asleep = stats->residency_ticks[BLE_POWER_MODE_SLEEP] + stats->residency_ticks[BLE_POWER_MODE_DEEPSLEEP];
+    stats->residency_ticks[BLE_POWER_MODE_ACTIVE] = (stats->elapsed_ticks > asleep) ? (stats->elapsed_ticks - asleep) : 0u;
+    if(stats->elapsed_ticks != 0u) {
+        for(i = 0u; i < BLE_POWER_MODE_NUM; i++) {
+            stats->residency_permille[i] = (uint32_t)(((uint64_t)stats->residency_ticks[i] * 1000u) / stats->elapsed_ticks);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_power_reset_stats
+****************************************************************************//**
+*
+* Resets the power manager statistics and starts a new measurement.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_power_reset_stats(void)
+{
+    uint32_t intr = Cy_SysLib_EnterCriticalSection();
+
+    memset(&ble_power_stats, 0, sizeof(ble_power_stats));
+    ble_power_stats_start = ble_time_now();
+    Cy_SysLib_ExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+* Function Name: ble_power_print_stats
+****************************************************************************//**
+*
+* Prints the residency of the power modes, the reasons of the CPU Sleep and
+* the wakeup sources.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_power_print_stats(void)
+{
+    static const char * const mode_names[BLE_POWER_MODE_NUM] = { "active", "sleep", "deep sleep" };
+    ble_power_stats_t stats;
+    uint32_t i;
+
+    ble_power_get_stats(&stats);
+    for(i = 0u; i < BLE_POWER_MODE_NUM; i++) {
+        BLE_DBG_PRINTF("Power %s: %lu.%lu%%, %lums, entries=%lu\r\n", mode_names[i], \
+            (unsigned long)(stats.residency_permille[i] / 10u), (unsigned long)(stats.residency_permille[i] % 10u), \
+            (unsigned long)BLE_TIME_TICKS_TO_MS(stats.residency_ticks[i]), (unsigned long)stats.entries[i]);
+    }
+    BLE_DBG_PRINTF("Sleep reasons: work=%lu, uart=%lu, stack=%lu, timer=%lu, refused=%lu (uart %lu, service %lu)\r\n", \
+        (unsigned long)stats.sleep_work, (unsigned long)stats.sleep_uart, (unsigned long)stats.sleep_stack, \
+        (unsigned long)stats.sleep_timer, (unsigned long)stats.refused, (unsigned long)stats.refused_uart, \
+        (unsigned long)stats.refused_service);
+    BLE_DBG_PRINTF("Wakeup sources:");
+    for(i = 0u; i < BLE_POWER_WAKE_NUM; i++) {
+        if(stats.wake_sources[i] != 0u) {
+            if(ble_power_wake_names[i] != NULL) {
+                BLE_DBG_PRINTF(" %s=%lu", ble_power_wake_names[i], (unsigned long)stats.wake_sources[i]);
+            } else {
+                BLE_DBG_PRINTF(" bit%lu=%lu", (unsigned long)i, (unsigned long)stats.wake_sources[i]);
+            }
+        }
+    }
+    BLE_DBG_PRINTF("\r\n");
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,102 @@
+/***************************************************************************//**
+* \file ble_power.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE power manager.
+*
+* The run loop asks the power manager for the low power mode when no event
+* is pending. Deep Sleep is chosen only when no response data is waiting,
+* the debug UART is idle, the link layer is not in an event and the next
+* software timer is far enough; otherwise the CPU Sleep is used. The SysPm
+* callbacks of the debug UART and the custom service refuse Deep Sleep under
+* the same conditions for the other callers of Cy_SysPm_DeepSleep().
+*
+* With ENABLE_SYS_LPM_FUNCTION disabled only the CPU Sleep is used.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_POWER_H_
+#define _BLE_POWER_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief Deep Sleep is chosen only if the next software timer expires at
+ *        least this time (ms) later, the shorter waits are not worth the
+ *        Deep Sleep entry and wakeup.
+ */
+#define BLE_POWER_DEEPSLEEP_MIN_MS          (2u)
+
+/**
+ * @brief The wakeup sources are counted per event flag: the flags 0 ~ 15 of
+ *        ble_event.h, the application events and the wakeups without event.
+ */
+#define BLE_POWER_WAKE_USER                 (16u)
+#define BLE_POWER_WAKE_NONE                 (17u)
+#define BLE_POWER_WAKE_NUM                  (18u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The power modes of the run loop.
+ */
+typedef enum
+{
+    BLE_POWER_MODE_ACTIVE = 0,
+    BLE_POWER_MODE_SLEEP,
+    BLE_POWER_MODE_DEEPSLEEP,
+    BLE_POWER_MODE_NUM
+} ble_power_mode_t;
+
+/**
+ * @brief The power manager statistics.
+ */
+typedef struct
+{
+    uint32_t elapsed_ticks;                             /* The measurement time in ble_time ticks */
+    uint32_t entries[BLE_POWER_MODE_NUM];               /* The entries of each mode */
+    uint32_t residency_ticks[BLE_POWER_MODE_NUM];       /* The time in each mode, active is the rest */
+    uint32_t residency_permille[BLE_POWER_MODE_NUM];
+    uint32_t sleep_work;                                /* Sleep chosen, response data is waiting */
+    uint32_t sleep_uart;                                /* Sleep chosen, the debug UART is busy */
+    uint32_t sleep_stack;                               /* Sleep chosen, the link layer is in an event */
+    uint32_t sleep_timer;                               /* Sleep chosen, a timer expires soon */
+    uint32_t refused;                                   /* Deep Sleep refused by a SysPm callback */
+    uint32_t refused_uart;                              /* ... by the debug UART callback */
+    uint32_t refused_service;                           /* ... by the custom service callback */
+    uint32_t wake_sources[BLE_POWER_WAKE_NUM];          /* The event flags posted by the wakeup */
+} ble_power_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_power_init(void);
+ble_power_mode_t ble_power_select(void);
+ble_power_mode_t ble_power_enter(ble_power_mode_t mode);
+void ble_power_wakeup(uint32_t events);
+void ble_power_get_stats(ble_power_stats_t *stats);
+void ble_power_reset_stats(void);
+void ble_power_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_POWER_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,359 @@
+/***************************************************************************//**
+* \file ble_ram.c
+* \version 1.0
+*
+* \brief
+* Source file for the stack high-water instrumentation of the BLE layer.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_ram.h"
+#if defined(COMPONENT_FREERTOS)
+#include "ble_rtos.h"
+#endif
+
+#if !defined(COMPONENT_FREERTOS)
+/**
+ * @brief The main stack of the linker scripts.
+ */
+#if defined(__ARMCC_VERSION)
+extern uint32_t Image$$ARM_LIB_STACK$$ZI$$Base;
+extern uint32_t Image$$ARM_LIB_STACK$$ZI$$Limit;
+#define BLE_RAM_STACK_LIMIT                 ((uint32_t)&Image$$ARM_LIB_STACK$$ZI$$Base)
+#define BLE_RAM_STACK_TOP                   ((uint32_t)&Image$$ARM_LIB_STACK$$ZI$$Limit)
+#elif defined(__ICCARM__)
+#pragma section = "CSTACK"
+#define BLE_RAM_STACK_LIMIT                 ((uint32_t)__section_begin("CSTACK"))
+#define BLE_RAM_STACK_TOP                   ((uint32_t)__section_end("CSTACK"))
+#else
+extern uint32_t __StackLimit;
+extern uint32_t __StackTop;
+#define BLE_RAM_STACK_LIMIT                 ((uint32_t)&__StackLimit)
+#define BLE_RAM_STACK_TOP                   ((uint32_t)&__StackTop)
+#endif
+#endif /* !defined(COMPONENT_FREERTOS) */
+
+/* The watched stack, the limit is its lowest address */
+static uint32_t ble_ram_limit;
+static uint32_t ble_ram_top;
+
+/* The deepest address known to be used */
+static uint32_t ble_ram_high;
+
+/* The callbacks being sampled, a nested one is not sampled */
+static uint32_t ble_ram_depth;
+
+/* The statistics */
+static ble_ram_stats_t ble_ram_stats;
+
+/* The samples of each event code, the first BLE_RAM_STATS_CODES codes */
+static struct
+{
+    uint32_t code;
+    uint32_t count;
+    uint32_t entry_max;
+    uint32_t peak_max;
+} ble_ram_codes[BLE_RAM_STATS_CODES];
+static uint32_t ble_ram_codes_used;
+
+
+/*******************************************************************************
+* Function Name: ble_ram_get_sp
+****************************************************************************//**
+*
+* Gets the stack pointer of the caller's stack.
+*
+* \param none.
+*
+* \return The stack pointer.
+*
+*******************************************************************************/
+static uint32_t ble_ram_get_sp(void)
+{
+#if defined(COMPONENT_FREERTOS)
+    /* The tasks run on the process stack, the interrupts on the main stack */
+    return (__get_IPSR() == 0u) ? __get_PSP() : __get_MSP();
+#else
+    return __get_MSP();
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_paint
+****************************************************************************//**
+*
+* Paints the unused stack words of a range.
+*
+* \param from The lowest address, word aligned.
+*
+* \param to The end of the range, word aligned.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_ram_paint(uint32_t from, uint32_t to)
+{
+    volatile uint32_t *p;
+
+    for(p = (volatile uint32_t *)from; p < (volatile uint32_t *)to; p++) {
+        *p = BLE_RAM_PAINT;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_scan
+****************************************************************************//**
+*
+* Finds the lowest word of a range which no longer holds the paint.
+*
+* \param from The lowest address, word aligned.
+*
+* \param to The end of the range, word aligned.
+*
+* \return The address of the word, to if the range is still painted.
+*
+*******************************************************************************/
+static uint32_t ble_ram_scan(uint32_t from, uint32_t to)
+{
+    const volatile uint32_t *p;
+
+    for(p = (const volatile uint32_t *)from; p < (const volatile uint32_t *)to; p++) {
+        if(*p != BLE_RAM_PAINT) {
+            break;
+        }
+    }
+    return (uint32_t)p;
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_window
+****************************************************************************//**
+*
+* Gets the sample window below the entry of a callback.
+*
+* \param entry The stack pointer at the entry.
+*
+* \param bottom The lowest address of the window is returned here.
+*
+* \return The end of the window.
+*
+*******************************************************************************/
+static uint32_t ble_ram_window(uint32_t entry, uint32_t *bottom)
+{
+    uint32_t end = (entry - BLE_RAM_PAINT_MARGIN) & ~3uL;
+
+    *bottom = ((end - ble_ram_limit) > BLE_RAM_SAMPLE_WINDOW) ? (end - BLE_RAM_SAMPLE_WINDOW) : ble_ram_limit;
+    return end;
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_init
+****************************************************************************//**
+*
+* Finds the watched stack and paints its free words. It is called from the
+* task which runs the BLE callbacks. In the FreeRTOS build, it is the stack
+* of the BLE task created by ble_rtos_init(), its lowest address is given by
+* pxTaskGetStackStart().
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ram_init(void)
+{
+    uint32_t sp = ble_ram_get_sp();
+
+#if defined(COMPONENT_FREERTOS)
+    ble_ram_limit = (uint32_t)pxTaskGetStackStart(NULL);
+    ble_ram_top = ble_ram_limit + (BLE_RTOS_BLE_TASK_STACK_SIZE * sizeof(StackType_t));
+#else
+    ble_ram_limit = BLE_RAM_STACK_LIMIT;
+    ble_ram_top = BLE_RAM_STACK_TOP;
+#endif
+    ble_ram_depth = 0u;
+    memset(&ble_ram_stats, 0, sizeof(ble_ram_stats));
+    ble_ram_codes_used = 0u;
+    if((sp <= (ble_ram_limit + BLE_RAM_PAINT_MARGIN)) || (sp > ble_ram_top)) {
+        /* Not called on the watched stack, nothing is sampled */
+        BLE_DBG_PRINTF("ble_ram_init: SP 0x%08lx out of the stack\r\n", (unsigned long)sp);
+        ble_ram_limit = 0u;
+        ble_ram_top = 0u;
+        ble_ram_high = 0u;
+        return;
+    }
+    ble_ram_high = (sp - BLE_RAM_PAINT_MARGIN) & ~3uL;
+    ble_ram_paint(ble_ram_limit, ble_ram_high);
+    ble_ram_stats.size = ble_ram_top - ble_ram_limit;
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_begin
+****************************************************************************//**
+*
+* Starts the sample of a callback, the window below the entry is painted.
+* A deeper use found in the window is recorded first.
+*
+* \param none.
+*
+* \return The entry to pass to ble_ram_end(), 0 if the callback is not
+* sampled.
+*
+*******************************************************************************/
+uint32_t ble_ram_begin(void)
+{
+    uint32_t sp = ble_ram_get_sp();
+    uint32_t bottom;
+    uint32_t end;
+    uint32_t used;
+
+    if((ble_ram_depth++ != 0u) || (sp <= (ble_ram_limit + BLE_RAM_PAINT_MARGIN)) || (sp > ble_ram_top)) {
+        return 0u;
+    }
+    end = ble_ram_window(sp, &bottom);
+    if(bottom < ble_ram_high) {
+        used = ble_ram_scan(bottom, ble_ram_high);
+        if(used < ble_ram_high) {
+            ble_ram_high = used;
+        }
+    }
+    ble_ram_paint(bottom, end);
+    return sp;
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_end
+****************************************************************************//**
+*
+* Completes the sample of a callback, the window is scanned for its deepest
+* use.
+*
+* \param event The event code.
+*
+* \param entry The entry of ble_ram_begin().
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ram_end(uint32_t event, uint32_t entry)
+{
+    uint32_t bottom;
+    uint32_t end;
+    uint32_t used;
+    uint32_t peak;
+    uint32_t n;
+
+    ble_ram_depth--;
+    if(entry == 0u) {
+        return;
+    }
+    end = ble_ram_window(entry, &bottom);
+    used = ble_ram_scan(bottom, end);
+    if((used == bottom) && (bottom != ble_ram_limit)) {
+        ble_ram_stats.overflows++;
+    }
+    if(used < ble_ram_high) {
+        ble_ram_high = used;
+    }
+    peak = ble_ram_top - used;
+    ble_ram_stats.callbacks++;
+    if(peak > ble_ram_stats.callback_max) {
+        ble_ram_stats.callback_max = peak;
+        ble_ram_stats.callback_max_code = event;
+    }
+    for(n = 0u; (n < ble_ram_codes_used) && (ble_ram_codes[n].code != event); n++) {
+    }
+    if(n == ble_ram_codes_used) {
+        if(n == BLE_RAM_STATS_CODES) {
+            return;
+        }
+        memset(&ble_ram_codes[n], 0, sizeof(ble_ram_codes[n]));
+        ble_ram_codes[n].code = event;
+        ble_ram_codes_used++;
+    }
+    ble_ram_codes[n].count++;
+    if((ble_ram_top - entry) > ble_ram_codes[n].entry_max) {
+        ble_ram_codes[n].entry_max = ble_ram_top - entry;
+    }
+    if(peak > ble_ram_codes[n].peak_max) {
+        ble_ram_codes[n].peak_max = peak;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_get_high_water
+****************************************************************************//**
+*
+* Gets the deepest stack use since init, the stack is scanned from its limit.
+*
+* \param none.
+*
+* \return The high water in bytes from the stack top.
+*
+*******************************************************************************/
+uint32_t ble_ram_get_high_water(void)
+{
+    uint32_t used = ble_ram_scan(ble_ram_limit, ble_ram_high);
+
+    if(used < ble_ram_high) {
+        ble_ram_high = used;
+    }
+    return ble_ram_top - ble_ram_high;
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_get_stats
+****************************************************************************//**
+*
+* Gets the stack statistics, the high water is updated.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ram_get_stats(ble_ram_stats_t *stats)
+{
+    ble_ram_stats.high_water = ble_ram_get_high_water();
+    if(stats != NULL) {
+        *stats = ble_ram_stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_ram_print_stats
+****************************************************************************//**
+*
+* Prints the stack high water and the callback samples.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_ram_print_stats(void)
+{
+    ble_ram_stats_t stats;
+    uint32_t n;
+
+    ble_ram_get_stats(&stats);
+    BLE_DBG_PRINTF("Stack: size=%lu, high water=%lu (%lu%%), free=%lu\r\n", (unsigned long)stats.size, \
+        (unsigned long)stats.high_water, (unsigned long)((stats.size != 0u) ? ((stats.high_water * 100u) / stats.size) : 0u), \
+        (unsigned long)(stats.size - stats.high_water));
+    BLE_DBG_PRINTF("  callbacks=%lu, deepest=%lu (event 0x%08lx), window overflows=%lu\r\n", \
+        (unsigned long)stats.callbacks, (unsigned long)stats.callback_max, \
+        (unsigned long)stats.callback_max_code, (unsigned long)stats.overflows);
+    for(n = 0u; n < ble_ram_codes_used; n++) {
+        BLE_DBG_PRINTF("  0x%08lx: count=%lu, entry max=%lu, peak max=%lu\r\n", (unsigned long)ble_ram_codes[n].code, \
+            (unsigned long)ble_ram_codes[n].count, (unsigned long)ble_ram_codes[n].entry_max, \
+            (unsigned long)ble_ram_codes[n].peak_max);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,96 @@
+/***************************************************************************//**
+* \file ble_ram.h
+* \version 1.0
+*
+* \brief
+* Header file for the stack high-water instrumentation of the BLE layer.
+*
+* The free stack is painted at init. The high water is the deepest word no
+* longer holding the paint, scanned from the stack limit. The watched stack
+* is the main stack of the bare metal build, or the BLE task stack of the
+* FreeRTOS build, found by pxTaskGetStackStart().
+*
+* ble_app_callback() samples each event: the stack depth at the entry, and
+* the deepest use within the handler, found by painting a window below the
+* entry and scanning it on exit. The depths are measured from the stack top.
+*
+* The static RAM of each module is reported at build time from the map file
+* of the GCC_ARM build, see ble_ram_report.awk.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_RAM_H_
+#define _BLE_RAM_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The paint of the free stack, the FreeRTOS stack fill byte.
+ */
+#define BLE_RAM_PAINT                       (0xA5A5A5A5uL)
+
+/**
+ * @brief The bytes kept below the stack pointer when painting, for the
+ *        frame of the painting function.
+ */
+#define BLE_RAM_PAINT_MARGIN                (64u)
+
+/**
+ * @brief The bytes painted below the entry of a callback, a deeper callback
+ *        is counted as a window overflow.
+ */
+#ifndef BLE_RAM_SAMPLE_WINDOW
+#define BLE_RAM_SAMPLE_WINDOW               (1024u)
+#endif
+
+/**
+ * @brief The number of event codes sampled by ble_ram_end().
+ */
+#define BLE_RAM_STATS_CODES                 (16u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The stack statistics, in bytes from the stack top.
+ */
+typedef struct
+{
+    uint32_t size;                      /* The watched stack size */
+    uint32_t high_water;                /* The deepest use since init */
+    uint32_t callbacks;                 /* The callbacks sampled */
+    uint32_t callback_max;              /* The deepest use of a callback */
+    uint32_t callback_max_code;         /* Its event code */
+    uint32_t overflows;                 /* Callbacks deeper than the sample window */
+} ble_ram_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_ram_init(void);
+uint32_t ble_ram_begin(void);
+void ble_ram_end(uint32_t event, uint32_t entry);
+uint32_t ble_ram_get_high_water(void);
+void ble_ram_get_stats(ble_ram_stats_t *stats);
+void ble_ram_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_RAM_H_ */
+
+/* [] END OF FILE */
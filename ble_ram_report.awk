@@ -0,0 +1,107 @@
+################################################################################
+# \file ble_ram_report.awk
+# \version 1.0
+#
+# \brief
+# Reports the static RAM of each module from the map file of the GCC_ARM
+# build, run as a post-build step:
+#
+#     awk -f ble_ram_report.awk <APPNAME>.map
+#
+# The .data, .bss and .noinit input sections of the memory map are summed by
+# object file, the objects of a library are summed by library. The stack and
+# the heap are reserved by the linker script and shown apart.
+#
+################################################################################
+# \copyright
+# Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+# You may use this file only in accordance with the license, terms, conditions,
+# disclaimers, and limitations in the end user license agreement accompanying
+# the software package with which this file was provided.
+################################################################################
+
+# Adds an input section: name address size object
+function add(name, size, object,    module) {
+    size = strtonum_hex(size)
+    if(size == 0) {
+        return
+    }
+    module = object
+    if(module ~ /\.a\(/) {
+        sub(/\(.*$/, "", module)
+    }
+    sub(/^.*\//, "", module)
+    if(name ~ /^\.data/) {
+        data[module] += size
+        total_data += size
+    } else {
+        bss[module] += size
+        total_bss += size
+    }
+    modules[module] = 1
+}
+
+# Converts a 0x prefixed hex number, awk has no portable strtonum
+function strtonum_hex(s,    i, n, c) {
+    n = 0
+    s = tolower(s)
+    sub(/^0x/, "", s)
+    for(i = 1; i <= length(s); i++) {
+        c = index("0123456789abcdef", substr(s, i, 1))
+        if(c == 0) {
+            break
+        }
+        n = n * 16 + c - 1
+    }
+    return n
+}
+
+BEGIN {
+    in_map = 0
+    pending = ""
+}
+
+/^Linker script and memory map/ {
+    in_map = 1
+    next
+}
+
+!in_map {
+    next
+}
+
+# The stack and the heap reserved by the linker script
+/^\.stack_dummy|^\.heap/ && NF >= 3 {
+    reserved[$1] = strtonum_hex($3)
+}
+
+# An input section name too long for its line, the rest follows
+pending != "" {
+    if(NF >= 3 && $1 ~ /^0x/) {
+        add(pending, $2, $3)
+    }
+    pending = ""
+    next
+}
+
+/^ (\.data|\.bss|\.noinit|COMMON)/ {
+    if(NF == 1) {
+        pending = $1
+    } else if(NF >= 4 && $2 ~ /^0x/) {
+        add($1, $3, $4)
+    }
+}
+
+END {
+    printf("Static RAM by module (%s):\n", FILENAME)
+    printf("  %-32s %8s %8s %8s\n", "module", "data", "bss", "total")
+    sort = "sort -k4 -n -r"
+    for(m in modules) {
+        printf("  %-32s %8d %8d %8d\n", m, data[m], bss[m], data[m] + bss[m]) | sort
+    }
+    close(sort)
+    printf("  %-32s %8d %8d %8d\n", "total", total_data, total_bss, total_data + total_bss)
+    for(r in reserved) {
+        printf("  %-32s %8d\n", r, reserved[r])
+    }
+}
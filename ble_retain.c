@@ -0,0 +1,246 @@
+/***************************************************************************//**
+* \file ble_retain.c
+* \version 1.0
+*
+* \brief
+* Source file for the BLE state retained across soft resets.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "ble_retain.h"
+
+/**
+ * @brief The retained region, the CRC covers all the fields before it.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t size;
+    ble_retain_data_t data;
+    ble_retain_stats_t stats;
+    uint32_t crc;
+} ble_retain_t;
+
+/* The retained region, not cleared by the startup code */
+CY_SECTION(".noinit") static ble_retain_t ble_retain;
+
+/* The region was valid at this boot */
+static bool ble_retain_warm;
+
+/* The time to advertise of this boot is recorded */
+static bool ble_retain_booted;
+
+/* The CRC-32 (IEEE 802.3) table of a nibble */
+static const uint32_t ble_retain_crc_table[16] =
+{
+    0x00000000uL, 0x1DB71064uL, 0x3B6E20C8uL, 0x26D930ACuL,
+    0x76DC4190uL, 0x6B6B51F4uL, 0x4DB26158uL, 0x5005713CuL,
+    0xEDB88320uL, 0xF00F9344uL, 0xD6D6A3E8uL, 0xCB61B38CuL,
+    0x9B64C2B0uL, 0x86D3D2D4uL, 0xA00AE278uL, 0xBDBDF21CuL
+};
+
+
+/*******************************************************************************
+* Function Name: ble_retain_crc
+****************************************************************************//**
+*
+* Calculates the CRC of the retained region.
+*
+* \param none.
+*
+* \return The CRC.
+*
+*******************************************************************************/
+static uint32_t ble_retain_crc(void)
+{
+    const uint8_t *p = (const uint8_t *)&ble_retain;
+    uint32_t crc = 0xFFFFFFFFuL;
+    uint32_t i;
+
+    for(i = 0u; i < offsetof(ble_retain_t, crc); i++) {
+        crc ^= p[i];
+        crc = (crc >> 4u) ^ ble_retain_crc_table[crc & 0x0Fu];
+        crc = (crc >> 4u) ^ ble_retain_crc_table[crc & 0x0Fu];
+    }
+    return ~crc;
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_init
+****************************************************************************//**
+*
+* Checks the retained region at boot. It is kept only after a soft reset and
+* if it is valid, otherwise it is cleared.
+*
+* \param none.
+*
+* \return true for a warm boot, the retained state is valid.
+*
+*******************************************************************************/
+bool ble_retain_init(void)
+{
+    bool soft = (0u != (Cy_SysLib_GetResetReason() & CY_SYSLIB_RESET_SOFT));
+    uint32_t lost = 0u;
+
+    /* The reset reasons are sticky, the next boot must see only its own */
+    Cy_SysLib_ClearResetReason();
+    ble_retain_warm = soft && (ble_retain.magic == BLE_RETAIN_MAGIC) && \
+                      (ble_retain.size == sizeof(ble_retain)) && (ble_retain.crc == ble_retain_crc());
+#if (ENABLE_WARM_BOOT_FUNCTION == DISABLED)
+    ble_retain_warm = false;
+#endif
+    ble_retain_booted = false;
+    if(ble_retain_warm) {
+        ble_retain.stats.warm_boots++;
+    } else {
+        if(soft && (ble_retain.magic == BLE_RETAIN_MAGIC)) {
+            lost = ble_retain.stats.lost + 1u;
+        }
+        memset(&ble_retain, 0, sizeof(ble_retain));
+        ble_retain.magic = BLE_RETAIN_MAGIC;
+        ble_retain.size = sizeof(ble_retain);
+        ble_retain.stats.lost = lost;
+    }
+    ble_retain_commit();
+    return ble_retain_warm;
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_is_warm
+****************************************************************************//**
+*
+* Checks if this boot is a warm boot.
+*
+* \param none.
+*
+* \return true if the retained state was valid at boot.
+*
+*******************************************************************************/
+bool ble_retain_is_warm(void)
+{
+    return ble_retain_warm;
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_get
+****************************************************************************//**
+*
+* Gets the retained state, ble_retain_commit() must follow a change.
+*
+* \param none.
+*
+* \return The retained state.
+*
+*******************************************************************************/
+ble_retain_data_t *ble_retain_get(void)
+{
+    return &ble_retain.data;
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_commit
+****************************************************************************//**
+*
+* Updates the CRC after a change of the retained state.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_retain_commit(void)
+{
+    ble_retain.crc = ble_retain_crc();
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_boot_done
+****************************************************************************//**
+*
+* Records the time to advertise of this boot, only the first call counts.
+*
+* \param tta_us The time from ble_app_init() to the first advertisement in us.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_retain_boot_done(uint32_t tta_us)
+{
+    if(ble_retain_booted) {
+        return;
+    }
+    ble_retain_booted = true;
+    if(ble_retain_warm) {
+        ble_retain.stats.warm_tta_us = tta_us;
+        if(tta_us > ble_retain.stats.warm_tta_max_us) {
+            ble_retain.stats.warm_tta_max_us = tta_us;
+        }
+    } else {
+        ble_retain.stats.cold_tta_us = tta_us;
+    }
+    ble_retain_commit();
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_soft_reset
+****************************************************************************//**
+*
+* Resets the device, the next boot is a warm boot.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_retain_soft_reset(void)
+{
+    ble_retain_commit();
+    BLE_UART_DEB_WAIT_TX_COMPLETE();
+    NVIC_SystemReset();
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_get_stats
+****************************************************************************//**
+*
+* Gets the boot statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_retain_get_stats(ble_retain_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_retain.stats;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_retain_print_stats
+****************************************************************************//**
+*
+* Prints the boot statistics.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_retain_print_stats(void)
+{
+    BLE_DBG_PRINTF("Boot: %s, warm boots=%lu, lost=%lu, cold tta=%lu us, warm tta=%lu us (max %lu us)\r\n", \
+        ble_retain_warm ? "warm" : "cold", (unsigned long)ble_retain.stats.warm_boots, \
+        (unsigned long)ble_retain.stats.lost, (unsigned long)ble_retain.stats.cold_tta_us, \
+        (unsigned long)ble_retain.stats.warm_tta_us, (unsigned long)ble_retain.stats.warm_tta_max_us);
+}
+
+/* [] END OF FILE */
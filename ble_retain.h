@@ -0,0 +1,100 @@
+/***************************************************************************//**
+* \file ble_retain.h
+* \version 1.0
+*
+* \brief
+* Header file for the BLE state retained across soft resets.
+*
+* The retained region is placed in the .noinit section of the linker scripts,
+* so the startup code does not clear it. It holds the generated keys, the
+* accepted connection parameters and the bond index. After a soft reset the
+* region is used if its magic, size and CRC are valid (a warm boot), otherwise
+* it is cleared (a cold boot). Every change must be followed by
+* ble_retain_commit() to update the CRC.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_RETAIN_H_
+#define _BLE_RETAIN_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The retained region is initialized, checked with the size and CRC.
+ */
+#define BLE_RETAIN_MAGIC                    (0x52544E42uL)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The connection parameters accepted by the last central, in the
+ *        units of ble_app_connection_param_update_request().
+ */
+typedef struct
+{
+    uint16_t interval_min;
+    uint16_t interval_max;
+    uint16_t slave_latency;
+    uint16_t timeout_multiplier;
+} ble_retain_link_t;
+
+/**
+ * @brief The retained BLE state.
+ */
+typedef struct
+{
+    bool     keys_valid;
+    bool     link_valid;
+    uint8_t  bond_count;
+    cy_stc_ble_gap_sec_key_param_t keys;                            /* The generated local keys */
+    ble_retain_link_t link;
+    cy_stc_ble_gap_peer_addr_info_t bonds[CY_BLE_MAX_BONDED_DEVICES];  /* The bond index */
+} ble_retain_data_t;
+
+/**
+ * @brief The boot statistics, the time to advertise is from ble_app_init()
+ *        to the start of the first advertisement. They are retained too, so
+ *        the cold boot time is known after the warm boots which follow.
+ */
+typedef struct
+{
+    uint32_t warm_boots;                /* Warm boots since the last cold boot */
+    uint32_t lost;                      /* Soft resets which found the region invalid */
+    uint32_t cold_tta_us;               /* The time to advertise of the last cold boot */
+    uint32_t warm_tta_us;               /* The time to advertise of the last warm boot */
+    uint32_t warm_tta_max_us;
+} ble_retain_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+bool ble_retain_init(void);
+bool ble_retain_is_warm(void);
+ble_retain_data_t *ble_retain_get(void);
+void ble_retain_commit(void);
+void ble_retain_boot_done(uint32_t tta_us);
+void ble_retain_soft_reset(void);
+void ble_retain_get_stats(ble_retain_stats_t *stats);
+void ble_retain_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_RETAIN_H_ */
+
+/* [] END OF FILE */
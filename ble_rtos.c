@@ -0,0 +1,350 @@
+/***************************************************************************//**
+* \file ble_rtos.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE FreeRTOS task architecture.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "ble_rtos.h"
+
+#if defined(COMPONENT_FREERTOS)
+
+#include <string.h>
+#include "ble_custom_cmd.h"
+#include "ble_event.h"
+#include "ble_pool.h"
+
+/**
+ * @brief The message pool, the free messages are kept in a queue of pointers.
+ *        The payload blocks are taken from ble_pool.c.
+ */
+static ble_rtos_msg_t ble_rtos_msgs[BLE_RTOS_MSG_NUM];
+static QueueHandle_t ble_rtos_free_queue = NULL;
+
+/**
+ * @brief The command queue to the application tasks and the response queue
+ *        to the BLE task, both pass message pointers.
+ */
+static QueueHandle_t ble_rtos_cmd_queue = NULL;
+static QueueHandle_t ble_rtos_res_queue = NULL;
+
+/**
+ * @brief The response waiting for the transmit queue space, BLE task only.
+ */
+static ble_rtos_msg_t *ble_rtos_res_pending = NULL;
+
+/**
+ * @brief The queue statistics.
+ */
+static ble_rtos_stats_t ble_rtos_stats;
+
+
+/*******************************************************************************
+* Function Name: ble_rtos_msg_get
+****************************************************************************//**
+*
+* Gets a message without a payload block from the pool.
+*
+* \param wait The ticks to wait for a free message.
+*
+* \return The message, NULL if no message is free.
+*
+*******************************************************************************/
+static ble_rtos_msg_t *ble_rtos_msg_get(TickType_t wait)
+{
+    ble_rtos_msg_t *msg = NULL;
+    uint32_t free_num;
+
+    if(pdTRUE != xQueueReceive(ble_rtos_free_queue, &msg, wait)) {
+        return NULL;
+    }
+    /* Any task allocates, the low water mark is updated under the lock */
+    taskENTER_CRITICAL();
+    free_num = (uint32_t)uxQueueMessagesWaiting(ble_rtos_free_queue);
+    if(free_num < ble_rtos_stats.msg_min_free) {
+        ble_rtos_stats.msg_min_free = free_num;
+    }
+    taskEXIT_CRITICAL();
+    msg->data = NULL;
+    return msg;
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_command_forward
+****************************************************************************//**
+*
+* The forward hook of the command framework, runs in the BLE task and passes
+* the command to the application tasks. The message takes the pool block of
+* the command.
+*
+* \param conn_id The connection ID.
+*
+* \param cmd The command frame, in a block of the pool.
+*
+* \param len The command frame size.
+*
+* \return true if the command is queued, the block is owned by the message.
+*
+*******************************************************************************/
+static bool ble_rtos_command_forward(uint8_t conn_id, uint8_t *cmd, uint16_t len)
+{
+    ble_rtos_msg_t *msg = ble_rtos_msg_get(0u);
+
+    if(msg == NULL) {
+        ble_rtos_stats.commands_dropped++;
+        return false;
+    }
+    msg->data = cmd;
+    msg->len = len;
+    msg->lane = BLE_CUSTOM_HI_LANE_CONTROL;
+    msg->conn_id = conn_id;
+    if(pdTRUE != xQueueSend(ble_rtos_cmd_queue, &msg, 0u)) {
+        /* The block goes back to the command framework */
+        msg->data = NULL;
+        ble_rtos_msg_free(msg);
+        ble_rtos_stats.commands_dropped++;
+        return false;
+    }
+    ble_rtos_stats.commands++;
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_init
+****************************************************************************//**
+*
+* Creates the message pool, the queues and the BLE task. It should be called
+* before vTaskStartScheduler().
+*
+* \param ble_task The BLE task function, it initializes the BLE application
+* and runs the event loop.
+*
+* \param arg The argument of the BLE task.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_rtos_init(TaskFunction_t ble_task, void *arg)
+{
+    ble_rtos_msg_t *msg;
+    uint32_t i;
+
+    ble_rtos_free_queue = xQueueCreate(BLE_RTOS_MSG_NUM, sizeof(ble_rtos_msg_t *));
+    ble_rtos_cmd_queue = xQueueCreate(BLE_RTOS_MSG_NUM, sizeof(ble_rtos_msg_t *));
+    ble_rtos_res_queue = xQueueCreate(BLE_RTOS_MSG_NUM, sizeof(ble_rtos_msg_t *));
+    if((ble_rtos_free_queue == NULL) || (ble_rtos_cmd_queue == NULL) || (ble_rtos_res_queue == NULL)) {
+        return CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+    for(i = 0u; i < BLE_RTOS_MSG_NUM; i++) {
+        msg = &ble_rtos_msgs[i];
+        (void)xQueueSend(ble_rtos_free_queue, &msg, 0u);
+    }
+    memset(&ble_rtos_stats, 0, sizeof(ble_rtos_stats));
+    ble_rtos_stats.msg_min_free = BLE_RTOS_MSG_NUM;
+    ble_custom_cmd_set_forward(ble_rtos_command_forward);
+
+    if(pdPASS != xTaskCreate(ble_task, "BLE", BLE_RTOS_BLE_TASK_STACK_SIZE, arg, \
+                             BLE_RTOS_BLE_TASK_PRIORITY, NULL)) {
+        return CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_msg_alloc
+****************************************************************************//**
+*
+* Gets a message and its payload block from the pool, it can be called from
+* any task.
+*
+* \param size The payload size.
+*
+* \param wait The ticks to wait for a free message, the payload block is not
+* waited for.
+*
+* \return The message, NULL if no message or no block is free.
+*
+*******************************************************************************/
+ble_rtos_msg_t *ble_rtos_msg_alloc(uint16_t size, TickType_t wait)
+{
+    ble_rtos_msg_t *msg = ble_rtos_msg_get(wait);
+
+    if(msg == NULL) {
+        return NULL;
+    }
+    if(NULL == (msg->data = ble_pool_alloc(size))) {
+        ble_rtos_msg_free(msg);
+        return NULL;
+    }
+    msg->len = 0u;
+    return msg;
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_msg_free
+****************************************************************************//**
+*
+* Returns a message and its payload block to the pool, it can be called from
+* any task.
+*
+* \param msg The message.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_rtos_msg_free(ble_rtos_msg_t *msg)
+{
+    if(msg != NULL) {
+        ble_pool_free(msg->data);
+        msg->data = NULL;
+        (void)xQueueSend(ble_rtos_free_queue, &msg, 0u);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_command_receive
+****************************************************************************//**
+*
+* Receives a command in an application task. The message holds the command
+* frame in its pool block, it is owned by the caller until it is freed or
+* submitted as the response. A response longer than the block needs a new
+* message from ble_rtos_msg_alloc().
+*
+* \param wait The ticks to wait for a command.
+*
+* \return The command message, NULL on the timeout.
+*
+*******************************************************************************/
+ble_rtos_msg_t *ble_rtos_command_receive(TickType_t wait)
+{
+    ble_rtos_msg_t *msg = NULL;
+
+    if(pdTRUE != xQueueReceive(ble_rtos_cmd_queue, &msg, wait)) {
+        return NULL;
+    }
+    return msg;
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_response_submit
+****************************************************************************//**
+*
+* Submits a response to the BLE task, it can be called from any task. The
+* message is owned by the BLE task and freed after it is queued for transmit.
+*
+* \param msg The response message, msg->len bytes of msg->data are sent to
+* the connection msg->conn_id, it is kept from the command message. The
+* response must fit the payload block.
+*
+* \param lane The transmit lane, see \ref ble_custom_hi_lane_t.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_rtos_response_submit(ble_rtos_msg_t *msg, ble_custom_hi_lane_t lane)
+{
+    if((msg == NULL) || (lane >= BLE_CUSTOM_HI_LANE_NUM) || (msg->len > ble_pool_block_size(msg->data))) {
+        ble_rtos_msg_free(msg);
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    msg->lane = lane;
+    /* The queue holds all messages of the pool, so it is never full */
+    (void)xQueueSend(ble_rtos_res_queue, &msg, 0u);
+    ble_event_post(BLE_EVENT_QUEUE);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_process
+****************************************************************************//**
+*
+* Moves the submitted responses to the transmit queue. When a lane is full,
+* the queued packets are sent first; if the stack is busy the response waits
+* for the next BLE_EVENT_TX. This function should be called in the BLE task
+* when BLE_EVENT_QUEUE or BLE_EVENT_TX is posted.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_rtos_process(void)
+{
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_iov_t iov;
+
+    for(;;) {
+        if((ble_rtos_res_pending == NULL) && \
+           (pdTRUE != xQueueReceive(ble_rtos_res_queue, &ble_rtos_res_pending, 0u))) {
+            ble_rtos_res_pending = NULL;
+            break;
+        }
+        iov.base = ble_rtos_res_pending->data;
+        iov.len = ble_rtos_res_pending->len;
+        apiResult = ble_custom_hi_response_queue(ble_rtos_res_pending->conn_id, ble_rtos_res_pending->lane, &iov, 1u);
+        if(apiResult == CY_BLE_ERROR_INSUFFICIENT_RESOURCES) {
+            ble_custom_hi_tx_task();
+            apiResult = ble_custom_hi_response_queue(ble_rtos_res_pending->conn_id, ble_rtos_res_pending->lane, \
+                                                     &iov, 1u);
+            if(apiResult == CY_BLE_ERROR_INSUFFICIENT_RESOURCES) {
+                ble_rtos_stats.retries++;
+                break;
+            }
+        }
+        if(apiResult == CY_BLE_SUCCESS) {
+            ble_rtos_stats.responses++;
+        } else {
+            ble_rtos_stats.responses_dropped++;
+        }
+        ble_rtos_msg_free(ble_rtos_res_pending);
+        ble_rtos_res_pending = NULL;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_rtos_get_stats
+****************************************************************************//**
+*
+* Gets the queue statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_rtos_get_stats(ble_rtos_stats_t *stats)
+{
+    if(stats != NULL) {
+        taskENTER_CRITICAL();
+        *stats = ble_rtos_stats;
+        taskEXIT_CRITICAL();
+    }
+}
+
+/*******************************************************************************
+* Function Name: vApplicationStackOverflowHook
+****************************************************************************//**
+*
+* FreeRTOS stack overflow hook, see configCHECK_FOR_STACK_OVERFLOW.
+*
+*******************************************************************************/
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+    (void)xTask;
+    (void)pcTaskName;
+    /* Halt CPU in Debug mode */
+    CY_ASSERT(0u != 0u);
+}
+
+#endif /* defined(COMPONENT_FREERTOS) */
+
+/* [] END OF FILE */
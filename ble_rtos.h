@@ -0,0 +1,102 @@
+/***************************************************************************//**
+* \file ble_rtos.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE FreeRTOS task architecture.
+*
+* In the FreeRTOS build (BLE_RTOS=FREERTOS in the Makefile) the BLE task owns
+* the BLE stack and runs the event loop, the other tasks never call the BLE
+* API. The commands without a handler are delivered to the application tasks
+* in messages of a shared pool, only the message pointer is passed through
+* the queues. The payload of a message is a block of ble_pool.c: a command
+* keeps the block it was received in, it is not copied. A task sends a
+* response by submitting a message, usually the command message itself, to
+* the response queue of the BLE task.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_RTOS_H_
+#define _BLE_RTOS_H_
+
+#if defined(COMPONENT_FREERTOS)
+
+#include "ble_common.h"
+#include "ble_custom_hi.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The number of messages of the pool shared by commands and responses,
+ *        each one holds a payload block while it is in use.
+ */
+#define BLE_RTOS_MSG_NUM                    (8u)
+
+/**
+ * @brief The stack size in words and the priority of the BLE task, it runs
+ *        above the application tasks so the stack events are not delayed.
+ */
+#define BLE_RTOS_BLE_TASK_STACK_SIZE        (4096u / sizeof(StackType_t))
+#define BLE_RTOS_BLE_TASK_PRIORITY          (configMAX_PRIORITIES - 1u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The message of the command and response queues.
+ */
+typedef struct
+{
+    ble_custom_hi_lane_t lane;      /* The transmit lane of a response */
+    uint8_t  conn_id;               /* The connection of the command, the response is sent to it */
+    uint16_t len;
+    uint8_t  *data;                 /* The payload, a block of ble_pool.c, see ble_pool_block_size() */
+} ble_rtos_msg_t;
+
+/**
+ * @brief The queue statistics.
+ */
+typedef struct
+{
+    uint32_t commands;              /* Commands delivered to the tasks */
+    uint32_t commands_dropped;      /* Commands answered busy, no message or queue full */
+    uint32_t responses;             /* Responses moved to the transmit queue */
+    uint32_t responses_dropped;     /* Responses dropped by the transmit queue */
+    uint32_t retries;               /* Response waits for the transmit queue space */
+    uint32_t msg_min_free;          /* The low water mark of the free messages */
+} ble_rtos_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+cy_en_ble_api_result_t ble_rtos_init(TaskFunction_t ble_task, void *arg);
+ble_rtos_msg_t *ble_rtos_msg_alloc(uint16_t size, TickType_t wait);
+void ble_rtos_msg_free(ble_rtos_msg_t *msg);
+ble_rtos_msg_t *ble_rtos_command_receive(TickType_t wait);
+cy_en_ble_api_result_t ble_rtos_response_submit(ble_rtos_msg_t *msg, ble_custom_hi_lane_t lane);
+void ble_rtos_process(void);
+void ble_rtos_get_stats(ble_rtos_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* defined(COMPONENT_FREERTOS) */
+
+#endif /* _BLE_RTOS_H_ */
+
+/* [] END OF FILE */
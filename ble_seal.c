@@ -0,0 +1,831 @@
+/***************************************************************************//**
+* \file ble_seal.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE payload sealing.
+*
+* The CCM mode (RFC 3610) is built on the block cipher of the backend: the
+* CBC-MAC and the counter stream are computed in one pass over the payload,
+* which is encrypted or decrypted in place.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_seal.h"
+#include "ble_pool.h"
+#include "ble_time.h"
+
+/**
+ * @brief The AES block size and the software key schedule size.
+ */
+#define BLE_SEAL_BLOCK_LEN                  (16u)
+#define BLE_SEAL_AES_ROUNDS                 (10u)
+
+/**
+ * @brief The CCM length field size (L) and the flags of the first block.
+ */
+#define BLE_SEAL_CCM_L                      (BLE_SEAL_BLOCK_LEN - 1u - BLE_SEAL_NONCE_LEN)
+#define BLE_SEAL_CCM_FLAGS                  ((((BLE_SEAL_MIC_LEN - 2u) / 2u) << 3u) | (BLE_SEAL_CCM_L - 1u))
+#define BLE_SEAL_CCM_FLAG_AAD               (0x40u)
+
+/**
+ * @brief The session of a connection.
+ */
+typedef struct
+{
+    bool     active;
+    uint8_t  key[BLE_SEAL_KEY_LEN];             /* Kept to rebuild the context for another backend */
+    uint8_t  iv[BLE_SEAL_IV_LEN];
+    uint32_t tx_counter;
+    uint32_t rx_counter;
+    ble_seal_ctx_t ctx;
+} ble_seal_session_t;
+
+/* The sessions indexed by the connection ID */
+static ble_seal_session_t ble_seal_sessions[BLE_SEAL_SESSION_NUM];
+
+/* The backend in use */
+static const ble_seal_backend_t *ble_seal_backend = &ble_seal_backend_soft;
+
+/* The sealing statistics */
+static ble_seal_stats_t ble_seal_stats;
+
+/* The AES S-box */
+static const uint8_t ble_seal_sbox[256] =
+{
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+
+/*******************************************************************************
+* Function Name: ble_seal_soft_set_key
+****************************************************************************//**
+*
+* Expands the AES-128 key into the round keys.
+*
+* \param ctx The key context, the round keys are stored here.
+*
+* \param key The key.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_seal_soft_set_key(ble_seal_ctx_t *ctx, const uint8_t *key)
+{
+    uint8_t *rk = (uint8_t *)ctx->data;
+    uint8_t rcon = 0x01u;
+    uint8_t t[4];
+    uint32_t i;
+
+    memcpy(rk, key, BLE_SEAL_KEY_LEN);
+    for(i = BLE_SEAL_KEY_LEN; i < BLE_SEAL_CTX_SIZE; i += 4u) {
+        memcpy(t, &rk[i - 4u], sizeof(t));
+        if((i % BLE_SEAL_KEY_LEN) == 0u) {
+            /* RotWord, SubWord and Rcon */
+            uint8_t first = t[0];
+            t[0] = ble_seal_sbox[t[1]] ^ rcon;
+            t[1] = ble_seal_sbox[t[2]];
+            t[2] = ble_seal_sbox[t[3]];
+            t[3] = ble_seal_sbox[first];
+            rcon = (uint8_t)((rcon << 1u) ^ (((rcon & 0x80u) != 0u) ? 0x1bu : 0x00u));
+        }
+        rk[i]      = rk[i - 16u] ^ t[0];
+        rk[i + 1u] = rk[i - 15u] ^ t[1];
+        rk[i + 2u] = rk[i - 14u] ^ t[2];
+        rk[i + 3u] = rk[i - 13u] ^ t[3];
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_soft_encrypt
+****************************************************************************//**
+*
+* Encrypts one block with the software AES-128.
+*
+* \param ctx The key context.
+*
+* \param in The plaintext block.
+*
+* \param out The ciphertext block, it may be the same as in.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_seal_soft_encrypt(const ble_seal_ctx_t *ctx, const uint8_t *in, uint8_t *out)
+{
+    const uint8_t *rk = (const uint8_t *)ctx->data;
+    uint8_t s[BLE_SEAL_BLOCK_LEN];
+    uint8_t t[BLE_SEAL_BLOCK_LEN];
+    uint8_t a;
+    uint8_t x;
+    uint32_t round;
+    uint32_t c;
+    uint32_t i;
+
+    for(i = 0u; i < BLE_SEAL_BLOCK_LEN; i++) {
+        s[i] = in[i] ^ rk[i];
+    }
+    for(round = 1u; round <= BLE_SEAL_AES_ROUNDS; round++) {
+        /* SubBytes and ShiftRows, the state is column major */
+        for(i = 0u; i < BLE_SEAL_BLOCK_LEN; i++) {
+            t[i] = ble_seal_sbox[s[(i + ((i % 4u) * 4u)) % BLE_SEAL_BLOCK_LEN]];
+        }
+        rk += BLE_SEAL_BLOCK_LEN;
+        if(round == BLE_SEAL_AES_ROUNDS) {
+            for(i = 0u; i < BLE_SEAL_BLOCK_LEN; i++) {
+                s[i] = t[i] ^ rk[i];
+            }
+            break;
+        }
+        /* MixColumns and AddRoundKey */
+        for(c = 0u; c < BLE_SEAL_BLOCK_LEN; c += 4u) {
+            a = t[c] ^ t[c + 1u] ^ t[c + 2u] ^ t[c + 3u];
+            for(i = 0u; i < 4u; i++) {
+                x = t[c + i] ^ t[c + ((i + 1u) % 4u)];
+                x = (uint8_t)((x << 1u) ^ (((x & 0x80u) != 0u) ? 0x1bu : 0x00u));
+                s[c + i] = t[c + i] ^ a ^ x ^ rk[c + i];
+            }
+        }
+    }
+    memcpy(out, s, BLE_SEAL_BLOCK_LEN);
+}
+
+/**
+ * @brief The portable software backend.
+ */
+const ble_seal_backend_t ble_seal_backend_soft =
+{
+    .name    = "soft",
+    .set_key = ble_seal_soft_set_key,
+    .load    = NULL,
+    .encrypt = ble_seal_soft_encrypt,
+    .unload  = NULL
+};
+
+#if defined(CY_IP_MXCRYPTO)
+/* The AES state of the crypto block, the key is loaded for each payload */
+static cy_stc_crypto_aes_state_t ble_seal_crypto_state;
+
+/*******************************************************************************
+* Function Name: ble_seal_crypto_set_key
+****************************************************************************//**
+*
+* Keeps the key in the context, the crypto block is shared by the sessions so
+* the key is loaded for each payload.
+*
+* \param ctx The key context.
+*
+* \param key The key.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_seal_crypto_set_key(ble_seal_ctx_t *ctx, const uint8_t *key)
+{
+    memcpy(ctx->data, key, BLE_SEAL_KEY_LEN);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_crypto_load
+****************************************************************************//**
+*
+* Enables the crypto block and loads the key of the context.
+*
+* \param ctx The key context.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_seal_crypto_load(const ble_seal_ctx_t *ctx)
+{
+    if(CY_CRYPTO_SUCCESS != Cy_Crypto_Core_Enable(CRYPTO)) {
+        return CY_BLE_ERROR_HARDWARE_FAILURE;
+    }
+    if(CY_CRYPTO_SUCCESS != Cy_Crypto_Core_Aes_Init(CRYPTO, (const uint8_t *)ctx->data, \
+                                                    CY_CRYPTO_KEY_AES_128, &ble_seal_crypto_state)) {
+        (void)Cy_Crypto_Core_Disable(CRYPTO);
+        return CY_BLE_ERROR_HARDWARE_FAILURE;
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_crypto_encrypt
+****************************************************************************//**
+*
+* Encrypts one block with the crypto block.
+*
+* \param ctx The key context, the key is already loaded.
+*
+* \param in The plaintext block.
+*
+* \param out The ciphertext block, it may be the same as in.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_seal_crypto_encrypt(const ble_seal_ctx_t *ctx, const uint8_t *in, uint8_t *out)
+{
+    (void)ctx;
+    (void)Cy_Crypto_Core_Aes_Ecb(CRYPTO, CY_CRYPTO_ENCRYPT, out, in, &ble_seal_crypto_state);
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_crypto_unload
+****************************************************************************//**
+*
+* Clears the key and disables the crypto block.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_seal_crypto_unload(void)
+{
+    (void)Cy_Crypto_Core_Aes_Free(CRYPTO, &ble_seal_crypto_state);
+    (void)Cy_Crypto_Core_Disable(CRYPTO);
+}
+
+/**
+ * @brief The PSoC 6 crypto block backend.
+ */
+const ble_seal_backend_t ble_seal_backend_crypto =
+{
+    .name    = "crypto",
+    .set_key = ble_seal_crypto_set_key,
+    .load    = ble_seal_crypto_load,
+    .encrypt = ble_seal_crypto_encrypt,
+    .unload  = ble_seal_crypto_unload
+};
+#endif /* defined(CY_IP_MXCRYPTO) */
+
+/*******************************************************************************
+* Function Name: ble_seal_ccm
+****************************************************************************//**
+*
+* Runs the CCM mode over a payload in place. The CBC-MAC is computed over the
+* plaintext, so the block is authenticated before it is encrypted, or after it
+* is decrypted. The key of the context must be loaded.
+*
+* \param backend The backend.
+*
+* \param ctx The key context.
+*
+* \param nonce The nonce of BLE_SEAL_NONCE_LEN bytes.
+*
+* \param aad The additional authenticated data, NULL if aad_len is 0.
+*
+* \param aad_len The additional authenticated data size, less than 0xFF00.
+*
+* \param buf The payload, it is encrypted or decrypted in place.
+*
+* \param len The payload size.
+*
+* \param mic The encrypted MIC of BLE_SEAL_MIC_LEN bytes is returned here.
+*
+* \param decrypt true to decrypt the payload.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_seal_ccm(const ble_seal_backend_t *backend, const ble_seal_ctx_t *ctx, const uint8_t *nonce, \
+                         const uint8_t *aad, uint16_t aad_len, uint8_t *buf, uint16_t len, uint8_t *mic, bool decrypt)
+{
+    uint32_t mac_block[BLE_SEAL_BLOCK_LEN / 4u];
+    uint32_t ctr_block[BLE_SEAL_BLOCK_LEN / 4u];
+    uint32_t pad_block[BLE_SEAL_BLOCK_LEN / 4u];
+    uint8_t *mac = (uint8_t *)mac_block;
+    uint8_t *ctr = (uint8_t *)ctr_block;
+    uint8_t *pad = (uint8_t *)pad_block;
+    uint16_t counter = 0u;
+    uint32_t chunk;
+    uint32_t pos;
+    uint32_t i;
+
+    /* B0: | flags | nonce | payload size | */
+    mac[0] = (uint8_t)(BLE_SEAL_CCM_FLAGS | ((aad_len != 0u) ? BLE_SEAL_CCM_FLAG_AAD : 0u));
+    memcpy(&mac[1], nonce, BLE_SEAL_NONCE_LEN);
+    mac[14] = (uint8_t)(len >> 8u);
+    mac[15] = (uint8_t)len;
+    backend->encrypt(ctx, mac, mac);
+    /* The additional data is prefixed by its size */
+    if(aad_len != 0u) {
+        mac[0] ^= (uint8_t)(aad_len >> 8u);
+        mac[1] ^= (uint8_t)aad_len;
+        pos = 2u;
+        for(i = 0u; i < aad_len; i++) {
+            mac[pos++] ^= aad[i];
+            if(pos == BLE_SEAL_BLOCK_LEN) {
+                backend->encrypt(ctx, mac, mac);
+                pos = 0u;
+            }
+        }
+        if(pos != 0u) {
+            backend->encrypt(ctx, mac, mac);
+        }
+    }
+    /* A0: | flags | nonce | counter | */
+    ctr[0] = (uint8_t)(BLE_SEAL_CCM_L - 1u);
+    memcpy(&ctr[1], nonce, BLE_SEAL_NONCE_LEN);
+    for(pos = 0u; pos < len; pos += chunk) {
+        chunk = ((len - pos) < BLE_SEAL_BLOCK_LEN) ? (len - pos) : BLE_SEAL_BLOCK_LEN;
+        counter++;
+        ctr[14] = (uint8_t)(counter >> 8u);
+        ctr[15] = (uint8_t)counter;
+        backend->encrypt(ctx, ctr, pad);
+        for(i = 0u; i < chunk; i++) {
+            if(decrypt) {
+                buf[pos + i] ^= pad[i];
+                mac[i] ^= buf[pos + i];
+            } else {
+                mac[i] ^= buf[pos + i];
+                buf[pos + i] ^= pad[i];
+            }
+        }
+        backend->encrypt(ctx, mac, mac);
+    }
+    /* The MIC is encrypted with A0 */
+    ctr[14] = 0u;
+    ctr[15] = 0u;
+    backend->encrypt(ctx, ctr, pad);
+    for(i = 0u; i < BLE_SEAL_MIC_LEN; i++) {
+        mic[i] = mac[i] ^ pad[i];
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_nonce
+****************************************************************************//**
+*
+* Builds the nonce of a packet.
+*
+* \param session The session.
+*
+* \param counter The packet counter.
+*
+* \param dir The direction, BLE_SEAL_DIR_RX or BLE_SEAL_DIR_TX.
+*
+* \param nonce The nonce of BLE_SEAL_NONCE_LEN bytes is returned here.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_seal_nonce(const ble_seal_session_t *session, uint32_t counter, uint8_t dir, uint8_t *nonce)
+{
+    nonce[0] = (uint8_t)counter;
+    nonce[1] = (uint8_t)(counter >> 8u);
+    nonce[2] = (uint8_t)(counter >> 16u);
+    nonce[3] = (uint8_t)(counter >> 24u);
+    nonce[4] = dir;
+    memcpy(&nonce[5], session->iv, BLE_SEAL_IV_LEN);
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_run
+****************************************************************************//**
+*
+* Loads the key of the backend and runs the CCM mode over a payload.
+*
+* \param backend The backend.
+*
+* \param ctx The key context.
+*
+* \param nonce The nonce.
+*
+* \param buf The payload.
+*
+* \param len The payload size.
+*
+* \param mic The encrypted MIC is returned here.
+*
+* \param decrypt true to decrypt the payload.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_seal_run(const ble_seal_backend_t *backend, const ble_seal_ctx_t *ctx, \
+                                           const uint8_t *nonce, uint8_t *buf, uint16_t len, uint8_t *mic, bool decrypt)
+{
+    cy_en_ble_api_result_t apiResult;
+
+    if((backend->load != NULL) && (CY_BLE_SUCCESS != (apiResult = backend->load(ctx)))) {
+        return apiResult;
+    }
+    ble_seal_ccm(backend, ctx, nonce, NULL, 0u, buf, len, mic, decrypt);
+    if(backend->unload != NULL) {
+        backend->unload();
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_init
+****************************************************************************//**
+*
+* Initializes the sealing, all sessions are stopped and the crypto block
+* backend is chosen if the device has one.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_seal_init(void)
+{
+    memset(ble_seal_sessions, 0, sizeof(ble_seal_sessions));
+    memset(&ble_seal_stats, 0, sizeof(ble_seal_stats));
+#if defined(CY_IP_MXCRYPTO)
+    ble_seal_backend = &ble_seal_backend_crypto;
+#else
+    ble_seal_backend = &ble_seal_backend_soft;
+#endif
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_set_backend
+****************************************************************************//**
+*
+* Changes the backend, the key contexts of the running sessions are rebuilt.
+*
+* \param backend The backend.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_seal_set_backend(const ble_seal_backend_t *backend)
+{
+    cy_en_ble_api_result_t apiResult;
+    uint32_t i;
+
+    if((backend == NULL) || (backend->set_key == NULL) || (backend->encrypt == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    for(i = 0u; i < BLE_SEAL_SESSION_NUM; i++) {
+        if(ble_seal_sessions[i].active && \
+           (CY_BLE_SUCCESS != (apiResult = backend->set_key(&ble_seal_sessions[i].ctx, ble_seal_sessions[i].key)))) {
+            /* Restore the contexts of the current backend */
+            while(i-- > 0u) {
+                if(ble_seal_sessions[i].active) {
+                    (void)ble_seal_backend->set_key(&ble_seal_sessions[i].ctx, ble_seal_sessions[i].key);
+                }
+            }
+            return apiResult;
+        }
+    }
+    ble_seal_backend = backend;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_get_backend
+****************************************************************************//**
+*
+* Gets the backend in use.
+*
+* \param none.
+*
+* \return The backend.
+*
+*******************************************************************************/
+const ble_seal_backend_t *ble_seal_get_backend(void)
+{
+    return ble_seal_backend;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_start
+****************************************************************************//**
+*
+* Starts the session of a connection, the payloads are sealed from the next
+* packet on and the counters of both directions start from 0.
+*
+* \param conn_id The connection ID.
+*
+* \param key The session key of BLE_SEAL_KEY_LEN bytes.
+*
+* \param iv The session IV of BLE_SEAL_IV_LEN bytes.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_seal_start(uint8_t conn_id, const uint8_t *key, const uint8_t *iv)
+{
+    ble_seal_session_t *session;
+    cy_en_ble_api_result_t apiResult;
+
+    if((conn_id >= BLE_SEAL_SESSION_NUM) || (key == NULL) || (iv == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    session = &ble_seal_sessions[conn_id];
+    ble_seal_stop(conn_id);
+    if(CY_BLE_SUCCESS != (apiResult = ble_seal_backend->set_key(&session->ctx, key))) {
+        return apiResult;
+    }
+    memcpy(session->key, key, BLE_SEAL_KEY_LEN);
+    memcpy(session->iv, iv, BLE_SEAL_IV_LEN);
+    session->active = true;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_stop
+****************************************************************************//**
+*
+* Stops the session of a connection and wipes its key.
+*
+* \param conn_id The connection ID.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_seal_stop(uint8_t conn_id)
+{
+    if(conn_id < BLE_SEAL_SESSION_NUM) {
+        memset(&ble_seal_sessions[conn_id], 0, sizeof(ble_seal_session_t));
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_is_active
+****************************************************************************//**
+*
+* Checks if the payloads of a connection are sealed.
+*
+* \param conn_id The connection ID.
+*
+* \return true if the session is started.
+*
+*******************************************************************************/
+bool ble_seal_is_active(uint8_t conn_id)
+{
+    return (conn_id < BLE_SEAL_SESSION_NUM) && ble_seal_sessions[conn_id].active;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_encrypt
+****************************************************************************//**
+*
+* Seals a response payload in place and appends the MIC.
+*
+* \param conn_id The connection ID.
+*
+* \param buf The payload, it must hold len + BLE_SEAL_MIC_LEN bytes.
+*
+* \param len The plaintext size.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_seal_encrypt(uint8_t conn_id, uint8_t *buf, uint16_t len)
+{
+    ble_seal_session_t *session;
+    cy_en_ble_api_result_t apiResult;
+    uint8_t nonce[BLE_SEAL_NONCE_LEN];
+
+    if((!ble_seal_is_active(conn_id)) || (buf == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    session = &ble_seal_sessions[conn_id];
+    ble_seal_nonce(session, session->tx_counter, BLE_SEAL_DIR_TX, nonce);
+    if(CY_BLE_SUCCESS != (apiResult = ble_seal_run(ble_seal_backend, &session->ctx, nonce, buf, len, \
+                                                   &buf[len], false))) {
+        ble_seal_stats.errors++;
+        return apiResult;
+    }
+    session->tx_counter++;
+    ble_seal_stats.sealed++;
+    ble_seal_stats.bytes += len;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_cancel
+****************************************************************************//**
+*
+* Takes back the counter of the last sealed payload when the stack did not
+* take it, so the next payload uses the counter the peer expects.
+*
+* \param conn_id The connection ID.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_seal_cancel(uint8_t conn_id)
+{
+    if(ble_seal_is_active(conn_id) && (ble_seal_sessions[conn_id].tx_counter != 0u)) {
+        ble_seal_sessions[conn_id].tx_counter--;
+        ble_seal_stats.sealed--;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_decrypt
+****************************************************************************//**
+*
+* Opens a sealed command payload in place. The plaintext is wiped if the MIC
+* does not match.
+*
+* \param conn_id The connection ID.
+*
+* \param buf The sealed payload, the plaintext is returned here.
+*
+* \param len The sealed payload size, the plaintext is BLE_SEAL_MIC_LEN bytes
+* shorter.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_seal_decrypt(uint8_t conn_id, uint8_t *buf, uint16_t len)
+{
+    ble_seal_session_t *session;
+    cy_en_ble_api_result_t apiResult;
+    uint8_t nonce[BLE_SEAL_NONCE_LEN];
+    uint8_t mic[BLE_SEAL_MIC_LEN];
+    uint8_t diff = 0u;
+    uint32_t i;
+
+    if((!ble_seal_is_active(conn_id)) || (buf == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(len < BLE_SEAL_MIC_LEN) {
+        ble_seal_stats.errors++;
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    len -= BLE_SEAL_MIC_LEN;
+    session = &ble_seal_sessions[conn_id];
+    ble_seal_nonce(session, session->rx_counter, BLE_SEAL_DIR_RX, nonce);
+    if(CY_BLE_SUCCESS != (apiResult = ble_seal_run(ble_seal_backend, &session->ctx, nonce, buf, len, mic, true))) {
+        ble_seal_stats.errors++;
+        return apiResult;
+    }
+    /* Compare in constant time */
+    for(i = 0u; i < BLE_SEAL_MIC_LEN; i++) {
+        diff |= mic[i] ^ buf[len + i];
+    }
+    if(diff != 0u) {
+        memset(buf, 0, len);
+        ble_seal_stats.auth_failures++;
+        return CY_BLE_ERROR_MIC_AUTH_FAILED;
+    }
+    session->rx_counter++;
+    ble_seal_stats.opened++;
+    ble_seal_stats.bytes += len;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_get_stats
+****************************************************************************//**
+*
+* Gets the sealing statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_seal_get_stats(ble_seal_stats_t *stats)
+{
+    *stats = ble_seal_stats;
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_print_stats
+****************************************************************************//**
+*
+* Prints the sealing statistics.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_seal_print_stats(void)
+{
+    BLE_DBG_PRINTF("Seal %s: sealed=%lu, opened=%lu, auth failures=%lu, errors=%lu, bytes=%lu\r\n", \
+        ble_seal_backend->name, (unsigned long)ble_seal_stats.sealed, (unsigned long)ble_seal_stats.opened, \
+        (unsigned long)ble_seal_stats.auth_failures, (unsigned long)ble_seal_stats.errors, \
+        (unsigned long)ble_seal_stats.bytes);
+}
+
+/*******************************************************************************
+* Function Name: ble_seal_benchmark
+****************************************************************************//**
+*
+* Measures the sealing time of each backend with a test key and checks that
+* the backends give the same ciphertext. It blocks the caller for the whole
+* measurement, so it is meant for the debug console.
+*
+* \param len The payload size.
+*
+* \param count The number of payloads sealed by each backend.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_seal_benchmark(uint16_t len, uint32_t count)
+{
+    static const ble_seal_backend_t *const backends[] =
+    {
+        &ble_seal_backend_soft,
+#if defined(CY_IP_MXCRYPTO)
+        &ble_seal_backend_crypto,
+#endif
+    };
+    static const uint8_t key[BLE_SEAL_KEY_LEN] =
+    {
+        0xc0u, 0xc1u, 0xc2u, 0xc3u, 0xc4u, 0xc5u, 0xc6u, 0xc7u, 0xc8u, 0xc9u, 0xcau, 0xcbu, 0xccu, 0xcdu, 0xceu, 0xcfu
+    };
+    static const uint8_t nonce[BLE_SEAL_NONCE_LEN] =
+    {
+        0x00u, 0x00u, 0x00u, 0x03u, 0x02u, 0x01u, 0x00u, 0xa0u, 0xa1u, 0xa2u, 0xa3u, 0xa4u, 0xa5u
+    };
+    ble_seal_ctx_t ctx;
+    uint8_t mic[BLE_SEAL_MIC_LEN];
+    uint8_t ref_mic[BLE_SEAL_MIC_LEN];
+    uint8_t *buf;
+    uint8_t *ref;
+    uint32_t start;
+    uint32_t ticks;
+    uint32_t n;
+    uint32_t i;
+    bool match;
+
+    if((len == 0u) || (count == 0u)) {
+        return;
+    }
+    buf = ble_pool_alloc(len);
+    ref = ble_pool_alloc(len);
+    if((buf == NULL) || (ref == NULL)) {
+        BLE_DBG_PRINTF("Seal benchmark: no buffer of %u bytes\r\n", (unsigned)len);
+        ble_pool_free(buf);
+        ble_pool_free(ref);
+        return;
+    }
+    for(i = 0u; i < (sizeof(backends) / sizeof(backends[0])); i++) {
+        /* The first payload is compared with the first backend */
+        for(n = 0u; n < len; n++) {
+            buf[n] = (uint8_t)n;
+        }
+        if((CY_BLE_SUCCESS != backends[i]->set_key(&ctx, key)) || \
+           (CY_BLE_SUCCESS != ble_seal_run(backends[i], &ctx, nonce, buf, len, mic, false))) {
+            BLE_DBG_PRINTF("Seal %s: backend error\r\n", backends[i]->name);
+            continue;
+        }
+        if(i == 0u) {
+            memcpy(ref, buf, len);
+            memcpy(ref_mic, mic, sizeof(mic));
+        }
+        match = (0 == memcmp(ref, buf, len)) && (0 == memcmp(ref_mic, mic, sizeof(mic)));
+        /* Seal and open in turn, the payload is back to the plaintext at the end */
+        start = ble_time_now();
+        for(n = 0u; n < count; n++) {
+            (void)ble_seal_run(backends[i], &ctx, nonce, buf, len, mic, (n & 1u) == 0u);
+        }
+        ticks = ble_time_now() - start;
+        if(ticks == 0u) {
+            ticks = 1u;
+        }
+        BLE_DBG_PRINTF("Seal %s: %u bytes x %lu, %lu us/payload, %lu kB/s, %s\r\n", backends[i]->name, \
+            (unsigned)len, (unsigned long)count, (unsigned long)(BLE_TIME_TICKS_TO_US(ticks) / count), \
+            (unsigned long)(((uint64_t)len * count * BLE_TIME_TICK_HZ) / ((uint64_t)ticks * 1024u)), \
+            match ? "match" : "MISMATCH");
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    ble_pool_free(buf);
+    ble_pool_free(ref);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,143 @@
+/***************************************************************************//**
+* \file ble_seal.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE payload sealing.
+*
+* The command and response payloads of a connection can be sealed with
+* AES-128 CCM on top of the link layer security. The session key and IV are
+* given by the application per connection, sealing is off until then.
+*
+* Sealed payload: | ciphertext(n) | MIC(BLE_SEAL_MIC_LEN) |
+* Nonce:          | counter(4, little endian) | direction(1) | IV(8) |
+*
+* The counters are not sent, each direction counts its packets from 0 when
+* the session starts, like the link layer encryption. A packet which fails
+* the MIC check is dropped and does not advance the counter.
+*
+* The block cipher is a pluggable backend: the PSoC 6 crypto block when the
+* device has one, or a portable software AES.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_SEAL_H_
+#define _BLE_SEAL_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The key, IV and nonce sizes.
+ */
+#define BLE_SEAL_KEY_LEN                    (16u)
+#define BLE_SEAL_IV_LEN                     (8u)
+#define BLE_SEAL_NONCE_LEN                  (13u)
+
+/**
+ * @brief The MIC size appended to each sealed payload, 4 ~ 16 and even.
+ */
+#ifndef BLE_SEAL_MIC_LEN
+#define BLE_SEAL_MIC_LEN                    (4u)
+#endif
+
+/**
+ * @brief The nonce direction of the commands (central to peripheral) and
+ *        of the responses.
+ */
+#define BLE_SEAL_DIR_RX                     (0x00u)
+#define BLE_SEAL_DIR_TX                     (0x01u)
+
+/**
+ * @brief The number of sessions, one per connection ID.
+ */
+#define BLE_SEAL_SESSION_NUM                (CY_BLE_CONN_COUNT)
+
+/**
+ * @brief The key context size of a backend, the software key schedule is the
+ *        largest.
+ */
+#define BLE_SEAL_CTX_SIZE                   (176u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The key context of a session, its layout is owned by the backend.
+ */
+typedef struct
+{
+    uint32_t data[BLE_SEAL_CTX_SIZE / 4u];
+} ble_seal_ctx_t;
+
+/**
+ * @brief The block cipher backend.
+ */
+typedef struct
+{
+    const char *name;
+    /* Prepares the key context when a session starts */
+    cy_en_ble_api_result_t (* set_key)(ble_seal_ctx_t *ctx, const uint8_t *key);
+    /* Loads the key before a payload is sealed or opened, may be NULL */
+    cy_en_ble_api_result_t (* load)(const ble_seal_ctx_t *ctx);
+    /* Encrypts one 16-byte block, in and out may be the same */
+    void (* encrypt)(const ble_seal_ctx_t *ctx, const uint8_t *in, uint8_t *out);
+    /* Releases the hardware after the payload, may be NULL */
+    void (* unload)(void);
+} ble_seal_backend_t;
+
+/**
+ * @brief The sealing statistics.
+ */
+typedef struct
+{
+    uint32_t sealed;                /* Payloads sealed */
+    uint32_t opened;                /* Payloads opened */
+    uint32_t auth_failures;         /* Payloads dropped by the MIC check */
+    uint32_t errors;                /* Payloads dropped by the backend or the length */
+    uint32_t bytes;                 /* Plaintext bytes of both directions */
+} ble_seal_stats_t;
+
+/***************************************
+* Global Variables
+***************************************/
+extern const ble_seal_backend_t ble_seal_backend_soft;
+#if defined(CY_IP_MXCRYPTO)
+extern const ble_seal_backend_t ble_seal_backend_crypto;
+#endif
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_seal_init(void);
+cy_en_ble_api_result_t ble_seal_set_backend(const ble_seal_backend_t *backend);
+const ble_seal_backend_t *ble_seal_get_backend(void);
+cy_en_ble_api_result_t ble_seal_start(uint8_t conn_id, const uint8_t *key, const uint8_t *iv);
+void ble_seal_stop(uint8_t conn_id);
+bool ble_seal_is_active(uint8_t conn_id);
+cy_en_ble_api_result_t ble_seal_encrypt(uint8_t conn_id, uint8_t *buf, uint16_t len);
+void ble_seal_cancel(uint8_t conn_id);
+cy_en_ble_api_result_t ble_seal_decrypt(uint8_t conn_id, uint8_t *buf, uint16_t len);
+void ble_seal_get_stats(ble_seal_stats_t *stats);
+void ble_seal_print_stats(void);
+void ble_seal_benchmark(uint16_t len, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_SEAL_H_ */
+
+/* [] END OF FILE */
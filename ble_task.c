@@ -0,0 +1,268 @@
+/***************************************************************************//**
+* \file ble_task.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE cooperative task runtime.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "ble_task.h"
+
+/**
+ * @brief The list of the started tasks.
+ */
+static ble_task_t *ble_task_list = NULL;
+
+
+/*******************************************************************************
+* Function Name: ble_task_timeout_callback
+****************************************************************************//**
+*
+* The wait timeout callback, makes the task ready.
+*
+* \param arg The task.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_task_timeout_callback(void *arg)
+{
+    ble_task_t *task = (ble_task_t *)arg;
+
+    task->timed_out = true;
+    task->ready = true;
+    task->stats.timeouts++;
+    ble_event_post(BLE_EVENT_TASK);
+}
+
+/*******************************************************************************
+* Function Name: ble_task_init
+****************************************************************************//**
+*
+* Initializes the task runtime, the DWT cycle counter is enabled for the
+* runtime accounting.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_task_init(void)
+{
+    ble_task_list = NULL;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+* Function Name: ble_task_start
+****************************************************************************//**
+*
+* Starts a task, the task function is called first in the next ble_task_run().
+*
+* \param task The task.
+*
+* \param name The task name for the statistics.
+*
+* \param func The task function.
+*
+* \param done The completion callback, it can be NULL.
+*
+* \param arg The task argument.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_task_start(ble_task_t *task, const char *name, ble_task_func_t func, \
+                                      ble_task_done_t done, void *arg)
+{
+    ble_task_t **link = &ble_task_list;
+
+    if((task == NULL) || (func == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(task->running) {
+        return CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    /* Add the task to the list on the first start */
+    while((*link != NULL) && (*link != task)) {
+        link = &(*link)->next;
+    }
+    if(*link == NULL) {
+        task->next = NULL;
+        task->stats = (ble_task_stats_t){ 0u };
+        *link = task;
+    }
+    task->name = name;
+    task->func = func;
+    task->done = done;
+    task->arg = arg;
+    task->lc = 0u;
+    task->wait = 0u;
+    task->timed_out = false;
+    task->result = CY_BLE_SUCCESS;
+    task->ready = true;
+    task->running = true;
+    task->stats.starts++;
+    ble_event_post(BLE_EVENT_TASK);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_task_cancel
+****************************************************************************//**
+*
+* Cancels a task, the completion callback is not called.
+*
+* \param task The task.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_task_cancel(ble_task_t *task)
+{
+    if((task != NULL) && task->running) {
+        ble_timer_stop(&task->timer);
+        task->running = false;
+        task->ready = false;
+        task->wait = 0u;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_task_is_running
+****************************************************************************//**
+*
+* Checks if a task is running.
+*
+* \param task The task.
+*
+* \return True if the task is started and not exited.
+*
+*******************************************************************************/
+bool ble_task_is_running(const ble_task_t *task)
+{
+    return (task != NULL) && task->running;
+}
+
+/*******************************************************************************
+* Function Name: ble_task_run
+****************************************************************************//**
+*
+* Runs the tasks that are ready or wait for any of the posted events. This
+* function should be called in the main loop after the events are handled.
+*
+* \param events The event flags returned by ble_event_wait().
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_task_run(uint32_t events)
+{
+    ble_task_t *task;
+    uint32_t start;
+    uint32_t cycles;
+    uint8_t status;
+
+    for(task = ble_task_list; task != NULL; task = task->next) {
+        if((!task->running) || ((!task->ready) && (0u == (events & task->wait)))) {
+            continue;
+        }
+        task->ready = false;
+        start = DWT->CYCCNT;
+        status = task->func(task);
+        cycles = DWT->CYCCNT - start;
+
+        task->stats.runs++;
+        task->stats.cycles += cycles;
+        if(cycles > task->stats.max_cycles) {
+            task->stats.max_cycles = cycles;
+        }
+        if(status == BLE_TASK_EXITED) {
+            ble_timer_stop(&task->timer);
+            task->running = false;
+            task->wait = 0u;
+            if(task->done != NULL) {
+                task->done(task, task->result);
+            }
+        } else if(status == BLE_TASK_YIELDED) {
+            task->ready = true;
+            ble_event_post(BLE_EVENT_TASK);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_task_print_stats
+****************************************************************************//**
+*
+* Prints the runtime statistics of the tasks.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_task_print_stats(void)
+{
+    const ble_task_t *task;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+
+    for(task = ble_task_list; task != NULL; task = task->next) {
+        BLE_DBG_PRINTF("Task %s: %s, starts=%lu, runs=%lu, timeouts=%lu, time=%luus, max=%luus\r\n", \
+            task->name, task->running ? "running" : "idle", (unsigned long)task->stats.starts, \
+            (unsigned long)task->stats.runs, (unsigned long)task->stats.timeouts, \
+            (unsigned long)(task->stats.cycles / cycles_per_us), \
+            (unsigned long)(task->stats.max_cycles / cycles_per_us));
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_task_wait_begin
+****************************************************************************//**
+*
+* Starts a wait of the task, used by the BLE_TASK_WAIT_xxx macros.
+*
+* \param task The task.
+*
+* \param events The events that resume the task.
+*
+* \param timeout The timeout in ms, 0 for no timeout.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_task_wait_begin(ble_task_t *task, uint32_t events, uint32_t timeout)
+{
+    task->wait = events;
+    task->timed_out = false;
+    if(timeout != 0u) {
+        ble_timer_start(&task->timer, timeout, 0u, ble_task_timeout_callback, task);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_task_wait_end
+****************************************************************************//**
+*
+* Ends a wait of the task, used by the BLE_TASK_WAIT_xxx macros.
+*
+* \param task The task.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_task_wait_end(ble_task_t *task)
+{
+    ble_timer_stop(&task->timer);
+    task->wait = 0u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,166 @@
+/***************************************************************************//**
+* \file ble_task.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE cooperative task runtime.
+*
+* The tasks are stackless coroutines in the protothread style, a task function
+* returns at each wait point and is resumed at the same point by the next
+* ble_task_run() pass that posts one of the events it waits for. The local
+* variables of a task function are not kept across a wait point, keep the
+* state in the object of the task argument instead. A switch statement cannot
+* contain a wait point.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_TASK_H_
+#define _BLE_TASK_H_
+
+#include "ble_common.h"
+#include "ble_event.h"
+#include "ble_timer.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The return values of a task function.
+ */
+#define BLE_TASK_WAITING                    (0u)    /* Waits for an event or a timeout */
+#define BLE_TASK_YIELDED                    (1u)    /* Runs again in the next pass */
+#define BLE_TASK_EXITED                     (2u)    /* The task is done */
+
+/**
+ * @brief The task body is placed between BLE_TASK_BEGIN and BLE_TASK_END.
+ */
+#define BLE_TASK_BEGIN(task)                switch((task)->lc) { case 0u:
+#define BLE_TASK_END(task)                  } (task)->lc = 0u; return BLE_TASK_EXITED
+
+/**
+ * @brief Waits until the condition is true, the condition is checked again
+ *        after a pass that posts any of the events.
+ */
+#define BLE_TASK_WAIT_UNTIL(task, events, cond) \
+    BLE_TASK_WAIT_UNTIL_TIMEOUT(task, events, cond, 0u)
+
+/**
+ * @brief Waits until the condition is true or the timeout in ms expires,
+ *        BLE_TASK_TIMED_OUT() tells which one ended the wait.
+ */
+#define BLE_TASK_WAIT_UNTIL_TIMEOUT(task, events, cond, timeout) \
+    do { \
+        ble_task_wait_begin((task), (events), (timeout)); \
+        (task)->lc = (uint16_t)__LINE__; case __LINE__: \
+        if(!(cond) && !(task)->timed_out) { \
+            return BLE_TASK_WAITING; \
+        } \
+        ble_task_wait_end(task); \
+    } while(0)
+
+/**
+ * @brief Lets the other tasks and the run loop go, the task runs again in the next pass.
+ */
+#define BLE_TASK_YIELD(task) \
+    do { \
+        (task)->lc = (uint16_t)__LINE__; \
+        return BLE_TASK_YIELDED; case __LINE__:; \
+    } while(0)
+
+/**
+ * @brief Ends the task with a result.
+ */
+#define BLE_TASK_EXIT(task, res) \
+    do { \
+        (task)->result = (res); \
+        (task)->lc = 0u; \
+        return BLE_TASK_EXITED; \
+    } while(0)
+
+/**
+ * @brief The last wait is ended by the timeout.
+ */
+#define BLE_TASK_TIMED_OUT(task)            ((task)->timed_out)
+
+/***************************************
+* Data Types
+***************************************/
+struct ble_task;
+
+/**
+ * @brief The task function prototype.
+ *
+ * \return BLE_TASK_WAITING, BLE_TASK_YIELDED or BLE_TASK_EXITED.
+ */
+typedef uint8_t (* ble_task_func_t)(struct ble_task *task);
+
+/**
+ * @brief The completion callback prototype, called when the task exits.
+ */
+typedef void (* ble_task_done_t)(struct ble_task *task, cy_en_ble_api_result_t result);
+
+/**
+ * @brief The per-task runtime statistics.
+ */
+typedef struct
+{
+    uint32_t starts;        /* The number of task starts */
+    uint32_t runs;          /* The number of task function calls */
+    uint32_t timeouts;      /* The number of waits ended by the timeout */
+    uint64_t cycles;        /* The CPU cycles spent in the task function */
+    uint32_t max_cycles;    /* The longest task function call */
+} ble_task_stats_t;
+
+/**
+ * @brief The task, the memory is owned by the caller and is kept in the task
+ *        list after the first start.
+ */
+typedef struct ble_task
+{
+    struct ble_task *next;
+    const char *name;
+    ble_task_func_t func;
+    ble_task_done_t done;
+    void *arg;
+    uint16_t lc;            /* The resume point of the task function */
+    bool running;
+    bool ready;
+    bool timed_out;
+    uint32_t wait;          /* The events of the current wait */
+    ble_timer_t timer;
+    cy_en_ble_api_result_t result;
+    ble_task_stats_t stats;
+} ble_task_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_task_init(void);
+cy_en_ble_api_result_t ble_task_start(ble_task_t *task, const char *name, ble_task_func_t func, \
+                                      ble_task_done_t done, void *arg);
+void ble_task_cancel(ble_task_t *task);
+bool ble_task_is_running(const ble_task_t *task);
+void ble_task_run(uint32_t events);
+void ble_task_print_stats(void);
+
+/* Used by the wait macros only */
+void ble_task_wait_begin(ble_task_t *task, uint32_t events, uint32_t timeout);
+void ble_task_wait_end(ble_task_t *task);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_TASK_H_ */
+
+/* [] END OF FILE */
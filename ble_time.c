@@ -0,0 +1,159 @@
+/***************************************************************************//**
+* \file ble_time.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE low power time base.
+*
+* The time base is a free running LPTimer clocked by LFCLK, it keeps counting
+* in CPU Sleep and Deep Sleep, so the time stamps are valid across low power
+* modes.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "ble_time.h"
+#include "ble_event.h"
+
+/**
+ * @brief The interrupt priority of the LPTimer alarm.
+ */
+#define BLE_TIME_INTR_PRIORITY              (3u)
+
+/**
+ * @brief The LPTimer object of the time base.
+ */
+static cyhal_lptimer_t ble_time_lptimer;
+
+/**
+ * @brief The time base is initialized.
+ */
+static bool ble_time_initialized = false;
+
+
+/*******************************************************************************
+* Function Name: ble_time_alarm_callback
+****************************************************************************//**
+*
+* LPTimer compare match interrupt callback, posts the timer event to the run loop.
+*
+* \param callback_arg Not used.
+*
+* \param event The LPTimer event.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_time_alarm_callback(void *callback_arg, cyhal_lptimer_event_t event)
+{
+    (void)callback_arg;
+    if(event == CYHAL_LPTIMER_COMPARE_MATCH) {
+        cyhal_lptimer_enable_event(&ble_time_lptimer, CYHAL_LPTIMER_COMPARE_MATCH, BLE_TIME_INTR_PRIORITY, false);
+        ble_event_post(BLE_EVENT_TIMER);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: ble_time_init
+****************************************************************************//**
+*
+* Initializes the time base, it can be called more than once.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+*
+*******************************************************************************/
+cy_rslt_t ble_time_init(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if(!ble_time_initialized) {
+        result = cyhal_lptimer_init(&ble_time_lptimer);
+        if(result == CY_RSLT_SUCCESS) {
+            cyhal_lptimer_register_callback(&ble_time_lptimer, ble_time_alarm_callback, NULL);
+            ble_time_initialized = true;
+        } else {
+            BLE_DBG_PRINTF("cyhal_lptimer_init error: 0x%lx\r\n", (unsigned long)result);
+        }
+    }
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: ble_time_now
+****************************************************************************//**
+*
+* Gets the current time stamp.
+*
+* \param none.
+*
+* \return The time stamp in ticks of BLE_TIME_TICK_HZ, wraps around at 32 bits.
+*
+*******************************************************************************/
+uint32_t ble_time_now(void)
+{
+    if(!ble_time_initialized) {
+        return 0u;
+    }
+    return cyhal_lptimer_read(&ble_time_lptimer);
+}
+
+/*******************************************************************************
+* Function Name: ble_time_set_alarm
+****************************************************************************//**
+*
+* Arms the one-shot alarm, BLE_EVENT_TIMER is posted when it expires. The
+* previous alarm is replaced. The alarm wakes up the device from Deep Sleep.
+*
+* \param delay The delay in ticks, it is limited to BLE_TIME_ALARM_MIN_TICKS ~
+* BLE_TIME_ALARM_MAX_TICKS.
+*
+* \return Return value indicates if the function succeeded or failed.
+*
+*******************************************************************************/
+cy_rslt_t ble_time_set_alarm(uint32_t delay)
+{
+    cy_rslt_t result = ble_time_init();
+
+    if(result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+    if(delay < BLE_TIME_ALARM_MIN_TICKS) {
+        delay = BLE_TIME_ALARM_MIN_TICKS;
+    } else if(delay > BLE_TIME_ALARM_MAX_TICKS) {
+        delay = BLE_TIME_ALARM_MAX_TICKS;
+    }
+    result = cyhal_lptimer_set_delay(&ble_time_lptimer, delay);
+    if(result == CY_RSLT_SUCCESS) {
+        cyhal_lptimer_enable_event(&ble_time_lptimer, CYHAL_LPTIMER_COMPARE_MATCH, BLE_TIME_INTR_PRIORITY, true);
+    } else {
+        BLE_DBG_PRINTF("cyhal_lptimer_set_delay error: 0x%lx\r\n", (unsigned long)result);
+    }
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: ble_time_cancel_alarm
+****************************************************************************//**
+*
+* Cancels the alarm.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_time_cancel_alarm(void)
+{
+    if(ble_time_initialized) {
+        cyhal_lptimer_enable_event(&ble_time_lptimer, CYHAL_LPTIMER_COMPARE_MATCH, BLE_TIME_INTR_PRIORITY, false);
+    }
+}
+
+/* [] END OF FILE */
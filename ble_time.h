@@ -0,0 +1,61 @@
+/***************************************************************************//**
+* \file ble_time.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE low power time base.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_TIME_H_
+#define _BLE_TIME_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The tick frequency of the time base (LFCLK driven LPTimer).
+ */
+#define BLE_TIME_TICK_HZ                    (32768u)
+
+/**
+ * @brief Converts the ticks to microseconds and milliseconds.
+ */
+#define BLE_TIME_TICKS_TO_US(ticks)         ((uint32_t)(((uint64_t)(ticks) * 1000000u) / BLE_TIME_TICK_HZ))
+#define BLE_TIME_TICKS_TO_MS(ticks)         ((uint32_t)(((uint64_t)(ticks) * 1000u) / BLE_TIME_TICK_HZ))
+#define BLE_TIME_MS_TO_TICKS(ms)            ((uint32_t)(((uint64_t)(ms) * BLE_TIME_TICK_HZ) / 1000u))
+
+/**
+ * @brief The alarm delay range in ticks, the LPTimer needs a few ticks to
+ *        update the match value and a longer delay is split by the caller.
+ */
+#define BLE_TIME_ALARM_MIN_TICKS            (4u)
+#define BLE_TIME_ALARM_MAX_TICKS            (BLE_TIME_TICK_HZ * 60u)
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+cy_rslt_t ble_time_init(void);
+uint32_t ble_time_now(void);
+cy_rslt_t ble_time_set_alarm(uint32_t delay);
+void ble_time_cancel_alarm(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_TIME_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,505 @@
+/***************************************************************************//**
+* \file ble_timer.c
+* \version 1.0
+*
+* \brief
+* Source file for BLE software timer wheel.
+*
+* The software timers are kept in a hierarchical wheel of millisecond
+* resolution, a timer is inserted into the slot list of its expiry time and
+* removed from it in constant time. The level occupancy bitmaps give the next
+* deadline without walking the lists, and only one LPTimer alarm is armed for
+* all timers, so the timers expiring in the same millisecond share a wakeup.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_timer.h"
+#include "ble_time.h"
+
+/**
+ * @brief The slot lists and the occupancy bitmaps of the levels.
+ */
+static ble_timer_t *ble_timer_slots[BLE_TIMER_LEVEL_NUM][BLE_TIMER_SLOT_NUM];
+static uint64_t ble_timer_bitmap[BLE_TIMER_LEVEL_NUM];
+
+/**
+ * @brief The wheel time in ms, all slots up to this time are processed.
+ */
+static uint32_t ble_timer_wheel_ms;
+
+/**
+ * @brief The millisecond clock extended from the LPTimer ticks.
+ */
+static uint32_t ble_timer_last_ticks;
+static uint64_t ble_timer_ticks;
+
+/**
+ * @brief The deadline of the armed alarm.
+ */
+static uint32_t ble_timer_alarm_ms;
+static bool ble_timer_alarm_armed = false;
+
+/**
+ * @brief The timer wheel statistics.
+ */
+static ble_timer_stats_t ble_timer_stats;
+
+
+/*******************************************************************************
+* Function Name: ble_timer_ctz64
+****************************************************************************//**
+*
+* Counts the trailing zero bits.
+*
+* \param value The value, it should not be 0.
+*
+* \return The number of trailing zero bits.
+*
+*******************************************************************************/
+static uint32_t ble_timer_ctz64(uint64_t value)
+{
+    uint32_t low = (uint32_t)value;
+
+    if(low != 0u) {
+        return __CLZ(__RBIT(low));
+    }
+    return 32u + __CLZ(__RBIT((uint32_t)(value >> 32u)));
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_insert
+****************************************************************************//**
+*
+* Links the timer into the slot of its expiry time.
+*
+* \param timer The timer.
+*
+* \param cascade The slot of the wheel time is not processed yet, it is true
+* when the timer is moved from a higher level.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_timer_insert(ble_timer_t *timer, bool cascade)
+{
+    int32_t delta = (int32_t)(timer->expires - ble_timer_wheel_ms);
+    uint32_t at = timer->expires;
+    uint32_t level;
+    uint32_t slot;
+
+    if(delta <= 0) {
+        /* Overdue, expire it in the slot being processed or in the next one */
+        at = ble_timer_wheel_ms + (cascade ? 0u : 1u);
+        level = 0u;
+    } else if(delta < (int32_t)(1uL << BLE_TIMER_SLOT_BITS)) {
+        level = 0u;
+    } else if(delta < (int32_t)(1uL << (2u * BLE_TIMER_SLOT_BITS))) {
+        level = 1u;
+    } else {
+        level = 2u;
+        if(delta >= (int32_t)(1uL << (3u * BLE_TIMER_SLOT_BITS))) {
+            /* Beyond the wheel, park it in the last slot and cascade it again */
+            at = ble_timer_wheel_ms + (1uL << (3u * BLE_TIMER_SLOT_BITS)) - (1uL << (2u * BLE_TIMER_SLOT_BITS));
+        }
+    }
+    slot = (at >> (level * BLE_TIMER_SLOT_BITS)) & BLE_TIMER_SLOT_MASK;
+
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    timer->prev = NULL;
+    timer->next = ble_timer_slots[level][slot];
+    if(timer->next != NULL) {
+        timer->next->prev = timer;
+    }
+    ble_timer_slots[level][slot] = timer;
+    ble_timer_bitmap[level] |= (1uLL << slot);
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_unlink
+****************************************************************************//**
+*
+* Removes the timer from its slot.
+*
+* \param timer The timer.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_timer_unlink(ble_timer_t *timer)
+{
+    if(timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        ble_timer_slots[timer->level][timer->slot] = timer->next;
+        if(timer->next == NULL) {
+            ble_timer_bitmap[timer->level] &= ~(1uLL << timer->slot);
+        }
+    }
+    if(timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_cascade
+****************************************************************************//**
+*
+* Moves the timers of a higher level slot to the lower levels.
+*
+* \param level The level.
+*
+* \param slot The slot.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_timer_cascade(uint32_t level, uint32_t slot)
+{
+    ble_timer_t *timer;
+
+    while((timer = ble_timer_slots[level][slot]) != NULL) {
+        ble_timer_unlink(timer);
+        ble_timer_insert(timer, true);
+        ble_timer_stats.cascades++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_expire
+****************************************************************************//**
+*
+* Expires the timers of a level 0 slot, the periodic timers are started again
+* before the callback so that the callback can stop them.
+*
+* \param slot The slot.
+*
+* \return The number of expired timers.
+*
+*******************************************************************************/
+static uint32_t ble_timer_expire(uint32_t slot)
+{
+    ble_timer_t *timer;
+    uint32_t expired = 0u;
+
+    while((timer = ble_timer_slots[0u][slot]) != NULL) {
+        ble_timer_unlink(timer);
+        if(timer->period != 0u) {
+            timer->expires += timer->period;
+            ble_timer_insert(timer, false);
+        } else {
+            timer->active = false;
+            ble_timer_stats.active--;
+        }
+        expired++;
+        if(timer->callback != NULL) {
+            timer->callback(timer->arg);
+        }
+    }
+    return expired;
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_next_deadline
+****************************************************************************//**
+*
+* Finds the next time the wheel needs to be processed, it is the expiry time
+* of the earliest level 0 slot or the cascade time of a higher level slot.
+*
+* \param deadline The deadline in ms is returned here.
+*
+* \return True if any timer is active.
+*
+*******************************************************************************/
+static bool ble_timer_next_deadline(uint32_t *deadline)
+{
+    bool found = false;
+    uint32_t level;
+    uint32_t base;
+    uint32_t shift;
+    uint32_t time;
+    uint64_t bitmap;
+
+    for(level = 0u; level < BLE_TIMER_LEVEL_NUM; level++) {
+        bitmap = ble_timer_bitmap[level];
+        if(bitmap == 0u) {
+            continue;
+        }
+        /* Rotate the bitmap so that bit 0 is the next slot of the level */
+        base = (ble_timer_wheel_ms >> (level * BLE_TIMER_SLOT_BITS)) + 1u;
+        shift = base & BLE_TIMER_SLOT_MASK;
+        bitmap = (bitmap >> shift) | (bitmap << ((BLE_TIMER_SLOT_NUM - shift) & BLE_TIMER_SLOT_MASK));
+        time = (base + ble_timer_ctz64(bitmap)) << (level * BLE_TIMER_SLOT_BITS);
+        if((!found) || ((int32_t)(time - *deadline) < 0)) {
+            *deadline = time;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_arm
+****************************************************************************//**
+*
+* Arms the LPTimer alarm for a deadline.
+*
+* \param deadline The deadline in ms.
+*
+* \param now The current time in ms.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_timer_arm(uint32_t deadline, uint32_t now)
+{
+    int32_t delay = (int32_t)(deadline - now);
+
+    if(delay < 0) {
+        delay = 0;
+    }
+    /* Two more ticks cover the rounding of the millisecond clock */
+    if(CY_RSLT_SUCCESS == ble_time_set_alarm(BLE_TIME_MS_TO_TICKS((uint32_t)delay) + 2u)) {
+        ble_timer_alarm_ms = deadline;
+        ble_timer_alarm_armed = true;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_init
+****************************************************************************//**
+*
+* Initializes the timer wheel, ble_time_init() should be called before.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_timer_init(void)
+{
+    memset(ble_timer_slots, 0, sizeof(ble_timer_slots));
+    memset(ble_timer_bitmap, 0, sizeof(ble_timer_bitmap));
+    memset(&ble_timer_stats, 0, sizeof(ble_timer_stats));
+    ble_timer_last_ticks = ble_time_now();
+    ble_timer_ticks = 0u;
+    ble_timer_wheel_ms = 0u;
+    ble_timer_alarm_armed = false;
+    ble_time_cancel_alarm();
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_start
+****************************************************************************//**
+*
+* Starts or restarts a software timer. This function should be called in the
+* main loop context, not in an interrupt.
+*
+* \param timer The timer.
+*
+* \param timeout The first timeout in ms.
+*
+* \param period The period in ms of a periodic timer, 0 for a one-shot timer.
+*
+* \param callback The callback, called in the ble_timer_process() context.
+*
+* \param arg The argument of the callback.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_timer_start(ble_timer_t *timer, uint32_t timeout, uint32_t period, ble_timer_callback_t callback, void *arg)
+{
+    uint32_t now;
+
+    if(timer == NULL) {
+        return;
+    }
+    ble_timer_stop(timer);
+    now = ble_timer_now();
+    if((ble_timer_bitmap[0u] | ble_timer_bitmap[1u] | ble_timer_bitmap[2u]) == 0u) {
+        /* Nothing to process, move the wheel to the current time */
+        ble_timer_wheel_ms = now;
+    }
+    timer->expires = now + timeout;
+    timer->period = period;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->active = true;
+    ble_timer_insert(timer, false);
+    ble_timer_stats.active++;
+    ble_timer_stats.started++;
+
+    /* Arm the alarm if the timer expires before it */
+    if((!ble_timer_alarm_armed) || ((int32_t)(timer->expires - ble_timer_alarm_ms) < 0)) {
+        ble_timer_arm(timer->expires, now);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_stop
+****************************************************************************//**
+*
+* Stops a software timer, it has no effect if the timer is not active. The alarm
+* is kept, an early wakeup only arms it again.
+*
+* \param timer The timer.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_timer_stop(ble_timer_t *timer)
+{
+    if((timer != NULL) && timer->active) {
+        ble_timer_unlink(timer);
+        timer->active = false;
+        ble_timer_stats.active--;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_is_active
+****************************************************************************//**
+*
+* Checks if a software timer is active.
+*
+* \param timer The timer.
+*
+* \return True if the timer is active.
+*
+*******************************************************************************/
+bool ble_timer_is_active(const ble_timer_t *timer)
+{
+    return (timer != NULL) && timer->active;
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_now
+****************************************************************************//**
+*
+* Gets the time of the timer wheel.
+*
+* \param none.
+*
+* \return The time in ms, wraps around at 32 bits.
+*
+*******************************************************************************/
+uint32_t ble_timer_now(void)
+{
+    uint32_t ticks = ble_time_now();
+
+    ble_timer_ticks += (uint32_t)(ticks - ble_timer_last_ticks);
+    ble_timer_last_ticks = ticks;
+    return (uint32_t)((ble_timer_ticks * 1000u) / BLE_TIME_TICK_HZ);
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_next_timeout
+****************************************************************************//**
+*
+* Gets the time to the next processing of the wheel, used to choose the
+* low power mode.
+*
+* \param none.
+*
+* \return The time in ms, 0 if the wheel is due, BLE_TIMER_NO_TIMEOUT if no
+* timer is active.
+*
+*******************************************************************************/
+uint32_t ble_timer_next_timeout(void)
+{
+    uint32_t deadline = 0u;
+    uint32_t now;
+
+    if(!ble_timer_next_deadline(&deadline)) {
+        return BLE_TIMER_NO_TIMEOUT;
+    }
+    now = ble_timer_now();
+    return ((int32_t)(deadline - now) > 0) ? (deadline - now) : 0u;
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_process
+****************************************************************************//**
+*
+* Advances the wheel to the current time, calls the callbacks of the expired
+* timers and arms the alarm for the next deadline. This function should be
+* called in the main loop when BLE_EVENT_TIMER is posted.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_timer_process(void)
+{
+    uint32_t now = ble_timer_now();
+    uint32_t expired = 0u;
+    uint32_t skip;
+    uint32_t deadline = 0u;
+
+    ble_timer_alarm_armed = false;
+    while((int32_t)(now - ble_timer_wheel_ms) > 0) {
+        if((ble_timer_bitmap[0u] | ble_timer_bitmap[1u] | ble_timer_bitmap[2u]) == 0u) {
+            ble_timer_wheel_ms = now;
+            break;
+        }
+        /* Skip the empty level 0 slots up to the next cascade */
+        if((ble_timer_bitmap[0u] == 0u) && ((ble_timer_wheel_ms & BLE_TIMER_SLOT_MASK) != BLE_TIMER_SLOT_MASK)) {
+            skip = BLE_TIMER_SLOT_MASK - (ble_timer_wheel_ms & BLE_TIMER_SLOT_MASK);
+            if(skip > (now - ble_timer_wheel_ms)) {
+                skip = now - ble_timer_wheel_ms;
+            }
+            ble_timer_wheel_ms += skip;
+            continue;
+        }
+        ble_timer_wheel_ms++;
+        if((ble_timer_wheel_ms & BLE_TIMER_SLOT_MASK) == 0u) {
+            if(((ble_timer_wheel_ms >> BLE_TIMER_SLOT_BITS) & BLE_TIMER_SLOT_MASK) == 0u) {
+                ble_timer_cascade(2u, (ble_timer_wheel_ms >> (2u * BLE_TIMER_SLOT_BITS)) & BLE_TIMER_SLOT_MASK);
+            }
+            ble_timer_cascade(1u, (ble_timer_wheel_ms >> BLE_TIMER_SLOT_BITS) & BLE_TIMER_SLOT_MASK);
+        }
+        expired += ble_timer_expire(ble_timer_wheel_ms & BLE_TIMER_SLOT_MASK);
+    }
+
+    if(expired != 0u) {
+        ble_timer_stats.expired += expired;
+        ble_timer_stats.wakeups++;
+        ble_timer_stats.coalesced += expired - 1u;
+    }
+
+    if(ble_timer_next_deadline(&deadline)) {
+        ble_timer_arm(deadline, ble_timer_now());
+    } else {
+        ble_time_cancel_alarm();
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_timer_get_stats
+****************************************************************************//**
+*
+* Gets the timer wheel statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_timer_get_stats(ble_timer_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = ble_timer_stats;
+    }
+}
+
+/* [] END OF FILE */
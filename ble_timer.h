@@ -0,0 +1,101 @@
+/***************************************************************************//**
+* \file ble_timer.h
+* \version 1.0
+*
+* \brief
+* Header file for BLE software timer wheel.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_TIMER_H_
+#define _BLE_TIMER_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The wheel geometry, each level has 64 slots and a slot of level n
+ *        covers 64^n milliseconds:
+ *        level 0: 1 ms slots,    0 ~ 63 ms
+ *        level 1: 64 ms slots,   64 ms ~ 4.1 s
+ *        level 2: 4096 ms slots, 4.1 s ~ 262 s, longer timers are cascaded again.
+ */
+#define BLE_TIMER_LEVEL_NUM                 (3u)
+#define BLE_TIMER_SLOT_BITS                 (6u)
+#define BLE_TIMER_SLOT_NUM                  (1u << BLE_TIMER_SLOT_BITS)
+#define BLE_TIMER_SLOT_MASK                 (BLE_TIMER_SLOT_NUM - 1u)
+
+/**
+ * @brief No timer is active, returned by ble_timer_next_timeout().
+ */
+#define BLE_TIMER_NO_TIMEOUT                (0xFFFFFFFFuL)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The timer callback prototype, it is called in the ble_timer_process() context.
+ */
+typedef void (* ble_timer_callback_t)(void *arg);
+
+/**
+ * @brief The software timer, the memory is owned by the caller and must stay
+ *        valid while the timer is active.
+ */
+typedef struct ble_timer
+{
+    struct ble_timer *next;
+    struct ble_timer *prev;
+    uint32_t expires;       /* The expiry time in ms of the wheel */
+    uint32_t period;        /* The period in ms, 0 for a one-shot timer */
+    ble_timer_callback_t callback;
+    void *arg;
+    uint8_t level;
+    uint8_t slot;
+    bool active;
+} ble_timer_t;
+
+/**
+ * @brief The timer wheel statistics.
+ */
+typedef struct
+{
+    uint32_t active;        /* The number of active timers */
+    uint32_t started;       /* The number of timer starts */
+    uint32_t expired;       /* The number of timer expirations */
+    uint32_t wakeups;       /* The number of wakeups that expired at least one timer */
+    uint32_t coalesced;     /* The number of expirations served by the wakeup of another timer */
+    uint32_t cascades;      /* The number of timers moved to a lower level */
+} ble_timer_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_timer_init(void);
+void ble_timer_start(ble_timer_t *timer, uint32_t timeout, uint32_t period, ble_timer_callback_t callback, void *arg);
+void ble_timer_stop(ble_timer_t *timer);
+bool ble_timer_is_active(const ble_timer_t *timer);
+uint32_t ble_timer_now(void);
+uint32_t ble_timer_next_timeout(void);
+void ble_timer_process(void);
+void ble_timer_get_stats(ble_timer_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_TIMER_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,529 @@
+/***************************************************************************//**
+* \file ble_trace.c
+* \version 1.0
+*
+* \brief
+* Source file for the BLE stack event trace recorder.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <string.h>
+#include "ble_trace.h"
+#include "ble_time.h"
+#include "ble_event.h"
+
+/**
+ * @brief The size of the event parameters kept by a record, a write event
+ *        keeps its value, see ble_trace.h.
+ */
+#define BLE_TRACE_PARAM_WRITE               (0xFFu)
+
+/**
+ * @brief The parameter size of the events, the parameters of an event not
+ *        listed are not kept.
+ */
+static const struct
+{
+    uint32_t code;
+    uint8_t  size;
+} ble_trace_param_sizes[] =
+{
+    { CY_BLE_EVT_TIMEOUT,                           sizeof(cy_stc_ble_timeout_param_t) },
+    { CY_BLE_EVT_HARDWARE_ERROR,                    sizeof(uint8_t) },
+    { CY_BLE_EVT_STACK_BUSY_STATUS,                 sizeof(uint8_t) },
+    { CY_BLE_EVT_SET_TX_PWR_COMPLETE,               sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_LE_SET_EVENT_MASK_COMPLETE,        sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_SET_DEVICE_ADDR_COMPLETE,          sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_GET_DEVICE_ADDR_COMPLETE,          sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_SET_SUGGESTED_DATA_LENGTH_COMPLETE, sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_GET_DATA_LENGTH_COMPLETE,          sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_SET_DEFAULT_PHY_COMPLETE,          sizeof(cy_stc_ble_events_param_generic_t) },
+    { CY_BLE_EVT_DATA_LENGTH_CHANGE,                sizeof(cy_stc_ble_data_length_change_event_param_t) },
+    { CY_BLE_EVT_GAP_KEYS_GEN_COMPLETE,             sizeof(cy_stc_ble_gap_sec_key_param_t) },
+    { CY_BLE_EVT_GAP_AUTH_REQ,                      sizeof(cy_stc_ble_gap_auth_info_t) },
+    { CY_BLE_EVT_GAP_PASSKEY_ENTRY_REQUEST,         sizeof(uint8_t) },
+    { CY_BLE_EVT_GAP_PASSKEY_DISPLAY_REQUEST,       sizeof(uint32_t) },
+    { CY_BLE_EVT_GAP_NUMERIC_COMPARISON_REQUEST,    sizeof(uint32_t) },
+    { CY_BLE_EVT_GAP_KEYINFO_EXCHNGE_CMPLT,         sizeof(cy_stc_ble_gap_sec_key_info_t) },
+    { CY_BLE_EVT_GAP_SMP_NEGOTIATED_AUTH_INFO,      sizeof(cy_stc_ble_gap_auth_info_t) },
+    { CY_BLE_EVT_GAP_AUTH_COMPLETE,                 sizeof(cy_stc_ble_gap_auth_info_t) },
+    { CY_BLE_EVT_GAP_AUTH_FAILED,                   sizeof(cy_stc_ble_gap_auth_info_t) },
+    { CY_BLE_EVT_GAP_ENHANCE_CONN_COMPLETE,         sizeof(cy_stc_ble_gap_enhance_conn_complete_param_t) },
+    { CY_BLE_EVT_GAP_DEVICE_CONNECTED,              sizeof(cy_stc_ble_gap_connected_param_t) },
+    { CY_BLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP,       sizeof(cy_stc_ble_l2cap_conn_update_rsp_param_t) },
+    { CY_BLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE,    sizeof(cy_stc_ble_gap_conn_param_updated_in_controller_t) },
+    { CY_BLE_EVT_GAP_DEVICE_DISCONNECTED,           sizeof(cy_stc_ble_gap_disconnect_param_t) },
+    { CY_BLE_EVT_GAP_ENCRYPT_CHANGE,                sizeof(uint8_t) },
+    { CY_BLE_EVT_GATT_CONNECT_IND,                  sizeof(cy_stc_ble_conn_handle_t) },
+    { CY_BLE_EVT_GATT_DISCONNECT_IND,               sizeof(cy_stc_ble_conn_handle_t) },
+    { CY_BLE_EVT_GATTS_XCNHG_MTU_REQ,               sizeof(cy_stc_ble_gatt_xchg_mtu_param_t) },
+    { CY_BLE_EVT_GATTS_READ_CHAR_VAL_ACCESS_REQ,    sizeof(cy_stc_ble_gatts_char_val_read_req_t) },
+    { CY_BLE_EVT_GATTS_WRITE_REQ,                   BLE_TRACE_PARAM_WRITE },
+    { CY_BLE_EVT_GATTS_WRITE_CMD_REQ,               BLE_TRACE_PARAM_WRITE },
+    { CY_BLE_EVT_GATTS_HANDLE_VALUE_CNF,            sizeof(cy_stc_ble_conn_handle_t) },
+    { CY_BLE_EVT_GATTS_INDICATION_ENABLED,          sizeof(cy_stc_ble_gatts_write_cmd_req_param_t) },
+    { CY_BLE_EVT_GATTS_INDICATION_DISABLED,         sizeof(cy_stc_ble_gatts_write_cmd_req_param_t) },
+    { CY_BLE_EVT_GATTS_NOTIFICATION_ENABLED,        sizeof(cy_stc_ble_gatts_write_cmd_req_param_t) },
+    { CY_BLE_EVT_GATTS_NOTIFICATION_DISABLED,       sizeof(cy_stc_ble_gatts_write_cmd_req_param_t) },
+};
+
+/* The record ring */
+static ble_trace_rec_t ble_trace_ring[BLE_TRACE_DEPTH];
+
+/* The records written, free running */
+static uint32_t ble_trace_head;
+
+/* The events being handled, a record made meanwhile is nested */
+static uint32_t ble_trace_depth;
+
+/* No record is made while frozen */
+static bool ble_trace_frozen;
+
+/* The GATT dump, no record is made while it runs */
+static struct
+{
+    ble_task_t task;
+    ble_trace_header_t header;
+    uint32_t index;                         /* The oldest record */
+    uint16_t offset;                        /* The next image byte to send */
+    uint16_t total;                         /* The image size */
+    uint8_t  seq;
+    uint8_t  conn_id;
+    ble_custom_hi_lane_t lane;
+} ble_trace_dump;
+
+
+/*******************************************************************************
+* Function Name: ble_trace_init
+****************************************************************************//**
+*
+* Initializes the trace, the ring is cleared and recording starts. The DWT
+* cycle counter must be enabled, see ble_task_init().
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_trace_init(void)
+{
+    memset(ble_trace_ring, 0, sizeof(ble_trace_ring));
+    ble_trace_head = 0u;
+    ble_trace_depth = 0u;
+    ble_trace_frozen = false;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_param
+****************************************************************************//**
+*
+* Keeps the parameter bytes of an event, no more than the event has.
+*
+* \param rec The record.
+*
+* \param event The event code.
+*
+* \param eventParam The event parameters.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_trace_param(ble_trace_rec_t *rec, uint32_t event, const void *eventParam)
+{
+    const cy_stc_ble_gatt_handle_value_pair_t *pair;
+    const cy_stc_ble_conn_handle_t *handle;
+    uint32_t i;
+    uint16_t len;
+
+    for(i = 0u; (i < (sizeof(ble_trace_param_sizes) / sizeof(ble_trace_param_sizes[0]))) && \
+                (ble_trace_param_sizes[i].code != event); i++) {
+    }
+    if(i == (sizeof(ble_trace_param_sizes) / sizeof(ble_trace_param_sizes[0]))) {
+        return;
+    }
+    if(ble_trace_param_sizes[i].size != BLE_TRACE_PARAM_WRITE) {
+        rec->len = (ble_trace_param_sizes[i].size < BLE_TRACE_PARAM_LEN) ? \
+                   ble_trace_param_sizes[i].size : BLE_TRACE_PARAM_LEN;
+        memcpy(rec->param, eventParam, rec->len);
+        return;
+    }
+    /* The written value is kept, the structure only holds a pointer to it */
+    if(event == CY_BLE_EVT_GATTS_WRITE_REQ) {
+        handle = &((const cy_stc_ble_gatt_write_param_t *)eventParam)->connHandle;
+        pair = &((const cy_stc_ble_gatt_write_param_t *)eventParam)->handleValPair;
+    } else {
+        handle = &((const cy_stc_ble_gatts_write_cmd_req_param_t *)eventParam)->connHandle;
+        pair = &((const cy_stc_ble_gatts_write_cmd_req_param_t *)eventParam)->handleValPair;
+    }
+    len = (pair->value.len < BLE_TRACE_WRITE_VALUE_LEN) ? pair->value.len : BLE_TRACE_WRITE_VALUE_LEN;
+    rec->param[0] = handle->attId;
+    rec->param[1] = handle->bdHandle;
+    rec->param[2] = (uint8_t)pair->attrHandle;
+    rec->param[3] = (uint8_t)(pair->attrHandle >> 8u);
+    if((len != 0u) && (pair->value.val != NULL)) {
+        memcpy(&rec->param[BLE_TRACE_WRITE_HEADER_LEN], pair->value.val, len);
+    } else {
+        len = 0u;
+    }
+    rec->len = (uint8_t)(BLE_TRACE_WRITE_HEADER_LEN + len);
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_begin
+****************************************************************************//**
+*
+* Records an event before its handler runs.
+*
+* \param event The event code.
+*
+* \param eventParam The event parameters, it can be NULL.
+*
+* \return The record to pass to ble_trace_end(), NULL if the trace is frozen.
+*
+*******************************************************************************/
+ble_trace_rec_t *ble_trace_begin(uint32_t event, const void *eventParam)
+{
+    ble_trace_rec_t *rec;
+
+    if(ble_trace_frozen || ble_task_is_running(&ble_trace_dump.task)) {
+        return NULL;
+    }
+    rec = &ble_trace_ring[ble_trace_head % BLE_TRACE_DEPTH];
+    ble_trace_head++;
+    rec->time = ble_time_now();
+    rec->code = event;
+    rec->flags = (ble_trace_depth != 0u) ? BLE_TRACE_FLAG_NESTED : 0u;
+    rec->len = 0u;
+    if(eventParam != NULL) {
+        rec->flags |= BLE_TRACE_FLAG_PARAM;
+        ble_trace_param(rec, event, eventParam);
+    }
+    ble_trace_depth++;
+    rec->cycles = DWT->CYCCNT;
+    return rec;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_end
+****************************************************************************//**
+*
+* Completes the record of an event once its handler returns.
+*
+* \param rec The record of ble_trace_begin(), it can be NULL.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_trace_end(ble_trace_rec_t *rec)
+{
+    if(rec != NULL) {
+        rec->cycles = DWT->CYCCNT - rec->cycles;
+        ble_trace_depth--;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_freeze
+****************************************************************************//**
+*
+* Stops recording, the records are kept until ble_trace_resume().
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_trace_freeze(void)
+{
+    ble_trace_frozen = true;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_resume
+****************************************************************************//**
+*
+* Resumes recording after ble_trace_freeze().
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_trace_resume(void)
+{
+    ble_trace_frozen = false;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_is_frozen
+****************************************************************************//**
+*
+* Checks if the trace is frozen.
+*
+* \param none.
+*
+* \return true if no record is made.
+*
+*******************************************************************************/
+bool ble_trace_is_frozen(void)
+{
+    return ble_trace_frozen;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_get_header
+****************************************************************************//**
+*
+* Fills the header of a dump of the ring.
+*
+* \param header The header.
+*
+* \return The index of the oldest record.
+*
+*******************************************************************************/
+static uint32_t ble_trace_get_header(ble_trace_header_t *header)
+{
+    uint32_t count = (ble_trace_head < BLE_TRACE_DEPTH) ? ble_trace_head : BLE_TRACE_DEPTH;
+
+    header->magic = BLE_TRACE_MAGIC;
+    header->version = BLE_TRACE_VERSION;
+    header->rec_size = (uint8_t)sizeof(ble_trace_rec_t);
+    header->count = (uint16_t)count;
+    header->tick_hz = BLE_TIME_TICK_HZ;
+    header->core_hz = SystemCoreClock;
+    header->overwritten = ble_trace_head - count;
+    return (ble_trace_head - count) % BLE_TRACE_DEPTH;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_dump_uart
+****************************************************************************//**
+*
+* Prints the records as hex lines, oldest first:
+* time code cycles flags:param. Recording is suspended meanwhile.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_trace_dump_uart(void)
+{
+    ble_trace_header_t header;
+    const ble_trace_rec_t *rec;
+    bool frozen = ble_trace_frozen;
+    uint32_t index;
+    uint32_t i;
+    uint32_t n;
+
+    ble_trace_frozen = true;
+    index = ble_trace_get_header(&header);
+    BLE_DBG_PRINTF("Trace: %d records, %lu overwritten, tick %lu Hz, core %lu Hz\r\n", header.count, \
+        (unsigned long)header.overwritten, (unsigned long)header.tick_hz, (unsigned long)header.core_hz);
+    for(i = 0u; i < header.count; i++) {
+        rec = &ble_trace_ring[(index + i) % BLE_TRACE_DEPTH];
+        BLE_DBG_PRINTF("%08lx %08lx %08lx %02x:", (unsigned long)rec->time, (unsigned long)rec->code, \
+            (unsigned long)rec->cycles, rec->flags);
+        for(n = 0u; n < rec->len; n++) {
+            BLE_DBG_PRINTF("%02x", rec->param[n]);
+        }
+        BLE_DBG_PRINTF("\r\n");
+    }
+    ble_trace_frozen = frozen;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_dump_chunk
+****************************************************************************//**
+*
+* Queues the next chunk of the GATT dump. The image is the header followed by
+* the records, oldest first.
+*
+* \param none.
+*
+* \return Return value indicates if the function succeeded or failed.
+* CY_BLE_ERROR_INSUFFICIENT_RESOURCES is returned when the lane is full.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_trace_dump_chunk(void)
+{
+    cy_en_ble_api_result_t apiResult;
+    ble_trace_chunk_t chunk;
+    ble_custom_hi_iov_t parts[3];
+    ble_custom_hi_iov_t iov[4];
+    uint32_t first = BLE_TRACE_DEPTH - ble_trace_dump.index;
+    uint32_t iovcnt = 1u;
+    uint32_t pos = ble_trace_dump.offset;
+    uint32_t n;
+    uint16_t len;
+
+    if(first > ble_trace_dump.header.count) {
+        first = ble_trace_dump.header.count;
+    }
+    parts[0].base = &ble_trace_dump.header;
+    parts[0].len = sizeof(ble_trace_dump.header);
+    parts[1].base = &ble_trace_ring[ble_trace_dump.index];
+    parts[1].len = (uint16_t)(first * sizeof(ble_trace_rec_t));
+    parts[2].base = &ble_trace_ring[0];
+    parts[2].len = (uint16_t)((ble_trace_dump.header.count - first) * sizeof(ble_trace_rec_t));
+    chunk.marker = BLE_TRACE_CHUNK_MARKER;
+    chunk.seq = ble_trace_dump.seq;
+    chunk.offset = ble_trace_dump.offset;
+    len = ble_trace_dump.total - ble_trace_dump.offset;
+    chunk.len = (len < BLE_TRACE_CHUNK_SIZE) ? len : BLE_TRACE_CHUNK_SIZE;
+    chunk.total = ble_trace_dump.total;
+    iov[0].base = &chunk;
+    iov[0].len = sizeof(chunk);
+    /* Slice the image bytes of the chunk from the parts */
+    len = chunk.len;
+    for(n = 0u; (n < 3u) && (len > 0u); n++) {
+        if(pos >= parts[n].len) {
+            pos -= parts[n].len;
+            continue;
+        }
+        iov[iovcnt].base = (const uint8_t *)parts[n].base + pos;
+        iov[iovcnt].len = ((parts[n].len - pos) < len) ? (uint16_t)(parts[n].len - pos) : len;
+        len -= iov[iovcnt].len;
+        iovcnt++;
+        pos = 0u;
+    }
+    apiResult = ble_custom_hi_response_queue(ble_trace_dump.conn_id, ble_trace_dump.lane, iov, iovcnt);
+    if(apiResult == CY_BLE_SUCCESS) {
+        ble_trace_dump.offset += chunk.len;
+        ble_trace_dump.seq++;
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_dump_task_func
+****************************************************************************//**
+*
+* The task of ble_trace_dump_gatt(), queues the chunks and waits for room in
+* the lane between them.
+*
+* \param task The task.
+*
+* \return The task status.
+*
+*******************************************************************************/
+static uint8_t ble_trace_dump_task_func(ble_task_t *task)
+{
+    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+
+    BLE_TASK_BEGIN(task);
+    while(ble_trace_dump.offset < ble_trace_dump.total) {
+        BLE_TASK_WAIT_UNTIL(task, BLE_EVENT_TX | BLE_EVENT_STACK, \
+            CY_BLE_ERROR_INSUFFICIENT_RESOURCES != (apiResult = ble_trace_dump_chunk()));
+        if(apiResult != CY_BLE_SUCCESS) {
+            BLE_TASK_EXIT(task, apiResult);
+        }
+    }
+    BLE_TASK_EXIT(task, CY_BLE_SUCCESS);
+    BLE_TASK_END(task);
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_dump_gatt
+****************************************************************************//**
+*
+* Starts sending the header and the records in chunks of up to
+* BLE_TRACE_CHUNK_SIZE bytes, see ble_trace.h. A chunk waits for room in the
+* lane, no record is made until the dump ends.
+*
+* \param conn_id The connection ID.
+*
+* \param lane The priority lane, see \ref ble_custom_hi_lane_t.
+*
+* \param done The callback of the result, it can be NULL.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_trace_dump_gatt(uint8_t conn_id, ble_custom_hi_lane_t lane, ble_task_done_t done)
+{
+    if(!ble_custom_hi_is_connected(conn_id) || (lane >= BLE_CUSTOM_HI_LANE_NUM)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(ble_task_is_running(&ble_trace_dump.task)) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    ble_trace_dump.index = ble_trace_get_header(&ble_trace_dump.header);
+    ble_trace_dump.total = (uint16_t)(sizeof(ble_trace_header_t) + \
+                                      (ble_trace_dump.header.count * sizeof(ble_trace_rec_t)));
+    ble_trace_dump.offset = 0u;
+    ble_trace_dump.seq = 0u;
+    ble_trace_dump.conn_id = conn_id;
+    ble_trace_dump.lane = lane;
+    return ble_task_start(&ble_trace_dump.task, "trace", ble_trace_dump_task_func, done, NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_trace_print_stats
+****************************************************************************//**
+*
+* Prints the handler time of each event code in the ring, the first
+* BLE_TRACE_STATS_CODES codes found are shown.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_trace_print_stats(void)
+{
+    struct
+    {
+        uint32_t code;
+        uint32_t count;
+        uint32_t max;
+        uint64_t total;
+    } codes[BLE_TRACE_STATS_CODES];
+    ble_trace_header_t header;
+    const ble_trace_rec_t *rec;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+    uint32_t used = 0u;
+    uint32_t index;
+    uint32_t i;
+    uint32_t n;
+
+    index = ble_trace_get_header(&header);
+    for(i = 0u; i < header.count; i++) {
+        rec = &ble_trace_ring[(index + i) % BLE_TRACE_DEPTH];
+        for(n = 0u; (n < used) && (codes[n].code != rec->code); n++) {
+        }
+        if(n == used) {
+            if(used == BLE_TRACE_STATS_CODES) {
+                continue;
+            }
+            codes[n].code = rec->code;
+            codes[n].count = 0u;
+            codes[n].max = 0u;
+            codes[n].total = 0u;
+            used++;
+        }
+        codes[n].count++;
+        codes[n].total += rec->cycles;
+        if(rec->cycles > codes[n].max) {
+            codes[n].max = rec->cycles;
+        }
+    }
+    if(cycles_per_us == 0u) {
+        cycles_per_us = 1u;
+    }
+    BLE_DBG_PRINTF("Trace: %d records%s\r\n", header.count, ble_trace_frozen ? " (frozen)" : "");
+    for(n = 0u; n < used; n++) {
+        BLE_DBG_PRINTF("  0x%08lx: count=%lu, avg=%lu us, max=%lu us\r\n", (unsigned long)codes[n].code, \
+            (unsigned long)codes[n].count, (unsigned long)(codes[n].total / codes[n].count / cycles_per_us), \
+            (unsigned long)(codes[n].max / cycles_per_us));
+    }
+}
+
+/* [] END OF FILE */
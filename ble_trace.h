@@ -0,0 +1,151 @@
+/***************************************************************************//**
+* \file ble_trace.h
+* \version 1.0
+*
+* \brief
+* Header file for the BLE stack event trace recorder.
+*
+* ble_app_callback() records every stack event into a RAM ring: the event
+* code, the time, the handler time and the first bytes of the event
+* parameters. The oldest records are overwritten, and the trace is frozen on
+* a hardware error so the events before it are kept. The trace is dumped as
+* hex lines over the debug UART, or as a binary image over GATT:
+*
+* | ble_trace_header_t | ble_trace_rec_t * count, oldest first |
+*
+* All fields are little endian. The parameter bytes are a raw copy of the
+* event parameter structure, as many bytes as the event has, up to
+* BLE_TRACE_PARAM_LEN. The write events keep the written value instead:
+*
+* | attId | bdHandle | attrHandle(2) | value |
+*
+* Over GATT, the image is cut into chunks of up to BLE_TRACE_CHUNK_SIZE bytes,
+* each queued as one response with a ble_trace_chunk_t header, so that a
+* chunk always fits an empty lane. The host places each chunk at its offset.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_TRACE_H_
+#define _BLE_TRACE_H_
+
+#include "ble_common.h"
+#include "ble_custom_hi.h"
+#include "ble_task.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The number of records of the ring, the RAM is
+ *        BLE_TRACE_DEPTH * sizeof(ble_trace_rec_t).
+ */
+#ifndef BLE_TRACE_DEPTH
+#define BLE_TRACE_DEPTH                     (128u)
+#endif
+
+/**
+ * @brief The bytes of the event parameters kept by a record.
+ */
+#define BLE_TRACE_PARAM_LEN                 (14u)
+
+/**
+ * @brief The bytes of the written value kept by a write event record.
+ */
+#define BLE_TRACE_WRITE_HEADER_LEN          (4u)
+#define BLE_TRACE_WRITE_VALUE_LEN           (BLE_TRACE_PARAM_LEN - BLE_TRACE_WRITE_HEADER_LEN)
+
+/**
+ * @brief The dump header magic and the format version.
+ */
+#define BLE_TRACE_MAGIC                     (0x43525442uL)
+#define BLE_TRACE_VERSION                   (2u)
+
+/**
+ * @brief The first byte of a GATT dump chunk, and the image bytes of a chunk.
+ */
+#define BLE_TRACE_CHUNK_MARKER              (0xD7u)
+#define BLE_TRACE_CHUNK_SIZE                (512u)
+
+/**
+ * @brief The record flags.
+ */
+#define BLE_TRACE_FLAG_PARAM                (0x01u)     /* The event has parameters */
+#define BLE_TRACE_FLAG_NESTED               (0x02u)     /* Raised while another event was handled */
+
+/**
+ * @brief The number of event codes summarized by ble_trace_print_stats().
+ */
+#define BLE_TRACE_STATS_CODES               (24u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief A trace record.
+ */
+typedef struct
+{
+    uint32_t time;                          /* ble_time_now() at the event, BLE_TIME_TICK_HZ */
+    uint32_t code;                          /* The event code */
+    uint32_t cycles;                        /* The handler time in CPU cycles */
+    uint8_t  flags;
+    uint8_t  len;                           /* The parameter bytes kept */
+    uint8_t  param[BLE_TRACE_PARAM_LEN];
+} ble_trace_rec_t;
+
+/**
+ * @brief The header of a binary dump.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  rec_size;                      /* sizeof(ble_trace_rec_t) */
+    uint16_t count;                         /* The records which follow */
+    uint32_t tick_hz;                       /* The unit of ble_trace_rec_t.time */
+    uint32_t core_hz;                       /* The unit of ble_trace_rec_t.cycles */
+    uint32_t overwritten;                   /* The records lost before the oldest one */
+} ble_trace_header_t;
+
+/**
+ * @brief The header of a GATT dump chunk, the image bytes follow.
+ */
+typedef struct
+{
+    uint8_t  marker;                        /* BLE_TRACE_CHUNK_MARKER */
+    uint8_t  seq;                           /* The chunk number */
+    uint16_t offset;                        /* The offset of the bytes in the image */
+    uint16_t len;                           /* The bytes which follow */
+    uint16_t total;                         /* The image size */
+} ble_trace_chunk_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_trace_init(void);
+ble_trace_rec_t *ble_trace_begin(uint32_t event, const void *eventParam);
+void ble_trace_end(ble_trace_rec_t *rec);
+void ble_trace_freeze(void);
+void ble_trace_resume(void);
+bool ble_trace_is_frozen(void);
+void ble_trace_dump_uart(void);
+cy_en_ble_api_result_t ble_trace_dump_gatt(uint8_t conn_id, ble_custom_hi_lane_t lane, ble_task_done_t done);
+void ble_trace_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_TRACE_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,352 @@
+/***************************************************************************//**
+* \file ble_host.c
+* \version 1.0
+*
+* \brief
+* Source file of the host harness, see ble_host.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdlib.h>
+#include <unistd.h>
+#include "ble_host.h"
+#include "ble_app.h"
+#include "ble_event.h"
+#include "ble_task.h"
+#include "ble_pool.h"
+#include "ble_custom_hi.h"
+#if defined(COMPONENT_BLESS_HOST_IPC)
+#include "ble_ipc.h"
+#endif
+
+/**
+ * @brief The harness state.
+ */
+static struct
+{
+    FILE     *report;
+    uint8_t  conn_id;
+    uint16_t cccd;
+} ble_host;
+
+
+/*******************************************************************************
+* Function Name: ble_host_wake
+****************************************************************************//**
+*
+* The wakeup callback of the simulation, the run loop returns to
+* ble_host_run_until() to check the stop condition.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_wake(void)
+{
+    ble_event_post(BLE_HOST_EVENT_WAKE);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_advertising
+****************************************************************************//**
+*
+* The stop condition of the stack startup.
+*
+* \param none.
+*
+* \return true if the device advertises.
+*
+*******************************************************************************/
+static bool ble_host_advertising(void)
+{
+    return Cy_BLE_GetAdvertisementState() == CY_BLE_ADV_STATE_ADVERTISING;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_connected
+****************************************************************************//**
+*
+* The stop condition of the connection, the CCCD written by the peer is set.
+*
+* \param none.
+*
+* \return true if the connection is ready.
+*
+*******************************************************************************/
+static bool ble_host_connected(void)
+{
+    if(!ble_custom_hi_is_connected(ble_host.conn_id)) {
+        return false;
+    }
+    if((0u != (ble_host.cccd & BLE_HOST_CCCD_NOTIFY)) && \
+       !CY_BLE_IS_NOTIFICATION_ENABLED(ble_host.conn_id, CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)) {
+        return false;
+    }
+    if((0u != (ble_host.cccd & BLE_HOST_CCCD_INDICATE)) && \
+       !CY_BLE_IS_INDICATION_ENABLED(ble_host.conn_id, CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)) {
+        return false;
+    }
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_compare
+****************************************************************************//**
+*
+* The comparison of the latency samples for qsort().
+*
+* \param a The first sample.
+*
+* \param b The second sample.
+*
+* \return The order of the samples.
+*
+*******************************************************************************/
+static int ble_host_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_init
+****************************************************************************//**
+*
+* Initializes the simulation and the firmware as ble_app_test() does, and
+* runs until the device advertises. The standard output is kept for the
+* report, the log goes to the standard error.
+*
+* \param link The link parameters, NULL for the defaults.
+*
+* \param rx The receive callback of the peer, it can be NULL.
+*
+* \param table The command table.
+*
+* \param count The number of commands.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_host_init(const ble_sim_link_t *link, ble_sim_rx_t rx, \
+                                     const ble_custom_cmd_desc_t *table, uint32_t count)
+{
+    cy_en_ble_api_result_t apiResult;
+    int fd;
+
+    (void)fflush(stdout);
+    if((fd = dup(STDOUT_FILENO)) < 0) {
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    ble_host.report = fdopen(fd, "w");
+    if((ble_host.report == NULL) || (dup2(STDERR_FILENO, STDOUT_FILENO) < 0)) {
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    ble_sim_init(link, rx, ble_host_wake);
+    ble_custom_cmd_init();
+    if(CY_BLE_SUCCESS != (apiResult = ble_custom_cmd_register(table, count))) {
+        return apiResult;
+    }
+    if(CY_BLE_SUCCESS != (apiResult = ble_app_init())) {
+        return apiResult;
+    }
+#if defined(COMPONENT_BLESS_HOST_IPC)
+    if(CY_BLE_SUCCESS != (apiResult = ble_ipc_init())) {
+        return apiResult;
+    }
+#endif
+    return ble_host_run_until(ble_host_advertising, 1000u) ? CY_BLE_SUCCESS : CY_BLE_ERROR_INVALID_STATE;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_connect
+****************************************************************************//**
+*
+* Connects the peer and writes the CCCD of the response characteristic.
+*
+* \param conn_id The connection ID.
+*
+* \param cccd The CCCD value, see BLE_HOST_CCCD_xxx.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_host_connect(uint8_t conn_id, uint16_t cccd)
+{
+    cy_en_ble_api_result_t apiResult;
+    uint8_t value[2] = { (uint8_t)cccd, (uint8_t)(cccd >> 8u) };
+
+    if(CY_BLE_SUCCESS != (apiResult = ble_sim_connect(conn_id))) {
+        return apiResult;
+    }
+    ble_host.conn_id = conn_id;
+    ble_host.cccd = cccd;
+    apiResult = ble_sim_peer_write(conn_id, \
+        CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE, value, sizeof(value), \
+        false);
+    if(apiResult != CY_BLE_SUCCESS) {
+        return apiResult;
+    }
+    return ble_host_run_until(ble_host_connected, 1000u) ? CY_BLE_SUCCESS : CY_BLE_ERROR_INVALID_STATE;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_run_until
+****************************************************************************//**
+*
+* Runs the run loop of ble_app_test() until the condition holds or the
+* virtual time runs out.
+*
+* \param cond The stop condition, NULL to run for the whole time.
+*
+* \param timeout_ms The virtual time limit.
+*
+* \return true if the condition holds, or if cond is NULL.
+*
+*******************************************************************************/
+bool ble_host_run_until(ble_host_cond_t cond, uint32_t timeout_ms)
+{
+    uint64_t deadline = ble_sim_time_us() + ((uint64_t)timeout_ms * 1000u);
+    uint32_t events;
+
+    for(;;)
+    {
+        if((cond != NULL) && cond()) {
+            return true;
+        }
+        if(ble_sim_time_us() >= deadline) {
+            return cond == NULL;
+        }
+        events = ble_event_wait();
+        ble_app_process_events(events);
+        if(0u != (events & (BLE_EVENT_COMMAND | BLE_EVENT_TX))) {
+            ble_custom_cmd_task();
+        }
+#if defined(COMPONENT_BLESS_HOST_IPC)
+        if(0u != (events & (BLE_EVENT_IPC | BLE_EVENT_TX))) {
+            ble_ipc_process();
+        }
+#endif
+        if(0u != (events & (BLE_EVENT_TX | BLE_EVENT_COMMAND | BLE_EVENT_QUEUE | BLE_EVENT_IPC))) {
+            ble_custom_hi_tx_task();
+        }
+        ble_task_run(events);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_report
+****************************************************************************//**
+*
+* Gets the report stream, the standard output of the program.
+*
+* \param none.
+*
+* \return The stream.
+*
+*******************************************************************************/
+FILE *ble_host_report(void)
+{
+    return (ble_host.report != NULL) ? ble_host.report : stdout;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_pool_allocs
+****************************************************************************//**
+*
+* Gets the allocations of all memory pool classes.
+*
+* \param none.
+*
+* \return The number of allocations.
+*
+*******************************************************************************/
+uint32_t ble_host_pool_allocs(void)
+{
+    ble_pool_stats_t stats;
+    uint32_t allocs = 0u;
+    uint32_t i;
+
+    for(i = 0u; i < BLE_POOL_CLASS_NUM; i++) {
+        if(CY_BLE_SUCCESS == ble_pool_get_stats(i, &stats)) {
+            allocs += stats.allocs;
+        }
+    }
+    return allocs;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_result
+****************************************************************************//**
+*
+* Fills the rates and the latencies of a result as ble_bench.c does, the
+* samples are sorted. The status, allocation and copy counts are left.
+*
+* \param result The result.
+*
+* \param samples The latency samples in us.
+*
+* \param n The number of samples, the completed operations.
+*
+* \param bytes The payload bytes.
+*
+* \param elapsed_us The virtual time of the operations.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_host_result(ble_bench_result_t *result, uint32_t *samples, uint32_t n, uint32_t bytes, \
+                     uint64_t elapsed_us)
+{
+    qsort(samples, n, sizeof(samples[0]), ble_host_compare);
+    result->valid = true;
+    result->ops = n;
+    result->bytes = bytes;
+    result->elapsed_us = (uint32_t)elapsed_us;
+    if(elapsed_us != 0u) {
+        result->ops_per_s = (uint32_t)(((uint64_t)n * 1000000u) / elapsed_us);
+        result->bytes_per_s = (uint32_t)(((uint64_t)bytes * 1000000u) / elapsed_us);
+    }
+    if(n != 0u) {
+        result->p50_us = samples[(n * 50u) / 100u];
+        result->p99_us = samples[(n * 99u) / 100u];
+        result->max_us = samples[n - 1u];
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_print_result
+****************************************************************************//**
+*
+* Prints a result to the report, in the layout of ble_bench_print_json().
+*
+* \param name The scenario name.
+*
+* \param result The result.
+*
+* \param first false to print the separator.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_host_print_result(const char *name, const ble_bench_result_t *result, bool first)
+{
+    fprintf(ble_host_report(), "%s{\"scenario\":\"%s\",\"status\":%lu,\"ops\":%lu,\"bytes\":%lu,\"elapsed_us\":%lu," \
+        "\"ops_per_s\":%lu,\"bytes_per_s\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu," \
+        "\"allocs\":%lu,\"copies\":%lu,\"copy_bytes\":%lu}", first ? "" : ",", name, \
+        (unsigned long)result->status, (unsigned long)result->ops, (unsigned long)result->bytes, \
+        (unsigned long)result->elapsed_us, (unsigned long)result->ops_per_s, (unsigned long)result->bytes_per_s, \
+        (unsigned long)result->p50_us, (unsigned long)result->p99_us, (unsigned long)result->max_us, \
+        (unsigned long)result->allocs, (unsigned long)result->copies, (unsigned long)result->copy_bytes);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,88 @@
+/***************************************************************************//**
+* \file ble_host.h
+* \version 1.0
+*
+* \brief
+* Header file of the host harness: it runs the firmware modules on the
+* simulated stack of ble_sim.c with the run loop of ble_app_test.c, and
+* collects the results of the host programs.
+*
+* The log of the firmware goes to the standard error, the standard output
+* only carries the JSON report of the program.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_HOST_H_
+#define _BLE_HOST_H_
+
+#include <stdio.h>
+#include "ble_common.h"
+#include "ble_custom_cmd.h"
+#include "ble_bench.h"
+#include "ble_sim.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The connection of the simulated peer.
+ */
+#define BLE_HOST_CONN_ID                    (0u)
+
+/**
+ * @brief The commands of the host table, the opcodes of ble_app_test.c.
+ *        ECHO returns the request payload, SINK takes a write without
+ *        response.
+ */
+#define BLE_HOST_OPCODE_ECHO                (0x01u)
+#define BLE_HOST_OPCODE_SINK                (0x04u)
+
+/**
+ * @brief The CCCD values written by the peer.
+ */
+#define BLE_HOST_CCCD_NOTIFY                (0x0001u)
+#define BLE_HOST_CCCD_INDICATE              (0x0002u)
+
+/**
+ * @brief The run loop stops on this event, posted at each wakeup.
+ */
+#define BLE_HOST_EVENT_WAKE                 BLE_EVENT_USER(15u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The stop condition of ble_host_run_until().
+ */
+typedef bool (* ble_host_cond_t)(void);
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+cy_en_ble_api_result_t ble_host_init(const ble_sim_link_t *link, ble_sim_rx_t rx, \
+                                     const ble_custom_cmd_desc_t *table, uint32_t count);
+cy_en_ble_api_result_t ble_host_connect(uint8_t conn_id, uint16_t cccd);
+bool ble_host_run_until(ble_host_cond_t cond, uint32_t timeout_ms);
+FILE *ble_host_report(void);
+uint32_t ble_host_pool_allocs(void);
+void ble_host_result(ble_bench_result_t *result, uint32_t *samples, uint32_t n, uint32_t bytes, \
+                     uint64_t elapsed_us);
+void ble_host_print_result(const char *name, const ble_bench_result_t *result, bool first);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_HOST_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,445 @@
+/***************************************************************************//**
+* \file ble_host_bench.c
+* \version 1.0
+*
+* \brief
+* The benchmark of the host interface on the simulated stack. The peer runs
+* the echo round-trip and the write without response burst, then the
+* scenarios of ble_bench.c run on the device side. One JSON line is printed
+* with the results in the layout of ble_bench_print_json(), the link and the
+* simulation counters:
+*
+*   ble_host_bench [interval_us [packets_per_event [tx_buffers [mtu]]]]
+*
+* The rates and latencies are in the virtual time of the link, cpu_ns is the
+* host time spent in the firmware and the simulation.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdlib.h>
+#include "ble_host.h"
+#include "ble_custom_hi.h"
+
+/**
+ * @brief The virtual time limit of a scenario.
+ */
+#define BLE_HOST_BENCH_TIMEOUT_MS           (60000u)
+
+/**
+ * @brief The sequence number leading the payload of the peer writes.
+ */
+#define BLE_HOST_BENCH_SEQ_LEN              (2u)
+
+/**
+ * @brief The scenarios of the peer.
+ */
+typedef enum
+{
+    BLE_HOST_BENCH_ECHO = 0,
+    BLE_HOST_BENCH_WRITE_CMD_BURST,
+    BLE_HOST_BENCH_SCENARIO_NUM
+} ble_host_bench_scenario_t;
+
+/**
+ * @brief The names of the scenarios in the JSON report, the peer ones
+ *        followed by the ones of ble_bench.c.
+ */
+static const char * const ble_host_bench_names[BLE_HOST_BENCH_SCENARIO_NUM + BLE_BENCH_SCENARIO_NUM] =
+{
+    "echo",
+    "write_cmd_burst",
+    "notify_stream",
+    "response_burst",
+    "mixed_sizes",
+    "indication"
+};
+
+/**
+ * @brief The benchmark state. A sample holds the virtual time an operation
+ *        was issued, then its latency in us.
+ */
+static struct
+{
+    uint16_t payload;
+    uint32_t issued;
+    uint32_t done;
+    uint32_t errors;
+    uint64_t start_us;
+    uint64_t last_us;               /* The time of the last completion */
+    uint32_t samples[BLE_BENCH_OPS];
+    uint8_t  frame[CY_BLE_GATT_MTU];
+    ble_bench_result_t results[BLE_HOST_BENCH_SCENARIO_NUM + BLE_BENCH_SCENARIO_NUM];
+} ble_host_bench;
+
+
+/*******************************************************************************
+* Function Name: ble_host_bench_complete
+****************************************************************************//**
+*
+* Completes an operation of a peer scenario.
+*
+* \param val The payload, it starts with the sequence number.
+*
+* \param len The payload size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_bench_complete(const uint8_t *val, uint16_t len)
+{
+    uint32_t seq;
+
+    if(len < BLE_HOST_BENCH_SEQ_LEN) {
+        ble_host_bench.errors++;
+        return;
+    }
+    seq = (uint32_t)val[0] | ((uint32_t)val[1] << 8u);
+    if((seq >= ble_host_bench.issued) || (seq != ble_host_bench.done)) {
+        ble_host_bench.errors++;
+        return;
+    }
+    ble_host_bench.last_us = ble_sim_time_us();
+    ble_host_bench.samples[seq] = (uint32_t)(ble_host_bench.last_us - ble_host_bench.samples[seq]);
+    ble_host_bench.done++;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_sink_handler
+****************************************************************************//**
+*
+* The sink command handler, completes the write without response.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_host_bench_sink_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    (void)res;
+    (void)res_len;
+    ble_host_bench_complete(req, req_len);
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_echo_handler
+****************************************************************************//**
+*
+* The echo command handler, returns the request payload.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_host_bench_echo_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    memcpy(res, req, req_len);
+    *res_len = req_len;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/**
+ * @brief The command table, the flags of the test table of ble_app_test.c.
+ */
+static const ble_custom_cmd_desc_t ble_host_bench_cmd_table[] =
+{
+    {
+        .opcode      = BLE_HOST_OPCODE_ECHO,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE,
+        .max_req_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .max_res_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .handler     = ble_host_bench_echo_handler
+    },
+    {
+        .opcode      = BLE_HOST_OPCODE_SINK,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE | BLE_CUSTOM_CMD_FLAG_NO_RESPONSE,
+        .max_req_len = BLE_CUSTOM_CMD_REQ_PAYLOAD_MAX,
+        .max_res_len = 0u,
+        .handler     = ble_host_bench_sink_handler
+    },
+};
+
+/*******************************************************************************
+* Function Name: ble_host_bench_rx
+****************************************************************************//**
+*
+* The receive callback of the peer, the echo responses complete the echo
+* round-trips. The values of the other scenarios are only counted by the
+* simulation.
+*
+* \param conn_id The connection ID.
+*
+* \param indication true for an indication.
+*
+* \param val The value.
+*
+* \param len The value size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_bench_rx(uint8_t conn_id, bool indication, const uint8_t *val, uint16_t len)
+{
+    (void)conn_id;
+    (void)indication;
+    if((ble_host_bench.done != ble_host_bench.issued) && (len >= BLE_CUSTOM_CMD_RES_HEADER_LEN) && \
+       (val[0] == BLE_HOST_OPCODE_ECHO)) {
+        if(val[1] != BLE_CUSTOM_CMD_STATUS_OK) {
+            ble_host_bench.errors++;
+            return;
+        }
+        ble_host_bench_complete(&val[BLE_CUSTOM_CMD_RES_HEADER_LEN], len - BLE_CUSTOM_CMD_RES_HEADER_LEN);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_issue
+****************************************************************************//**
+*
+* Queues a peer write of the running scenario, the payload is the sequence
+* number and a pattern.
+*
+* \param opcode The command opcode.
+*
+* \param len The payload size.
+*
+* \param command true for a write without response.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_host_bench_issue(uint8_t opcode, uint16_t len, bool command)
+{
+    cy_en_ble_api_result_t apiResult;
+    uint32_t seq = ble_host_bench.issued;
+    uint16_t i;
+
+    ble_host_bench.frame[0] = opcode;
+    ble_host_bench.frame[1] = (uint8_t)seq;
+    ble_host_bench.frame[2] = (uint8_t)(seq >> 8u);
+    for(i = BLE_HOST_BENCH_SEQ_LEN; i < len; i++) {
+        ble_host_bench.frame[BLE_CUSTOM_CMD_REQ_HEADER_LEN + i] = (uint8_t)(seq + i);
+    }
+    apiResult = ble_sim_peer_write(BLE_HOST_CONN_ID, CY_BLE_CUSTOM_HOST_INTERFACE_COMMAND_CHAR_HANDLE, \
+                                   ble_host_bench.frame, BLE_CUSTOM_CMD_REQ_HEADER_LEN + len, command);
+    if(apiResult == CY_BLE_SUCCESS) {
+        ble_host_bench.samples[ble_host_bench.issued++] = (uint32_t)ble_sim_time_us();
+    }
+    return apiResult;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_echo_done
+****************************************************************************//**
+*
+* The stop condition of an echo round-trip.
+*
+* \param none.
+*
+* \return true if the last echo came back.
+*
+*******************************************************************************/
+static bool ble_host_bench_echo_done(void)
+{
+    return (ble_host_bench.done == ble_host_bench.issued) || (ble_host_bench.errors != 0u);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_burst_done
+****************************************************************************//**
+*
+* The stop condition of the write without response burst.
+*
+* \param none.
+*
+* \return true if all writes were handled.
+*
+*******************************************************************************/
+static bool ble_host_bench_burst_done(void)
+{
+    return (ble_host_bench.done == BLE_BENCH_OPS) || (ble_host_bench.errors != 0u);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_device_done
+****************************************************************************//**
+*
+* The stop condition of the scenarios of ble_bench.c.
+*
+* \param none.
+*
+* \return true if the benchmark ended.
+*
+*******************************************************************************/
+static bool ble_host_bench_device_done(void)
+{
+    return !ble_bench_is_running();
+}
+
+/*******************************************************************************
+* Function Name: ble_host_bench_run
+****************************************************************************//**
+*
+* Runs a peer scenario. The echo round-trips are issued one at a time, the
+* burst writes are queued at once.
+*
+* \param scenario The scenario.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_bench_run(ble_host_bench_scenario_t scenario)
+{
+    ble_bench_result_t *result = &ble_host_bench.results[scenario];
+    ble_custom_hi_copy_stats_t copies;
+    ble_custom_hi_copy_stats_t copies_end;
+    cy_en_ble_api_result_t apiResult = CY_BLE_SUCCESS;
+    uint32_t allocs = ble_host_pool_allocs();
+    uint16_t len;
+
+    (void)ble_custom_hi_get_copy_stats(&copies);
+    ble_host_bench.issued = 0u;
+    ble_host_bench.done = 0u;
+    ble_host_bench.errors = 0u;
+    ble_host_bench.start_us = ble_sim_time_us();
+    ble_host_bench.last_us = ble_host_bench.start_us;
+    if(scenario == BLE_HOST_BENCH_ECHO) {
+        /* The echo response fits one notification */
+        len = ble_host_bench.payload - BLE_CUSTOM_CMD_RES_HEADER_LEN;
+        while((ble_host_bench.issued < BLE_BENCH_OPS) && (ble_host_bench.errors == 0u)) {
+            if(CY_BLE_SUCCESS != (apiResult = ble_host_bench_issue(BLE_HOST_OPCODE_ECHO, len, false))) {
+                break;
+            }
+            if(!ble_host_run_until(ble_host_bench_echo_done, BLE_HOST_BENCH_TIMEOUT_MS)) {
+                apiResult = CY_BLE_ERROR_INVALID_OPERATION;
+                break;
+            }
+        }
+    } else {
+        len = ble_host_bench.payload - BLE_CUSTOM_CMD_REQ_HEADER_LEN;
+        while((ble_host_bench.issued < BLE_BENCH_OPS) && (apiResult == CY_BLE_SUCCESS)) {
+            apiResult = ble_host_bench_issue(BLE_HOST_OPCODE_SINK, len, true);
+        }
+        if((apiResult == CY_BLE_SUCCESS) && \
+           !ble_host_run_until(ble_host_bench_burst_done, BLE_HOST_BENCH_TIMEOUT_MS)) {
+            apiResult = CY_BLE_ERROR_INVALID_OPERATION;
+        }
+    }
+    if((apiResult == CY_BLE_SUCCESS) && (ble_host_bench.errors != 0u)) {
+        apiResult = CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    (void)ble_custom_hi_get_copy_stats(&copies_end);
+    memset(result, 0, sizeof(*result));
+    ble_host_result(result, ble_host_bench.samples, ble_host_bench.done, ble_host_bench.done * len, \
+                    ble_host_bench.last_us - ble_host_bench.start_us);
+    result->status = apiResult;
+    result->allocs = ble_host_pool_allocs() - allocs;
+    result->copies = copies_end.copies - copies.copies;
+    result->copy_bytes = copies_end.bytes - copies.bytes;
+}
+
+/*******************************************************************************
+* Function Name: main
+****************************************************************************//**
+*
+* Runs the scenarios and prints the report.
+*
+* \param argc The number of arguments.
+*
+* \param argv The link parameters, see the file header.
+*
+* \return 0 if all scenarios completed.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    ble_sim_link_t link =
+    {
+        .interval_us       = BLE_SIM_INTERVAL_US,
+        .packets_per_event = BLE_SIM_PACKETS_PER_EVENT,
+        .tx_buffers        = BLE_SIM_TX_BUFFERS,
+        .mtu               = BLE_SIM_MTU
+    };
+    ble_sim_stats_t stats;
+    const ble_bench_result_t *result;
+    FILE *report;
+    uint64_t cpu_ns;
+    int status = EXIT_SUCCESS;
+    uint32_t i;
+
+    if(argc > 1) {
+        link.interval_us = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if(argc > 2) {
+        link.packets_per_event = (uint8_t)strtoul(argv[2], NULL, 0);
+    }
+    if(argc > 3) {
+        link.tx_buffers = (uint8_t)strtoul(argv[3], NULL, 0);
+    }
+    if(argc > 4) {
+        link.mtu = (uint16_t)strtoul(argv[4], NULL, 0);
+    }
+    if((CY_BLE_SUCCESS != ble_host_init(&link, ble_host_bench_rx, ble_host_bench_cmd_table, \
+            sizeof(ble_host_bench_cmd_table) / sizeof(ble_host_bench_cmd_table[0]))) || \
+       (CY_BLE_SUCCESS != ble_host_connect(BLE_HOST_CONN_ID, BLE_HOST_CCCD_NOTIFY | BLE_HOST_CCCD_INDICATE))) {
+        fprintf(stderr, "ble_host_bench: the connection failed\n");
+        return EXIT_FAILURE;
+    }
+    ble_host_bench.payload = ble_custom_hi_get_payload_size(BLE_HOST_CONN_ID);
+    ble_sim_reset_stats();
+    cpu_ns = ble_sim_cpu_ns();
+    ble_host_bench_run(BLE_HOST_BENCH_ECHO);
+    ble_host_bench_run(BLE_HOST_BENCH_WRITE_CMD_BURST);
+    if(CY_BLE_SUCCESS == ble_bench_start(BLE_HOST_CONN_ID, BLE_BENCH_ALL, NULL)) {
+        (void)ble_host_run_until(ble_host_bench_device_done, BLE_HOST_BENCH_TIMEOUT_MS);
+    }
+    for(i = 0u; i < BLE_BENCH_SCENARIO_NUM; i++) {
+        (void)ble_bench_get_result((ble_bench_scenario_t)i, &ble_host_bench.results[BLE_HOST_BENCH_SCENARIO_NUM + i]);
+    }
+    cpu_ns = ble_sim_cpu_ns() - cpu_ns;
+    ble_sim_get_stats(&stats);
+
+    report = ble_host_report();
+    fprintf(report, "{\"bench\":\"ble_host\",\"conn\":%u,\"payload\":%u,", BLE_HOST_CONN_ID, ble_host_bench.payload);
+    fprintf(report, "\"link\":{\"interval_us\":%lu,\"packets_per_event\":%u,\"tx_buffers\":%u,\"mtu\":%u},", \
+        (unsigned long)link.interval_us, link.packets_per_event, link.tx_buffers, link.mtu);
+    fprintf(report, "\"results\":[");
+    for(i = 0u; i < (BLE_HOST_BENCH_SCENARIO_NUM + BLE_BENCH_SCENARIO_NUM); i++) {
+        result = &ble_host_bench.results[i];
+        if(!result->valid || (result->status != CY_BLE_SUCCESS) || (result->ops != BLE_BENCH_OPS)) {
+            status = EXIT_FAILURE;
+        }
+        ble_host_print_result(ble_host_bench_names[i], result, i == 0u);
+    }
+    fprintf(report, "],\"sim\":{\"conn_events\":%lu,\"stack_events\":%lu,\"notifications\":%lu,\"indications\":%lu," \
+        "\"write_reqs\":%lu,\"write_cmds\":%lu,\"busy\":%lu,\"rejected\":%lu,\"tx_queue_max\":%lu," \
+        "\"event_queue_max\":%lu,\"sleeps\":%lu},\"cpu_ns\":%llu}\n", (unsigned long)stats.conn_events, \
+        (unsigned long)stats.stack_events, (unsigned long)stats.notifications, (unsigned long)stats.indications, \
+        (unsigned long)stats.write_reqs, (unsigned long)stats.write_cmds, (unsigned long)stats.busy, \
+        (unsigned long)stats.rejected, (unsigned long)stats.tx_queue_max, (unsigned long)stats.event_queue_max, \
+        (unsigned long)stats.sleeps, (unsigned long long)cpu_ns);
+    (void)fflush(report);
+    return status;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,491 @@
+/***************************************************************************//**
+* \file ble_host_ipc.c
+* \version 1.0
+*
+* \brief
+* The two thread simulation of the command offload pipe of ble_ipc.c. The
+* main thread is the CM4: it sends the commands through the forward hook and
+* takes the responses in ble_ipc_process(). The second thread is the peer
+* core of a custom CM0+ image (BLE_IPC_PEER_LOOPBACK disabled): it waits for
+* the command doorbell, acknowledges it and calls ble_ipc_peer_process().
+*
+* The IPC driver is modelled with a lock and a notify status per channel and
+* interrupt structure, the doorbells of the rings are coalesced as on the
+* device. The transmit queue of ble_custom_hi.c is replaced with a check of
+* the responses, it is randomly full.
+*
+* Each response must come in the order of the commands, with the size and
+* the payload the peer built from its command. The program prints one JSON
+* line with the counts and the offload statistics, and fails on the first
+* mismatch or if the pipe stalls.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "ble_ipc.h"
+#include "ble_custom_cmd.h"
+#include "ble_event.h"
+#include "ble_pool.h"
+#include "ble_timer.h"
+
+/**
+ * @brief The commands round-tripped by default.
+ */
+#define BLE_HOST_IPC_COMMANDS               (20000u)
+
+/**
+ * @brief The connection of the commands.
+ */
+#define BLE_HOST_IPC_CONN_ID                (0u)
+
+/**
+ * @brief The command frame: the opcode and the sequence number, then the
+ *        payload. The peer inverts the payload bits of the mask.
+ */
+#define BLE_HOST_IPC_OPCODE                 (0x7Fu)
+#define BLE_HOST_IPC_HEADER_LEN             (5u)
+#define BLE_HOST_IPC_PAYLOAD_MASK           (0xA5u)
+
+/**
+ * @brief The transmit queue is full for 1 response in BLE_HOST_IPC_FULL_RATE.
+ */
+#define BLE_HOST_IPC_FULL_RATE              (4u)
+
+/**
+ * @brief The time the CM4 waits for a doorbell before the pipe is stalled.
+ */
+#define BLE_HOST_IPC_STALL_MS               (1000u)
+
+/**
+ * @brief The IPC channels and interrupt structures of the model.
+ */
+#define BLE_HOST_IPC_CHANNELS               (16u)
+
+/**
+ * @brief The simulation state. The IPC driver model is guarded by the mutex,
+ *        the rings of ble_ipc.c are not.
+ */
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  doorbell;
+    IPC_STRUCT_Type chan[BLE_HOST_IPC_CHANNELS];
+    IPC_INTR_STRUCT_Type intr[BLE_HOST_IPC_CHANNELS];
+    uint32_t notify[BLE_HOST_IPC_CHANNELS];     /* The notify status of the interrupt structures */
+    bool     stop;
+    /* The CM4 side */
+    void     (*isr)(void);
+    ble_custom_cmd_forward_t forward;
+    uint32_t events;
+    uint32_t commands;
+    uint32_t sent;
+    uint32_t freed;                             /* The command blocks freed by the forward hook */
+    uint32_t received;
+    uint32_t errors;
+    uint32_t tx_full;
+    uint32_t peer_commands;                     /* Written by the peer thread only */
+    unsigned int seed;
+    uint8_t  frame[BLE_IPC_BUF_SIZE];
+} ble_host_ipc =
+{
+    .lock     = PTHREAD_MUTEX_INITIALIZER,
+    .doorbell = PTHREAD_COND_INITIALIZER,
+    .seed     = 1u,
+};
+
+/**
+ * @brief The core clock of the cycle counter.
+ */
+uint32_t SystemCoreClock = 100000000uL;
+static DWT_Type ble_host_ipc_dwt;
+
+
+/*******************************************************************************
+* Function Name: ble_host_ipc_now_ns
+****************************************************************************//**
+*
+* Gets the host monotonic time.
+*
+* \param none.
+*
+* \return The time in ns.
+*
+*******************************************************************************/
+static uint64_t ble_host_ipc_now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_ipc_frame_len
+****************************************************************************//**
+*
+* Gets the command frame size of a sequence number, the sizes cover the
+* whole shared buffer.
+*
+* \param seq The sequence number.
+*
+* \return The frame size.
+*
+*******************************************************************************/
+static uint16_t ble_host_ipc_frame_len(uint32_t seq)
+{
+    return (uint16_t)(BLE_HOST_IPC_HEADER_LEN + ((seq * 37u) % (BLE_IPC_BUF_SIZE - BLE_HOST_IPC_HEADER_LEN + 1u)));
+}
+
+/*******************************************************************************
+* Function Name: ble_host_ipc_peer_handler
+****************************************************************************//**
+*
+* The command handler of the peer, the response is the command with the
+* payload bits of BLE_HOST_IPC_PAYLOAD_MASK inverted.
+*
+* \param buf  The command frame, the response frame is written here.
+*
+* \param len  The command frame size.
+*
+* \param size The buffer size.
+*
+* \return The response frame size.
+*
+*******************************************************************************/
+static uint16_t ble_host_ipc_peer_handler(uint8_t *buf, uint16_t len, uint16_t size)
+{
+    uint16_t i;
+
+    (void)size;
+    for(i = BLE_HOST_IPC_HEADER_LEN; i < len; i++) {
+        buf[i] ^= BLE_HOST_IPC_PAYLOAD_MASK;
+    }
+    ble_host_ipc.peer_commands++;
+    return len;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_ipc_peer_thread
+****************************************************************************//**
+*
+* The peer core: it waits for the notify of the command channel, releases
+* the channel so that the next command rings again, and processes the ring.
+*
+* \param arg Not used.
+*
+* \return NULL.
+*
+*******************************************************************************/
+static void *ble_host_ipc_peer_thread(void *arg)
+{
+    uint32_t cmd = 1uL << BLE_IPC_CHAN_CMD;
+    bool stop;
+
+    (void)arg;
+    for(;;)
+    {
+        (void)pthread_mutex_lock(&ble_host_ipc.lock);
+        while(!ble_host_ipc.stop && (0u == (ble_host_ipc.notify[BLE_IPC_INTR_PEER] & cmd))) {
+            (void)pthread_cond_wait(&ble_host_ipc.doorbell, &ble_host_ipc.lock);
+        }
+        ble_host_ipc.notify[BLE_IPC_INTR_PEER] &= ~cmd;
+        stop = ble_host_ipc.stop;
+        (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+        if(stop) {
+            return NULL;
+        }
+        (void)Cy_IPC_Drv_LockRelease(Cy_IPC_Drv_GetIpcBaseAddress(BLE_IPC_CHAN_CMD), CY_IPC_NO_NOTIFICATION);
+        ble_ipc_peer_process(ble_host_ipc_peer_handler);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_ipc_interrupt
+****************************************************************************//**
+*
+* Runs the IPC interrupt of the CM4 if its notify is pending, waits for it
+* when the CM4 has nothing else to do.
+*
+* \param wait true to wait for the doorbell.
+*
+* \return false if the wait timed out.
+*
+*******************************************************************************/
+static bool ble_host_ipc_interrupt(bool wait)
+{
+    struct timespec deadline;
+    bool pending;
+    int rc = 0;
+
+    (void)clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += BLE_HOST_IPC_STALL_MS / 1000u;
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    while(wait && (rc != ETIMEDOUT) && (0u == (ble_host_ipc.notify[BLE_IPC_INTR_CM4] & \
+                                              ble_host_ipc.intr[BLE_IPC_INTR_CM4].INTR_MASK))) {
+        rc = pthread_cond_timedwait(&ble_host_ipc.doorbell, &ble_host_ipc.lock, &deadline);
+    }
+    pending = 0u != (ble_host_ipc.notify[BLE_IPC_INTR_CM4] & ble_host_ipc.intr[BLE_IPC_INTR_CM4].INTR_MASK);
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+    if(pending && (ble_host_ipc.isr != NULL)) {
+        ble_host_ipc.isr();
+    }
+    return pending || !wait;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_ipc_send
+****************************************************************************//**
+*
+* Sends the next command through the forward hook of ble_ipc.c.
+*
+* \param none.
+*
+* \return true if the command was taken, false if no buffer is free.
+*
+*******************************************************************************/
+static bool ble_host_ipc_send(void)
+{
+    uint32_t seq = ble_host_ipc.sent;
+    uint16_t len = ble_host_ipc_frame_len(seq);
+    uint16_t i;
+
+    ble_host_ipc.frame[0] = BLE_HOST_IPC_OPCODE;
+    memcpy(&ble_host_ipc.frame[1], &seq, sizeof(seq));
+    for(i = BLE_HOST_IPC_HEADER_LEN; i < len; i++) {
+        ble_host_ipc.frame[i] = (uint8_t)(seq + i);
+    }
+    if(!ble_host_ipc.forward(BLE_HOST_IPC_CONN_ID, ble_host_ipc.frame, len)) {
+        return false;
+    }
+    ble_host_ipc.sent++;
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: main
+****************************************************************************//**
+*
+* Round-trips the commands, see the file header.
+*
+* \param argc The number of arguments.
+*
+* \param argv The arguments: the number of commands and the random seed.
+*
+* \return 0 if all the responses are received intact and in order.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    ble_ipc_stats_t stats;
+    pthread_t peer;
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+    bool stalled = false;
+
+    ble_host_ipc.commands = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BLE_HOST_IPC_COMMANDS;
+    ble_host_ipc.seed = (argc > 2) ? (unsigned int)strtoul(argv[2], NULL, 0) : 1u;
+    if((CY_BLE_SUCCESS != ble_ipc_init()) || (ble_host_ipc.forward == NULL) || \
+       (0 != pthread_create(&peer, NULL, ble_host_ipc_peer_thread, NULL))) {
+        fprintf(stderr, "ble_host_ipc: the initialization failed\n");
+        return EXIT_FAILURE;
+    }
+    start = ble_host_ipc_now_ns();
+    while((ble_host_ipc.errors == 0u) && (ble_host_ipc.received < ble_host_ipc.commands))
+    {
+        /* The CM4 sends until the shared buffers run out, then waits */
+        while((ble_host_ipc.sent < ble_host_ipc.commands) && ble_host_ipc_send()) {
+        }
+        if(!ble_host_ipc_interrupt(ble_host_ipc.events == 0u)) {
+            stalled = true;
+            break;
+        }
+        if(ble_host_ipc.events != 0u) {
+            ble_host_ipc.events = 0u;
+            ble_ipc_process();
+        }
+    }
+    elapsed = ble_host_ipc_now_ns() - start;
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    ble_host_ipc.stop = true;
+    (void)pthread_cond_broadcast(&ble_host_ipc.doorbell);
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+    (void)pthread_join(peer, NULL);
+
+    ble_ipc_get_stats(&stats);
+    printf("{\"ipc\":\"two_thread\",\"commands\":%lu,\"sent\":%lu,\"received\":%lu,\"peer\":%lu,\"errors\":%lu," \
+        "\"stalled\":%s,\"busy\":%lu,\"tx_full\":%lu,\"dropped\":%lu,\"buf_min_free\":%lu," \
+        "\"latency_avg_us\":%lu,\"latency_max_us\":%lu,\"elapsed_ns\":%llu}\n", \
+        (unsigned long)ble_host_ipc.commands, (unsigned long)ble_host_ipc.sent, \
+        (unsigned long)ble_host_ipc.received, (unsigned long)ble_host_ipc.peer_commands, \
+        (unsigned long)ble_host_ipc.errors, stalled ? "true" : "false", (unsigned long)stats.busy, \
+        (unsigned long)ble_host_ipc.tx_full, (unsigned long)stats.dropped, (unsigned long)stats.buf_min_free, \
+        (unsigned long)((stats.responses != 0u) ? ((stats.latency_cycles / stats.responses) / cycles_per_us) : 0u), \
+        (unsigned long)(stats.latency_max / cycles_per_us), (unsigned long long)elapsed);
+    return ((ble_host_ipc.errors == 0u) && !stalled && (ble_host_ipc.received == ble_host_ipc.commands) && \
+            (ble_host_ipc.freed == ble_host_ipc.sent) && (stats.dropped == 0u)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*******************************************************************************
+* CM4 stand-ins: the hooks of ble_ipc.c into the command and transmit layers
+*******************************************************************************/
+void ble_custom_cmd_set_forward(ble_custom_cmd_forward_t forward)
+{
+    ble_host_ipc.forward = forward;
+}
+
+/* The forward hook takes the command block, it must free it once copied */
+void ble_pool_free(void *block)
+{
+    if(block != ble_host_ipc.frame) {
+        ble_host_ipc.errors++;
+    }
+    ble_host_ipc.freed++;
+}
+
+void ble_event_post(uint32_t events)
+{
+    ble_host_ipc.events |= events;
+}
+
+uint32_t ble_timer_now(void)
+{
+    return (uint32_t)(ble_host_ipc_now_ns() / 1000000u);
+}
+
+void ble_custom_hi_tx_task(void)
+{
+}
+
+/* The check of the responses, the queue is randomly full */
+cy_en_ble_api_result_t ble_custom_hi_response_queue(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    const ble_custom_hi_iov_t *iov, uint32_t iovcnt)
+{
+    const uint8_t *res = (const uint8_t *)iov->base;
+    uint32_t seq = ble_host_ipc.received;
+    uint32_t got;
+    uint16_t i;
+
+    (void)lane;
+    if((rand_r(&ble_host_ipc.seed) % BLE_HOST_IPC_FULL_RATE) == 0u) {
+        ble_host_ipc.tx_full++;
+        ble_host_ipc.events |= BLE_EVENT_TX;
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    memcpy(&got, &res[1], sizeof(got));
+    if((conn_id != BLE_HOST_IPC_CONN_ID) || (iovcnt != 1u) || (iov->len != ble_host_ipc_frame_len(seq)) || \
+       (res[0] != BLE_HOST_IPC_OPCODE) || (got != seq)) {
+        ble_host_ipc.errors++;
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    for(i = BLE_HOST_IPC_HEADER_LEN; i < iov->len; i++) {
+        if(res[i] != (uint8_t)((uint8_t)(seq + i) ^ BLE_HOST_IPC_PAYLOAD_MASK)) {
+            ble_host_ipc.errors++;
+            return CY_BLE_ERROR_INVALID_PARAMETER;
+        }
+    }
+    ble_host_ipc.received++;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* PDL stand-ins: the cycle counter, the interrupts and the IPC driver
+*******************************************************************************/
+DWT_Type *ble_sim_dwt(void)
+{
+    ble_host_ipc_dwt.CYCCNT = (uint32_t)((ble_host_ipc_now_ns() * (SystemCoreClock / 1000000u)) / 1000u);
+    return &ble_host_ipc_dwt;
+}
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, void (*userIsr)(void))
+{
+    (void)config;
+    ble_host_ipc.isr = userIsr;
+    return CY_SYSINT_SUCCESS;
+}
+
+IPC_STRUCT_Type *Cy_IPC_Drv_GetIpcBaseAddress(uint32_t ipcIndex)
+{
+    return &ble_host_ipc.chan[ipcIndex % BLE_HOST_IPC_CHANNELS];
+}
+
+IPC_INTR_STRUCT_Type *Cy_IPC_Drv_GetIntrBaseAddr(uint32_t ipcIntrIndex)
+{
+    return &ble_host_ipc.intr[ipcIntrIndex % BLE_HOST_IPC_CHANNELS];
+}
+
+/* The channel is locked until the receiver releases it, a send to a locked
+ * channel fails: the doorbell is coalesced. */
+cy_en_ipcdrv_status_t Cy_IPC_Drv_SendMsgWord(IPC_STRUCT_Type *base, uint32_t notifyMask, uint32_t message)
+{
+    uint32_t chan = (uint32_t)(base - ble_host_ipc.chan);
+    cy_en_ipcdrv_status_t status = CY_IPC_DRV_ERROR;
+    uint32_t i;
+
+    (void)message;
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    if(base->LOCK_STATUS == 0u) {
+        base->LOCK_STATUS = 1u;
+        for(i = 0u; i < BLE_HOST_IPC_CHANNELS; i++) {
+            if(0u != (notifyMask & (1uL << i))) {
+                ble_host_ipc.notify[i] |= 1uL << chan;
+            }
+        }
+        (void)pthread_cond_broadcast(&ble_host_ipc.doorbell);
+        status = CY_IPC_DRV_SUCCESS;
+    }
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+    return status;
+}
+
+cy_en_ipcdrv_status_t Cy_IPC_Drv_LockRelease(IPC_STRUCT_Type *base, uint32_t releaseEventIntr)
+{
+    (void)releaseEventIntr;
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    base->LOCK_STATUS = 0u;
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+    return CY_IPC_DRV_SUCCESS;
+}
+
+void Cy_IPC_Drv_SetInterruptMask(IPC_INTR_STRUCT_Type *base, uint32_t ipcReleaseMask, uint32_t ipcNotifyMask)
+{
+    (void)ipcReleaseMask;
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    base->INTR_MASK = ipcNotifyMask;
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+}
+
+/* The notify status is in the upper half word, as in the INTR_MASKED register */
+uint32_t Cy_IPC_Drv_GetInterruptStatusMasked(IPC_INTR_STRUCT_Type *base)
+{
+    uint32_t status;
+
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    status = (ble_host_ipc.notify[base - ble_host_ipc.intr] & base->INTR_MASK) << 16u;
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+    return status;
+}
+
+uint32_t Cy_IPC_Drv_ExtractAcquireMask(uint32_t intMask)
+{
+    return (intMask >> 16u) & 0xFFFFu;
+}
+
+void Cy_IPC_Drv_ClearInterrupt(IPC_INTR_STRUCT_Type *base, uint32_t ipcReleaseMask, uint32_t ipcNotifyMask)
+{
+    (void)ipcReleaseMask;
+    (void)pthread_mutex_lock(&ble_host_ipc.lock);
+    ble_host_ipc.notify[base - ble_host_ipc.intr] &= ~ipcNotifyMask;
+    (void)pthread_mutex_unlock(&ble_host_ipc.lock);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,557 @@
+/***************************************************************************//**
+* \file ble_host_lz.c
+* \version 1.0
+*
+* \brief
+* The report of the response compression of ble_custom_hi.c on the host
+* simulation:
+*
+*   ble_host_lz [responses [interval_us [packets_per_event [tx_buffers [mtu]]]]]
+*
+* For each sample (a log, a configuration dump and random bytes) the same
+* responses are sent twice over the simulated link to the peer: as they are
+* with ble_custom_hi_response_queue(), then with
+* ble_custom_hi_response_compressed(). The peer decodes the framing of
+* BLE_CUSTOM_HI_COMP_MARKER, decompresses the responses with the LZ flag and
+* checks each response.
+*
+* The program prints one JSON line: for each sample the compression ratio
+* (response bytes over the notification bytes, headers included), the time
+* of both runs on the link, the effective throughput (response bytes per
+* second) and its gain, and the host time of the encoder.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "ble_host.h"
+#include "ble_custom_hi.h"
+#include "ble_lz.h"
+
+/**
+ * @brief The responses of each run by default, and their size: a raw
+ *        response fits the bulk lane.
+ */
+#define BLE_HOST_LZ_RESPONSES               (50u)
+#define BLE_HOST_LZ_RESPONSE_LEN            (900u)
+
+/**
+ * @brief The virtual time limit of a run.
+ */
+#define BLE_HOST_LZ_TIMEOUT_MS              (60000u)
+
+/**
+ * @brief The samples.
+ */
+typedef enum
+{
+    BLE_HOST_LZ_LOG = 0,
+    BLE_HOST_LZ_CONFIG,
+    BLE_HOST_LZ_RANDOM,
+    BLE_HOST_LZ_SAMPLE_NUM
+} ble_host_lz_sample_t;
+
+/**
+ * @brief The result of a sample.
+ */
+typedef struct
+{
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint32_t compressed;
+    uint64_t raw_us;
+    uint64_t lz_us;
+    uint64_t encode_ns;
+    uint32_t errors;
+} ble_host_lz_result_t;
+
+/**
+ * @brief The report state and the receiver of the peer.
+ */
+static struct
+{
+    ble_host_lz_sample_t sample;
+    bool     framed;                    /* The responses of the run are framed */
+    uint32_t responses;
+    uint32_t queued;
+    uint32_t received;
+    uint32_t mark;                      /* The responses received when the lane was full */
+    uint32_t errors;
+    uint32_t expected;                  /* The size of the response being received */
+    uint32_t stream_len;
+    bool     lz;
+    uint8_t  stream[BLE_HOST_LZ_RESPONSE_LEN + BLE_CUSTOM_HI_LANE_BUF_SIZE];
+    uint8_t  response[BLE_HOST_LZ_RESPONSE_LEN];
+    uint8_t  check[BLE_HOST_LZ_RESPONSE_LEN];
+    ble_host_lz_result_t results[BLE_HOST_LZ_SAMPLE_NUM];
+} ble_host_lz;
+
+/**
+ * @brief The sample names of the report.
+ */
+static const char *const ble_host_lz_names[BLE_HOST_LZ_SAMPLE_NUM] = { "log", "config", "random" };
+
+
+/*******************************************************************************
+* Function Name: ble_host_lz_echo_handler
+****************************************************************************//**
+*
+* The echo command handler of the command table, the report sends no
+* command.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_host_lz_echo_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    memcpy(res, req, req_len);
+    *res_len = req_len;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/**
+ * @brief The command table.
+ */
+static const ble_custom_cmd_desc_t ble_host_lz_cmd_table[] =
+{
+    {
+        .opcode      = BLE_HOST_OPCODE_ECHO,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE,
+        .max_req_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .max_res_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .handler     = ble_host_lz_echo_handler
+    },
+};
+
+/*******************************************************************************
+* Function Name: ble_host_lz_build
+****************************************************************************//**
+*
+* Builds a response of a sample, the responses of a run differ.
+*
+* \param sample The sample.
+*
+* \param n The response number.
+*
+* \param buf The response of BLE_HOST_LZ_RESPONSE_LEN bytes is returned here.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_lz_build(ble_host_lz_sample_t sample, uint32_t n, uint8_t *buf)
+{
+    static const char *const keys[] =
+    {
+        "adv.interval_ms", "adv.timeout_s", "conn.interval_us", "conn.latency", "conn.timeout_ms", "gatt.mtu",
+        "phy.tx", "phy.rx", "power.tx_dbm", "bond.max", "log.level", "uart.baud"
+    };
+    char text[BLE_HOST_LZ_RESPONSE_LEN + 128u];
+    uint32_t state = 0x9E3779B9u ^ n;
+    uint32_t len = 0u;
+    uint32_t i = 0u;
+
+    switch(sample)
+    {
+        case BLE_HOST_LZ_LOG:
+            while(len < BLE_HOST_LZ_RESPONSE_LEN) {
+                len += (uint32_t)snprintf(&text[len], sizeof(text) - len, \
+                    "[%05lu.%03lu] I ble: conn 0 evt %lu rssi -%lu dBm tx %lu rx %lu\r\n", \
+                    (unsigned long)((n * 17u) + (i / 8u)), (unsigned long)((i * 125u) % 1000u), \
+                    (unsigned long)((n * 64u) + i), (unsigned long)(40u + ((n + i) % 23u)), \
+                    (unsigned long)(i % 7u), (unsigned long)((i + n) % 5u));
+                i++;
+            }
+            memcpy(buf, text, BLE_HOST_LZ_RESPONSE_LEN);
+            break;
+        case BLE_HOST_LZ_CONFIG:
+            while(len < BLE_HOST_LZ_RESPONSE_LEN) {
+                len += (uint32_t)snprintf(&text[len], sizeof(text) - len, "dev%lu.%s = %lu\n", \
+                    (unsigned long)(i / (sizeof(keys) / sizeof(keys[0]))), keys[i % (sizeof(keys) / sizeof(keys[0]))], \
+                    (unsigned long)(((i * 37u) + n) % 1000u));
+                i++;
+            }
+            memcpy(buf, text, BLE_HOST_LZ_RESPONSE_LEN);
+            break;
+        default:
+            for(i = 0u; i < BLE_HOST_LZ_RESPONSE_LEN; i++) {
+                state ^= state << 13u;
+                state ^= state >> 17u;
+                state ^= state << 5u;
+                buf[i] = (uint8_t)state;
+            }
+            break;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_decode
+****************************************************************************//**
+*
+* The decoder of the peer, see ble_lz.h.
+*
+* \param in The stream.
+*
+* \param len The stream size.
+*
+* \param out The output buffer.
+*
+* \param size The output buffer size.
+*
+* \return The output size, size + 1 if the stream is not valid.
+*
+*******************************************************************************/
+static uint32_t ble_host_lz_decode(const uint8_t *in, uint32_t len, uint8_t *out, uint32_t size)
+{
+    uint32_t pos = 0u;
+    uint32_t n = 0u;
+    uint32_t dist;
+    uint32_t count;
+    uint8_t flags;
+    uint8_t item;
+
+    while(pos < len) {
+        flags = in[pos++];
+        for(item = 0u; (item < 8u) && (pos < len); item++) {
+            if(0u == (flags & (1u << item))) {
+                if(n == size) {
+                    return size + 1u;
+                }
+                out[n++] = in[pos++];
+                continue;
+            }
+            if((pos + 2u) > len) {
+                return size + 1u;
+            }
+            dist = ((uint32_t)in[pos] | ((uint32_t)(in[pos + 1u] >> 6u) << 8u)) + 1u;
+            count = (uint32_t)(in[pos + 1u] & 0x3Fu) + BLE_LZ_MATCH_MIN;
+            pos += 2u;
+            if((dist > n) || ((n + count) > size)) {
+                return size + 1u;
+            }
+            for(; count != 0u; count--, n++) {
+                out[n] = out[n - dist];
+            }
+        }
+    }
+    return n;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_complete
+****************************************************************************//**
+*
+* Checks a received response against the one sent.
+*
+* \param data The response.
+*
+* \param len The response size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_lz_complete(const uint8_t *data, uint32_t len)
+{
+    ble_host_lz_build(ble_host_lz.sample, ble_host_lz.received, ble_host_lz.check);
+    if((len != BLE_HOST_LZ_RESPONSE_LEN) || (0 != memcmp(data, ble_host_lz.check, len))) {
+        ble_host_lz.errors++;
+    }
+    ble_host_lz.received++;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_rx
+****************************************************************************//**
+*
+* The receive callback of the peer. The raw responses are cut by their size,
+* the framed ones by the FIRST and LAST flags.
+*
+* \param conn_id The connection ID.
+*
+* \param indication true for an indication.
+*
+* \param val The value.
+*
+* \param len The value size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_lz_rx(uint8_t conn_id, bool indication, const uint8_t *val, uint16_t len)
+{
+    uint32_t header = BLE_CUSTOM_HI_COMP_HEADER_LEN;
+    uint32_t n;
+    uint8_t ctrl;
+
+    (void)conn_id;
+    (void)indication;
+    if(!ble_host_lz.framed) {
+        n = BLE_HOST_LZ_RESPONSE_LEN - ble_host_lz.stream_len;
+        n = (len < n) ? len : n;
+        memcpy(&ble_host_lz.stream[ble_host_lz.stream_len], val, n);
+        ble_host_lz.stream_len += n;
+        if(ble_host_lz.stream_len == BLE_HOST_LZ_RESPONSE_LEN) {
+            ble_host_lz_complete(ble_host_lz.stream, ble_host_lz.stream_len);
+            ble_host_lz.stream_len = 0u;
+        }
+        return;
+    }
+    if((len < BLE_CUSTOM_HI_COMP_HEADER_LEN) || (val[0] != BLE_CUSTOM_HI_COMP_MARKER)) {
+        ble_host_lz.errors++;
+        return;
+    }
+    ctrl = val[1];
+    if(0u != (ctrl & BLE_CUSTOM_HI_COMP_FLAG_FIRST)) {
+        if(len < (BLE_CUSTOM_HI_COMP_HEADER_LEN + BLE_CUSTOM_HI_COMP_SIZE_LEN)) {
+            ble_host_lz.errors++;
+            return;
+        }
+        ble_host_lz.expected = (uint32_t)val[2] | ((uint32_t)val[3] << 8u) | ((uint32_t)val[4] << 16u) | \
+                               ((uint32_t)val[5] << 24u);
+        ble_host_lz.lz = 0u != (ctrl & BLE_CUSTOM_HI_COMP_FLAG_LZ);
+        ble_host_lz.stream_len = 0u;
+        header += BLE_CUSTOM_HI_COMP_SIZE_LEN;
+    }
+    if((ble_host_lz.stream_len + (len - header)) > sizeof(ble_host_lz.stream)) {
+        ble_host_lz.errors++;
+        return;
+    }
+    memcpy(&ble_host_lz.stream[ble_host_lz.stream_len], &val[header], len - header);
+    ble_host_lz.stream_len += len - header;
+    if(0u == (ctrl & BLE_CUSTOM_HI_COMP_FLAG_LAST)) {
+        return;
+    }
+    if(ble_host_lz.lz) {
+        n = ble_host_lz_decode(ble_host_lz.stream, ble_host_lz.stream_len, ble_host_lz.response, \
+                               sizeof(ble_host_lz.response));
+        ble_host_lz_complete(ble_host_lz.response, (n == ble_host_lz.expected) ? n : 0u);
+    } else {
+        ble_host_lz_complete(ble_host_lz.stream, \
+                             (ble_host_lz.stream_len == ble_host_lz.expected) ? ble_host_lz.stream_len : 0u);
+    }
+    ble_host_lz.stream_len = 0u;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_drained
+****************************************************************************//**
+*
+* The stop condition of a run: the queued responses are received.
+*
+* \param none.
+*
+* \return true if the peer has all the queued responses.
+*
+*******************************************************************************/
+static bool ble_host_lz_drained(void)
+{
+    return ble_host_lz.received == ble_host_lz.queued;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_progress
+****************************************************************************//**
+*
+* The stop condition of a full lane: a response was received since.
+*
+* \param none.
+*
+* \return true if the lane may take the next response.
+*
+*******************************************************************************/
+static bool ble_host_lz_progress(void)
+{
+    return (ble_host_lz.received != ble_host_lz.mark) || (ble_host_lz.errors != 0u);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_run
+****************************************************************************//**
+*
+* Sends the responses of a sample, raw or through the compression stage.
+*
+* \param sample The sample.
+*
+* \param framed true to send them with ble_custom_hi_response_compressed().
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_host_lz_run(ble_host_lz_sample_t sample, bool framed)
+{
+    ble_host_lz_result_t *result = &ble_host_lz.results[sample];
+    cy_en_ble_api_result_t apiResult;
+    ble_custom_hi_comp_stats_t stats;
+    ble_custom_hi_comp_stats_t base;
+    ble_custom_hi_iov_t iov = { .base = ble_host_lz.response, .len = BLE_HOST_LZ_RESPONSE_LEN };
+    uint64_t start = ble_sim_time_us();
+    uint64_t encode;
+
+    ble_host_lz.sample = sample;
+    ble_host_lz.framed = framed;
+    ble_host_lz.queued = 0u;
+    ble_host_lz.received = 0u;
+    ble_host_lz.stream_len = 0u;
+    (void)ble_custom_hi_get_comp_stats(&base);
+    while(ble_host_lz.queued < ble_host_lz.responses) {
+        ble_host_lz_build(sample, ble_host_lz.queued, ble_host_lz.response);
+        encode = ble_sim_cpu_ns();
+        if(framed) {
+            apiResult = ble_custom_hi_response_compressed(BLE_HOST_CONN_ID, BLE_CUSTOM_HI_LANE_BULK, &iov, 1u);
+            result->encode_ns += ble_sim_cpu_ns() - encode;
+        } else {
+            apiResult = ble_custom_hi_response_queue(BLE_HOST_CONN_ID, BLE_CUSTOM_HI_LANE_BULK, &iov, 1u);
+        }
+        if(apiResult == CY_BLE_SUCCESS) {
+            ble_host_lz.queued++;
+        } else if((apiResult != CY_BLE_ERROR_INSUFFICIENT_RESOURCES) || (ble_host_lz.queued == ble_host_lz.received)) {
+            return apiResult;
+        } else {
+            ble_host_lz.mark = ble_host_lz.received;
+            if(!ble_host_run_until(ble_host_lz_progress, BLE_HOST_LZ_TIMEOUT_MS)) {
+                return CY_BLE_ERROR_INVALID_STATE;
+            }
+        }
+    }
+    if(!ble_host_run_until(ble_host_lz_drained, BLE_HOST_LZ_TIMEOUT_MS)) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    result->errors += ble_host_lz.errors;
+    ble_host_lz.errors = 0u;
+    if(!framed) {
+        result->raw_us = ble_sim_time_us() - start;
+        return CY_BLE_SUCCESS;
+    }
+    result->lz_us = ble_sim_time_us() - start;
+    (void)ble_custom_hi_get_comp_stats(&stats);
+    result->bytes_in = stats.bytes_in - base.bytes_in;
+    result->bytes_out = stats.bytes_out - base.bytes_out;
+    result->compressed = stats.compressed - base.compressed;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_ratio
+****************************************************************************//**
+*
+* Prints a ratio with 2 decimals.
+*
+* \param report The report stream.
+*
+* \param num The numerator.
+*
+* \param den The denominator.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_lz_ratio(FILE *report, uint64_t num, uint64_t den)
+{
+    uint64_t x100 = (den != 0u) ? ((num * 100u) / den) : 0u;
+
+    fprintf(report, "%llu.%02llu", (unsigned long long)(x100 / 100u), (unsigned long long)(x100 % 100u));
+}
+
+/*******************************************************************************
+* Function Name: ble_host_lz_print
+****************************************************************************//**
+*
+* Prints the JSON report.
+*
+* \param link The link parameters.
+*
+* \return true if all the responses were received intact.
+*
+*******************************************************************************/
+static bool ble_host_lz_print(const ble_sim_link_t *link)
+{
+    const ble_host_lz_result_t *result;
+    FILE *report = ble_host_report();
+    uint64_t bytes = (uint64_t)ble_host_lz.responses * BLE_HOST_LZ_RESPONSE_LEN;
+    uint32_t sample;
+    bool passed = true;
+
+    fprintf(report, "{\"lz\":\"ble_host\",\"responses\":%lu,\"len\":%u,\"window\":%u,\"link\":{\"interval_us\":%lu," \
+        "\"packets_per_event\":%u,\"tx_buffers\":%u,\"mtu\":%u},\"results\":[", \
+        (unsigned long)ble_host_lz.responses, (unsigned)BLE_HOST_LZ_RESPONSE_LEN, (unsigned)BLE_LZ_WINDOW_SIZE, \
+        (unsigned long)link->interval_us, link->packets_per_event, link->tx_buffers, link->mtu);
+    for(sample = 0u; sample < BLE_HOST_LZ_SAMPLE_NUM; sample++) {
+        result = &ble_host_lz.results[sample];
+        fprintf(report, "%s{\"sample\":\"%s\",\"bytes_in\":%lu,\"bytes_out\":%lu,\"compressed\":%lu,\"ratio\":", \
+            (sample == 0u) ? "" : ",", ble_host_lz_names[sample], (unsigned long)result->bytes_in, \
+            (unsigned long)result->bytes_out, (unsigned long)result->compressed);
+        ble_host_lz_ratio(report, result->bytes_in, result->bytes_out);
+        fprintf(report, ",\"raw_us\":%llu,\"lz_us\":%llu,\"raw_Bps\":%llu,\"lz_Bps\":%llu,\"gain\":", \
+            (unsigned long long)result->raw_us, (unsigned long long)result->lz_us, \
+            (unsigned long long)((result->raw_us != 0u) ? ((bytes * 1000000u) / result->raw_us) : 0u), \
+            (unsigned long long)((result->lz_us != 0u) ? ((bytes * 1000000u) / result->lz_us) : 0u));
+        ble_host_lz_ratio(report, result->raw_us, result->lz_us);
+        fprintf(report, ",\"encode_ns\":%llu,\"errors\":%lu}", \
+            (unsigned long long)((result->bytes_in != 0u) ? (result->encode_ns / ble_host_lz.responses) : 0u), \
+            (unsigned long)result->errors);
+        passed = passed && (result->errors == 0u) && (result->raw_us != 0u) && (result->lz_us != 0u);
+    }
+    fprintf(report, "]}\n");
+    (void)fflush(report);
+    return passed;
+}
+
+/*******************************************************************************
+* Function Name: main
+****************************************************************************//**
+*
+* Runs the report, see the file header.
+*
+* \param argc The number of arguments.
+*
+* \param argv The arguments.
+*
+* \return 0 if all the responses were received intact.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    ble_sim_link_t link =
+    {
+        .interval_us       = BLE_SIM_INTERVAL_US,
+        .packets_per_event = BLE_SIM_PACKETS_PER_EVENT,
+        .tx_buffers        = BLE_SIM_TX_BUFFERS,
+        .mtu               = BLE_SIM_MTU
+    };
+    uint32_t sample;
+
+    ble_host_lz.responses = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BLE_HOST_LZ_RESPONSES;
+    link.interval_us = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : link.interval_us;
+    link.packets_per_event = (argc > 3) ? (uint8_t)strtoul(argv[3], NULL, 0) : link.packets_per_event;
+    link.tx_buffers = (argc > 4) ? (uint8_t)strtoul(argv[4], NULL, 0) : link.tx_buffers;
+    link.mtu = (argc > 5) ? (uint16_t)strtoul(argv[5], NULL, 0) : link.mtu;
+    if((ble_host_lz.responses == 0u) || \
+       (CY_BLE_SUCCESS != ble_host_init(&link, ble_host_lz_rx, ble_host_lz_cmd_table, \
+                                        sizeof(ble_host_lz_cmd_table) / sizeof(ble_host_lz_cmd_table[0]))) || \
+       (CY_BLE_SUCCESS != ble_host_connect(BLE_HOST_CONN_ID, BLE_HOST_CCCD_NOTIFY))) {
+        fprintf(stderr, "ble_host_lz: the initialization failed\n");
+        return EXIT_FAILURE;
+    }
+    for(sample = 0u; sample < BLE_HOST_LZ_SAMPLE_NUM; sample++) {
+        if((CY_BLE_SUCCESS != ble_host_lz_run((ble_host_lz_sample_t)sample, false)) || \
+           (CY_BLE_SUCCESS != ble_host_lz_run((ble_host_lz_sample_t)sample, true))) {
+            ble_host_lz.results[sample].errors++;
+        }
+    }
+    return ble_host_lz_print(&link) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
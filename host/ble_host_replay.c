@@ -0,0 +1,791 @@
+/***************************************************************************//**
+* \file ble_host_replay.c
+* \version 1.0
+*
+* \brief
+* The replay of a stack event trace of ble_trace.c on the simulated stack:
+*
+*   ble_host_replay trace         -- replays a trace, prints the JSON report
+*   ble_host_replay -r trace      -- records a trace of a sample session
+*
+* The trace is the binary image of ble_trace_dump_gatt() with the chunk
+* headers removed, or the hex lines of ble_trace_dump_uart(), any other line
+* of the log is skipped.
+*
+* The records are fed at their recorded time, relative to the first one. The
+* events coming from the peer are replayed through the simulated link: a
+* connection or a disconnection of the peer, and the writes, whose value is
+* cut to BLE_TRACE_WRITE_VALUE_LEN bytes by the recorder. A write to a
+* connection the trace does not show connecting connects it first. The other
+* events are queued to the event callback with the recorded parameters,
+* except the ones the simulated stack raises itself in answer to the
+* firmware calls (STACK_ON, the advertisement state, the busy status, the
+* confirmations...), which are counted only.
+*
+* The report gives, for each event code, the handler time recorded on the
+* device and the one of the replay, and the queue behaviour of the replay:
+* the simulated stack buffers and event queue, and the lanes of
+* ble_custom_hi.c.
+*
+* The event codes of the trace are the ones of the stack the firmware was
+* built with. The host cycfg_ble.h numbers them on its own, so a trace of
+* the device is replayed once its enum holds the stack values.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ble_host.h"
+#include "ble_custom_hi.h"
+#include "ble_event.h"
+#include "ble_trace.h"
+#include "ble_time.h"
+
+/**
+ * @brief The records of a replayed trace at most.
+ */
+#define BLE_HOST_REPLAY_RECORDS             (4096u)
+
+/**
+ * @brief The event codes with handler statistics, 0 ~ (n - 1).
+ */
+#define BLE_HOST_REPLAY_CODES               (64u)
+
+/**
+ * @brief The virtual time given to the firmware to drain its queues after
+ *        the last record, and to a recorded session step.
+ */
+#define BLE_HOST_REPLAY_DRAIN_MS            (2000u)
+
+/**
+ * @brief The writes of each kind in the recorded session.
+ */
+#define BLE_HOST_REPLAY_SESSION_WRITES      (24u)
+
+/**
+ * @brief The command frame size of the recorded session, the opcode and
+ *        the payload.
+ */
+#define BLE_HOST_REPLAY_FRAME_LEN           (20u)
+
+/**
+ * @brief The GATT dump bytes kept by the recorder.
+ */
+#define BLE_HOST_REPLAY_DUMP_SIZE           (sizeof(ble_trace_header_t) + (BLE_TRACE_DEPTH * sizeof(ble_trace_rec_t)) + \
+                                             (8u * sizeof(ble_trace_chunk_t)))
+
+/**
+ * @brief The statistics of an event code.
+ */
+typedef struct
+{
+    uint32_t recorded;                  /* The records of the trace */
+    uint32_t injected;                  /* The records fed to the firmware */
+    uint64_t trace_cycles;              /* The recorded handler time */
+    uint32_t trace_max_cycles;
+    uint32_t dispatched;                /* The events handled in the replay */
+    uint64_t host_ns;                   /* The handler time of the replay */
+    uint64_t host_max_ns;
+} ble_host_replay_code_t;
+
+/**
+ * @brief The replay state.
+ */
+static struct
+{
+    ble_trace_header_t header;
+    ble_trace_rec_t recs[BLE_HOST_REPLAY_RECORDS];
+    uint32_t count;
+    uint64_t target_us;                 /* The time the next record is fed at */
+    ble_host_replay_code_t codes[BLE_HOST_REPLAY_CODES];
+    uint32_t injected;
+    uint32_t regenerated;
+    uint32_t implied_connects;
+    uint32_t failed;
+    uint32_t rx_packets;
+    uint32_t rx_bytes;
+    /* The recorder */
+    bool     dumping;
+    bool     dumped;
+    cy_en_ble_api_result_t dump_result;
+    uint8_t  dump[BLE_HOST_REPLAY_DUMP_SIZE];
+    uint32_t dump_len;
+} ble_host_replay;
+
+
+/*******************************************************************************
+* Function Name: ble_host_replay_echo_handler
+****************************************************************************//**
+*
+* The echo command handler, returns the request payload.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_host_replay_echo_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    memcpy(res, req, req_len);
+    *res_len = req_len;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_sink_handler
+****************************************************************************//**
+*
+* The sink command handler, takes the write without response.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_host_replay_sink_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    (void)req;
+    (void)req_len;
+    (void)res;
+    (void)res_len;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/**
+ * @brief The command table, the echo and sink commands of ble_app_test.c.
+ */
+static const ble_custom_cmd_desc_t ble_host_replay_cmd_table[] =
+{
+    {
+        .opcode      = BLE_HOST_OPCODE_ECHO,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE,
+        .max_req_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .max_res_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .handler     = ble_host_replay_echo_handler
+    },
+    {
+        .opcode      = BLE_HOST_OPCODE_SINK,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE | BLE_CUSTOM_CMD_FLAG_NO_RESPONSE,
+        .max_req_len = BLE_CUSTOM_CMD_REQ_PAYLOAD_MAX,
+        .max_res_len = 0u,
+        .handler     = ble_host_replay_sink_handler
+    },
+};
+
+/*******************************************************************************
+* Function Name: ble_host_replay_rx
+****************************************************************************//**
+*
+* The receive callback of the peer. The values are counted, and kept while
+* the recorder dumps the trace.
+*
+* \param conn_id The connection ID.
+*
+* \param indication true for an indication.
+*
+* \param val The value.
+*
+* \param len The value size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_replay_rx(uint8_t conn_id, bool indication, const uint8_t *val, uint16_t len)
+{
+    (void)conn_id;
+    (void)indication;
+    ble_host_replay.rx_packets++;
+    ble_host_replay.rx_bytes += len;
+    if(ble_host_replay.dumping && ((ble_host_replay.dump_len + len) <= sizeof(ble_host_replay.dump))) {
+        memcpy(&ble_host_replay.dump[ble_host_replay.dump_len], val, len);
+        ble_host_replay.dump_len += len;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_dispatch
+****************************************************************************//**
+*
+* The dispatch callback of the simulation, keeps the handler time.
+*
+* \param event The event code.
+*
+* \param ns The handler time.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_replay_dispatch(uint32_t event, uint64_t ns)
+{
+    ble_host_replay_code_t *code;
+
+    if(event >= BLE_HOST_REPLAY_CODES) {
+        return;
+    }
+    code = &ble_host_replay.codes[event];
+    code->dispatched++;
+    code->host_ns += ns;
+    if(ns > code->host_max_ns) {
+        code->host_max_ns = ns;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_due
+****************************************************************************//**
+*
+* The stop condition of the wait for the time of the next record.
+*
+* \param none.
+*
+* \return true if the time is reached.
+*
+*******************************************************************************/
+static bool ble_host_replay_due(void)
+{
+    return ble_sim_time_us() >= ble_host_replay.target_us;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_idle
+****************************************************************************//**
+*
+* The stop condition of the drain: the peer writes are delivered and the
+* responses are sent.
+*
+* \param none.
+*
+* \return true if the firmware and the link are idle.
+*
+*******************************************************************************/
+static bool ble_host_replay_idle(void)
+{
+    uint8_t i;
+
+    for(i = 0u; i < CY_BLE_CONN_COUNT; i++) {
+        if((ble_sim_peer_pending(i) != 0u) || (ble_sim_tx_pending(i) != 0u)) {
+            return false;
+        }
+    }
+    return ble_custom_hi_is_idle();
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_answered
+****************************************************************************//**
+*
+* The stop condition of the recorded session: the echo responses are
+* received.
+*
+* \param none.
+*
+* \return true if the session is over.
+*
+*******************************************************************************/
+static bool ble_host_replay_answered(void)
+{
+    return (ble_host_replay.rx_packets >= BLE_HOST_REPLAY_SESSION_WRITES) && ble_host_replay_idle();
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_dumped
+****************************************************************************//**
+*
+* The stop condition of the GATT dump of the recorder.
+*
+* \param none.
+*
+* \return true if the dump is received.
+*
+*******************************************************************************/
+static bool ble_host_replay_dumped(void)
+{
+    return ble_host_replay.dumped && ble_host_replay_idle();
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_dump_done
+****************************************************************************//**
+*
+* The completion callback of ble_trace_dump_gatt().
+*
+* \param task The dump task.
+*
+* \param result The dump result.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_replay_dump_done(ble_task_t *task, cy_en_ble_api_result_t result)
+{
+    (void)task;
+    ble_host_replay.dumped = true;
+    ble_host_replay.dump_result = result;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_is_regenerated
+****************************************************************************//**
+*
+* Checks if the simulated stack raises an event itself, in answer to the
+* firmware calls or to a replayed connection.
+*
+* \param event The event code.
+*
+* \return true if the record is not fed.
+*
+*******************************************************************************/
+static bool ble_host_replay_is_regenerated(uint32_t event)
+{
+    switch(event)
+    {
+        case CY_BLE_EVT_STACK_ON:
+        case CY_BLE_EVT_STACK_SHUTDOWN_COMPLETE:
+        case CY_BLE_EVT_STACK_BUSY_STATUS:
+        case CY_BLE_EVT_SET_DEFAULT_PHY_COMPLETE:
+        case CY_BLE_EVT_GAP_KEYS_GEN_COMPLETE:
+        case CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP:
+        case CY_BLE_EVT_GAPP_UPDATE_ADV_SCAN_DATA_COMPLETE:
+        case CY_BLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP:
+        case CY_BLE_EVT_GATT_CONNECT_IND:
+        case CY_BLE_EVT_GATT_DISCONNECT_IND:
+        case CY_BLE_EVT_GATTS_XCNHG_MTU_REQ:
+        case CY_BLE_EVT_GATTS_HANDLE_VALUE_CNF:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_inject
+****************************************************************************//**
+*
+* Feeds a record, see the file header.
+*
+* \param rec The record.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_host_replay_inject(const ble_trace_rec_t *rec)
+{
+    cy_stc_ble_gap_connected_param_t connected;
+    cy_stc_ble_gap_disconnect_param_t disconnected;
+    cy_en_ble_api_result_t apiResult;
+    uint8_t conn_id;
+    uint16_t handle;
+
+    switch(rec->code)
+    {
+        case CY_BLE_EVT_GAP_DEVICE_CONNECTED:
+            memset(&connected, 0, sizeof(connected));
+            memcpy(&connected, rec->param, (rec->len < sizeof(connected)) ? rec->len : sizeof(connected));
+            return ble_sim_connect(connected.bdHandle);
+        case CY_BLE_EVT_GAP_DEVICE_DISCONNECTED:
+            memset(&disconnected, 0, sizeof(disconnected));
+            memcpy(&disconnected, rec->param, \
+                   (rec->len < sizeof(disconnected)) ? rec->len : sizeof(disconnected));
+            return ble_sim_disconnect(disconnected.bdHandle, disconnected.reason);
+        case CY_BLE_EVT_GATTS_WRITE_REQ:
+        case CY_BLE_EVT_GATTS_WRITE_CMD_REQ:
+            if(rec->len < BLE_TRACE_WRITE_HEADER_LEN) {
+                return CY_BLE_ERROR_INVALID_PARAMETER;
+            }
+            conn_id = rec->param[0];
+            handle = (uint16_t)(rec->param[2] | ((uint16_t)rec->param[3] << 8u));
+            if((conn_id < CY_BLE_CONN_COUNT) && (Cy_BLE_GetConnectionState((cy_stc_ble_conn_handle_t) \
+                { .bdHandle = rec->param[1], .attId = conn_id }) != CY_BLE_CONN_STATE_CONNECTED)) {
+                if(CY_BLE_SUCCESS != (apiResult = ble_sim_connect(conn_id))) {
+                    return apiResult;
+                }
+                ble_host_replay.implied_connects++;
+            }
+            return ble_sim_peer_write(conn_id, handle, &rec->param[BLE_TRACE_WRITE_HEADER_LEN], \
+                                      rec->len - BLE_TRACE_WRITE_HEADER_LEN, rec->code == CY_BLE_EVT_GATTS_WRITE_CMD_REQ);
+        default:
+            return ble_sim_event(rec->code, ((rec->flags & BLE_TRACE_FLAG_PARAM) != 0u) ? rec->param : NULL, rec->len);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_hex
+****************************************************************************//**
+*
+* Parses a hex byte.
+*
+* \param s The two hex digits.
+*
+* \return The byte, -1 if s is not hex.
+*
+*******************************************************************************/
+static int ble_host_replay_hex(const char *s)
+{
+    char digits[3] = { s[0], s[1], '\0' };
+
+    if(!isxdigit((unsigned char)digits[0]) || !isxdigit((unsigned char)digits[1])) {
+        return -1;
+    }
+    return (int)strtol(digits, NULL, 16);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_load_text
+****************************************************************************//**
+*
+* Loads the hex lines of ble_trace_dump_uart().
+*
+* \param file The trace file.
+*
+* \return true if a trace header was found.
+*
+*******************************************************************************/
+static bool ble_host_replay_load_text(FILE *file)
+{
+    ble_trace_header_t *header = &ble_host_replay.header;
+    ble_trace_rec_t *rec;
+    unsigned long time;
+    unsigned long code;
+    unsigned long cycles;
+    unsigned int flags;
+    unsigned int count;
+    unsigned long overwritten;
+    unsigned long tick_hz;
+    unsigned long core_hz;
+    char line[256];
+    const char *p;
+    int pos;
+    int byte;
+    bool found = false;
+
+    while(fgets(line, sizeof(line), file) != NULL) {
+        if(NULL != (p = strstr(line, "Trace: "))) {
+            if(4 == sscanf(p, "Trace: %u records, %lu overwritten, tick %lu Hz, core %lu Hz", &count, \
+                           &overwritten, &tick_hz, &core_hz)) {
+                header->magic = BLE_TRACE_MAGIC;
+                header->version = BLE_TRACE_VERSION;
+                header->rec_size = (uint8_t)sizeof(ble_trace_rec_t);
+                header->count = (uint16_t)count;
+                header->overwritten = (uint32_t)overwritten;
+                header->tick_hz = (uint32_t)tick_hz;
+                header->core_hz = (uint32_t)core_hz;
+                ble_host_replay.count = 0u;
+                found = true;
+            }
+            continue;
+        }
+        if(!found || (ble_host_replay.count == BLE_HOST_REPLAY_RECORDS) || \
+           (4 != sscanf(line, "%8lx %8lx %8lx %2x:%n", &time, &code, &cycles, &flags, &pos))) {
+            continue;
+        }
+        rec = &ble_host_replay.recs[ble_host_replay.count++];
+        memset(rec, 0, sizeof(*rec));
+        rec->time = (uint32_t)time;
+        rec->code = (uint32_t)code;
+        rec->cycles = (uint32_t)cycles;
+        rec->flags = (uint8_t)flags;
+        for(p = &line[pos]; (rec->len < BLE_TRACE_PARAM_LEN) && ((byte = ble_host_replay_hex(p)) >= 0); p += 2) {
+            rec->param[rec->len++] = (uint8_t)byte;
+        }
+    }
+    return found;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_load
+****************************************************************************//**
+*
+* Loads a trace, the binary image or the hex lines.
+*
+* \param path The trace file.
+*
+* \return true if the trace was loaded.
+*
+*******************************************************************************/
+static bool ble_host_replay_load(const char *path)
+{
+    ble_trace_header_t *header = &ble_host_replay.header;
+    FILE *file = fopen(path, "rb");
+    size_t n;
+    bool loaded = false;
+
+    if(file == NULL) {
+        return false;
+    }
+    n = fread(header, 1u, sizeof(*header), file);
+    if((n == sizeof(*header)) && (header->magic == BLE_TRACE_MAGIC)) {
+        if((header->version == BLE_TRACE_VERSION) && (header->rec_size == sizeof(ble_trace_rec_t))) {
+            ble_host_replay.count = (header->count < BLE_HOST_REPLAY_RECORDS) ? header->count : BLE_HOST_REPLAY_RECORDS;
+            ble_host_replay.count = (uint32_t)fread(ble_host_replay.recs, sizeof(ble_trace_rec_t), \
+                                                    ble_host_replay.count, file);
+            loaded = true;
+        }
+    } else {
+        rewind(file);
+        loaded = ble_host_replay_load_text(file);
+    }
+    (void)fclose(file);
+    return loaded && (header->tick_hz != 0u);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_run
+****************************************************************************//**
+*
+* Feeds the records at their time, then lets the firmware drain its queues.
+*
+* \param none.
+*
+* \return The virtual time of the replay in us.
+*
+*******************************************************************************/
+static uint64_t ble_host_replay_run(void)
+{
+    const ble_trace_rec_t *rec;
+    ble_host_replay_code_t *code;
+    uint64_t start = ble_sim_time_us();
+    uint32_t i;
+
+    for(i = 0u; i < ble_host_replay.count; i++) {
+        rec = &ble_host_replay.recs[i];
+        code = (rec->code < BLE_HOST_REPLAY_CODES) ? &ble_host_replay.codes[rec->code] : NULL;
+        if(code != NULL) {
+            code->recorded++;
+            code->trace_cycles += rec->cycles;
+            if(rec->cycles > code->trace_max_cycles) {
+                code->trace_max_cycles = rec->cycles;
+            }
+        }
+        if(ble_host_replay_is_regenerated(rec->code)) {
+            ble_host_replay.regenerated++;
+            continue;
+        }
+        ble_host_replay.target_us = start + (((uint64_t)(rec->time - ble_host_replay.recs[0].time) * 1000000u) / \
+                                             ble_host_replay.header.tick_hz);
+        ble_sim_wake_at(ble_host_replay.target_us);
+        (void)ble_host_run_until(ble_host_replay_due, UINT32_MAX / 1000u);
+        if(CY_BLE_SUCCESS != ble_host_replay_inject(rec)) {
+            ble_host_replay.failed++;
+            continue;
+        }
+        ble_host_replay.injected++;
+        if(code != NULL) {
+            code->injected++;
+        }
+    }
+    (void)ble_host_run_until(ble_host_replay_idle, BLE_HOST_REPLAY_DRAIN_MS);
+    return ble_sim_time_us() - start;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_report
+****************************************************************************//**
+*
+* Prints the JSON report of the replay.
+*
+* \param path The trace file.
+*
+* \param replay_us The virtual time of the replay.
+*
+* \param cpu_ns The host time of the replay.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_replay_report(const char *path, uint64_t replay_us, uint64_t cpu_ns)
+{
+    const ble_trace_header_t *header = &ble_host_replay.header;
+    const ble_host_replay_code_t *code;
+    ble_custom_hi_lane_stats_t lane;
+    ble_event_stats_t run;
+    ble_sim_stats_t sim;
+    FILE *report = ble_host_report();
+    uint64_t span_us = 0u;
+    uint32_t core_mhz = (header->core_hz >= 1000000u) ? (header->core_hz / 1000000u) : 1u;
+    bool first = true;
+    uint32_t i;
+    uint8_t conn_id;
+    uint8_t n;
+
+    if(ble_host_replay.count != 0u) {
+        span_us = ((uint64_t)(ble_host_replay.recs[ble_host_replay.count - 1u].time - ble_host_replay.recs[0].time) * \
+                   1000000u) / header->tick_hz;
+    }
+    fprintf(report, "{\"replay\":\"%s\",\"records\":%lu,\"overwritten\":%lu,\"span_us\":%llu,\"replay_us\":%llu," \
+        "\"injected\":%lu,\"regenerated\":%lu,\"implied_connects\":%lu,\"failed\":%lu,\"handlers\":[", path, \
+        (unsigned long)ble_host_replay.count, (unsigned long)header->overwritten, (unsigned long long)span_us, \
+        (unsigned long long)replay_us, (unsigned long)ble_host_replay.injected, \
+        (unsigned long)ble_host_replay.regenerated, (unsigned long)ble_host_replay.implied_connects, \
+        (unsigned long)ble_host_replay.failed);
+    for(i = 0u; i < BLE_HOST_REPLAY_CODES; i++) {
+        code = &ble_host_replay.codes[i];
+        if((code->recorded == 0u) && (code->dispatched == 0u)) {
+            continue;
+        }
+        fprintf(report, "%s{\"code\":%lu,\"recorded\":%lu,\"injected\":%lu,\"trace_avg_us\":%lu,\"trace_max_us\":%lu," \
+            "\"dispatched\":%lu,\"host_avg_ns\":%llu,\"host_max_ns\":%llu}", first ? "" : ",", (unsigned long)i, \
+            (unsigned long)code->recorded, (unsigned long)code->injected, \
+            (unsigned long)((code->recorded != 0u) ? ((code->trace_cycles / code->recorded) / core_mhz) : 0u), \
+            (unsigned long)(code->trace_max_cycles / core_mhz), (unsigned long)code->dispatched, \
+            (unsigned long long)((code->dispatched != 0u) ? (code->host_ns / code->dispatched) : 0u), \
+            (unsigned long long)code->host_max_ns);
+        first = false;
+    }
+    ble_sim_get_stats(&sim);
+    ble_event_get_stats(&run);
+    fprintf(report, "],\"queues\":{\"sim\":{\"stack_events\":%lu,\"event_queue_max\":%lu,\"tx_queue_max\":%lu," \
+        "\"busy\":%lu,\"rejected\":%lu,\"notifications\":%lu,\"indications\":%lu,\"rx_bytes\":%lu}," \
+        "\"run\":{\"posts\":%lu,\"wakeups\":%lu},\"lanes\":[", (unsigned long)sim.stack_events, \
+        (unsigned long)sim.event_queue_max, (unsigned long)sim.tx_queue_max, (unsigned long)sim.busy, \
+        (unsigned long)sim.rejected, (unsigned long)sim.notifications, (unsigned long)sim.indications, \
+        (unsigned long)sim.rx_bytes, (unsigned long)run.posts, (unsigned long)run.wakeups);
+    first = true;
+    for(conn_id = 0u; conn_id < CY_BLE_CONN_COUNT; conn_id++) {
+        for(n = 0u; n < BLE_CUSTOM_HI_LANE_NUM; n++) {
+            if((CY_BLE_SUCCESS != ble_custom_hi_get_lane_stats(conn_id, (ble_custom_hi_lane_t)n, &lane)) || \
+               (lane.packets == 0u)) {
+                continue;
+            }
+            fprintf(report, "%s{\"conn\":%u,\"lane\":%u,\"packets\":%lu,\"bytes\":%lu,\"dropped\":%lu," \
+                "\"wait_avg_us\":%lu,\"wait_max_us\":%lu}", first ? "" : ",", conn_id, n, \
+                (unsigned long)lane.packets, (unsigned long)lane.bytes, (unsigned long)lane.dropped, \
+                (unsigned long)(lane.wait_total_us / lane.packets), (unsigned long)lane.wait_max_us);
+            first = false;
+        }
+    }
+    fprintf(report, "]},\"cpu_ns\":%llu}\n", (unsigned long long)cpu_ns);
+    (void)fflush(report);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_replay_record
+****************************************************************************//**
+*
+* Records the trace of a sample session: the connection, echo requests and
+* writes without response, then the trace is dumped over GATT and the image
+* is rebuilt from the chunks.
+*
+* \param path The trace file to write.
+*
+* \return true if the trace was written.
+*
+*******************************************************************************/
+static bool ble_host_replay_record(const char *path)
+{
+    ble_trace_chunk_t chunk;
+    static uint8_t image[BLE_HOST_REPLAY_DUMP_SIZE];
+    uint8_t frame[BLE_HOST_REPLAY_FRAME_LEN];
+    uint32_t total = 0u;
+    uint32_t pos;
+    uint32_t i;
+    FILE *file;
+
+    if(CY_BLE_SUCCESS != ble_host_connect(BLE_HOST_CONN_ID, BLE_HOST_CCCD_NOTIFY)) {
+        return false;
+    }
+    ble_host_replay.rx_packets = 0u;
+    for(i = 0u; i < BLE_HOST_REPLAY_SESSION_WRITES; i++) {
+        frame[0] = BLE_HOST_OPCODE_ECHO;
+        memset(&frame[1], (int)i, sizeof(frame) - 1u);
+        (void)ble_sim_peer_write(BLE_HOST_CONN_ID, CY_BLE_CUSTOM_HOST_INTERFACE_COMMAND_CHAR_HANDLE, frame, \
+                                 (uint16_t)(1u + (i % (sizeof(frame) - 1u))), false);
+        frame[0] = BLE_HOST_OPCODE_SINK;
+        (void)ble_sim_peer_write(BLE_HOST_CONN_ID, CY_BLE_CUSTOM_HOST_INTERFACE_COMMAND_CHAR_HANDLE, frame, \
+                                 sizeof(frame), true);
+    }
+    if(!ble_host_run_until(ble_host_replay_answered, BLE_HOST_REPLAY_DRAIN_MS)) {
+        return false;
+    }
+    ble_host_replay.dumping = true;
+    if((CY_BLE_SUCCESS != ble_trace_dump_gatt(BLE_HOST_CONN_ID, BLE_CUSTOM_HI_LANE_BULK, ble_host_replay_dump_done)) || \
+       !ble_host_run_until(ble_host_replay_dumped, BLE_HOST_REPLAY_DRAIN_MS) || \
+       (ble_host_replay.dump_result != CY_BLE_SUCCESS)) {
+        return false;
+    }
+    /* The chunks follow each other in the notifications of the bulk lane */
+    for(pos = 0u; (pos + sizeof(chunk)) <= ble_host_replay.dump_len; pos += sizeof(chunk) + chunk.len) {
+        memcpy(&chunk, &ble_host_replay.dump[pos], sizeof(chunk));
+        if((chunk.marker != BLE_TRACE_CHUNK_MARKER) || ((pos + sizeof(chunk) + chunk.len) > ble_host_replay.dump_len) || \
+           (chunk.total > sizeof(image)) || ((chunk.offset + chunk.len) > chunk.total)) {
+            return false;
+        }
+        memcpy(&image[chunk.offset], &ble_host_replay.dump[pos + sizeof(chunk)], chunk.len);
+        total = chunk.total;
+    }
+    if((total == 0u) || (NULL == (file = fopen(path, "wb")))) {
+        return false;
+    }
+    i = (uint32_t)fwrite(image, 1u, total, file);
+    return (0 == fclose(file)) && (i == total);
+}
+
+/*******************************************************************************
+* Function Name: main
+****************************************************************************//**
+*
+* Records or replays a trace, see the file header.
+*
+* \param argc The number of arguments.
+*
+* \param argv The arguments.
+*
+* \return 0 if the trace was recorded or replayed without failure.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    const char *path;
+    bool record = (argc == 3) && (0 == strcmp(argv[1], "-r"));
+    uint64_t replay_us;
+    uint64_t cpu_ns;
+
+    if((argc != 2) && !record) {
+        fprintf(stderr, "usage: ble_host_replay [-r] trace\n");
+        return EXIT_FAILURE;
+    }
+    path = argv[argc - 1];
+    if(!record && !ble_host_replay_load(path)) {
+        fprintf(stderr, "ble_host_replay: %s is not a trace\n", path);
+        return EXIT_FAILURE;
+    }
+    if(CY_BLE_SUCCESS != ble_host_init(NULL, ble_host_replay_rx, ble_host_replay_cmd_table, \
+                                       sizeof(ble_host_replay_cmd_table) / sizeof(ble_host_replay_cmd_table[0]))) {
+        fprintf(stderr, "ble_host_replay: the initialization failed\n");
+        return EXIT_FAILURE;
+    }
+    if(record) {
+        if(!ble_host_replay_record(path)) {
+            fprintf(stderr, "ble_host_replay: the trace was not recorded\n");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    ble_sim_reset_stats();
+    ble_sim_set_dispatch(ble_host_replay_dispatch);
+    cpu_ns = ble_sim_cpu_ns();
+    replay_us = ble_host_replay_run();
+    cpu_ns = ble_sim_cpu_ns() - cpu_ns;
+    ble_host_replay_report(path, replay_us, cpu_ns);
+    return (ble_host_replay.failed == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,543 @@
+/***************************************************************************//**
+* \file ble_host_rtos.c
+* \version 1.0
+*
+* \brief
+* The load test of the FreeRTOS task architecture of ble_rtos.c, on the host
+* model of FreeRTOS of ble_sim_rtos.c. ble_rtos.c, ble_event.c and ble_pool.c
+* are built with COMPONENT_FREERTOS as on the target.
+*
+* The BLE task runs the run loop of ble_app_test.c. It takes the place of the
+* command framework: each command is written to a pool block and handed to
+* the forward hook of ble_rtos.c, for the connections in turn. The worker
+* tasks take the commands and submit the responses, most in the command
+* block and some in a new message with a larger block. The transmit queue of
+* ble_custom_hi.c is replaced with a check of the responses, it is randomly
+* full.
+*
+* Each command must be answered once, on its connection, with the payload the
+* worker built from it. The program prints one JSON line with the counts, the
+* ble_rtos_stats_t counters and the pool usage, and fails on the first
+* mismatch, on a leaked block or if the tasks stall.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ble_rtos.h"
+#include "ble_custom_cmd.h"
+#include "ble_event.h"
+#include "ble_pool.h"
+#include "ble_time.h"
+
+/**
+ * @brief The commands sent by default and the worker tasks.
+ */
+#define BLE_HOST_RTOS_COMMANDS              (20000u)
+#define BLE_HOST_RTOS_WORKERS               (3u)
+#define BLE_HOST_RTOS_WORKERS_MAX           (8u)
+
+/**
+ * @brief The command frame: the opcode and the sequence number, then the
+ *        payload. ECHO is answered in the command block with the payload
+ *        bits of the mask inverted, EXPAND in a new message with the payload
+ *        twice. A worker without a message answers EXPAND busy in place.
+ */
+#define BLE_HOST_RTOS_OPCODE_ECHO           (0x7Fu)
+#define BLE_HOST_RTOS_OPCODE_EXPAND         (0x7Eu)
+#define BLE_HOST_RTOS_HEADER_LEN            (5u)
+#define BLE_HOST_RTOS_PAYLOAD_MASK          (0xA5u)
+#define BLE_HOST_RTOS_EXPAND_RATE           (8u)
+#define BLE_HOST_RTOS_EXPAND_MAX            (100u)
+
+/**
+ * @brief The largest command, the command framework adds a byte to the block.
+ */
+#define BLE_HOST_RTOS_FRAME_MAX             (BLE_CUSTOM_CMD_BUFFER_SIZE - 1u)
+
+/**
+ * @brief The transmit queue is full for 1 response in BLE_HOST_RTOS_FULL_RATE.
+ */
+#define BLE_HOST_RTOS_FULL_RATE             (4u)
+
+/**
+ * @brief The time without a response before the tasks are stalled, and the
+ *        period of its check.
+ */
+#define BLE_HOST_RTOS_STALL_MS              (1000u)
+#define BLE_HOST_RTOS_MONITOR_MS            (50u)
+
+/**
+ * @brief The priorities of the tasks below the BLE task.
+ */
+#define BLE_HOST_RTOS_WORKER_PRIORITY       (BLE_RTOS_BLE_TASK_PRIORITY - 1u)
+#define BLE_HOST_RTOS_MONITOR_PRIORITY      (tskIDLE_PRIORITY + 1u)
+#define BLE_HOST_RTOS_STACK_SIZE            (1024u / sizeof(StackType_t))
+
+/**
+ * @brief The test state. The counters are written by the BLE task, those
+ *        shared with the other tasks under the critical section.
+ */
+static struct
+{
+    ble_custom_cmd_forward_t forward;
+    uint32_t commands;
+    uint32_t workers;
+    uint32_t sent;
+    uint32_t received;
+    uint32_t busy;                              /* Commands refused by the forward hook */
+    uint32_t no_block;                          /* Commands waiting for a pool block */
+    uint32_t expanded;                          /* EXPAND responses in a new message */
+    uint32_t expand_busy;                       /* EXPAND answered busy, no message or block */
+    uint32_t errors;
+    uint32_t tx_full;
+    bool     done;
+    bool     stalled;
+    unsigned int seed;
+    uint8_t  *answered;
+    uint64_t start_ns;
+    uint64_t elapsed_ns;
+} ble_host_rtos =
+{
+    .seed = 1u,
+};
+
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_now_ns
+****************************************************************************//**
+*
+* Gets the host monotonic time.
+*
+* \param none.
+*
+* \return The time in ns.
+*
+*******************************************************************************/
+static uint64_t ble_host_rtos_now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_opcode
+****************************************************************************//**
+*
+* Gets the opcode of a sequence number.
+*
+* \param seq The sequence number.
+*
+* \return The opcode.
+*
+*******************************************************************************/
+static uint8_t ble_host_rtos_opcode(uint32_t seq)
+{
+    return ((seq % BLE_HOST_RTOS_EXPAND_RATE) == (BLE_HOST_RTOS_EXPAND_RATE - 1u)) ? \
+           BLE_HOST_RTOS_OPCODE_EXPAND : BLE_HOST_RTOS_OPCODE_ECHO;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_frame_len
+****************************************************************************//**
+*
+* Gets the command frame size of a sequence number, the ECHO sizes cover the
+* three size classes of the pool.
+*
+* \param seq The sequence number.
+*
+* \return The frame size.
+*
+*******************************************************************************/
+static uint16_t ble_host_rtos_frame_len(uint32_t seq)
+{
+    uint32_t max = (ble_host_rtos_opcode(seq) == BLE_HOST_RTOS_OPCODE_EXPAND) ? \
+                   BLE_HOST_RTOS_EXPAND_MAX : (BLE_HOST_RTOS_FRAME_MAX - BLE_HOST_RTOS_HEADER_LEN);
+
+    return (uint16_t)(BLE_HOST_RTOS_HEADER_LEN + ((seq * 37u) % (max + 1u)));
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_send
+****************************************************************************//**
+*
+* Sends the next command to the forward hook as the command framework does:
+* the frame is written to a pool block with a spare byte, the block is owned
+* by ble_rtos.c once it is taken.
+*
+* \param none.
+*
+* \return true if the command was taken, false if no block is free or the
+* hook refused it.
+*
+*******************************************************************************/
+static bool ble_host_rtos_send(void)
+{
+    uint32_t seq = ble_host_rtos.sent;
+    uint16_t len = ble_host_rtos_frame_len(seq);
+    uint8_t *frame = ble_pool_alloc(len + 1u);
+    uint16_t i;
+
+    if(frame == NULL) {
+        ble_host_rtos.no_block++;
+        return false;
+    }
+    frame[0] = ble_host_rtos_opcode(seq);
+    memcpy(&frame[1], &seq, sizeof(seq));
+    for(i = BLE_HOST_RTOS_HEADER_LEN; i < len; i++) {
+        frame[i] = (uint8_t)(seq + i);
+    }
+    if(!ble_host_rtos.forward((uint8_t)(seq % BLE_CUSTOM_HI_CONN_NUM), frame, len)) {
+        /* The framework answers busy and frees the block */
+        ble_pool_free(frame);
+        ble_host_rtos.busy++;
+        return false;
+    }
+    ble_host_rtos.sent++;
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_ble_task
+****************************************************************************//**
+*
+* The BLE task, the run loop of ble_app_test.c with the command source in
+* place of the stack. It ends the scheduler once all commands are answered.
+*
+* \param arg Not used.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_host_rtos_ble_task(void *arg)
+{
+    uint32_t events;
+
+    (void)arg;
+    ble_event_post(BLE_EVENT_COMMAND);
+    for(;;)
+    {
+        events = ble_event_wait();
+        /* Move the responses of the workers to the transmit queue */
+        if(0u != (events & (BLE_EVENT_QUEUE | BLE_EVENT_TX))) {
+            ble_rtos_process();
+        }
+        if(ble_host_rtos.received >= ble_host_rtos.commands) {
+            break;
+        }
+        /* The central writes until the messages or the blocks run out */
+        while((ble_host_rtos.sent < ble_host_rtos.commands) && ble_host_rtos_send()) {
+        }
+    }
+    ble_host_rtos.elapsed_ns = ble_host_rtos_now_ns() - ble_host_rtos.start_ns;
+    taskENTER_CRITICAL();
+    ble_host_rtos.done = true;
+    taskEXIT_CRITICAL();
+    vTaskEndScheduler();
+    vTaskDelete(NULL);
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_expand
+****************************************************************************//**
+*
+* Answers an EXPAND command in a new message, the payload twice. The worker
+* does not wait for a message: the other workers may hold them all.
+*
+* \param msg The command message, it is freed.
+*
+* \return The response message, NULL if no message or no block is free.
+*
+*******************************************************************************/
+static ble_rtos_msg_t *ble_host_rtos_expand(ble_rtos_msg_t *msg)
+{
+    uint16_t payload = msg->len - BLE_HOST_RTOS_HEADER_LEN;
+    ble_rtos_msg_t *res = ble_rtos_msg_alloc(BLE_CUSTOM_CMD_RES_HEADER_LEN + 4u + (2u * payload), 0u);
+    uint16_t i;
+
+    if(res == NULL) {
+        return NULL;
+    }
+    res->conn_id = msg->conn_id;
+    res->data[0] = msg->data[0];
+    res->data[1] = BLE_CUSTOM_CMD_STATUS_OK;
+    memcpy(&res->data[2], &msg->data[1], 4u);
+    for(i = 0u; i < payload; i++) {
+        res->data[6u + i] = msg->data[BLE_HOST_RTOS_HEADER_LEN + i] ^ BLE_HOST_RTOS_PAYLOAD_MASK;
+        res->data[6u + payload + i] = res->data[6u + i];
+    }
+    res->len = 6u + (2u * payload);
+    ble_rtos_msg_free(msg);
+    return res;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_worker_task
+****************************************************************************//**
+*
+* A worker task: the ECHO response is built in the pool block of the command,
+* | opcode | status | seq | payload ^ mask |, and the message is submitted back.
+*
+* \param arg Not used.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_host_rtos_worker_task(void *arg)
+{
+    ble_rtos_msg_t *msg;
+    ble_rtos_msg_t *res;
+    uint16_t i;
+
+    (void)arg;
+    for(;;)
+    {
+        msg = ble_rtos_command_receive(portMAX_DELAY);
+        if(msg == NULL) {
+            continue;
+        }
+        if(msg->data[0] == BLE_HOST_RTOS_OPCODE_EXPAND) {
+            res = ble_host_rtos_expand(msg);
+            taskENTER_CRITICAL();
+            if(res != NULL) {
+                ble_host_rtos.expanded++;
+            } else {
+                ble_host_rtos.expand_busy++;
+            }
+            taskEXIT_CRITICAL();
+            if(res != NULL) {
+                (void)ble_rtos_response_submit(res, BLE_CUSTOM_HI_LANE_BULK);
+                continue;
+            }
+            /* | opcode | busy | seq | */
+            msg->len = BLE_HOST_RTOS_HEADER_LEN;
+        }
+        /* The block has the spare byte of the status */
+        memmove(&msg->data[2], &msg->data[1], msg->len - 1u);
+        for(i = BLE_HOST_RTOS_HEADER_LEN + 1u; i <= msg->len; i++) {
+            msg->data[i] ^= BLE_HOST_RTOS_PAYLOAD_MASK;
+        }
+        msg->data[1] = (msg->data[0] == BLE_HOST_RTOS_OPCODE_ECHO) ? BLE_CUSTOM_CMD_STATUS_OK : \
+                                                                     BLE_CUSTOM_CMD_STATUS_BUSY;
+        msg->len++;
+        (void)ble_rtos_response_submit(msg, BLE_CUSTOM_HI_LANE_BULK);
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_rtos_monitor_task
+****************************************************************************//**
+*
+* Ends the scheduler if no response comes for BLE_HOST_RTOS_STALL_MS.
+*
+* \param arg Not used.
+*
+* \return None
+*
+*******************************************************************************/
+static void ble_host_rtos_monitor_task(void *arg)
+{
+    uint32_t received = 0u;
+    uint32_t now;
+    TickType_t last = xTaskGetTickCount();
+    bool done = false;
+
+    (void)arg;
+    while(!done)
+    {
+        vTaskDelay(pdMS_TO_TICKS(BLE_HOST_RTOS_MONITOR_MS));
+        taskENTER_CRITICAL();
+        now = ble_host_rtos.received;
+        done = ble_host_rtos.done;
+        taskEXIT_CRITICAL();
+        if(received != now) {
+            received = now;
+            last = xTaskGetTickCount();
+        } else if(!done && ((xTaskGetTickCount() - last) >= pdMS_TO_TICKS(BLE_HOST_RTOS_STALL_MS))) {
+            taskENTER_CRITICAL();
+            ble_host_rtos.stalled = true;
+            taskEXIT_CRITICAL();
+            vTaskEndScheduler();
+            break;
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/*******************************************************************************
+* Function Name: main
+****************************************************************************//**
+*
+* Runs the load test, see the file header.
+*
+* \param argc The number of arguments.
+*
+* \param argv The arguments: the number of commands, the number of worker
+* tasks and the random seed.
+*
+* \return 0 if all the commands are answered intact and no block is leaked.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    ble_rtos_stats_t stats;
+    ble_pool_stats_t pool;
+    uint32_t pool_used = 0u;
+    uint32_t pool_high = 0u;
+    uint32_t i;
+
+    ble_host_rtos.commands = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BLE_HOST_RTOS_COMMANDS;
+    ble_host_rtos.workers = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : BLE_HOST_RTOS_WORKERS;
+    ble_host_rtos.seed = (argc > 3) ? (unsigned int)strtoul(argv[3], NULL, 0) : 1u;
+    if((ble_host_rtos.workers == 0u) || (ble_host_rtos.workers > BLE_HOST_RTOS_WORKERS_MAX) || \
+       (NULL == (ble_host_rtos.answered = calloc(ble_host_rtos.commands + 1u, 1u)))) {
+        fprintf(stderr, "ble_host_rtos: [commands [workers (1 ~ %u) [seed]]]\n", BLE_HOST_RTOS_WORKERS_MAX);
+        return EXIT_FAILURE;
+    }
+    ble_pool_init();
+    if(CY_BLE_SUCCESS != ble_rtos_init(ble_host_rtos_ble_task, NULL)) {
+        fprintf(stderr, "ble_host_rtos: the initialization failed\n");
+        return EXIT_FAILURE;
+    }
+    for(i = 0u; i < ble_host_rtos.workers; i++) {
+        if(pdPASS != xTaskCreate(ble_host_rtos_worker_task, "worker", BLE_HOST_RTOS_STACK_SIZE, NULL, \
+                                 BLE_HOST_RTOS_WORKER_PRIORITY, NULL)) {
+            return EXIT_FAILURE;
+        }
+    }
+    if(pdPASS != xTaskCreate(ble_host_rtos_monitor_task, "monitor", BLE_HOST_RTOS_STACK_SIZE, NULL, \
+                             BLE_HOST_RTOS_MONITOR_PRIORITY, NULL)) {
+        return EXIT_FAILURE;
+    }
+    ble_host_rtos.start_ns = ble_host_rtos_now_ns();
+    vTaskStartScheduler();
+
+    ble_rtos_get_stats(&stats);
+    for(i = 0u; i < BLE_POOL_CLASS_NUM; i++) {
+        if(CY_BLE_SUCCESS == ble_pool_get_stats(i, &pool)) {
+            pool_used += pool.used;
+            pool_high += pool.high_water;
+        }
+    }
+    printf("{\"rtos\":\"host_threads\",\"commands\":%lu,\"workers\":%lu,\"sent\":%lu,\"received\":%lu," \
+        "\"errors\":%lu,\"stalled\":%s,\"busy\":%lu,\"no_block\":%lu,\"expanded\":%lu,\"expand_busy\":%lu," \
+        "\"tx_full\":%lu,\"queues\":{\"commands\":%lu,\"commands_dropped\":%lu,\"responses\":%lu," \
+        "\"responses_dropped\":%lu,\"retries\":%lu,\"msg_min_free\":%lu},\"pool_used\":%lu," \
+        "\"pool_high_water\":%lu,\"elapsed_ns\":%llu}\n", \
+        (unsigned long)ble_host_rtos.commands, (unsigned long)ble_host_rtos.workers, \
+        (unsigned long)ble_host_rtos.sent, (unsigned long)ble_host_rtos.received, \
+        (unsigned long)ble_host_rtos.errors, ble_host_rtos.stalled ? "true" : "false", \
+        (unsigned long)ble_host_rtos.busy, (unsigned long)ble_host_rtos.no_block, \
+        (unsigned long)ble_host_rtos.expanded, (unsigned long)ble_host_rtos.expand_busy, \
+        (unsigned long)ble_host_rtos.tx_full, (unsigned long)stats.commands, (unsigned long)stats.commands_dropped, \
+        (unsigned long)stats.responses, (unsigned long)stats.responses_dropped, (unsigned long)stats.retries, \
+        (unsigned long)stats.msg_min_free, (unsigned long)pool_used, (unsigned long)pool_high, \
+        (unsigned long long)ble_host_rtos.elapsed_ns);
+    return ((ble_host_rtos.errors == 0u) && !ble_host_rtos.stalled && \
+            (ble_host_rtos.received == ble_host_rtos.commands) && (stats.commands == ble_host_rtos.sent) && \
+            (stats.responses == ble_host_rtos.received) && (stats.responses_dropped == 0u) && \
+            (pool_used == 0u)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*******************************************************************************
+* BLE layer stand-ins: the command framework and the transmit queue
+*******************************************************************************/
+void ble_custom_cmd_set_forward(ble_custom_cmd_forward_t forward)
+{
+    ble_host_rtos.forward = forward;
+}
+
+void ble_custom_hi_tx_task(void)
+{
+}
+
+/* The check of the responses, the queue is randomly full and the transmit
+ * completes on a later BLE_EVENT_TX */
+cy_en_ble_api_result_t ble_custom_hi_response_queue(uint8_t conn_id, ble_custom_hi_lane_t lane, \
+                                                    const ble_custom_hi_iov_t *iov, uint32_t iovcnt)
+{
+    const uint8_t *res = (const uint8_t *)iov->base;
+    uint16_t payload;
+    uint32_t seq;
+    uint16_t len;
+    uint16_t i;
+    bool busy;
+
+    if((rand_r(&ble_host_rtos.seed) % BLE_HOST_RTOS_FULL_RATE) == 0u) {
+        ble_host_rtos.tx_full++;
+        ble_event_post(BLE_EVENT_TX);
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    if((iovcnt != 1u) || (iov->len < (BLE_HOST_RTOS_HEADER_LEN + 1u)) || (lane != BLE_CUSTOM_HI_LANE_BULK)) {
+        ble_host_rtos.errors++;
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    memcpy(&seq, &res[2], sizeof(seq));
+    if((seq >= ble_host_rtos.sent) || (ble_host_rtos.answered[seq] != 0u) || \
+       (conn_id != (seq % BLE_CUSTOM_HI_CONN_NUM)) || (res[0] != ble_host_rtos_opcode(seq))) {
+        ble_host_rtos.errors++;
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    payload = ble_host_rtos_frame_len(seq) - BLE_HOST_RTOS_HEADER_LEN;
+    busy = (res[0] == BLE_HOST_RTOS_OPCODE_EXPAND) && (res[1] == BLE_CUSTOM_CMD_STATUS_BUSY);
+    len = (uint16_t)(BLE_HOST_RTOS_HEADER_LEN + 1u + (busy ? 0u : \
+                     ((res[0] == BLE_HOST_RTOS_OPCODE_EXPAND) ? (2u * payload) : payload)));
+    if((iov->len != len) || (!busy && (res[1] != BLE_CUSTOM_CMD_STATUS_OK))) {
+        ble_host_rtos.errors++;
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    for(i = BLE_HOST_RTOS_HEADER_LEN + 1u; i < len; i++) {
+        if(res[i] != (uint8_t)((uint8_t)(seq + BLE_HOST_RTOS_HEADER_LEN + \
+                               ((i - BLE_HOST_RTOS_HEADER_LEN - 1u) % payload)) ^ BLE_HOST_RTOS_PAYLOAD_MASK)) {
+            ble_host_rtos.errors++;
+            return CY_BLE_ERROR_INVALID_PARAMETER;
+        }
+    }
+    ble_host_rtos.answered[seq] = 1u;
+    taskENTER_CRITICAL();
+    ble_host_rtos.received++;
+    taskEXIT_CRITICAL();
+    return CY_BLE_SUCCESS;
+}
+
+uint32_t ble_time_now(void)
+{
+    return (uint32_t)((ble_host_rtos_now_ns() * BLE_TIME_TICK_HZ) / 1000000000u);
+}
+
+/*******************************************************************************
+* PDL stand-ins: the interrupts are masked with the critical section of the
+* FreeRTOS model, the tasks never run in an interrupt
+*******************************************************************************/
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    vTaskEnterCritical();
+    return 0u;
+}
+
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    (void)savedIntrStatus;
+    vTaskExitCritical();
+}
+
+uint32_t __get_IPSR(void)
+{
+    return 0u;
+}
+
+void ble_sim_assert(const char *file, int line)
+{
+    fprintf(stderr, "ble_host_rtos: assert %s:%d\n", file, line);
+    abort();
+}
+
+/* [] END OF FILE */
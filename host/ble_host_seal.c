@@ -0,0 +1,454 @@
+/***************************************************************************//**
+* \file ble_host_seal.c
+* \version 1.0
+*
+* \brief
+* The benchmark of the sealing backends of ble_seal.c on the host:
+*
+*   ble_host_seal [count]
+*
+* Each backend, the software AES and the crypto block (modelled by ble_sim.c
+* with the same software AES), is first checked with the FIPS-197 block
+* vector. Then, for each payload size, count response payloads are sealed
+* with ble_seal_encrypt() and count command payloads are opened with
+* ble_seal_decrypt(), in place in a pooled buffer, as in the transmit and
+* receive paths.
+*
+* The peer side is a separate CCM over the software block cipher: it opens
+* each sealed response and seals each command, so the payloads, the MICs and
+* the nonce counters of both directions are checked against an independent
+* implementation. The ciphertext of each backend is compared with the one of
+* the first backend.
+*
+* The program prints one JSON line: for each backend and size the host time
+* per payload and the rate of both directions, and the key loads and blocks
+* of the crypto block per payload. On the device the crypto block runs the
+* blocks in hardware, so its host time only shows the cost of the backend
+* calls; the blocks and key loads per payload are what differ in cycles.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "ble_host.h"
+#include "ble_pool.h"
+#include "ble_seal.h"
+
+/**
+ * @brief The payloads sealed and opened for each backend and size by
+ *        default.
+ */
+#define BLE_HOST_SEAL_COUNT                 (2000u)
+
+/**
+ * @brief The AES block and the CCM fields of the peer, see RFC 3610: no
+ *        additional data, a 2-byte length field.
+ */
+#define BLE_HOST_SEAL_BLOCK_LEN             (16u)
+#define BLE_HOST_SEAL_CCM_L                 (2u)
+#define BLE_HOST_SEAL_CCM_FLAGS             ((((BLE_SEAL_MIC_LEN - 2u) / 2u) << 3u) | (BLE_HOST_SEAL_CCM_L - 1u))
+
+/**
+ * @brief The largest payload: a notification at the default MTU with the
+ *        MIC appended.
+ */
+#define BLE_HOST_SEAL_LEN_MAX               (CY_BLE_GATT_MTU - 3u - BLE_SEAL_MIC_LEN)
+
+/**
+ * @brief The payload sizes of the benchmark.
+ */
+static const uint16_t ble_host_seal_lens[] = { 20u, 64u, 128u, BLE_HOST_SEAL_LEN_MAX };
+
+#define BLE_HOST_SEAL_LEN_NUM               (sizeof(ble_host_seal_lens) / sizeof(ble_host_seal_lens[0]))
+
+/**
+ * @brief The backends compared, the first one is the reference.
+ */
+static const ble_seal_backend_t *const ble_host_seal_backends[] =
+{
+    &ble_seal_backend_soft,
+#if defined(CY_IP_MXCRYPTO)
+    &ble_seal_backend_crypto,
+#endif
+};
+
+#define BLE_HOST_SEAL_BACKEND_NUM           (sizeof(ble_host_seal_backends) / sizeof(ble_host_seal_backends[0]))
+
+/**
+ * @brief The session key and IV of the benchmark.
+ */
+static const uint8_t ble_host_seal_key[BLE_SEAL_KEY_LEN] =
+{
+    0x2bu, 0x7eu, 0x15u, 0x16u, 0x28u, 0xaeu, 0xd2u, 0xa6u, 0xabu, 0xf7u, 0x15u, 0x88u, 0x09u, 0xcfu, 0x4fu, 0x3cu
+};
+static const uint8_t ble_host_seal_iv[BLE_SEAL_IV_LEN] =
+{
+    0x10u, 0x32u, 0x54u, 0x76u, 0x98u, 0xbau, 0xdcu, 0xfeu
+};
+
+/**
+ * @brief The result of a backend and a payload size.
+ */
+typedef struct
+{
+    bool     kat;                       /* The FIPS-197 block vector passed */
+    bool     match;                     /* The ciphertext is the one of the reference backend */
+    uint32_t peer_errors;               /* The payloads the peer CCM did not agree with */
+    uint64_t seal_ns;
+    uint64_t open_ns;
+    uint32_t loads;                     /* The crypto block key loads */
+    uint32_t blocks;                    /* The crypto block blocks */
+} ble_host_seal_result_t;
+
+/**
+ * @brief The benchmark state.
+ */
+static struct
+{
+    ble_seal_ctx_t peer;                /* The key context of the peer CCM */
+    uint32_t count;
+    uint8_t  ref[BLE_HOST_SEAL_LEN_NUM][BLE_HOST_SEAL_LEN_MAX + BLE_SEAL_MIC_LEN];
+    uint8_t  plain[BLE_HOST_SEAL_LEN_MAX];
+    ble_host_seal_result_t results[BLE_HOST_SEAL_BACKEND_NUM][BLE_HOST_SEAL_LEN_NUM];
+} ble_host_seal;
+
+
+/*******************************************************************************
+* Function Name: ble_host_seal_echo_handler
+****************************************************************************//**
+*
+* The echo command handler of the command table, the benchmark sends no
+* command.
+*
+* \param req      The request payload.
+*
+* \param req_len  The request payload size.
+*
+* \param res      The response payload buffer.
+*
+* \param res_len  The response payload size.
+*
+* \return The response status.
+*
+*******************************************************************************/
+static uint8_t ble_host_seal_echo_handler(const uint8_t *req, uint16_t req_len, uint8_t *res, uint16_t *res_len)
+{
+    memcpy(res, req, req_len);
+    *res_len = req_len;
+    return BLE_CUSTOM_CMD_STATUS_OK;
+}
+
+/**
+ * @brief The command table.
+ */
+static const ble_custom_cmd_desc_t ble_host_seal_cmd_table[] =
+{
+    {
+        .opcode      = BLE_HOST_OPCODE_ECHO,
+        .flags       = BLE_CUSTOM_CMD_FLAG_ISR_SAFE,
+        .max_req_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .max_res_len = BLE_CUSTOM_CMD_RES_PAYLOAD_MAX,
+        .handler     = ble_host_seal_echo_handler
+    },
+};
+
+/*******************************************************************************
+* Function Name: ble_host_seal_kat
+****************************************************************************//**
+*
+* Checks the block cipher of a backend with the AES-128 vector of FIPS-197
+* appendix C.1.
+*
+* \param backend The backend.
+*
+* \return true if the ciphertext is the expected one.
+*
+*******************************************************************************/
+static bool ble_host_seal_kat(const ble_seal_backend_t *backend)
+{
+    static const uint8_t key[BLE_SEAL_KEY_LEN] =
+    {
+        0x00u, 0x01u, 0x02u, 0x03u, 0x04u, 0x05u, 0x06u, 0x07u, 0x08u, 0x09u, 0x0au, 0x0bu, 0x0cu, 0x0du, 0x0eu, 0x0fu
+    };
+    static const uint8_t plain[BLE_HOST_SEAL_BLOCK_LEN] =
+    {
+        0x00u, 0x11u, 0x22u, 0x33u, 0x44u, 0x55u, 0x66u, 0x77u, 0x88u, 0x99u, 0xaau, 0xbbu, 0xccu, 0xddu, 0xeeu, 0xffu
+    };
+    static const uint8_t cipher[BLE_HOST_SEAL_BLOCK_LEN] =
+    {
+        0x69u, 0xc4u, 0xe0u, 0xd8u, 0x6au, 0x7bu, 0x04u, 0x30u, 0xd8u, 0xcdu, 0xb7u, 0x80u, 0x70u, 0xb4u, 0xc5u, 0x5au
+    };
+    ble_seal_ctx_t ctx;
+    uint8_t out[BLE_HOST_SEAL_BLOCK_LEN];
+
+    if((CY_BLE_SUCCESS != backend->set_key(&ctx, key)) || \
+       ((backend->load != NULL) && (CY_BLE_SUCCESS != backend->load(&ctx)))) {
+        return false;
+    }
+    backend->encrypt(&ctx, plain, out);
+    if(backend->unload != NULL) {
+        backend->unload();
+    }
+    return 0 == memcmp(out, cipher, sizeof(out));
+}
+
+/*******************************************************************************
+* Function Name: ble_host_seal_peer_ccm
+****************************************************************************//**
+*
+* The CCM of the peer: CBC-MAC over the plaintext, CTR encryption, the MIC
+* encrypted with the counter block 0.
+*
+* \param counter The packet counter of the nonce.
+*
+* \param dir The direction of the nonce, see BLE_SEAL_DIR_xxx.
+*
+* \param buf The payload, it is encrypted or decrypted in place.
+*
+* \param len The payload size.
+*
+* \param mic The MIC of BLE_SEAL_MIC_LEN bytes is returned here.
+*
+* \param decrypt true to decrypt the payload.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_seal_peer_ccm(uint32_t counter, uint8_t dir, uint8_t *buf, uint16_t len, uint8_t *mic, \
+                                   bool decrypt)
+{
+    uint8_t nonce[BLE_SEAL_NONCE_LEN];
+    uint8_t x[BLE_HOST_SEAL_BLOCK_LEN];
+    uint8_t a[BLE_HOST_SEAL_BLOCK_LEN];
+    uint8_t s[BLE_HOST_SEAL_BLOCK_LEN];
+    uint16_t block;
+    uint16_t pos;
+    uint16_t i;
+
+    nonce[0] = (uint8_t)counter;
+    nonce[1] = (uint8_t)(counter >> 8u);
+    nonce[2] = (uint8_t)(counter >> 16u);
+    nonce[3] = (uint8_t)(counter >> 24u);
+    nonce[4] = dir;
+    memcpy(&nonce[5], ble_host_seal_iv, BLE_SEAL_IV_LEN);
+
+    x[0] = (uint8_t)BLE_HOST_SEAL_CCM_FLAGS;
+    memcpy(&x[1], nonce, BLE_SEAL_NONCE_LEN);
+    x[14] = (uint8_t)(len >> 8u);
+    x[15] = (uint8_t)len;
+    ble_seal_backend_soft.encrypt(&ble_host_seal.peer, x, x);
+    a[0] = (uint8_t)(BLE_HOST_SEAL_CCM_L - 1u);
+    memcpy(&a[1], nonce, BLE_SEAL_NONCE_LEN);
+    for(pos = 0u, block = 1u; pos < len; pos += BLE_HOST_SEAL_BLOCK_LEN, block++) {
+        a[14] = (uint8_t)(block >> 8u);
+        a[15] = (uint8_t)block;
+        ble_seal_backend_soft.encrypt(&ble_host_seal.peer, a, s);
+        for(i = 0u; (i < BLE_HOST_SEAL_BLOCK_LEN) && ((pos + i) < len); i++) {
+            if(decrypt) {
+                buf[pos + i] ^= s[i];
+            }
+            x[i] ^= buf[pos + i];
+            if(!decrypt) {
+                buf[pos + i] ^= s[i];
+            }
+        }
+        ble_seal_backend_soft.encrypt(&ble_host_seal.peer, x, x);
+    }
+    a[14] = 0u;
+    a[15] = 0u;
+    ble_seal_backend_soft.encrypt(&ble_host_seal.peer, a, s);
+    for(i = 0u; i < BLE_SEAL_MIC_LEN; i++) {
+        mic[i] = x[i] ^ s[i];
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_seal_fill
+****************************************************************************//**
+*
+* Fills the plaintext of a payload.
+*
+* \param n The payload number.
+*
+* \param len The payload size.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_host_seal_fill(uint32_t n, uint16_t len)
+{
+    uint16_t i;
+
+    for(i = 0u; i < len; i++) {
+        ble_host_seal.plain[i] = (uint8_t)(n + (i * 7u));
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_host_seal_run
+****************************************************************************//**
+*
+* Seals and opens the payloads of a size with a backend, see the file
+* header.
+*
+* \param backend The backend index.
+*
+* \param size The payload size index.
+*
+* \param buf The pooled buffer, it holds a payload and its MIC.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_host_seal_run(uint32_t backend, uint32_t size, uint8_t *buf)
+{
+    ble_host_seal_result_t *result = &ble_host_seal.results[backend][size];
+    cy_en_ble_api_result_t apiResult;
+    ble_sim_stats_t stats;
+    uint16_t len = ble_host_seal_lens[size];
+    uint8_t mic[BLE_SEAL_MIC_LEN];
+    uint64_t start;
+    uint32_t n;
+
+    if((CY_BLE_SUCCESS != (apiResult = ble_seal_set_backend(ble_host_seal_backends[backend]))) || \
+       (CY_BLE_SUCCESS != (apiResult = ble_seal_start(BLE_HOST_CONN_ID, ble_host_seal_key, ble_host_seal_iv)))) {
+        return apiResult;
+    }
+    ble_sim_reset_stats();
+    /* The responses: sealed by the device, opened by the peer */
+    for(n = 0u; n < ble_host_seal.count; n++) {
+        ble_host_seal_fill(n, len);
+        memcpy(buf, ble_host_seal.plain, len);
+        start = ble_sim_cpu_ns();
+        apiResult = ble_seal_encrypt(BLE_HOST_CONN_ID, buf, len);
+        result->seal_ns += ble_sim_cpu_ns() - start;
+        if(apiResult != CY_BLE_SUCCESS) {
+            return apiResult;
+        }
+        if(n == 0u) {
+            if(backend == 0u) {
+                memcpy(ble_host_seal.ref[size], buf, len + BLE_SEAL_MIC_LEN);
+            }
+            result->match = 0 == memcmp(ble_host_seal.ref[size], buf, len + BLE_SEAL_MIC_LEN);
+        }
+        ble_host_seal_peer_ccm(n, BLE_SEAL_DIR_TX, buf, len, mic, true);
+        if((0 != memcmp(buf, ble_host_seal.plain, len)) || (0 != memcmp(&buf[len], mic, sizeof(mic)))) {
+            result->peer_errors++;
+        }
+    }
+    ble_sim_get_stats(&stats);
+    result->loads = stats.crypto_loads;
+    result->blocks = stats.crypto_blocks;
+    /* The commands: sealed by the peer, opened by the device */
+    for(n = 0u; n < ble_host_seal.count; n++) {
+        ble_host_seal_fill(n, len);
+        memcpy(buf, ble_host_seal.plain, len);
+        ble_host_seal_peer_ccm(n, BLE_SEAL_DIR_RX, buf, len, &buf[len], false);
+        start = ble_sim_cpu_ns();
+        apiResult = ble_seal_decrypt(BLE_HOST_CONN_ID, buf, len + BLE_SEAL_MIC_LEN);
+        result->open_ns += ble_sim_cpu_ns() - start;
+        if((apiResult != CY_BLE_SUCCESS) || (0 != memcmp(buf, ble_host_seal.plain, len))) {
+            result->peer_errors++;
+        }
+    }
+    ble_seal_stop(BLE_HOST_CONN_ID);
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_host_seal_print
+****************************************************************************//**
+*
+* Prints the JSON report.
+*
+* \param cpu_ns The host time of the benchmark.
+*
+* \return true if all the checks passed.
+*
+*******************************************************************************/
+static bool ble_host_seal_print(uint64_t cpu_ns)
+{
+    const ble_host_seal_result_t *result;
+    FILE *report = ble_host_report();
+    uint64_t bytes;
+    uint32_t count = ble_host_seal.count;
+    uint32_t backend;
+    uint32_t size;
+    bool passed = true;
+
+    fprintf(report, "{\"seal\":\"ble_host\",\"mic_len\":%u,\"count\":%lu,\"results\":[", (unsigned)BLE_SEAL_MIC_LEN, \
+        (unsigned long)count);
+    for(backend = 0u; backend < BLE_HOST_SEAL_BACKEND_NUM; backend++) {
+        for(size = 0u; size < BLE_HOST_SEAL_LEN_NUM; size++) {
+            result = &ble_host_seal.results[backend][size];
+            bytes = (uint64_t)ble_host_seal_lens[size] * count * 1000000000u;
+            fprintf(report, "%s{\"backend\":\"%s\",\"len\":%u,\"kat\":%s,\"match\":%s,\"peer_errors\":%lu," \
+                "\"seal_ns\":%llu,\"open_ns\":%llu,\"seal_kBps\":%llu,\"open_kBps\":%llu," \
+                "\"loads_per_payload\":%lu,\"blocks_per_payload\":%lu}", ((backend | size) == 0u) ? "" : ",", \
+                ble_host_seal_backends[backend]->name, (unsigned)ble_host_seal_lens[size], \
+                result->kat ? "true" : "false", result->match ? "true" : "false", \
+                (unsigned long)result->peer_errors, (unsigned long long)(result->seal_ns / count), \
+                (unsigned long long)(result->open_ns / count), \
+                (unsigned long long)((result->seal_ns != 0u) ? (bytes / (result->seal_ns * 1024u)) : 0u), \
+                (unsigned long long)((result->open_ns != 0u) ? (bytes / (result->open_ns * 1024u)) : 0u), \
+                (unsigned long)(result->loads / count), (unsigned long)(result->blocks / count));
+            passed = passed && result->kat && result->match && (result->peer_errors == 0u);
+        }
+    }
+    fprintf(report, "],\"cpu_ns\":%llu}\n", (unsigned long long)cpu_ns);
+    (void)fflush(report);
+    return passed;
+}
+
+/*******************************************************************************
+* Function Name: main
+****************************************************************************//**
+*
+* Runs the benchmark, see the file header.
+*
+* \param argc The number of arguments.
+*
+* \param argv The arguments: the number of payloads.
+*
+* \return 0 if all the checks passed.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    uint8_t *buf;
+    uint64_t cpu_ns;
+    uint32_t backend;
+    uint32_t size;
+    bool kat;
+
+    ble_host_seal.count = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BLE_HOST_SEAL_COUNT;
+    if((ble_host_seal.count == 0u) || \
+       (CY_BLE_SUCCESS != ble_host_init(NULL, NULL, ble_host_seal_cmd_table, \
+                                        sizeof(ble_host_seal_cmd_table) / sizeof(ble_host_seal_cmd_table[0]))) || \
+       (CY_BLE_SUCCESS != ble_seal_backend_soft.set_key(&ble_host_seal.peer, ble_host_seal_key)) || \
+       (NULL == (buf = ble_pool_alloc(BLE_HOST_SEAL_LEN_MAX + BLE_SEAL_MIC_LEN)))) {
+        fprintf(stderr, "ble_host_seal: the initialization failed\n");
+        return EXIT_FAILURE;
+    }
+    cpu_ns = ble_sim_cpu_ns();
+    for(backend = 0u; backend < BLE_HOST_SEAL_BACKEND_NUM; backend++) {
+        kat = ble_host_seal_kat(ble_host_seal_backends[backend]);
+        for(size = 0u; size < BLE_HOST_SEAL_LEN_NUM; size++) {
+            ble_host_seal.results[backend][size].kat = kat;
+            if(CY_BLE_SUCCESS != ble_host_seal_run(backend, size, buf)) {
+                ble_host_seal.results[backend][size].peer_errors++;
+            }
+        }
+    }
+    cpu_ns = ble_sim_cpu_ns() - cpu_ns;
+    ble_pool_free(buf);
+    return ble_host_seal_print(cpu_ns) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
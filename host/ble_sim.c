@@ -0,0 +1,1479 @@
+/***************************************************************************//**
+* \file ble_sim.c
+* \version 1.0
+*
+* \brief
+* Source file for the simulated BLE stack of the host build, see ble_sim.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ble_sim.h"
+#include "ble_time.h"
+#include "ble_seal.h"
+
+/**
+ * @brief The SysPm callbacks kept for Cy_SysPm_DeepSleep().
+ */
+#define BLE_SIM_SYSPM_CALLBACKS             (8u)
+
+/**
+ * @brief The values buffered by the stack of a connection at most.
+ */
+#define BLE_SIM_TX_BUFFERS_MAX              (32u)
+
+/**
+ * @brief The MTU of a new connection before the exchange.
+ */
+#define BLE_SIM_DEFAULT_MTU                 (23u)
+
+/**
+ * @brief A stack event waiting for Cy_BLE_ProcessEvents(). The value of a
+ *        write event is kept apart, its parameters point to it.
+ */
+typedef struct
+{
+    uint32_t code;
+    bool     has_value;
+    union
+    {
+        uint8_t  bytes[BLE_SIM_EVENT_PARAM_LEN];
+        uint64_t align;
+    } param;
+    uint8_t  value[CY_BLE_GATT_MTU];
+} ble_sim_event_t;
+
+/**
+ * @brief A write of the peer waiting for a connection event.
+ */
+typedef struct
+{
+    uint16_t handle;
+    uint16_t len;
+    bool     command;
+    uint8_t  data[CY_BLE_GATT_MTU - CY_BLE_GATT_WRITE_HEADER_LEN];
+} ble_sim_write_t;
+
+/**
+ * @brief A value buffered by the stack.
+ */
+typedef struct
+{
+    bool     indication;
+    uint16_t len;
+    uint8_t  data[CY_BLE_GATT_MTU - CY_BLE_GATT_WRITE_HEADER_LEN];
+} ble_sim_value_t;
+
+/**
+ * @brief The state of a connection, indexed by attId.
+ */
+typedef struct
+{
+    bool     connected;
+    cy_stc_ble_conn_handle_t handle;
+    uint16_t mtu;
+    uint16_t cccd;
+    bool     busy;                      /* The stack buffers are full */
+    bool     req_pending;               /* A write request waits for its response */
+    bool     ind_pending;               /* An indication waits for its confirmation */
+    bool     cnf_due;                   /* The indication is confirmed at the next event */
+    ble_sim_value_t tx[BLE_SIM_TX_BUFFERS_MAX];
+    uint32_t tx_head;
+    uint32_t tx_count;
+    ble_sim_write_t peer[BLE_SIM_PEER_DEPTH];
+    uint32_t peer_head;
+    uint32_t peer_count;
+} ble_sim_conn_t;
+
+/**
+ * @brief The simulation state.
+ */
+static struct
+{
+    ble_sim_link_t link;
+    ble_sim_rx_t rx;
+    ble_sim_wake_t wake;
+    ble_sim_dispatch_t dispatch;
+    uint64_t now_us;
+    uint64_t wake_us;                   /* The wakeup of ble_sim_wake_at(), 0 if none */
+    cy_ble_callback_t callback;
+    cy_ble_app_notify_callback_t host_callback;
+    cy_en_ble_state_t state;
+    cy_en_ble_adv_state_t adv_state;
+    ble_sim_conn_t conns[CY_BLE_CONN_COUNT];
+    ble_sim_event_t events[BLE_SIM_EVENT_DEPTH];
+    uint32_t event_head;
+    uint32_t event_count;
+    uint8_t  cmd_value[CY_BLE_GATT_DB_MAX_VALUE_LEN];
+    uint16_t cmd_len;
+    /* The LPTimer alarm */
+    cyhal_lptimer_event_callback_t alarm_callback;
+    void     *alarm_arg;
+    uint64_t alarm_us;
+    bool     alarm_enabled;
+    /* The SysPm callbacks */
+    cy_stc_syspm_callback_t *syspm[BLE_SIM_SYSPM_CALLBACKS];
+    uint32_t syspm_num;
+    uint32_t critical;
+    ble_sim_stats_t stats;
+} ble_sim;
+
+/*******************************************************************************
+* The objects of the PDL, the HAL and the generated configuration
+*******************************************************************************/
+uint32_t SystemCoreClock = 100000000uL;
+static DWT_Type ble_sim_dwt_regs;
+static CRYPTO_Type ble_sim_crypto_regs;
+static ble_seal_ctx_t ble_sim_crypto_key;   /* The key loaded in the crypto block */
+static CoreDebug_Type ble_sim_core_debug;
+CoreDebug_Type *CoreDebug = &ble_sim_core_debug;
+cyhal_uart_t cy_retarget_io_uart_obj = { .base = NULL };
+
+/* The limits of the main stack of the linker script, see ble_ram.c. The
+ * stack pointer reads 0 on the host, so no stack is sampled. */
+uint32_t __StackLimit;
+uint32_t __StackTop;
+
+static cy_stc_ble_hw_config_t ble_sim_hw_config;
+static cy_stc_ble_gapp_disc_data_t ble_sim_adv_data;
+static cy_stc_ble_gapp_scan_rsp_data_t ble_sim_scan_rsp_data;
+static cy_stc_ble_gapp_disc_mode_info_t ble_sim_disc_mode_info[1] =
+{
+    { .discMode = 0u, .advParam = NULL, .advData = &ble_sim_adv_data, .scanRspData = &ble_sim_scan_rsp_data, \
+      .advTo = 0u }
+};
+cy_stc_ble_config_t cy_ble_config = { .hw = &ble_sim_hw_config, .discoveryModeInfo = ble_sim_disc_mode_info };
+static cy_stc_ble_gap_auth_info_t ble_sim_auth_info[1] =
+{
+    { .bdHandle = 0u, .security = CY_BLE_GAP_SEC_MODE_1 | CY_BLE_GAP_SEC_LEVEL_1, .bonding = CY_BLE_BONDING_YES, \
+      .ekeySize = 16u, .authErr = 0u, .pairingProperties = 0u }
+};
+static cy_stc_ble_config_ptr_t ble_sim_config_ptr = { .authInfo = ble_sim_auth_info };
+cy_stc_ble_config_ptr_t *cy_ble_configPtr = &ble_sim_config_ptr;
+cy_stc_ble_gap_bd_addr_t cy_ble_deviceAddress = { .type = 0u, .bdAddr = { 0x00u, 0xA0u, 0x50u, 0x00u, 0x00u, 0x01u } };
+volatile uint8_t cy_ble_pendingFlashWrite = 0u;
+
+
+/*******************************************************************************
+* Function Name: ble_sim_get_conn
+****************************************************************************//**
+*
+* Gets the state of a connected connection.
+*
+* \param attId The connection ID.
+*
+* \return The connection state, NULL if it is not connected.
+*
+*******************************************************************************/
+static ble_sim_conn_t *ble_sim_get_conn(uint8_t attId)
+{
+    if((attId >= CY_BLE_CONN_COUNT) || !ble_sim.conns[attId].connected) {
+        return NULL;
+    }
+    return &ble_sim.conns[attId];
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_event_alloc
+****************************************************************************//**
+*
+* Takes the next entry of the event queue, the host callback is called so
+* that the run loop processes it.
+*
+* \param code The event code.
+*
+* \return The entry, NULL if the queue is full.
+*
+*******************************************************************************/
+static ble_sim_event_t *ble_sim_event_alloc(uint32_t code)
+{
+    ble_sim_event_t *event;
+
+    if(ble_sim.event_count == BLE_SIM_EVENT_DEPTH) {
+        return NULL;
+    }
+    event = &ble_sim.events[(ble_sim.event_head + ble_sim.event_count) % BLE_SIM_EVENT_DEPTH];
+    ble_sim.event_count++;
+    if(ble_sim.event_count > ble_sim.stats.event_queue_max) {
+        ble_sim.stats.event_queue_max = ble_sim.event_count;
+    }
+    memset(&event->param, 0, sizeof(event->param));
+    event->code = code;
+    event->has_value = false;
+    if(ble_sim.host_callback != NULL) {
+        ble_sim.host_callback();
+    }
+    return event;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_event
+****************************************************************************//**
+*
+* Queues a stack event, the parameters are copied.
+*
+* \param event The event code.
+*
+* \param param The event parameters, NULL if none.
+*
+* \param len The parameter bytes, up to BLE_SIM_EVENT_PARAM_LEN.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_sim_event(uint32_t event, const void *param, uint32_t len)
+{
+    ble_sim_event_t *entry;
+
+    if(len > BLE_SIM_EVENT_PARAM_LEN) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(NULL == (entry = ble_sim_event_alloc(event))) {
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    if(param != NULL) {
+        memcpy(entry->param.bytes, param, len);
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_event_write
+****************************************************************************//**
+*
+* Queues a write event, CY_BLE_EVT_GATTS_WRITE_REQ or
+* CY_BLE_EVT_GATTS_WRITE_CMD_REQ, the value is copied.
+*
+* \param event The event code.
+*
+* \param connHandle The connection handle.
+*
+* \param handle The attribute handle.
+*
+* \param val The written value.
+*
+* \param len The value size.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_sim_event_write(uint32_t event, cy_stc_ble_conn_handle_t connHandle, \
+                                           uint16_t handle, const void *val, uint16_t len)
+{
+    ble_sim_event_t *entry;
+    cy_stc_ble_gatt_write_param_t *param;
+
+    if(len > sizeof(entry->value)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(NULL == (entry = ble_sim_event_alloc(event))) {
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    param = (cy_stc_ble_gatt_write_param_t *)entry->param.bytes;
+    param->connHandle = connHandle;
+    param->handleValPair.attrHandle = handle;
+    param->handleValPair.value.len = len;
+    param->handleValPair.value.actualLen = len;
+    memcpy(entry->value, val, len);
+    entry->has_value = true;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_has_work
+****************************************************************************//**
+*
+* Checks if a link has traffic for the next connection event.
+*
+* \param none.
+*
+* \return true if a connection event is needed.
+*
+*******************************************************************************/
+static bool ble_sim_has_work(void)
+{
+    const ble_sim_conn_t *conn;
+    uint32_t i;
+
+    for(i = 0u; i < CY_BLE_CONN_COUNT; i++) {
+        conn = &ble_sim.conns[i];
+        if(!conn->connected) {
+            continue;
+        }
+        if((conn->tx_count != 0u) || conn->cnf_due) {
+            return true;
+        }
+        if((conn->peer_count != 0u) && (conn->peer[conn->peer_head].command || !conn->req_pending)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_conn_event
+****************************************************************************//**
+*
+* Runs a connection event of each link: the confirmation of the indication
+* of the previous event, the writes of the peer, then the values buffered by
+* the stack. A write is held back while the event queue is full, as the link
+* layer does not acknowledge it.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_sim_conn_event(void)
+{
+    ble_sim_conn_t *conn;
+    ble_sim_write_t *write;
+    ble_sim_value_t *value;
+    uint8_t state;
+    uint32_t n;
+    uint32_t i;
+
+    ble_sim.stats.conn_events++;
+    for(i = 0u; i < CY_BLE_CONN_COUNT; i++) {
+        conn = &ble_sim.conns[i];
+        if(!conn->connected) {
+            continue;
+        }
+        if(conn->cnf_due) {
+            conn->cnf_due = false;
+            conn->ind_pending = false;
+            ble_sim.stats.confirmations++;
+            (void)ble_sim_event(CY_BLE_EVT_GATTS_HANDLE_VALUE_CNF, &conn->handle, sizeof(conn->handle));
+        }
+        for(n = 0u; (n < ble_sim.link.packets_per_event) && (conn->peer_count != 0u); n++) {
+            write = &conn->peer[conn->peer_head];
+            if((!write->command && conn->req_pending) || (ble_sim.event_count >= (BLE_SIM_EVENT_DEPTH - 2u))) {
+                break;
+            }
+            (void)ble_sim_event_write(write->command ? CY_BLE_EVT_GATTS_WRITE_CMD_REQ : CY_BLE_EVT_GATTS_WRITE_REQ, \
+                                      conn->handle, write->handle, write->data, write->len);
+            if(write->command) {
+                ble_sim.stats.write_cmds++;
+            } else {
+                ble_sim.stats.write_reqs++;
+                conn->req_pending = true;
+            }
+            ble_sim.stats.rx_bytes += write->len;
+            conn->peer_head = (conn->peer_head + 1u) % BLE_SIM_PEER_DEPTH;
+            conn->peer_count--;
+        }
+        for(n = 0u; (n < ble_sim.link.packets_per_event) && (conn->tx_count != 0u); n++) {
+            value = &conn->tx[conn->tx_head];
+            if(value->indication) {
+                ble_sim.stats.indications++;
+                conn->cnf_due = true;
+            } else {
+                ble_sim.stats.notifications++;
+            }
+            ble_sim.stats.tx_bytes += value->len;
+            if(ble_sim.rx != NULL) {
+                ble_sim.rx(conn->handle.attId, value->indication, value->data, value->len);
+            }
+            conn->tx_head = (conn->tx_head + 1u) % ble_sim.link.tx_buffers;
+            conn->tx_count--;
+        }
+        if(conn->busy && (conn->tx_count < ble_sim.link.tx_buffers)) {
+            conn->busy = false;
+            state = CY_BLE_STACK_STATE_FREE;
+            (void)ble_sim_event(CY_BLE_EVT_STACK_BUSY_STATUS, &state, sizeof(state));
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_next_conn_event
+****************************************************************************//**
+*
+* Gets the time of the next connection event, the events of all links are
+* anchored on the multiples of the interval.
+*
+* \param none.
+*
+* \return The time in us.
+*
+*******************************************************************************/
+static uint64_t ble_sim_next_conn_event(void)
+{
+    return ((ble_sim.now_us / ble_sim.link.interval_us) + 1u) * ble_sim.link.interval_us;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_sleep
+****************************************************************************//**
+*
+* The sleep of the CPU: the time moves on to the next connection event with
+* traffic, to the LPTimer alarm or to the wakeup of ble_sim_wake_at(),
+* whichever comes first, or by one interval if nothing is scheduled. The
+* wakeup callback is called after.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_sim_sleep(void)
+{
+    uint64_t link = ble_sim_has_work() ? ble_sim_next_conn_event() : UINT64_MAX;
+    uint64_t alarm = ble_sim.alarm_enabled ? ble_sim.alarm_us : UINT64_MAX;
+    uint64_t wake = (ble_sim.wake_us != 0u) ? ble_sim.wake_us : UINT64_MAX;
+    uint64_t next = (link < alarm) ? link : alarm;
+
+    ble_sim.stats.sleeps++;
+    if(wake < next) {
+        next = wake;
+    }
+    if(next == UINT64_MAX) {
+        next = ble_sim.now_us + ble_sim.link.interval_us;
+    }
+    if(next > ble_sim.now_us) {
+        ble_sim.now_us = next;
+    }
+    if(link <= ble_sim.now_us) {
+        ble_sim_conn_event();
+    }
+    if(ble_sim.alarm_enabled && (ble_sim.alarm_us <= ble_sim.now_us)) {
+        ble_sim.alarm_enabled = false;
+        if(ble_sim.alarm_callback != NULL) {
+            ble_sim.alarm_callback(ble_sim.alarm_arg, CYHAL_LPTIMER_COMPARE_MATCH);
+        }
+    }
+    if(wake <= ble_sim.now_us) {
+        ble_sim.wake_us = 0u;
+    }
+    if(ble_sim.wake != NULL) {
+        ble_sim.wake();
+    }
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_value_queue
+****************************************************************************//**
+*
+* Buffers a notification or an indication for the next connection events.
+*
+* \param connHandle The connection handle.
+*
+* \param pair The attribute handle and the value.
+*
+* \param indication true for an indication.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+static cy_en_ble_api_result_t ble_sim_value_queue(const cy_stc_ble_conn_handle_t *connHandle, \
+                                                  const cy_stc_ble_gatt_handle_value_pair_t *pair, bool indication)
+{
+    ble_sim_conn_t *conn;
+    ble_sim_value_t *value;
+    uint8_t state;
+
+    if((connHandle == NULL) || (pair == NULL)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(NULL == (conn = ble_sim_get_conn(connHandle->attId))) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(pair->value.len > (conn->mtu - CY_BLE_GATT_WRITE_HEADER_LEN)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(0u == (conn->cccd & (indication ? 0x02u : 0x01u))) {
+        return indication ? CY_BLE_ERROR_IND_DISABLED : CY_BLE_ERROR_NTF_DISABLED;
+    }
+    if(conn->busy || (indication && conn->ind_pending)) {
+        ble_sim.stats.rejected++;
+        return CY_BLE_ERROR_INVALID_OPERATION;
+    }
+    value = &conn->tx[(conn->tx_head + conn->tx_count) % ble_sim.link.tx_buffers];
+    value->indication = indication;
+    value->len = pair->value.len;
+    memcpy(value->data, pair->value.val, pair->value.len);
+    conn->tx_count++;
+    if(conn->tx_count > ble_sim.stats.tx_queue_max) {
+        ble_sim.stats.tx_queue_max = conn->tx_count;
+    }
+    if(indication) {
+        conn->ind_pending = true;
+    }
+    if(conn->tx_count == ble_sim.link.tx_buffers) {
+        conn->busy = true;
+        ble_sim.stats.busy++;
+        state = CY_BLE_STACK_STATE_BUSY;
+        (void)ble_sim_event(CY_BLE_EVT_STACK_BUSY_STATUS, &state, sizeof(state));
+    }
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_init
+****************************************************************************//**
+*
+* Initializes the simulation, it is called before ble_app_init().
+*
+* \param link The link parameters, NULL for the defaults.
+*
+* \param rx The receive callback of the peer, it can be NULL.
+*
+* \param wake The wakeup callback, it can be NULL.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_sim_init(const ble_sim_link_t *link, ble_sim_rx_t rx, ble_sim_wake_t wake)
+{
+    memset(&ble_sim, 0, sizeof(ble_sim));
+    ble_sim.link.interval_us = BLE_SIM_INTERVAL_US;
+    ble_sim.link.packets_per_event = BLE_SIM_PACKETS_PER_EVENT;
+    ble_sim.link.tx_buffers = BLE_SIM_TX_BUFFERS;
+    ble_sim.link.mtu = BLE_SIM_MTU;
+    if(link != NULL) {
+        ble_sim.link = *link;
+    }
+    if(ble_sim.link.interval_us == 0u) {
+        ble_sim.link.interval_us = BLE_SIM_INTERVAL_US;
+    }
+    if(ble_sim.link.packets_per_event == 0u) {
+        ble_sim.link.packets_per_event = 1u;
+    }
+    if((ble_sim.link.tx_buffers == 0u) || (ble_sim.link.tx_buffers > BLE_SIM_TX_BUFFERS_MAX)) {
+        ble_sim.link.tx_buffers = BLE_SIM_TX_BUFFERS_MAX;
+    }
+    if((ble_sim.link.mtu < BLE_SIM_DEFAULT_MTU) || (ble_sim.link.mtu > CY_BLE_GATT_MTU)) {
+        ble_sim.link.mtu = CY_BLE_GATT_MTU;
+    }
+    ble_sim.rx = rx;
+    ble_sim.wake = wake;
+    ble_sim.state = CY_BLE_STATE_STOPPED;
+    ble_sim.adv_state = CY_BLE_ADV_STATE_STOPPED;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_time_us
+****************************************************************************//**
+*
+* Gets the virtual time.
+*
+* \param none.
+*
+* \return The time in us since ble_sim_init().
+*
+*******************************************************************************/
+uint64_t ble_sim_time_us(void)
+{
+    return ble_sim.now_us;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_cpu_ns
+****************************************************************************//**
+*
+* Gets the host time, for the CPU time of the firmware.
+*
+* \param none.
+*
+* \return The monotonic time in ns.
+*
+*******************************************************************************/
+uint64_t ble_sim_cpu_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_wake_at
+****************************************************************************//**
+*
+* Schedules a wakeup of the run loop, the sleep ends at this time at the
+* latest.
+*
+* \param time_us The virtual time of the wakeup, 0 to cancel it.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_sim_wake_at(uint64_t time_us)
+{
+    ble_sim.wake_us = time_us;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_set_dispatch
+****************************************************************************//**
+*
+* Sets the dispatch callback, see ble_sim_dispatch_t.
+*
+* \param dispatch The callback, NULL to remove it.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_sim_set_dispatch(ble_sim_dispatch_t dispatch)
+{
+    ble_sim.dispatch = dispatch;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_connect
+****************************************************************************//**
+*
+* Connects the peer: the advertisement stops, then the connection, the GATT
+* connection and the MTU exchange events are queued.
+*
+* \param conn_id The connection ID, attId and bdHandle.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_sim_connect(uint8_t conn_id)
+{
+    ble_sim_conn_t *conn;
+    cy_stc_ble_gap_connected_param_t connected;
+    cy_stc_ble_gatt_xchg_mtu_param_t mtu;
+
+    if(conn_id >= CY_BLE_CONN_COUNT) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(ble_sim.state != CY_BLE_STATE_ON) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    conn = &ble_sim.conns[conn_id];
+    if(conn->connected) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    memset(conn, 0, sizeof(*conn));
+    conn->connected = true;
+    conn->handle.attId = conn_id;
+    conn->handle.bdHandle = conn_id;
+    conn->mtu = BLE_SIM_DEFAULT_MTU;
+    if(ble_sim.adv_state != CY_BLE_ADV_STATE_STOPPED) {
+        ble_sim.adv_state = CY_BLE_ADV_STATE_STOPPED;
+        (void)ble_sim_event(CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+    }
+    memset(&connected, 0, sizeof(connected));
+    connected.bdHandle = conn_id;
+    connected.connIntv = (uint16_t)(ble_sim.link.interval_us / 1250u);
+    connected.supervisionTO = 400u;
+    connected.role = 1u;
+    (void)ble_sim_event(CY_BLE_EVT_GAP_DEVICE_CONNECTED, &connected, sizeof(connected));
+    (void)ble_sim_event(CY_BLE_EVT_GATT_CONNECT_IND, &conn->handle, sizeof(conn->handle));
+    conn->mtu = ble_sim.link.mtu;
+    mtu.connHandle = conn->handle;
+    mtu.mtu = conn->mtu;
+    return ble_sim_event(CY_BLE_EVT_GATTS_XCNHG_MTU_REQ, &mtu, sizeof(mtu));
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_disconnect
+****************************************************************************//**
+*
+* Disconnects the peer, the values buffered by the stack and the writes of
+* the peer are dropped.
+*
+* \param conn_id The connection ID.
+*
+* \param reason The HCI reason code.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_sim_disconnect(uint8_t conn_id, uint8_t reason)
+{
+    ble_sim_conn_t *conn;
+    cy_stc_ble_conn_handle_t handle;
+    cy_stc_ble_gap_disconnect_param_t disconnected;
+
+    if(NULL == (conn = ble_sim_get_conn(conn_id))) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    handle = conn->handle;
+    memset(conn, 0, sizeof(*conn));
+    (void)ble_sim_event(CY_BLE_EVT_GATT_DISCONNECT_IND, &handle, sizeof(handle));
+    disconnected.bdHandle = handle.bdHandle;
+    disconnected.reason = reason;
+    disconnected.status = 0u;
+    return ble_sim_event(CY_BLE_EVT_GAP_DEVICE_DISCONNECTED, &disconnected, sizeof(disconnected));
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_peer_write
+****************************************************************************//**
+*
+* Queues a write of the peer, sent at the next connection events. A write
+* request waits for the response of the previous one.
+*
+* \param conn_id The connection ID.
+*
+* \param handle The attribute handle.
+*
+* \param val The value.
+*
+* \param len The value size, up to MTU - 3.
+*
+* \param command true for a write without response.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t ble_sim_peer_write(uint8_t conn_id, uint16_t handle, const void *val, uint16_t len, \
+                                          bool command)
+{
+    ble_sim_conn_t *conn;
+    ble_sim_write_t *write;
+
+    if(NULL == (conn = ble_sim_get_conn(conn_id))) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    if(len > (conn->mtu - CY_BLE_GATT_WRITE_HEADER_LEN)) {
+        return CY_BLE_ERROR_INVALID_PARAMETER;
+    }
+    if(conn->peer_count == BLE_SIM_PEER_DEPTH) {
+        return CY_BLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    write = &conn->peer[(conn->peer_head + conn->peer_count) % BLE_SIM_PEER_DEPTH];
+    write->handle = handle;
+    write->len = len;
+    write->command = command;
+    memcpy(write->data, val, len);
+    conn->peer_count++;
+    return CY_BLE_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_peer_pending
+****************************************************************************//**
+*
+* Gets the writes of the peer not delivered yet.
+*
+* \param conn_id The connection ID.
+*
+* \return The number of writes.
+*
+*******************************************************************************/
+uint32_t ble_sim_peer_pending(uint8_t conn_id)
+{
+    const ble_sim_conn_t *conn = ble_sim_get_conn(conn_id);
+
+    return (conn != NULL) ? conn->peer_count : 0u;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_tx_pending
+****************************************************************************//**
+*
+* Gets the values buffered by the stack and not received by the peer yet.
+*
+* \param conn_id The connection ID.
+*
+* \return The number of values.
+*
+*******************************************************************************/
+uint32_t ble_sim_tx_pending(uint8_t conn_id)
+{
+    const ble_sim_conn_t *conn = ble_sim_get_conn(conn_id);
+
+    return (conn != NULL) ? conn->tx_count : 0u;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_get_stats
+****************************************************************************//**
+*
+* Gets the simulation statistics.
+*
+* \param stats The statistics are copied here.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_sim_get_stats(ble_sim_stats_t *stats)
+{
+    *stats = ble_sim.stats;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_reset_stats
+****************************************************************************//**
+*
+* Clears the simulation statistics.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_sim_reset_stats(void)
+{
+    memset(&ble_sim.stats, 0, sizeof(ble_sim.stats));
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_assert
+****************************************************************************//**
+*
+* The failure of CY_ASSERT(), the program is aborted.
+*
+* \param file The source file.
+*
+* \param line The source line.
+*
+* \return none.
+*
+*******************************************************************************/
+void ble_sim_assert(const char *file, int line)
+{
+    fprintf(stderr, "CY_ASSERT failed at %s:%d\n", file, line);
+    abort();
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_dwt
+****************************************************************************//**
+*
+* Gets the DWT registers, the cycle counter is set from the host time at
+* SystemCoreClock.
+*
+* \param none.
+*
+* \return The registers.
+*
+*******************************************************************************/
+DWT_Type *ble_sim_dwt(void)
+{
+    ble_sim_dwt_regs.CYCCNT = (uint32_t)((ble_sim_cpu_ns() * (SystemCoreClock / 1000000u)) / 1000u);
+    return &ble_sim_dwt_regs;
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_crypto
+****************************************************************************//**
+*
+* Gets the crypto block registers, CTL is set while the block is enabled.
+*
+* \param none.
+*
+* \return The registers.
+*
+*******************************************************************************/
+CRYPTO_Type *ble_sim_crypto(void)
+{
+    return &ble_sim_crypto_regs;
+}
+
+/*******************************************************************************
+* Core, SysLib, SysInt
+*******************************************************************************/
+uint32_t __get_MSP(void)
+{
+    return 0u;
+}
+
+uint32_t __get_PSP(void)
+{
+    return 0u;
+}
+
+uint32_t __get_IPSR(void)
+{
+    return 0u;
+}
+
+void NVIC_SystemReset(void)
+{
+    fprintf(stderr, "NVIC_SystemReset\n");
+    exit(EXIT_FAILURE);
+}
+
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    return ble_sim.critical++;
+}
+
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    ble_sim.critical = savedIntrStatus;
+}
+
+uint32_t Cy_SysLib_GetResetReason(void)
+{
+    return 0u;
+}
+
+void Cy_SysLib_ClearResetReason(void)
+{
+}
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, void (*userIsr)(void))
+{
+    (void)config;
+    (void)userIsr;
+    return CY_SYSINT_SUCCESS;
+}
+
+/*******************************************************************************
+* Crypto: the AES of the block is the software AES of ble_seal.c
+*******************************************************************************/
+cy_en_crypto_status_t Cy_Crypto_Core_Enable(CRYPTO_Type *base)
+{
+    base->CTL = 1u;
+    return CY_CRYPTO_SUCCESS;
+}
+
+cy_en_crypto_status_t Cy_Crypto_Core_Disable(CRYPTO_Type *base)
+{
+    base->CTL = 0u;
+    return CY_CRYPTO_SUCCESS;
+}
+
+cy_en_crypto_status_t Cy_Crypto_Core_Aes_Init(CRYPTO_Type *base, uint8_t const *key, \
+                                              cy_en_crypto_aes_key_length_t keyLength, \
+                                              cy_stc_crypto_aes_state_t *aesState)
+{
+    if(base->CTL == 0u) {
+        return CY_CRYPTO_HW_NOT_ENABLED;
+    }
+    if((keyLength != CY_CRYPTO_KEY_AES_128) || (aesState == NULL)) {
+        return CY_CRYPTO_BAD_PARAMS;
+    }
+    memcpy(aesState->key, key, sizeof(aesState->key));
+    ble_sim.stats.crypto_loads++;
+    return (CY_BLE_SUCCESS == ble_seal_backend_soft.set_key(&ble_sim_crypto_key, key)) ? \
+           CY_CRYPTO_SUCCESS : CY_CRYPTO_BAD_PARAMS;
+}
+
+cy_en_crypto_status_t Cy_Crypto_Core_Aes_Ecb(CRYPTO_Type *base, cy_en_crypto_dir_mode_t dirMode, uint8_t *dst, \
+                                             uint8_t const *src, cy_stc_crypto_aes_state_t *aesState)
+{
+    (void)aesState;
+    if(base->CTL == 0u) {
+        return CY_CRYPTO_HW_NOT_ENABLED;
+    }
+    if(dirMode != CY_CRYPTO_ENCRYPT) {
+        return CY_CRYPTO_BAD_PARAMS;
+    }
+    ble_seal_backend_soft.encrypt(&ble_sim_crypto_key, src, dst);
+    ble_sim.stats.crypto_blocks++;
+    return CY_CRYPTO_SUCCESS;
+}
+
+cy_en_crypto_status_t Cy_Crypto_Core_Aes_Free(CRYPTO_Type *base, cy_stc_crypto_aes_state_t *aesState)
+{
+    (void)base;
+    memset(aesState, 0, sizeof(*aesState));
+    memset(&ble_sim_crypto_key, 0, sizeof(ble_sim_crypto_key));
+    return CY_CRYPTO_SUCCESS;
+}
+
+/*******************************************************************************
+* SysPm: the sleeps move the virtual time on
+*******************************************************************************/
+bool Cy_SysPm_RegisterCallback(cy_stc_syspm_callback_t *handler)
+{
+    if((handler == NULL) || (ble_sim.syspm_num == BLE_SIM_SYSPM_CALLBACKS)) {
+        return false;
+    }
+    ble_sim.syspm[ble_sim.syspm_num++] = handler;
+    return true;
+}
+
+cy_en_syspm_status_t Cy_SysPm_DeepSleep(int waitFor)
+{
+    cy_stc_syspm_callback_t *cb;
+    uint32_t i;
+
+    (void)waitFor;
+    for(i = 0u; i < ble_sim.syspm_num; i++) {
+        cb = ble_sim.syspm[i];
+        if((cb->type == CY_SYSPM_DEEPSLEEP) && \
+           (CY_SYSPM_SUCCESS != cb->callback(cb->callbackParams, CY_SYSPM_CHECK_READY))) {
+            return CY_SYSPM_FAIL;
+        }
+    }
+    ble_sim_sleep();
+    return CY_SYSPM_SUCCESS;
+}
+
+cy_en_syspm_status_t Cy_SysPm_CpuEnterSleep(int waitFor)
+{
+    (void)waitFor;
+    ble_sim_sleep();
+    return CY_SYSPM_SUCCESS;
+}
+
+/*******************************************************************************
+* SCB UART, retarget-io, BSP: the debug output is the standard output
+*******************************************************************************/
+uint32_t Cy_SCB_UART_Put(void *base, uint32_t data)
+{
+    (void)base;
+    (void)putchar((int)data);
+    return 1u;
+}
+
+uint32_t Cy_SCB_UART_Get(void *base)
+{
+    (void)base;
+    return CY_SCB_UART_RX_NO_DATA;
+}
+
+uint32_t Cy_SCB_UART_IsTxComplete(void *base)
+{
+    (void)base;
+    return 1u;
+}
+
+uint32_t Cy_SCB_UART_GetNumInRxFifo(void *base)
+{
+    (void)base;
+    return 0u;
+}
+
+void Cy_SCB_UART_ClearRxFifo(void *base)
+{
+    (void)base;
+}
+
+cy_rslt_t cy_retarget_io_init(int tx, int rx, int baudrate)
+{
+    (void)tx;
+    (void)rx;
+    (void)baudrate;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cybsp_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_uart_register_callback(cyhal_uart_t *obj, cyhal_uart_event_callback_t callback, void *callback_arg)
+{
+    (void)obj;
+    (void)callback;
+    (void)callback_arg;
+}
+
+void cyhal_uart_enable_event(cyhal_uart_t *obj, cyhal_uart_event_t event, uint8_t intrPriority, bool enable)
+{
+    (void)obj;
+    (void)event;
+    (void)intrPriority;
+    (void)enable;
+}
+
+/*******************************************************************************
+* LPTimer: counts the virtual time at BLE_TIME_TICK_HZ
+*******************************************************************************/
+cy_rslt_t cyhal_lptimer_init(cyhal_lptimer_t *obj)
+{
+    (void)obj;
+    return CY_RSLT_SUCCESS;
+}
+
+uint32_t cyhal_lptimer_read(const cyhal_lptimer_t *obj)
+{
+    (void)obj;
+    return (uint32_t)((ble_sim.now_us * BLE_TIME_TICK_HZ) / 1000000u);
+}
+
+cy_rslt_t cyhal_lptimer_set_delay(cyhal_lptimer_t *obj, uint32_t delay)
+{
+    (void)obj;
+    ble_sim.alarm_us = ble_sim.now_us + ((((uint64_t)delay * 1000000u) + BLE_TIME_TICK_HZ - 1u) / BLE_TIME_TICK_HZ);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cyhal_lptimer_set_match(cyhal_lptimer_t *obj, uint32_t value)
+{
+    return cyhal_lptimer_set_delay(obj, value - cyhal_lptimer_read(obj));
+}
+
+void cyhal_lptimer_register_callback(cyhal_lptimer_t *obj, cyhal_lptimer_event_callback_t callback, \
+                                     void *callback_arg)
+{
+    (void)obj;
+    ble_sim.alarm_callback = callback;
+    ble_sim.alarm_arg = callback_arg;
+}
+
+void cyhal_lptimer_enable_event(cyhal_lptimer_t *obj, cyhal_lptimer_event_t event, uint8_t intr_priority, \
+                                bool enable)
+{
+    (void)obj;
+    (void)event;
+    (void)intr_priority;
+    ble_sim.alarm_enabled = enable;
+}
+
+/*******************************************************************************
+* Stack: general
+*******************************************************************************/
+cy_en_ble_api_result_t Cy_BLE_Init(cy_stc_ble_config_t *config)
+{
+    return (config != NULL) ? CY_BLE_SUCCESS : CY_BLE_ERROR_INVALID_PARAMETER;
+}
+
+cy_en_ble_api_result_t Cy_BLE_Enable(void)
+{
+    if(ble_sim.state != CY_BLE_STATE_STOPPED) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    ble_sim.state = CY_BLE_STATE_ON;
+    return ble_sim_event(CY_BLE_EVT_STACK_ON, NULL, 0u);
+}
+
+cy_en_ble_api_result_t Cy_BLE_Disable(void)
+{
+    uint32_t i;
+
+    for(i = 0u; i < CY_BLE_CONN_COUNT; i++) {
+        memset(&ble_sim.conns[i], 0, sizeof(ble_sim.conns[i]));
+    }
+    ble_sim.state = CY_BLE_STATE_STOPPED;
+    ble_sim.adv_state = CY_BLE_ADV_STATE_STOPPED;
+    return ble_sim_event(CY_BLE_EVT_STACK_SHUTDOWN_COMPLETE, NULL, 0u);
+}
+
+void Cy_BLE_EnableLowPowerMode(void)
+{
+}
+
+void Cy_BLE_RegisterEventCallback(cy_ble_callback_t callback)
+{
+    ble_sim.callback = callback;
+}
+
+void Cy_BLE_RegisterAppHostCallback(cy_ble_app_notify_callback_t callback)
+{
+    ble_sim.host_callback = callback;
+}
+
+/*******************************************************************************
+* Function Name: Cy_BLE_ProcessEvents
+****************************************************************************//**
+*
+* Dispatches the queued stack events. Called while the GATT layer is busy
+* with nothing queued, it stands for the CPU spinning until the next
+* connection event, which is run.
+*
+* \param none.
+*
+* \return none.
+*
+*******************************************************************************/
+void Cy_BLE_ProcessEvents(void)
+{
+    ble_sim_event_t event;
+    uint64_t start;
+    uint32_t i;
+
+    if(ble_sim.event_count == 0u) {
+        for(i = 0u; i < CY_BLE_CONN_COUNT; i++) {
+            if(ble_sim.conns[i].connected && ble_sim.conns[i].busy) {
+                ble_sim.now_us = ble_sim_next_conn_event();
+                ble_sim_conn_event();
+                break;
+            }
+        }
+    }
+    while(ble_sim.event_count != 0u) {
+        event = ble_sim.events[ble_sim.event_head];
+        ble_sim.event_head = (ble_sim.event_head + 1u) % BLE_SIM_EVENT_DEPTH;
+        ble_sim.event_count--;
+        if(event.has_value) {
+            ((cy_stc_ble_gatt_write_param_t *)event.param.bytes)->handleValPair.value.val = event.value;
+        }
+        ble_sim.stats.stack_events++;
+        if(ble_sim.callback != NULL) {
+            start = ble_sim_cpu_ns();
+            ble_sim.callback(event.code, event.param.bytes);
+            if(ble_sim.dispatch != NULL) {
+                ble_sim.dispatch(event.code, ble_sim_cpu_ns() - start);
+            }
+        }
+    }
+}
+
+void Cy_BLE_BlessIsrHandler(void)
+{
+}
+
+cy_en_ble_state_t Cy_BLE_GetState(void)
+{
+    return ble_sim.state;
+}
+
+cy_en_ble_bless_state_t Cy_BLE_StackGetBleSsState(void)
+{
+    return CY_BLE_BLESS_STATE_SLEEP;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GetStackLibraryVersion(cy_stc_ble_stack_lib_version_t *stackVersion)
+{
+    memset(stackVersion, 0, sizeof(*stackVersion));
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_StoreBondingData(void)
+{
+    cy_ble_pendingFlashWrite = 0u;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_SetDefaultPhy(const cy_stc_ble_set_suggested_phy_info_t *param)
+{
+    (void)param;
+    return ble_sim_event(CY_BLE_EVT_SET_DEFAULT_PHY_COMPLETE, NULL, 0u);
+}
+
+uint8_t Cy_BLE_GetNumOfActiveConn(void)
+{
+    uint8_t count = 0u;
+    uint32_t i;
+
+    for(i = 0u; i < CY_BLE_CONN_COUNT; i++) {
+        if(ble_sim.conns[i].connected) {
+            count++;
+        }
+    }
+    return count;
+}
+
+cy_en_ble_conn_state_t Cy_BLE_GetConnectionState(cy_stc_ble_conn_handle_t connHandle)
+{
+    return (ble_sim_get_conn(connHandle.attId) != NULL) ? CY_BLE_CONN_STATE_CONNECTED : CY_BLE_CONN_STATE_DISCONNECTED;
+}
+
+/*******************************************************************************
+* Stack: GAP
+*******************************************************************************/
+cy_en_ble_api_result_t Cy_BLE_GAPP_StartAdvertisement(uint8_t advertisingIntervalType, uint8_t advIndex)
+{
+    (void)advertisingIntervalType;
+    (void)advIndex;
+    if((ble_sim.state != CY_BLE_STATE_ON) || (ble_sim.adv_state != CY_BLE_ADV_STATE_STOPPED)) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    ble_sim.adv_state = CY_BLE_ADV_STATE_ADVERTISING;
+    return ble_sim_event(CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAPP_StopAdvertisement(void)
+{
+    if(ble_sim.adv_state == CY_BLE_ADV_STATE_STOPPED) {
+        return CY_BLE_ERROR_INVALID_STATE;
+    }
+    ble_sim.adv_state = CY_BLE_ADV_STATE_STOPPED;
+    return ble_sim_event(CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP, NULL, 0u);
+}
+
+cy_en_ble_adv_state_t Cy_BLE_GetAdvertisementState(void)
+{
+    return ble_sim.adv_state;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAPP_UpdateAdvScanData(cy_stc_ble_gapp_disc_mode_info_t *param)
+{
+    (void)param;
+    return ble_sim_event(CY_BLE_EVT_GAPP_UPDATE_ADV_SCAN_DATA_COMPLETE, NULL, 0u);
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAPP_AuthReqReply(cy_stc_ble_gap_auth_info_t *param)
+{
+    (void)param;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_AuthReq(cy_stc_ble_gap_auth_info_t *param)
+{
+    (void)param;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_GetBdAddress(void)
+{
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_SetIdAddress(cy_stc_ble_gap_bd_addr_t *param)
+{
+    (void)param;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_GenerateKeys(cy_stc_ble_gap_sec_key_info_t *param)
+{
+    return ble_sim_event(CY_BLE_EVT_GAP_KEYS_GEN_COMPLETE, &param->SecKeyParam, sizeof(param->SecKeyParam));
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_SetSecurityKeys(cy_stc_ble_gap_sec_key_info_t *param)
+{
+    (void)param;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_GetBondList(cy_stc_ble_gap_bonded_device_list_info_t *param)
+{
+    param->noOfDevices = 0u;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_RemoveBondedDevice(cy_stc_ble_gap_bd_addr_t *param)
+{
+    (void)param;
+    return CY_BLE_ERROR_NO_DEVICE_ENTITY;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GAP_RemoveOldestDeviceFromBondedList(void)
+{
+    return CY_BLE_ERROR_NO_DEVICE_ENTITY;
+}
+
+/*******************************************************************************
+* Function Name: Cy_BLE_L2CAP_LeConnectionParamUpdateRequest
+****************************************************************************//**
+*
+* The peer accepts the request, the interval of the links becomes the
+* maximum interval requested.
+*
+* \param param The requested parameters.
+*
+* \return Return value indicates if the function succeeded or failed.
+* see \ref cy_en_ble_api_result_t.
+*
+*******************************************************************************/
+cy_en_ble_api_result_t Cy_BLE_L2CAP_LeConnectionParamUpdateRequest(cy_stc_ble_gap_conn_update_param_info_t *param)
+{
+    cy_stc_ble_l2cap_conn_update_rsp_param_t rsp = { .result = 0u, .bdHandle = param->bdHandle };
+    cy_stc_ble_gap_conn_param_updated_in_controller_t updated =
+    {
+        .status = 0u,
+        .bdHandle = param->bdHandle,
+        .connIntv = param->connIntvMax,
+        .connLatency = param->connLatency,
+        .supervisionTO = param->supervisionTO
+    };
+
+    if(ble_sim_get_conn(param->bdHandle) == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    ble_sim.link.interval_us = (uint32_t)param->connIntvMax * 1250u;
+    (void)ble_sim_event(CY_BLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP, &rsp, sizeof(rsp));
+    return ble_sim_event(CY_BLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE, &updated, sizeof(updated));
+}
+
+/*******************************************************************************
+* Stack: GATT server
+*******************************************************************************/
+cy_en_ble_stack_state_t Cy_BLE_GATT_GetBusyStatus(uint8_t attId)
+{
+    const ble_sim_conn_t *conn = ble_sim_get_conn(attId);
+
+    return ((conn != NULL) && conn->busy) ? CY_BLE_STACK_STATE_BUSY : CY_BLE_STACK_STATE_FREE;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GATT_GetMtuSize(cy_stc_ble_gatt_xchg_mtu_param_t *param)
+{
+    const ble_sim_conn_t *conn = ble_sim_get_conn(param->connHandle.attId);
+
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_DEVICE_ENTITY;
+    }
+    param->mtu = conn->mtu;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GATTS_SendNotification(cy_stc_ble_conn_handle_t *connHandle, \
+                                                     cy_stc_ble_gatt_handle_value_pair_t *ntfParam)
+{
+    return ble_sim_value_queue(connHandle, ntfParam, false);
+}
+
+cy_en_ble_api_result_t Cy_BLE_GATTS_SendIndication(cy_stc_ble_conn_handle_t *connHandle, \
+                                                   cy_stc_ble_gatt_handle_value_pair_t *indParam)
+{
+    return ble_sim_value_queue(connHandle, indParam, true);
+}
+
+cy_en_ble_api_result_t Cy_BLE_GATTS_WriteRsp(cy_stc_ble_conn_handle_t connHandle)
+{
+    ble_sim_conn_t *conn = ble_sim_get_conn(connHandle.attId);
+
+    if(conn == NULL) {
+        return CY_BLE_ERROR_NO_CONNECTION;
+    }
+    conn->req_pending = false;
+    return CY_BLE_SUCCESS;
+}
+
+cy_en_ble_api_result_t Cy_BLE_GATTS_ErrorRsp(cy_stc_ble_gatt_err_param_t *param)
+{
+    return Cy_BLE_GATTS_WriteRsp(param->connHandle);
+}
+
+cy_en_ble_gatt_err_code_t Cy_BLE_GATTS_WriteAttributeValueCCCD(cy_stc_ble_gatts_db_attr_val_info_t *param)
+{
+    ble_sim_conn_t *conn = ble_sim_get_conn(param->connHandle.attId);
+    const cy_stc_ble_gatt_value_t *value = &param->handleValuePair.value;
+
+    if((conn == NULL) || \
+       (param->handleValuePair.attrHandle != CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE)) {
+        return CY_BLE_GATT_ERR_INVALID_HANDLE;
+    }
+    if(value->len != 2u) {
+        return CY_BLE_GATT_ERR_INVALID_ATTRIBUTE_LEN;
+    }
+    conn->cccd = (uint16_t)(value->val[0] | ((uint16_t)value->val[1] << 8u));
+    return CY_BLE_GATT_ERR_NONE;
+}
+
+cy_en_ble_gatt_err_code_t Cy_BLE_GATTS_WriteAttributeValueLocal(cy_stc_ble_gatt_handle_value_pair_t *param)
+{
+    if(param->attrHandle != CY_BLE_CUSTOM_HOST_INTERFACE_COMMAND_CHAR_HANDLE) {
+        return CY_BLE_GATT_ERR_INVALID_HANDLE;
+    }
+    if(param->value.len > sizeof(ble_sim.cmd_value)) {
+        return CY_BLE_GATT_ERR_INVALID_ATTRIBUTE_LEN;
+    }
+    memcpy(ble_sim.cmd_value, param->value.val, param->value.len);
+    ble_sim.cmd_len = param->value.len;
+    return CY_BLE_GATT_ERR_NONE;
+}
+
+bool CY_BLE_IS_NOTIFICATION_ENABLED(uint8_t attId, uint16_t cccdHandle)
+{
+    const ble_sim_conn_t *conn = ble_sim_get_conn(attId);
+
+    (void)cccdHandle;
+    return (conn != NULL) && (0u != (conn->cccd & 0x01u));
+}
+
+bool CY_BLE_IS_INDICATION_ENABLED(uint8_t attId, uint16_t cccdHandle)
+{
+    const ble_sim_conn_t *conn = ble_sim_get_conn(attId);
+
+    (void)cccdHandle;
+    return (conn != NULL) && (0u != (conn->cccd & 0x02u));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,147 @@
+/***************************************************************************//**
+* \file ble_sim.h
+* \version 1.0
+*
+* \brief
+* Header file for the simulated BLE stack of the host build.
+*
+* ble_sim.c implements the stack API of cycfg_ble.h and the PDL and HAL calls
+* of the BLE layer, so that the modules of the firmware run unchanged on the
+* host. A simulated central (the peer) sits at the other end of each link.
+*
+* The time is virtual: it stands still while the firmware runs and moves on
+* when the run loop sleeps (Cy_SysPm_CpuEnterSleep() or Cy_SysPm_DeepSleep()),
+* to the next connection event or LPTimer alarm. At a connection event each
+* link carries up to packets_per_event PDUs in each direction: the writes of
+* the peer are delivered as stack events, and the notifications and
+* indications queued by the firmware are handed to the receive callback of
+* the peer. The stack buffers up to tx_buffers values per connection, the
+* GATT busy status and CY_BLE_EVT_STACK_BUSY_STATUS follow it. An indication
+* is confirmed at the connection event after the one which carried it.
+*
+* The stack events are queued and dispatched by Cy_BLE_ProcessEvents(), after
+* the host callback has posted BLE_EVENT_STACK, as on the target.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _BLE_SIM_H_
+#define _BLE_SIM_H_
+
+#include "ble_common.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The default link: 7.5 ms interval, 6 PDUs of each direction per
+ *        connection event, 8 values buffered by the stack, MTU 247.
+ */
+#define BLE_SIM_INTERVAL_US                 (7500u)
+#define BLE_SIM_PACKETS_PER_EVENT           (6u)
+#define BLE_SIM_TX_BUFFERS                  (8u)
+#define BLE_SIM_MTU                         (CY_BLE_GATT_MTU)
+
+/**
+ * @brief The stack events waiting for Cy_BLE_ProcessEvents(), and the writes
+ *        of the peer waiting for a connection event, of each connection.
+ */
+#define BLE_SIM_EVENT_DEPTH                 (64u)
+#define BLE_SIM_PEER_DEPTH                  (256u)
+
+/**
+ * @brief The parameter bytes of a stack event.
+ */
+#define BLE_SIM_EVENT_PARAM_LEN             (48u)
+
+/***************************************
+* Data Types
+***************************************/
+/**
+ * @brief The link parameters.
+ */
+typedef struct
+{
+    uint32_t interval_us;               /* The connection interval */
+    uint8_t  packets_per_event;         /* The PDUs of each direction per connection event */
+    uint8_t  tx_buffers;                /* The values buffered by the stack of a connection */
+    uint16_t mtu;                       /* The ATT MTU of the peer */
+} ble_sim_link_t;
+
+/**
+ * @brief The receive callback of the peer, called at the connection event
+ *        which carries a notification or an indication.
+ */
+typedef void (* ble_sim_rx_t)(uint8_t conn_id, bool indication, const uint8_t *val, uint16_t len);
+
+/**
+ * @brief The wakeup callback, called each time the virtual time moves on.
+ *        It may queue peer writes or post run loop events.
+ */
+typedef void (* ble_sim_wake_t)(void);
+
+/**
+ * @brief The dispatch callback, called after each stack event handled by the
+ *        event callback with the host time the handler took.
+ */
+typedef void (* ble_sim_dispatch_t)(uint32_t event, uint64_t ns);
+
+/**
+ * @brief The simulation statistics.
+ */
+typedef struct
+{
+    uint32_t conn_events;               /* The connection events with traffic */
+    uint32_t stack_events;              /* The events dispatched to the callback */
+    uint32_t notifications;             /* The values received by the peer */
+    uint32_t indications;
+    uint32_t confirmations;
+    uint32_t tx_bytes;
+    uint32_t write_reqs;                /* The writes delivered to the firmware */
+    uint32_t write_cmds;
+    uint32_t rx_bytes;
+    uint32_t busy;                      /* The BUSY transitions of the GATT status */
+    uint32_t rejected;                  /* The values refused by the stack */
+    uint32_t tx_queue_max;              /* The values buffered at most */
+    uint32_t event_queue_max;           /* The stack events queued at most */
+    uint32_t sleeps;                    /* The sleeps of the run loop */
+    uint32_t crypto_loads;              /* The keys loaded in the crypto block */
+    uint32_t crypto_blocks;             /* The blocks encrypted by the crypto block */
+} ble_sim_stats_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+void ble_sim_init(const ble_sim_link_t *link, ble_sim_rx_t rx, ble_sim_wake_t wake);
+uint64_t ble_sim_time_us(void);
+uint64_t ble_sim_cpu_ns(void);
+void ble_sim_wake_at(uint64_t time_us);
+void ble_sim_set_dispatch(ble_sim_dispatch_t dispatch);
+cy_en_ble_api_result_t ble_sim_connect(uint8_t conn_id);
+cy_en_ble_api_result_t ble_sim_disconnect(uint8_t conn_id, uint8_t reason);
+cy_en_ble_api_result_t ble_sim_peer_write(uint8_t conn_id, uint16_t handle, const void *val, uint16_t len, \
+                                          bool command);
+uint32_t ble_sim_peer_pending(uint8_t conn_id);
+uint32_t ble_sim_tx_pending(uint8_t conn_id);
+cy_en_ble_api_result_t ble_sim_event(uint32_t event, const void *param, uint32_t len);
+cy_en_ble_api_result_t ble_sim_event_write(uint32_t event, cy_stc_ble_conn_handle_t connHandle, \
+                                           uint16_t handle, const void *val, uint16_t len);
+void ble_sim_get_stats(ble_sim_stats_t *stats);
+void ble_sim_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _BLE_SIM_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,373 @@
+/***************************************************************************//**
+* \file ble_sim_rtos.c
+* \version 1.0
+*
+* \brief
+* The host model of the FreeRTOS calls of the BLE layer, see FreeRTOS.h.
+*
+* A task is a thread, it waits for vTaskStartScheduler() before it runs. The
+* notifications of a task and the queues are guarded by mutexes, a blocked
+* call waits on a condition with the timeout of its ticks, 1 ms each. The
+* critical section is one recursive lock, the interrupt masking of the PDL
+* model takes the same lock. vTaskEndScheduler() returns from
+* vTaskStartScheduler(), the tasks are left blocked.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+/* The recursive mutex initializer of glibc */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/**
+ * @brief A task, the handle of the FreeRTOS calls.
+ */
+struct ble_sim_rtos_task
+{
+    pthread_t      thread;
+    TaskFunction_t code;
+    void           *arg;
+    const char     *name;
+    UBaseType_t    priority;
+    uint32_t       notify;                      /* The notification value, guarded by the lock of the model */
+    pthread_cond_t notified;
+};
+
+/**
+ * @brief A queue, the items are stored in a ring.
+ */
+struct ble_sim_rtos_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    UBaseType_t     length;
+    UBaseType_t     item_size;
+    UBaseType_t     head;
+    UBaseType_t     count;
+    uint8_t         *items;
+};
+
+/**
+ * @brief The model state.
+ */
+static struct
+{
+    pthread_mutex_t lock;                       /* The scheduler state and the notifications */
+    pthread_cond_t  started;
+    pthread_cond_t  ended;
+    bool            running;
+    bool            stopped;
+    pthread_mutex_t critical;
+    struct timespec start;
+} ble_sim_rtos =
+{
+    .lock     = PTHREAD_MUTEX_INITIALIZER,
+    .started  = PTHREAD_COND_INITIALIZER,
+    .ended    = PTHREAD_COND_INITIALIZER,
+    .critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP,
+};
+
+/**
+ * @brief The task of the calling thread, NULL outside the tasks.
+ */
+static __thread struct ble_sim_rtos_task *ble_sim_rtos_current = NULL;
+
+
+/*******************************************************************************
+* Function Name: ble_sim_rtos_deadline
+****************************************************************************//**
+*
+* Gets the deadline of a wait, for pthread_cond_timedwait().
+*
+* \param ticks The ticks to wait.
+*
+* \param deadline The deadline is returned here.
+*
+* \return none.
+*
+*******************************************************************************/
+static void ble_sim_rtos_deadline(TickType_t ticks, struct timespec *deadline)
+{
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000u;
+
+    (void)clock_gettime(CLOCK_REALTIME, deadline);
+    ns += (uint64_t)deadline->tv_nsec;
+    deadline->tv_sec += (time_t)(ns / 1000000000u);
+    deadline->tv_nsec = (long)(ns % 1000000000u);
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_rtos_block
+****************************************************************************//**
+*
+* Blocks on a condition until it is signalled or the wait times out.
+*
+* \param cond The condition.
+*
+* \param lock The lock of the condition, it is held.
+*
+* \param ticks The ticks to wait, portMAX_DELAY to wait forever.
+*
+* \param deadline The deadline of a finite wait.
+*
+* \return false if the wait timed out.
+*
+*******************************************************************************/
+static bool ble_sim_rtos_block(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, \
+                               const struct timespec *deadline)
+{
+    if(ticks == portMAX_DELAY) {
+        (void)pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return ETIMEDOUT != pthread_cond_timedwait(cond, lock, deadline);
+}
+
+/*******************************************************************************
+* Function Name: ble_sim_rtos_entry
+****************************************************************************//**
+*
+* The thread of a task, it runs the task once the scheduler is started.
+*
+* \param arg The task.
+*
+* \return NULL.
+*
+*******************************************************************************/
+static void *ble_sim_rtos_entry(void *arg)
+{
+    struct ble_sim_rtos_task *task = (struct ble_sim_rtos_task *)arg;
+
+    ble_sim_rtos_current = task;
+    (void)pthread_mutex_lock(&ble_sim_rtos.lock);
+    while(!ble_sim_rtos.running) {
+        (void)pthread_cond_wait(&ble_sim_rtos.started, &ble_sim_rtos.lock);
+    }
+    (void)pthread_mutex_unlock(&ble_sim_rtos.lock);
+    task->code(task->arg);
+    /* A task function must not return, the task is deleted as by vTaskDelete(NULL) */
+    return NULL;
+}
+
+/*******************************************************************************
+* Tasks
+*******************************************************************************/
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, \
+                       void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask)
+{
+    struct ble_sim_rtos_task *task = calloc(1u, sizeof(*task));
+
+    (void)usStackDepth;
+    if(task == NULL) {
+        return pdFAIL;
+    }
+    task->code = pxTaskCode;
+    task->arg = pvParameters;
+    task->name = pcName;
+    task->priority = uxPriority;
+    (void)pthread_cond_init(&task->notified, NULL);
+    if(0 != pthread_create(&task->thread, NULL, ble_sim_rtos_entry, task)) {
+        free(task);
+        return pdFAIL;
+    }
+    (void)pthread_detach(task->thread);
+    if(pxCreatedTask != NULL) {
+        *pxCreatedTask = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    /* Only a task can delete itself in the model */
+    if((xTaskToDelete == NULL) || (xTaskToDelete == ble_sim_rtos_current)) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    struct timespec ts =
+    {
+        .tv_sec  = (time_t)((xTicksToDelay * portTICK_PERIOD_MS) / 1000u),
+        .tv_nsec = (long)(((xTicksToDelay * portTICK_PERIOD_MS) % 1000u) * 1000000u),
+    };
+
+    (void)nanosleep(&ts, NULL);
+}
+
+void vTaskStartScheduler(void)
+{
+    (void)pthread_mutex_lock(&ble_sim_rtos.lock);
+    (void)clock_gettime(CLOCK_MONOTONIC, &ble_sim_rtos.start);
+    ble_sim_rtos.running = true;
+    (void)pthread_cond_broadcast(&ble_sim_rtos.started);
+    while(!ble_sim_rtos.stopped) {
+        (void)pthread_cond_wait(&ble_sim_rtos.ended, &ble_sim_rtos.lock);
+    }
+    (void)pthread_mutex_unlock(&ble_sim_rtos.lock);
+}
+
+void vTaskEndScheduler(void)
+{
+    (void)pthread_mutex_lock(&ble_sim_rtos.lock);
+    ble_sim_rtos.stopped = true;
+    (void)pthread_cond_broadcast(&ble_sim_rtos.ended);
+    (void)pthread_mutex_unlock(&ble_sim_rtos.lock);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return ble_sim_rtos_current;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)((((int64_t)(now.tv_sec - ble_sim_rtos.start.tv_sec) * 1000) + \
+                         ((now.tv_nsec - ble_sim_rtos.start.tv_nsec) / 1000000)) / portTICK_PERIOD_MS);
+}
+
+/*******************************************************************************
+* Notifications
+*******************************************************************************/
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    (void)pthread_mutex_lock(&ble_sim_rtos.lock);
+    xTaskToNotify->notify++;
+    (void)pthread_cond_signal(&xTaskToNotify->notified);
+    (void)pthread_mutex_unlock(&ble_sim_rtos.lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskNotifyGive(xTaskToNotify);
+    if(pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    struct ble_sim_rtos_task *task = ble_sim_rtos_current;
+    struct timespec deadline;
+    uint32_t value;
+
+    ble_sim_rtos_deadline(xTicksToWait, &deadline);
+    (void)pthread_mutex_lock(&ble_sim_rtos.lock);
+    while((task->notify == 0u) && (xTicksToWait != 0u) && \
+          ble_sim_rtos_block(&task->notified, &ble_sim_rtos.lock, xTicksToWait, &deadline)) {
+    }
+    value = task->notify;
+    if(value != 0u) {
+        task->notify = (xClearCountOnExit != pdFALSE) ? 0u : (value - 1u);
+    }
+    (void)pthread_mutex_unlock(&ble_sim_rtos.lock);
+    return value;
+}
+
+/*******************************************************************************
+* Critical section
+*******************************************************************************/
+void vTaskEnterCritical(void)
+{
+    (void)pthread_mutex_lock(&ble_sim_rtos.critical);
+}
+
+void vTaskExitCritical(void)
+{
+    (void)pthread_mutex_unlock(&ble_sim_rtos.critical);
+}
+
+/*******************************************************************************
+* Queues
+*******************************************************************************/
+QueueHandle_t xQueueCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize)
+{
+    struct ble_sim_rtos_queue *queue = calloc(1u, sizeof(*queue));
+
+    if(queue == NULL) {
+        return NULL;
+    }
+    if(NULL == (queue->items = malloc(uxQueueLength * uxItemSize))) {
+        free(queue);
+        return NULL;
+    }
+    (void)pthread_mutex_init(&queue->lock, NULL);
+    (void)pthread_cond_init(&queue->not_empty, NULL);
+    (void)pthread_cond_init(&queue->not_full, NULL);
+    queue->length = uxQueueLength;
+    queue->item_size = uxItemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait)
+{
+    struct timespec deadline;
+    UBaseType_t tail;
+    BaseType_t sent = pdFALSE;
+
+    ble_sim_rtos_deadline(xTicksToWait, &deadline);
+    (void)pthread_mutex_lock(&xQueue->lock);
+    while((xQueue->count == xQueue->length) && (xTicksToWait != 0u) && \
+          ble_sim_rtos_block(&xQueue->not_full, &xQueue->lock, xTicksToWait, &deadline)) {
+    }
+    if(xQueue->count < xQueue->length) {
+        tail = (xQueue->head + xQueue->count) % xQueue->length;
+        memcpy(&xQueue->items[tail * xQueue->item_size], pvItemToQueue, xQueue->item_size);
+        xQueue->count++;
+        (void)pthread_cond_signal(&xQueue->not_empty);
+        sent = pdTRUE;
+    }
+    (void)pthread_mutex_unlock(&xQueue->lock);
+    return sent;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait)
+{
+    struct timespec deadline;
+    BaseType_t received = pdFALSE;
+
+    ble_sim_rtos_deadline(xTicksToWait, &deadline);
+    (void)pthread_mutex_lock(&xQueue->lock);
+    while((xQueue->count == 0u) && (xTicksToWait != 0u) && \
+          ble_sim_rtos_block(&xQueue->not_empty, &xQueue->lock, xTicksToWait, &deadline)) {
+    }
+    if(xQueue->count != 0u) {
+        memcpy(pvBuffer, &xQueue->items[xQueue->head * xQueue->item_size], xQueue->item_size);
+        xQueue->head = (xQueue->head + 1u) % xQueue->length;
+        xQueue->count--;
+        (void)pthread_cond_signal(&xQueue->not_full);
+        received = pdTRUE;
+    }
+    (void)pthread_mutex_unlock(&xQueue->lock);
+    return received;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    UBaseType_t count;
+
+    (void)pthread_mutex_lock(&xQueue->lock);
+    count = xQueue->count;
+    (void)pthread_mutex_unlock(&xQueue->lock);
+    return count;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+* \file FreeRTOS.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the FreeRTOS header, for the BLE_RTOS=FREERTOS
+* modules: the tasks are threads, the queues and the task notifications are
+* guarded by mutexes, see ble_sim_rtos.c. Only the calls of the BLE layer are
+* modelled. The task priorities are kept but not enforced, the tasks run in
+* parallel on the host cores.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FreeRTOSConfig.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Data Types
+***************************************/
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+/***************************************
+* Macro definitions
+***************************************/
+#define pdFALSE                             ((BaseType_t)0)
+#define pdTRUE                              ((BaseType_t)1)
+#define pdPASS                              (pdTRUE)
+#define pdFAIL                              (pdFALSE)
+
+/**
+ * @brief A tick is 1 ms as configTICK_RATE_HZ of the target.
+ */
+#define portMAX_DELAY                       ((TickType_t)0xFFFFFFFFuL)
+#define portTICK_PERIOD_MS                  ((TickType_t)1000u / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)                   ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000u))
+
+/**
+ * @brief The model has no interrupts, the tasks are woken at once.
+ */
+#define portYIELD_FROM_ISR(woken)           ((void)(woken))
+
+#define tskIDLE_PRIORITY                    ((UBaseType_t)0u)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INC_FREERTOS_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,267 @@
+/***************************************************************************//**
+* \file cy_pdl.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the PDL header. Only the types, constants and
+* functions used by the BLE layer are declared, they are implemented by
+* ble_sim.c. The register blocks are plain objects, the DWT cycle counter
+* follows the host CPU time.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _CY_PDL_H_
+#define _CY_PDL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Common
+***************************************/
+typedef char char8;
+typedef uint32_t cy_rslt_t;
+
+#define CY_RSLT_SUCCESS                     (0u)
+#define CY_ASSERT(x)                        do { if(!(x)) { ble_sim_assert(__FILE__, __LINE__); } } while(0)
+#define CY_SECTION(name)                    __attribute__((section(name)))
+
+#define CY_CPU_CORTEX_M0P                   (0u)
+#define CY_CPU_CORTEX_M4                    (1u)
+
+void ble_sim_assert(const char *file, int line);
+
+/***************************************
+* Core
+***************************************/
+typedef int IRQn_Type;
+
+#define bless_interrupt_IRQn                (24)
+#define cpuss_interrupts_ipc_0_IRQn         (23)
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk              (1uL)
+#define CoreDebug_DEMCR_TRCENA_Msk          (1uL << 24u)
+
+/* The cycle counter is updated on each access */
+#define DWT                                 (ble_sim_dwt())
+
+DWT_Type *ble_sim_dwt(void);
+extern CoreDebug_Type *CoreDebug;
+extern uint32_t SystemCoreClock;
+
+static inline void __enable_irq(void) {}
+static inline void __disable_irq(void) {}
+static inline void __WFI(void) {}
+static inline uint32_t __CLZ(uint32_t x) { return (x != 0u) ? (uint32_t)__builtin_clz(x) : 32u; }
+static inline uint32_t __RBIT(uint32_t x)
+{
+    uint32_t r = 0u;
+    uint32_t i;
+
+    for(i = 0u; i < 32u; i++) {
+        r = (r << 1u) | (x & 1u);
+        x >>= 1u;
+    }
+    return r;
+}
+static inline void NVIC_EnableIRQ(IRQn_Type n) { (void)n; }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type n) { (void)n; }
+#define __DMB()                             __sync_synchronize()
+
+uint32_t __get_MSP(void);
+uint32_t __get_PSP(void);
+uint32_t __get_IPSR(void);
+void NVIC_SystemReset(void);
+
+/***************************************
+* SysLib, SysInt
+***************************************/
+#define CY_SYSLIB_RESET_SOFT                (0x0010u)
+
+uint32_t Cy_SysLib_EnterCriticalSection(void);
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus);
+uint32_t Cy_SysLib_GetResetReason(void);
+void Cy_SysLib_ClearResetReason(void);
+
+typedef struct
+{
+    IRQn_Type intrSrc;
+    uint32_t  intrPriority;
+} cy_stc_sysint_t;
+
+#define CY_SYSINT_SUCCESS                   (0)
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, void (*userIsr)(void));
+
+/***************************************
+* SysPm
+***************************************/
+#define CY_SYSPM_WAIT_FOR_INTERRUPT         (0)
+#define CY_SYSPM_SKIP_CHECK_FAIL            (1u)
+#define CY_SYSPM_SKIP_BEFORE_TRANSITION     (2u)
+#define CY_SYSPM_SKIP_AFTER_TRANSITION      (4u)
+
+typedef enum
+{
+    CY_SYSPM_SUCCESS,
+    CY_SYSPM_FAIL
+} cy_en_syspm_status_t;
+
+typedef enum
+{
+    CY_SYSPM_CHECK_READY,
+    CY_SYSPM_CHECK_FAIL,
+    CY_SYSPM_BEFORE_TRANSITION,
+    CY_SYSPM_AFTER_TRANSITION
+} cy_en_syspm_callback_mode_t;
+
+typedef enum
+{
+    CY_SYSPM_SLEEP,
+    CY_SYSPM_DEEPSLEEP
+} cy_en_syspm_callback_type_t;
+
+typedef struct
+{
+    void *base;
+    void *context;
+} cy_stc_syspm_callback_params_t;
+
+typedef cy_en_syspm_status_t (*Cy_SysPmCallback)(cy_stc_syspm_callback_params_t *params, \
+                                                 cy_en_syspm_callback_mode_t mode);
+
+typedef struct cy_stc_syspm_callback
+{
+    Cy_SysPmCallback callback;
+    cy_en_syspm_callback_type_t type;
+    uint32_t skipMode;
+    cy_stc_syspm_callback_params_t *callbackParams;
+    struct cy_stc_syspm_callback *prevItm;
+    struct cy_stc_syspm_callback *nextItm;
+    uint8_t order;
+} cy_stc_syspm_callback_t;
+
+bool Cy_SysPm_RegisterCallback(cy_stc_syspm_callback_t *handler);
+cy_en_syspm_status_t Cy_SysPm_DeepSleep(int waitFor);
+cy_en_syspm_status_t Cy_SysPm_CpuEnterSleep(int waitFor);
+
+/***************************************
+* SCB UART
+***************************************/
+#define CY_SCB_UART_RX_NO_DATA              (0xFFFFFFFFuL)
+
+uint32_t Cy_SCB_UART_Put(void *base, uint32_t data);
+uint32_t Cy_SCB_UART_Get(void *base);
+uint32_t Cy_SCB_UART_IsTxComplete(void *base);
+uint32_t Cy_SCB_UART_GetNumInRxFifo(void *base);
+void Cy_SCB_UART_ClearRxFifo(void *base);
+
+/***************************************
+* Crypto
+***************************************/
+/* The device has the crypto block, ble_sim.c models it with the software AES
+ * of ble_seal.c and counts its key loads and blocks */
+#define CY_IP_MXCRYPTO                      (1u)
+
+typedef struct
+{
+    volatile uint32_t CTL;
+} CRYPTO_Type;
+
+typedef enum
+{
+    CY_CRYPTO_SUCCESS = 0,
+    CY_CRYPTO_HW_NOT_ENABLED,
+    CY_CRYPTO_BAD_PARAMS
+} cy_en_crypto_status_t;
+
+typedef enum
+{
+    CY_CRYPTO_KEY_AES_128 = 0
+} cy_en_crypto_aes_key_length_t;
+
+typedef enum
+{
+    CY_CRYPTO_ENCRYPT = 0,
+    CY_CRYPTO_DECRYPT
+} cy_en_crypto_dir_mode_t;
+
+typedef struct
+{
+    uint8_t key[16];
+} cy_stc_crypto_aes_state_t;
+
+#define CRYPTO                              (ble_sim_crypto())
+
+CRYPTO_Type *ble_sim_crypto(void);
+cy_en_crypto_status_t Cy_Crypto_Core_Enable(CRYPTO_Type *base);
+cy_en_crypto_status_t Cy_Crypto_Core_Disable(CRYPTO_Type *base);
+cy_en_crypto_status_t Cy_Crypto_Core_Aes_Init(CRYPTO_Type *base, uint8_t const *key, \
+                                              cy_en_crypto_aes_key_length_t keyLength, \
+                                              cy_stc_crypto_aes_state_t *aesState);
+cy_en_crypto_status_t Cy_Crypto_Core_Aes_Ecb(CRYPTO_Type *base, cy_en_crypto_dir_mode_t dirMode, uint8_t *dst, \
+                                             uint8_t const *src, cy_stc_crypto_aes_state_t *aesState);
+cy_en_crypto_status_t Cy_Crypto_Core_Aes_Free(CRYPTO_Type *base, cy_stc_crypto_aes_state_t *aesState);
+
+/***************************************
+* IPC
+***************************************/
+#define CY_IPC_CHAN_USER                    (7u)
+#define CY_IPC_INTR_USER                    (8u)
+#define CY_IPC_NO_NOTIFICATION              (0u)
+
+typedef struct
+{
+    volatile uint32_t LOCK_STATUS;
+} IPC_STRUCT_Type;
+
+typedef struct
+{
+    volatile uint32_t INTR_MASK;
+} IPC_INTR_STRUCT_Type;
+
+typedef enum
+{
+    CY_IPC_DRV_SUCCESS = 0,
+    CY_IPC_DRV_ERROR
+} cy_en_ipcdrv_status_t;
+
+IPC_STRUCT_Type *Cy_IPC_Drv_GetIpcBaseAddress(uint32_t ipcIndex);
+IPC_INTR_STRUCT_Type *Cy_IPC_Drv_GetIntrBaseAddr(uint32_t ipcIntrIndex);
+cy_en_ipcdrv_status_t Cy_IPC_Drv_SendMsgWord(IPC_STRUCT_Type *base, uint32_t notifyMask, uint32_t message);
+cy_en_ipcdrv_status_t Cy_IPC_Drv_LockRelease(IPC_STRUCT_Type *base, uint32_t releaseEventIntr);
+void Cy_IPC_Drv_SetInterruptMask(IPC_INTR_STRUCT_Type *base, uint32_t ipcReleaseMask, uint32_t ipcNotifyMask);
+uint32_t Cy_IPC_Drv_GetInterruptStatusMasked(IPC_INTR_STRUCT_Type *base);
+uint32_t Cy_IPC_Drv_ExtractAcquireMask(uint32_t intMask);
+void Cy_IPC_Drv_ClearInterrupt(IPC_INTR_STRUCT_Type *base, uint32_t ipcReleaseMask, uint32_t ipcNotifyMask);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _CY_PDL_H_ */
+
+/* [] END OF FILE */
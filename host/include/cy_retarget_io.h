@@ -0,0 +1,29 @@
+/***************************************************************************//**
+* \file cy_retarget_io.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the retarget-io header, printf() writes to the
+* standard output of the host.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _CY_RETARGET_IO_H_
+#define _CY_RETARGET_IO_H_
+
+#include "cyhal.h"
+
+#define CY_RETARGET_IO_BAUDRATE             (115200)
+
+extern cyhal_uart_t cy_retarget_io_uart_obj;
+
+cy_rslt_t cy_retarget_io_init(int tx, int rx, int baudrate);
+
+#endif /* _CY_RETARGET_IO_H_ */
+
+/* [] END OF FILE */
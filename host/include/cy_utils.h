@@ -0,0 +1,22 @@
+/***************************************************************************//**
+* \file cy_utils.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the utilities header, CY_ASSERT is in cy_pdl.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _CY_UTILS_H_
+#define _CY_UTILS_H_
+
+#include "cy_pdl.h"
+
+#endif /* _CY_UTILS_H_ */
+
+/* [] END OF FILE */
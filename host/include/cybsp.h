@@ -0,0 +1,27 @@
+/***************************************************************************//**
+* \file cybsp.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the BSP header.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _CYBSP_H_
+#define _CYBSP_H_
+
+#include "cyhal.h"
+
+#define CYBSP_DEBUG_UART_TX                 (0)
+#define CYBSP_DEBUG_UART_RX                 (1)
+
+cy_rslt_t cybsp_init(void);
+
+#endif /* _CYBSP_H_ */
+
+/* [] END OF FILE */
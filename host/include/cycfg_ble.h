@@ -0,0 +1,535 @@
+/***************************************************************************//**
+* \file cycfg_ble.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the generated BLE configuration and of the BLE stack
+* API, implemented by ble_sim.c. The GATT database holds the custom service of
+* design.cybt, the structures keep the members used by the BLE layer.
+*
+* The event codes are numbered in the order of this file, not with the values
+* of the stack headers (cy_ble_stack.h). A trace dumped by the target is
+* replayed by the host build after the codes of this file are given the
+* values of the stack headers of the target build.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _CYCFG_BLE_H_
+#define _CYCFG_BLE_H_
+
+#include "cy_pdl.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Configuration of design.cybt
+***************************************/
+#define CY_BLE_CONN_COUNT                   (4u)
+#define CY_BLE_GATT_MTU                     (247u)
+#define CY_BLE_GATT_DB_MAX_VALUE_LEN        (244u)
+#define CY_BLE_MAX_BONDED_DEVICES           (16u)
+#define CY_BLE_BONDING_YES                  (1u)
+#define CY_BLE_BONDING_REQUIREMENT          (CY_BLE_BONDING_YES)
+#define CY_BLE_CONTR_CORE                   (CY_CPU_CORTEX_M4)
+#define CY_BLE_HOST_CORE                    (CY_CPU_CORTEX_M4)
+#define CY_BLE_CONFIG_ENABLE_PHY_UPDATE     (1u)
+#define CY_BLE_LL_PRIVACY_FEATURE_ENABLED   (0u)
+#define CY_BLE_PERIPHERAL_CONFIGURATION_0_INDEX (0u)
+#define CY_BLE_SECURITY_CONFIGURATION_0_INDEX   (0u)
+
+#define CY_BLE_CUSTOM_HOST_INTERFACE_COMMAND_CHAR_HANDLE    (0x0010u)
+#define CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CHAR_HANDLE   (0x0012u)
+#define CY_BLE_CUSTOM_HOST_INTERFACE_RESPONSE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE (0x0013u)
+
+/***************************************
+* Stack constants
+***************************************/
+#define CY_BLE_GATT_WRITE_REQ               (0x12u)
+#define CY_BLE_GATT_WRITE_HEADER_LEN        (3u)
+#define CY_BLE_GATT_DB_LOCALLY_INITIATED    (0u)
+#define CY_BLE_GATT_DB_PEER_INITIATED       (1u)
+#define CY_BLE_GAP_BD_ADDR_SIZE             (6u)
+#define CY_BLE_GAP_ADDR_TYPE_RANDOM         (1u)
+#define CY_BLE_GAP_RANDOM_RESOLVABLE_ADDR_TYPE (2u)
+#define CY_BLE_GAP_MAX_ADV_DATA_LEN         (31u)
+#define CY_BLE_GAP_MAX_SCAN_RSP_DATA_LEN    (31u)
+#define CY_BLE_ADVERTISING_FAST             (0u)
+#define CY_BLE_ADVERTISING_SLOW             (1u)
+#define CY_BLE_ADVERTISING_CUSTOM           (2u)
+#define CY_BLE_PHY_NO_PREF_MASK_NONE        (0u)
+#define CY_BLE_PHY_MASK_LE_2M               (2u)
+
+#define CY_BLE_GAP_SEC_MODE_1               (0x10u)
+#define CY_BLE_GAP_SEC_LEVEL_1              (0x00u)
+#define CY_BLE_GAP_SEC_LEVEL_MASK           (0x0Fu)
+#define CY_BLE_GAP_AUTH_ERROR_CONFIRM_VALUE_NOT_MATCH           (0x04u)
+#define CY_BLE_GAP_AUTH_ERROR_PAIRING_NOT_SUPPORTED             (0x05u)
+#define CY_BLE_GAP_AUTH_ERROR_INSUFFICIENT_ENCRYPTION_KEY_SIZE  (0x06u)
+#define CY_BLE_GAP_AUTH_ERROR_UNSPECIFIED_REASON                (0x08u)
+#define CY_BLE_GAP_AUTH_ERROR_AUTHENTICATION_TIMEOUT            (0x15u)
+
+#define CY_BLE_GAP_SMP_INIT_ENC_KEY_DIST    (0x01u)
+#define CY_BLE_GAP_SMP_INIT_IRK_KEY_DIST    (0x02u)
+#define CY_BLE_GAP_SMP_INIT_CSRK_KEY_DIST   (0x04u)
+#define CY_BLE_GAP_SMP_RESP_ENC_KEY_DIST    (0x10u)
+#define CY_BLE_GAP_SMP_RESP_IRK_KEY_DIST    (0x20u)
+#define CY_BLE_GAP_SMP_RESP_CSRK_KEY_DIST   (0x40u)
+
+/***************************************
+* Status and states
+***************************************/
+typedef enum
+{
+    CY_BLE_SUCCESS = 0,
+    CY_BLE_ERROR_INVALID_PARAMETER,
+    CY_BLE_ERROR_INVALID_OPERATION,
+    CY_BLE_ERROR_MEMORY_ALLOCATION_FAILED,
+    CY_BLE_ERROR_INSUFFICIENT_RESOURCES,
+    CY_BLE_ERROR_OOB_NOT_AVAILABLE,
+    CY_BLE_ERROR_NO_CONNECTION,
+    CY_BLE_ERROR_NO_DEVICE_ENTITY,
+    CY_BLE_ERROR_REPEATED_ATTEMPTS,
+    CY_BLE_ERROR_GAP_ROLE,
+    CY_BLE_ERROR_SEC_FAILED,
+    CY_BLE_ERROR_INVALID_STATE,
+    CY_BLE_ERROR_FLASH_WRITE_NOT_PERMITED,
+    CY_BLE_ERROR_FLASH_WRITE,
+    CY_BLE_ERROR_MIC_AUTH_FAILED,
+    CY_BLE_ERROR_HARDWARE_FAILURE,
+    CY_BLE_ERROR_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE,
+    CY_BLE_ERROR_NTF_DISABLED,
+    CY_BLE_ERROR_IND_DISABLED,
+    CY_BLE_ERROR_CHAR_IS_NOT_DISCOVERED,
+    CY_BLE_ERROR_GATT_DB_INVALID_ATTR_HANDLE,
+    CY_BLE_ERROR_MAX
+} cy_en_ble_api_result_t;
+
+typedef enum
+{
+    CY_BLE_GATT_ERR_NONE = 0x00,
+    CY_BLE_GATT_ERR_INVALID_HANDLE = 0x01,
+    CY_BLE_GATT_ERR_WRITE_NOT_PERMITTED = 0x03,
+    CY_BLE_GATT_ERR_REQUEST_NOT_SUPPORTED = 0x06,
+    CY_BLE_GATT_ERR_INVALID_ATTRIBUTE_LEN = 0x0D,
+    CY_BLE_GATT_ERR_UNLIKELY_ERROR = 0x0E,
+    CY_BLE_GATT_ERR_INSUFFICIENT_RESOURCE = 0x11
+} cy_en_ble_gatt_err_code_t;
+
+typedef enum
+{
+    CY_BLE_STACK_STATE_FREE = 0,
+    CY_BLE_STACK_STATE_BUSY = 1
+} cy_en_ble_stack_state_t;
+
+typedef enum
+{
+    CY_BLE_CONN_STATE_DISCONNECTED,
+    CY_BLE_CONN_STATE_CONNECTED
+} cy_en_ble_conn_state_t;
+
+typedef enum
+{
+    CY_BLE_STATE_STOPPED,
+    CY_BLE_STATE_INITIALIZING,
+    CY_BLE_STATE_ON
+} cy_en_ble_state_t;
+
+typedef enum
+{
+    CY_BLE_ADV_STATE_STOPPED,
+    CY_BLE_ADV_STATE_ADV_INITIATED,
+    CY_BLE_ADV_STATE_ADVERTISING,
+    CY_BLE_ADV_STATE_STOP_INITIATED
+} cy_en_ble_adv_state_t;
+
+typedef enum
+{
+    CY_BLE_BLESS_STATE_ACTIVE,
+    CY_BLE_BLESS_STATE_EVENT_CLOSE,
+    CY_BLE_BLESS_STATE_SLEEP,
+    CY_BLE_BLESS_STATE_ECO_ON,
+    CY_BLE_BLESS_STATE_ECO_STABLE,
+    CY_BLE_BLESS_STATE_DEEPSLEEP,
+    CY_BLE_BLESS_STATE_HIBERNATE,
+    CY_BLE_BLESS_STATE_INVALID
+} cy_en_ble_bless_state_t;
+
+typedef enum
+{
+    CY_BLE_GENERIC_APP_TO = 1
+} cy_en_ble_to_reason_code_t;
+
+/***************************************
+* Events
+***************************************/
+enum
+{
+    CY_BLE_EVT_STACK_ON = 1,
+    CY_BLE_EVT_TIMEOUT,
+    CY_BLE_EVT_HARDWARE_ERROR,
+    CY_BLE_EVT_STACK_BUSY_STATUS,
+    CY_BLE_EVT_SET_TX_PWR_COMPLETE,
+    CY_BLE_EVT_LE_SET_EVENT_MASK_COMPLETE,
+    CY_BLE_EVT_SET_DEVICE_ADDR_COMPLETE,
+    CY_BLE_EVT_GET_DEVICE_ADDR_COMPLETE,
+    CY_BLE_EVT_STACK_SHUTDOWN_COMPLETE,
+    CY_BLE_EVT_DATA_LENGTH_CHANGE,
+    CY_BLE_EVT_SET_SUGGESTED_DATA_LENGTH_COMPLETE,
+    CY_BLE_EVT_GET_DATA_LENGTH_COMPLETE,
+    CY_BLE_EVT_SET_DEFAULT_PHY_COMPLETE,
+    CY_BLE_EVT_GAP_KEYS_GEN_COMPLETE,
+    CY_BLE_EVT_GAP_AUTH_REQ,
+    CY_BLE_EVT_GAP_PASSKEY_ENTRY_REQUEST,
+    CY_BLE_EVT_GAP_PASSKEY_DISPLAY_REQUEST,
+    CY_BLE_EVT_GAP_NUMERIC_COMPARISON_REQUEST,
+    CY_BLE_EVT_GAP_KEYINFO_EXCHNGE_CMPLT,
+    CY_BLE_EVT_GAP_SMP_NEGOTIATED_AUTH_INFO,
+    CY_BLE_EVT_GAP_AUTH_COMPLETE,
+    CY_BLE_EVT_GAP_AUTH_FAILED,
+    CY_BLE_EVT_GAPP_ADVERTISEMENT_START_STOP,
+    CY_BLE_EVT_GAP_ENHANCE_CONN_COMPLETE,
+    CY_BLE_EVT_GAP_DEVICE_CONNECTED,
+    CY_BLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP,
+    CY_BLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE,
+    CY_BLE_EVT_GAP_DEVICE_DISCONNECTED,
+    CY_BLE_EVT_GAP_ENCRYPT_CHANGE,
+    CY_BLE_EVT_GATT_CONNECT_IND,
+    CY_BLE_EVT_GATT_DISCONNECT_IND,
+    CY_BLE_EVT_GATTS_XCNHG_MTU_REQ,
+    CY_BLE_EVT_GATTS_READ_CHAR_VAL_ACCESS_REQ,
+    CY_BLE_EVT_GATTS_WRITE_REQ,
+    CY_BLE_EVT_GATTS_WRITE_CMD_REQ,
+    CY_BLE_EVT_GATTS_HANDLE_VALUE_CNF,
+    CY_BLE_EVT_GATTS_INDICATION_DISABLED,
+    CY_BLE_EVT_GATTS_INDICATION_ENABLED,
+    CY_BLE_EVT_GATTS_NOTIFICATION_ENABLED,
+    CY_BLE_EVT_GATTS_NOTIFICATION_DISABLED,
+    CY_BLE_EVT_PENDING_FLASH_WRITE,
+    CY_BLE_EVT_GATTS_PREP_WRITE_REQ,
+    CY_BLE_EVT_GATTS_EXEC_WRITE_REQ,
+    CY_BLE_EVT_GAPP_UPDATE_ADV_SCAN_DATA_COMPLETE,
+    CY_BLE_EVT_STACK_SHUTDOWN
+};
+
+typedef void (*cy_ble_callback_t)(uint32_t event, void *eventParam);
+typedef void (*cy_ble_app_notify_callback_t)(void);
+
+/***************************************
+* Event parameters
+***************************************/
+typedef struct
+{
+    uint8_t attId;
+    uint8_t bdHandle;
+} cy_stc_ble_conn_handle_t;
+
+typedef struct
+{
+    uint8_t  *val;
+    uint16_t len;
+    uint16_t actualLen;
+} cy_stc_ble_gatt_value_t;
+
+typedef struct
+{
+    cy_stc_ble_gatt_value_t value;
+    uint16_t attrHandle;
+} cy_stc_ble_gatt_handle_value_pair_t;
+
+typedef struct
+{
+    cy_stc_ble_conn_handle_t connHandle;
+    cy_stc_ble_gatt_handle_value_pair_t handleValPair;
+} cy_stc_ble_gatt_write_param_t;
+
+typedef cy_stc_ble_gatt_write_param_t cy_stc_ble_gatts_write_cmd_req_param_t;
+
+typedef struct
+{
+    cy_stc_ble_gatt_handle_value_pair_t handleValuePair;
+    cy_stc_ble_conn_handle_t connHandle;
+    uint16_t offset;
+    uint8_t  flags;
+} cy_stc_ble_gatts_db_attr_val_info_t;
+
+typedef struct
+{
+    struct
+    {
+        uint8_t  opCode;
+        uint16_t attrHandle;
+        uint8_t  errorCode;
+    } errInfo;
+    cy_stc_ble_conn_handle_t connHandle;
+} cy_stc_ble_gatt_err_param_t;
+
+typedef struct
+{
+    cy_stc_ble_conn_handle_t connHandle;
+    uint16_t mtu;
+} cy_stc_ble_gatt_xchg_mtu_param_t;
+
+typedef struct
+{
+    cy_stc_ble_conn_handle_t connHandle;
+    uint16_t attrHandle;
+    uint8_t  gattErrorCode;
+} cy_stc_ble_gatts_char_val_read_req_t;
+
+typedef struct
+{
+    uint8_t  status;
+    uint8_t  bdHandle;
+    uint16_t connIntv;
+    uint16_t connLatency;
+    uint16_t supervisionTO;
+    uint8_t  role;
+} cy_stc_ble_gap_connected_param_t;
+
+typedef struct
+{
+    uint8_t  status;
+    uint8_t  bdHandle;
+    uint8_t  peerBdAddrType;
+    uint8_t  peerBdAddr[CY_BLE_GAP_BD_ADDR_SIZE];
+    uint16_t connIntv;
+    uint16_t connLatency;
+    uint16_t supervisionTo;
+} cy_stc_ble_gap_enhance_conn_complete_param_t;
+
+typedef struct
+{
+    uint8_t  status;
+    uint8_t  bdHandle;
+    uint16_t connIntv;
+    uint16_t connLatency;
+    uint16_t supervisionTO;
+} cy_stc_ble_gap_conn_param_updated_in_controller_t;
+
+typedef struct
+{
+    uint8_t bdHandle;
+    uint8_t reason;
+    uint8_t status;
+} cy_stc_ble_gap_disconnect_param_t;
+
+typedef struct
+{
+    uint8_t result;
+    uint8_t bdHandle;
+} cy_stc_ble_l2cap_conn_update_rsp_param_t;
+
+typedef struct
+{
+    uint16_t connMaxTxOctets;
+    uint16_t connMaxTxTime;
+    uint16_t connMaxRxOctets;
+    uint16_t connMaxRxTime;
+    uint8_t  bdHandle;
+} cy_stc_ble_data_length_change_event_param_t;
+
+typedef struct
+{
+    uint16_t suggestedTxOctets;
+    uint16_t suggestedTxTime;
+    uint16_t maxTxOctets;
+    uint16_t maxTxTime;
+    uint16_t maxRxOctets;
+    uint16_t maxRxTime;
+} cy_stc_ble_data_length_param_t;
+
+typedef struct
+{
+    uint8_t publicBdAddr[CY_BLE_GAP_BD_ADDR_SIZE];
+    uint8_t privateBdAddr[CY_BLE_GAP_BD_ADDR_SIZE];
+} cy_stc_ble_bd_addrs_t;
+
+typedef struct
+{
+    uint8_t status;
+    void    *eventParams;
+} cy_stc_ble_events_param_generic_t;
+
+typedef struct
+{
+    cy_en_ble_to_reason_code_t reasonCode;
+    uint8_t timerHandle;
+} cy_stc_ble_timeout_param_t;
+
+/***************************************
+* GAP
+***************************************/
+typedef struct
+{
+    uint8_t type;
+    uint8_t bdAddr[CY_BLE_GAP_BD_ADDR_SIZE];
+} cy_stc_ble_gap_bd_addr_t;
+
+typedef struct
+{
+    cy_stc_ble_gap_bd_addr_t bdAddr;
+    uint8_t bdHandle;
+} cy_stc_ble_gap_peer_addr_info_t;
+
+typedef struct
+{
+    cy_stc_ble_gap_peer_addr_info_t *bdHandleAddrList;
+    uint8_t noOfDevices;
+} cy_stc_ble_gap_bonded_device_list_info_t;
+
+typedef struct
+{
+    uint8_t irk[16];
+    uint8_t idAddrInfo[7];
+    uint8_t csrk[16];
+    uint8_t bdHandle;
+} cy_stc_ble_gap_sec_key_param_t;
+
+typedef struct
+{
+    cy_stc_ble_gap_sec_key_param_t SecKeyParam;
+    uint8_t localKeysFlag;
+    uint8_t exchangeKeysFlag;
+} cy_stc_ble_gap_sec_key_info_t;
+
+typedef struct
+{
+    uint8_t bdHandle;
+    uint8_t security;
+    uint8_t bonding;
+    uint8_t ekeySize;
+    uint8_t authErr;
+    uint8_t pairingProperties;
+} cy_stc_ble_gap_auth_info_t;
+
+typedef struct
+{
+    uint8_t  bdHandle;
+    uint16_t connIntvMin;
+    uint16_t connIntvMax;
+    uint16_t connLatency;
+    uint16_t supervisionTO;
+} cy_stc_ble_gap_conn_update_param_info_t;
+
+typedef struct
+{
+    uint8_t allPhyMask;
+    uint8_t txPhyMask;
+    uint8_t rxPhyMask;
+} cy_stc_ble_set_suggested_phy_info_t;
+
+typedef struct
+{
+    uint8_t advData[CY_BLE_GAP_MAX_ADV_DATA_LEN];
+    uint8_t advDataLen;
+} cy_stc_ble_gapp_disc_data_t;
+
+typedef struct
+{
+    uint8_t scanRspData[CY_BLE_GAP_MAX_SCAN_RSP_DATA_LEN];
+    uint8_t scanRspDataLen;
+} cy_stc_ble_gapp_scan_rsp_data_t;
+
+typedef struct
+{
+    uint8_t  discMode;
+    void     *advParam;
+    cy_stc_ble_gapp_disc_data_t *advData;
+    cy_stc_ble_gapp_scan_rsp_data_t *scanRspData;
+    uint16_t advTo;
+} cy_stc_ble_gapp_disc_mode_info_t;
+
+typedef struct
+{
+    uint8_t majorVersion;
+    uint8_t minorVersion;
+    uint8_t patch;
+    uint8_t buildNumber;
+} cy_stc_ble_stack_lib_version_t;
+
+/***************************************
+* Configuration
+***************************************/
+typedef struct
+{
+    cy_stc_sysint_t const *blessIsrConfig;
+} cy_stc_ble_hw_config_t;
+
+typedef struct
+{
+    cy_stc_ble_hw_config_t *hw;
+    cy_stc_ble_gapp_disc_mode_info_t *discoveryModeInfo;
+} cy_stc_ble_config_t;
+
+typedef struct
+{
+    cy_stc_ble_gap_auth_info_t *authInfo;
+} cy_stc_ble_config_ptr_t;
+
+extern cy_stc_ble_config_t cy_ble_config;
+extern cy_stc_ble_config_ptr_t *cy_ble_configPtr;
+extern cy_stc_ble_gap_bd_addr_t cy_ble_deviceAddress;
+extern volatile uint8_t cy_ble_pendingFlashWrite;
+
+/***************************************
+* Stack API
+***************************************/
+cy_en_ble_api_result_t Cy_BLE_Init(cy_stc_ble_config_t *config);
+cy_en_ble_api_result_t Cy_BLE_Enable(void);
+cy_en_ble_api_result_t Cy_BLE_Disable(void);
+void Cy_BLE_EnableLowPowerMode(void);
+void Cy_BLE_RegisterEventCallback(cy_ble_callback_t callback);
+void Cy_BLE_RegisterAppHostCallback(cy_ble_app_notify_callback_t callback);
+void Cy_BLE_ProcessEvents(void);
+void Cy_BLE_BlessIsrHandler(void);
+cy_en_ble_state_t Cy_BLE_GetState(void);
+cy_en_ble_bless_state_t Cy_BLE_StackGetBleSsState(void);
+cy_en_ble_api_result_t Cy_BLE_GetStackLibraryVersion(cy_stc_ble_stack_lib_version_t *stackVersion);
+cy_en_ble_api_result_t Cy_BLE_StoreBondingData(void);
+cy_en_ble_api_result_t Cy_BLE_SetDefaultPhy(const cy_stc_ble_set_suggested_phy_info_t *param);
+uint8_t Cy_BLE_GetNumOfActiveConn(void);
+cy_en_ble_conn_state_t Cy_BLE_GetConnectionState(cy_stc_ble_conn_handle_t connHandle);
+
+cy_en_ble_api_result_t Cy_BLE_GAPP_StartAdvertisement(uint8_t advertisingIntervalType, uint8_t advIndex);
+cy_en_ble_api_result_t Cy_BLE_GAPP_StopAdvertisement(void);
+cy_en_ble_adv_state_t Cy_BLE_GetAdvertisementState(void);
+cy_en_ble_api_result_t Cy_BLE_GAPP_UpdateAdvScanData(cy_stc_ble_gapp_disc_mode_info_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAPP_AuthReqReply(cy_stc_ble_gap_auth_info_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_AuthReq(cy_stc_ble_gap_auth_info_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_GetBdAddress(void);
+cy_en_ble_api_result_t Cy_BLE_GAP_SetIdAddress(cy_stc_ble_gap_bd_addr_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_GenerateKeys(cy_stc_ble_gap_sec_key_info_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_SetSecurityKeys(cy_stc_ble_gap_sec_key_info_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_GetBondList(cy_stc_ble_gap_bonded_device_list_info_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_RemoveBondedDevice(cy_stc_ble_gap_bd_addr_t *param);
+cy_en_ble_api_result_t Cy_BLE_GAP_RemoveOldestDeviceFromBondedList(void);
+cy_en_ble_api_result_t Cy_BLE_L2CAP_LeConnectionParamUpdateRequest(cy_stc_ble_gap_conn_update_param_info_t *param);
+
+cy_en_ble_stack_state_t Cy_BLE_GATT_GetBusyStatus(uint8_t attId);
+cy_en_ble_api_result_t Cy_BLE_GATT_GetMtuSize(cy_stc_ble_gatt_xchg_mtu_param_t *param);
+cy_en_ble_api_result_t Cy_BLE_GATTS_SendNotification(cy_stc_ble_conn_handle_t *connHandle, \
+                                                     cy_stc_ble_gatt_handle_value_pair_t *ntfParam);
+cy_en_ble_api_result_t Cy_BLE_GATTS_SendIndication(cy_stc_ble_conn_handle_t *connHandle, \
+                                                   cy_stc_ble_gatt_handle_value_pair_t *indParam);
+cy_en_ble_api_result_t Cy_BLE_GATTS_WriteRsp(cy_stc_ble_conn_handle_t connHandle);
+cy_en_ble_api_result_t Cy_BLE_GATTS_ErrorRsp(cy_stc_ble_gatt_err_param_t *param);
+cy_en_ble_gatt_err_code_t Cy_BLE_GATTS_WriteAttributeValueCCCD(cy_stc_ble_gatts_db_attr_val_info_t *param);
+cy_en_ble_gatt_err_code_t Cy_BLE_GATTS_WriteAttributeValueLocal(cy_stc_ble_gatt_handle_value_pair_t *param);
+bool CY_BLE_IS_NOTIFICATION_ENABLED(uint8_t attId, uint16_t cccdHandle);
+bool CY_BLE_IS_INDICATION_ENABLED(uint8_t attId, uint16_t cccdHandle);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _CYCFG_BLE_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,76 @@
+/***************************************************************************//**
+* \file cyhal.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the HAL header: the LPTimer of the time base and the
+* debug UART events, implemented by ble_sim.c. The LPTimer counts the virtual
+* time of the simulation.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef _CYHAL_H_
+#define _CYHAL_H_
+
+#include "cy_pdl.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* LPTimer
+***************************************/
+typedef struct
+{
+    uint32_t match;
+} cyhal_lptimer_t;
+
+typedef enum
+{
+    CYHAL_LPTIMER_COMPARE_MATCH
+} cyhal_lptimer_event_t;
+
+typedef void (*cyhal_lptimer_event_callback_t)(void *callback_arg, cyhal_lptimer_event_t event);
+
+cy_rslt_t cyhal_lptimer_init(cyhal_lptimer_t *obj);
+uint32_t cyhal_lptimer_read(const cyhal_lptimer_t *obj);
+cy_rslt_t cyhal_lptimer_set_match(cyhal_lptimer_t *obj, uint32_t value);
+cy_rslt_t cyhal_lptimer_set_delay(cyhal_lptimer_t *obj, uint32_t delay);
+void cyhal_lptimer_register_callback(cyhal_lptimer_t *obj, cyhal_lptimer_event_callback_t callback, \
+                                     void *callback_arg);
+void cyhal_lptimer_enable_event(cyhal_lptimer_t *obj, cyhal_lptimer_event_t event, uint8_t intr_priority, \
+                                bool enable);
+
+/***************************************
+* UART
+***************************************/
+typedef struct
+{
+    void *base;
+} cyhal_uart_t;
+
+typedef enum
+{
+    CYHAL_UART_IRQ_NONE = 0,
+    CYHAL_UART_IRQ_RX_NOT_EMPTY = 1
+} cyhal_uart_event_t;
+
+typedef void (*cyhal_uart_event_callback_t)(void *callback_arg, cyhal_uart_event_t event);
+
+void cyhal_uart_register_callback(cyhal_uart_t *obj, cyhal_uart_event_callback_t callback, void *callback_arg);
+void cyhal_uart_enable_event(cyhal_uart_t *obj, cyhal_uart_event_t event, uint8_t intrPriority, bool enable);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _CYHAL_H_ */
+
+/* [] END OF FILE */
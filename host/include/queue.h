@@ -0,0 +1,45 @@
+/***************************************************************************//**
+* \file queue.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the FreeRTOS queue calls, see FreeRTOS.h. The items
+* are copied as on the target.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef INC_QUEUE_H
+#define INC_QUEUE_H
+
+#include "FreeRTOS.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Data Types
+***************************************/
+typedef struct ble_sim_rtos_queue *QueueHandle_t;
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+QueueHandle_t xQueueCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait);
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INC_QUEUE_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,65 @@
+/***************************************************************************//**
+* \file task.h
+* \version 1.0
+*
+* \brief
+* Host build stand-in of the FreeRTOS task and notification calls, see
+* FreeRTOS.h.
+*
+********************************************************************************
+* \copyright
+* Copyright 2016-2018, Cypress Semiconductor Corporation. All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+/* The C binding of definitions if building with the C++ compiler */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/***************************************
+* Data Types
+***************************************/
+typedef struct ble_sim_rtos_task *TaskHandle_t;
+typedef void (* TaskFunction_t)(void *arg);
+
+/***************************************
+* Macro definitions
+***************************************/
+/**
+ * @brief The critical section is one recursive lock shared with the
+ *        interrupt masking of the PDL model.
+ */
+#define taskENTER_CRITICAL()                vTaskEnterCritical()
+#define taskEXIT_CRITICAL()                 vTaskExitCritical()
+
+/***************************************
+* Public Function Prototypes
+***************************************/
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, \
+                       void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(const TickType_t xTicksToDelay);
+void vTaskStartScheduler(void);
+void vTaskEndScheduler(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskEnterCritical(void);
+void vTaskExitCritical(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INC_TASK_H */
+
+/* [] END OF FILE */
@@ -44,6 +44,10 @@
 #include "cybsp.h"
 #include "cy_retarget_io.h"
 #include "ble_app_test.h"
+#if defined(COMPONENT_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
 
 /*******************************************************************************
 * Macros
@@ -89,8 +93,17 @@ int main(void)
     /* Enable global interrupts */
     __enable_irq();
 
+#if defined(COMPONENT_FREERTOS)
+    /* Run BLE testing in the BLE task */
+    if (ble_app_test_rtos() != CY_BLE_SUCCESS)
+    {
+        CY_ASSERT(0);
+    }
+    vTaskStartScheduler();
+#else
     /* Run BLE testing */
     ble_app_test();
+#endif
 
     for(;;)
     {